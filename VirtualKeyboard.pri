@@ -0,0 +1,50 @@
+#-------------------------------------------------
+#
+#   VirtualKeyboard for Qt 5
+#
+#   Sources of the keyboard widget, shared by the test application and the benchmarks
+#
+#-------------------------------------------------
+
+INCLUDEPATH += $$PWD/src
+
+SOURCES +=  $$PWD/src/VirtualKeyboard.cpp \
+            $$PWD/src/VirtualKeyboardDictionary.cpp \
+            $$PWD/src/VirtualKeyboardFocusDispatcher.cpp \
+            $$PWD/src/VirtualKeyboardGeometry.cpp \
+            $$PWD/src/VirtualKeyboardGestureDecoder.cpp \
+            $$PWD/src/VirtualKeyboardInputTarget.cpp \
+            $$PWD/src/VirtualKeyboardKeyFilter.cpp \
+            $$PWD/src/VirtualKeyboardKeyModel.cpp \
+            $$PWD/src/VirtualKeyboardKeymap.cpp \
+            $$PWD/src/VirtualKeyboardLatency.cpp \
+            $$PWD/src/VirtualKeyboardLoader.cpp \
+            $$PWD/src/VirtualKeyboardPredictionWorker.cpp \
+            $$PWD/src/VirtualKeyboardSecondaryBar.cpp \
+            $$PWD/src/VirtualKeyboardSnippet.cpp \
+            $$PWD/src/VirtualKeyboardSurface.cpp \
+            $$PWD/src/VirtualKeyboardTapModel.cpp \
+            $$PWD/src/VirtualKeyboardTrace.cpp
+
+HEADERS  += $$PWD/src/VirtualKeyboard.h \
+            $$PWD/src/VirtualKeyboardDictionary.h \
+            $$PWD/src/VirtualKeyboardFocusDispatcher.h \
+            $$PWD/src/VirtualKeyboardGeometry.h \
+            $$PWD/src/VirtualKeyboardGestureDecoder.h \
+            $$PWD/src/VirtualKeyboardInputTarget.h \
+            $$PWD/src/VirtualKeyboardKeyFilter.h \
+            $$PWD/src/VirtualKeyboardKeyModel.h \
+            $$PWD/src/VirtualKeyboardKeymap.h \
+            $$PWD/src/VirtualKeyboardLatency.h \
+            $$PWD/src/VirtualKeyboardLoader.h \
+            $$PWD/src/VirtualKeyboardPredictionWorker.h \
+            $$PWD/src/VirtualKeyboardRingBuffer.h \
+            $$PWD/src/VirtualKeyboardSecondaryBar.h \
+            $$PWD/src/VirtualKeyboardSnippet.h \
+            $$PWD/src/VirtualKeyboardSurface.h \
+            $$PWD/src/VirtualKeyboardTapModel.h \
+            $$PWD/src/VirtualKeyboardTrace.h
+
+FORMS    += $$PWD/ui/VirtualKeyboard.ui
+
+RESOURCES += $$PWD/resources/resources.qrc
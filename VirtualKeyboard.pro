@@ -32,16 +32,13 @@ TEMPLATE = app
 CONFIG += c++11
 
 SOURCES +=  src/TEST_VirtualKeyboard.cpp \
-            src/main_VirtualKeyboard.cpp \
-            src/VirtualKeyboard.cpp
+            src/main_VirtualKeyboard.cpp
 
-HEADERS  += src/TEST_VirtualKeyboard.h \
-            src/VirtualKeyboard.h
+HEADERS  += src/TEST_VirtualKeyboard.h
 
-FORMS    += ui/TEST_VirtualKeyboard.ui \
-            ui/VirtualKeyboard.ui
+FORMS    += ui/TEST_VirtualKeyboard.ui
 
-RESOURCES += resources/resources.qrc
+include(VirtualKeyboard.pri)
 
 OTHER_FILES += README.md
 
@@ -0,0 +1,1423 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+#include "BENCH_VirtualKeyboard.h"
+
+#include <QApplication>
+#include <QLineEdit>
+#include <QTextEdit>
+#include <QPlainTextEdit>
+#include <QComboBox>
+#include <QScopedPointer>
+#include <QBuffer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QPushButton>
+#include <QVBoxLayout>
+#include <QElapsedTimer>
+#include <QClipboard>
+#include <QLineF>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+
+// Number of secondary keys added and removed by secondaryKeysChurn
+#define BENCH_SECONDARYKEYS_COUNT   40
+
+// Form navigated by focusNavigation : number of widgets (line edits and buttons) and of keyboards following the focus
+#define BENCH_FOCUS_WIDGETCOUNT     200
+#define BENCH_FOCUS_KEYBOARDCOUNT   4
+
+// The text of a QLineEdit is limited (maxLength), it is cleared every BENCH_LINEEDIT_CLEARPERIOD keys
+#define BENCH_LINEEDIT_CLEARPERIOD  1000
+
+// Keys typed by each iteration of typingBurst, and size of the document the text edits are filled with
+#define BENCH_BURST_KEYCOUNT        32
+#define BENCH_BURST_DOCUMENTSIZE    100000
+
+// Characters typed then deleted by largeDocumentTyping, the events are processed (a frame) every BENCH_LARGEDOCUMENT_FRAMEPERIOD keys
+#define BENCH_LARGEDOCUMENT_KEYCOUNT    10000
+#define BENCH_LARGEDOCUMENT_FRAMEPERIOD 32
+
+// Session replayed by undoMemory and undoSteps : words typed (5 characters and a space), 3 backspaces every BENCH_UNDO_BACKSPACEPERIOD words
+#define BENCH_UNDO_WORDCOUNT        20000
+#define BENCH_UNDO_BACKSPACEPERIOD  10
+#define BENCH_UNDO_CLEARTHRESHOLD   100
+
+// Size of the clipboard text pasted by pasteStall, in characters
+#define BENCH_PASTE_SIZE            4000000
+
+// Snippet keys added to each keyboard by snippetMemory, and size of their texts in characters
+#define BENCH_SNIPPET_KEYCOUNT      1000
+#define BENCH_SNIPPET_SIZE          200
+
+// Words of the dictionary of predictionLookup, and number of prefixes looked up in turn
+#define BENCH_PREDICTION_WORDCOUNT  500000
+#define BENCH_PREDICTION_PREFIXCOUNT 1000
+
+// Words of the source dictionary loaded by startupTime
+#define BENCH_STARTUP_WORDCOUNT     100000
+
+// Words corrected in turn by tapCorrection, and offset of their taps from the centre of the keys, in key widths
+#define BENCH_TAPCORRECTION_WORDCOUNT   200
+#define BENCH_TAPCORRECTION_OFFSET      0.6
+
+// Words traced in turn by gestureDecoding, distance between two points of their paths in pixels (pointer events),
+// and largest offset of the corners of the paths from the centre of the keys, in key sizes
+#define BENCH_GESTURE_WORDCOUNT     200
+#define BENCH_GESTURE_POINTSPACING  12
+#define BENCH_GESTURE_JITTER        0.3
+
+
+#if defined(__GLIBC__)
+#define BENCH_HAS_ALLOCATIONCOUNT
+
+extern "C" void *__libc_malloc(size_t i_size);
+extern "C" void *__libc_calloc(size_t i_count, size_t i_size);
+extern "C" void *__libc_realloc(void *p_memory, size_t i_size);
+
+/**
+ * Number of heap allocations of the process, Qt included (malloc, calloc and realloc are interposed)
+ */
+static QBasicAtomicInt st_allocationCount = Q_BASIC_ATOMIC_INITIALIZER(0);
+
+extern "C" void *malloc(size_t i_size)
+{
+    st_allocationCount.fetchAndAddRelaxed(1);
+    return __libc_malloc(i_size);
+}
+
+extern "C" void *calloc(size_t i_count, size_t i_size)
+{
+    st_allocationCount.fetchAndAddRelaxed(1);
+    return __libc_calloc(i_count, i_size);
+}
+
+extern "C" void *realloc(void *p_memory, size_t i_size)
+{
+    st_allocationCount.fetchAndAddRelaxed(1);
+    return __libc_realloc(p_memory, i_size);
+}
+
+/**
+ * \brief Get the number of bytes of heap in use by the process
+ */
+static qint64 heapInUse()
+{
+#if __GLIBC_PREREQ(2, 33)
+    return qint64(mallinfo2().uordblks);
+#else
+    return qint64(mallinfo().uordblks);
+#endif
+}
+#endif
+
+
+
+/**
+ * \brief Get a word of the dictionary of predictionLookup : distinct words made of syllables, the digits of their rank in base 20
+ */
+static QString predictionWord(int i_rank)
+{
+    static const char *const stc_syllables[20] = { "a", "e", "i", "o", "u", "ba", "ce", "di", "fo", "gu",
+                                                   "la", "me", "ni", "po", "ru", "sa", "te", "vi", "mo", "tra" };
+
+    QString s_word = QLatin1String("s");
+    for (int i_digits = i_rank; i_digits > 0; i_digits /= 20) s_word += QLatin1String(stc_syllables[i_digits % 20]);
+
+    return s_word;
+}
+
+
+/**
+ * \brief Get the letter keys of a keymap laid out
+ * \param[in] o_geometry : Key-geometry table of the keymap, lower layer
+ * \param[in] po_keymap : Keymap
+ * \param[out] ps_characters : Letter of each key
+ * \param[out] pveco_rects : Rectangle of each key
+ */
+static void letterKeys(const VirtualKeyboardGeometry &o_geometry, const VirtualKeyboardKeymap *po_keymap, QString *ps_characters, QVector<QRectF> *pveco_rects)
+{
+    foreach (const VirtualKeyboardGeometry::Key &o_key, o_geometry.keys())
+    {
+        if (o_key.i_keyId < 0) continue;
+
+        const QString s_key = po_keymap->keyText(VIRTUALKEYBOARD_LAYER_LOWER, o_key.i_keyId);
+        if (s_key.size() != 1 || !s_key.at(0).isLetter()) continue;
+
+        *ps_characters += s_key;
+        pveco_rects->append(o_key.o_rect);
+    }
+}
+
+
+
+QWidget *BENCH_VirtualKeyboard::createInputWidget(const QString &s_type)
+{
+    if (s_type == "QLineEdit")      return new QLineEdit();
+    if (s_type == "QTextEdit")      return new QTextEdit();
+    if (s_type == "QPlainTextEdit") return new QPlainTextEdit();
+
+    QComboBox *w_comboBox = new QComboBox();
+    w_comboBox->setEditable(true);
+    return w_comboBox;
+}
+
+
+QString BENCH_VirtualKeyboard::predictionDictionary()
+{
+    static QTemporaryDir so_directory;
+    static QString ss_fileName;
+
+    if (!ss_fileName.isEmpty() || !so_directory.isValid()) return ss_fileName;
+
+    // Zipf distribution of the frequencies
+    QString s_source;
+    s_source.reserve(BENCH_PREDICTION_WORDCOUNT * 16);
+
+    for (int i_rank = 0; i_rank < BENCH_PREDICTION_WORDCOUNT; ++i_rank)
+        s_source += predictionWord(i_rank) + QLatin1Char(' ') + QString::number(100000000 / (i_rank + 1) + 1) + QLatin1Char('\n');
+
+    QByteArray ba_compiled;
+    if (!VirtualKeyboardDictionary::compile(s_source, &ba_compiled)) return ss_fileName;
+
+    QFile o_file(so_directory.path() + QLatin1String("/BENCH" VIRTUALKEYBOARD_DICTIONARY_COMPILEDSUFFIX));
+    if (o_file.open(QIODevice::WriteOnly) && o_file.write(ba_compiled) == ba_compiled.size())
+        ss_fileName = o_file.fileName();
+
+    return ss_fileName;
+}
+
+
+QByteArray BENCH_VirtualKeyboard::undoSession()
+{
+    static QByteArray sba_trace;
+
+    if (!sba_trace.isEmpty()) return sba_trace;
+
+    // Words, spaces and runs of backspaces, recorded on a line edit
+    QLineEdit w_lineEdit;
+    VirtualKeyboard w_recordingKeyboard;
+    if (w_recordingKeyboard.initialisation(&w_lineEdit) != VIRTUALKEYBOARD_SUCCESS) return sba_trace;
+
+    QByteArray ba_trace;
+    QBuffer o_buffer(&ba_trace);
+    o_buffer.open(QIODevice::WriteOnly);
+
+    VirtualKeyboardTraceRecorder o_recorder(&w_recordingKeyboard);
+    if (!o_recorder.start(&o_buffer)) return sba_trace;
+
+    for (int i_word = 0; i_word < BENCH_UNDO_WORDCOUNT; ++i_word)
+    {
+        for (int i_i = 0; i_i < 5; ++i_i) w_recordingKeyboard.pressKey((i_word + i_i) % 26);
+        w_recordingKeyboard.pressKey(VIRTUALKEYBOARD_KEY_SPACE);
+
+        if (i_word % BENCH_UNDO_BACKSPACEPERIOD == 0)
+            for (int i_i = 0; i_i < 3; ++i_i) w_recordingKeyboard.pressKey(VIRTUALKEYBOARD_KEY_BACKSPACE);
+
+        if (i_word % BENCH_LINEEDIT_CLEARPERIOD == 0) w_lineEdit.clear();
+    }
+    o_recorder.stop();
+
+    sba_trace = ba_trace;
+    return sba_trace;
+}
+
+
+void BENCH_VirtualKeyboard::initialisation_data()
+{
+    QTest::addColumn<int>("renderMode");
+
+    QTest::newRow("widgets") << VIRTUALKEYBOARD_RENDER_WIDGETS;
+    QTest::newRow("painted") << VIRTUALKEYBOARD_RENDER_PAINTED;
+}
+
+
+void BENCH_VirtualKeyboard::initialisation()
+{
+    QFETCH(int, renderMode);
+
+    QBENCHMARK
+    {
+        VirtualKeyboard w_keyboard;
+        QCOMPARE(w_keyboard.initialisation(NULL, "EN", true, false, renderMode), VIRTUALKEYBOARD_SUCCESS);
+    }
+}
+
+
+void BENCH_VirtualKeyboard::keymapAllocations_data()
+{
+    QTest::addColumn<QString>("source");
+
+    QTest::newRow("builtin")    << QString();
+    QTest::newRow("compiled")   << QString(VIRTUALKEYBOARD_KEYMAP_COMPILEDSUFFIX);
+    QTest::newRow("source")     << QString(VIRTUALKEYBOARD_KEYMAP_SOURCESUFFIX);
+}
+
+
+void BENCH_VirtualKeyboard::keymapAllocations()
+{
+#ifndef BENCH_HAS_ALLOCATIONCOUNT
+    QSKIP("Counting the allocations needs glibc");
+#else
+    QFETCH(QString, source);
+
+    QString s_language = "EN";
+    QTemporaryDir o_directory;
+
+    // File keymaps : a language which has not been loaded yet (the keymaps are cached by the process), written from the EN source
+    if (!source.isEmpty())
+    {
+        static int si_languageCount = 0;
+        s_language = QString("BENCH%1").arg(++si_languageCount);
+
+        QFile o_source(QFINDTESTDATA("../keymaps/EN.vkm"));
+        QVERIFY(o_source.open(QIODevice::ReadOnly));
+        QByteArray ba_keymap = o_source.readAll();
+
+        if (source == VIRTUALKEYBOARD_KEYMAP_COMPILEDSUFFIX)
+            QVERIFY(VirtualKeyboardKeymap::compile(QString::fromUtf8(ba_keymap), &ba_keymap));
+
+        QFile o_file(o_directory.path() + "/" + s_language + source);
+        QVERIFY(o_file.open(QIODevice::WriteOnly));
+        QCOMPARE(o_file.write(ba_keymap), qint64(ba_keymap.size()));
+        o_file.close();
+
+        VirtualKeyboardKeymap::addSearchPath(o_directory.path());
+    }
+
+    const int i_allocationCount = st_allocationCount.load();
+    const VirtualKeyboardKeymap *po_keymap = VirtualKeyboardKeymap::find(s_language);
+    const int i_keymapAllocationCount = st_allocationCount.load() - i_allocationCount;
+
+    QVERIFY(po_keymap != NULL);
+    QCOMPARE(po_keymap->keyText(VIRTUALKEYBOARD_LAYER_LOWER, 0), QString("q"));
+
+    QTest::setBenchmarkResult(i_keymapAllocationCount, QTest::Events);
+#endif
+}
+
+
+void BENCH_VirtualKeyboard::layerToggle_data()
+{
+    QTest::addColumn<int>("renderMode");
+    QTest::addColumn<int>("keyId");
+
+    QTest::newRow("widgets/caps")           << VIRTUALKEYBOARD_RENDER_WIDGETS << VIRTUALKEYBOARD_KEY_CAPS;
+    QTest::newRow("widgets/numbers")        << VIRTUALKEYBOARD_RENDER_WIDGETS << VIRTUALKEYBOARD_KEY_NUMBERS;
+    QTest::newRow("widgets/punctuation")    << VIRTUALKEYBOARD_RENDER_WIDGETS << VIRTUALKEYBOARD_KEY_PUNCTUATION;
+    QTest::newRow("painted/caps")           << VIRTUALKEYBOARD_RENDER_PAINTED << VIRTUALKEYBOARD_KEY_CAPS;
+    QTest::newRow("painted/numbers")        << VIRTUALKEYBOARD_RENDER_PAINTED << VIRTUALKEYBOARD_KEY_NUMBERS;
+    QTest::newRow("painted/punctuation")    << VIRTUALKEYBOARD_RENDER_PAINTED << VIRTUALKEYBOARD_KEY_PUNCTUATION;
+}
+
+
+void BENCH_VirtualKeyboard::layerToggle()
+{
+    QFETCH(int, renderMode);
+    QFETCH(int, keyId);
+
+    VirtualKeyboard w_keyboard;
+    QCOMPARE(w_keyboard.initialisation(NULL, "EN", true, false, renderMode), VIRTUALKEYBOARD_SUCCESS);
+    w_keyboard.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&w_keyboard));
+
+    QBENCHMARK
+    {
+        // On then off, each toggle being repainted
+        w_keyboard.pressKey(keyId);
+        w_keyboard.repaint();
+        w_keyboard.pressKey(keyId);
+        w_keyboard.repaint();
+    }
+}
+
+
+void BENCH_VirtualKeyboard::languageSwitch_data()
+{
+    this->initialisation_data();
+}
+
+
+void BENCH_VirtualKeyboard::languageSwitch()
+{
+    QFETCH(int, renderMode);
+
+    VirtualKeyboard w_keyboard;
+    QCOMPARE(w_keyboard.initialisation(NULL, "EN", true, false, renderMode), VIRTUALKEYBOARD_SUCCESS);
+    w_keyboard.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&w_keyboard));
+
+    QBENCHMARK
+    {
+        // FR then back to EN, each switch being repainted
+        QCOMPARE(w_keyboard.setLanguage("FR"), VIRTUALKEYBOARD_SUCCESS);
+        w_keyboard.repaint();
+        QCOMPARE(w_keyboard.setLanguage("EN"), VIRTUALKEYBOARD_SUCCESS);
+        w_keyboard.repaint();
+    }
+}
+
+
+void BENCH_VirtualKeyboard::keyPressed_data()
+{
+    QTest::addColumn<QString>("inputType");
+
+    QTest::newRow("QLineEdit")          << "QLineEdit";
+    QTest::newRow("QTextEdit")          << "QTextEdit";
+    QTest::newRow("QPlainTextEdit")     << "QPlainTextEdit";
+    QTest::newRow("QComboBox")          << "QComboBox";
+}
+
+
+void BENCH_VirtualKeyboard::keyPressed()
+{
+    QFETCH(QString, inputType);
+
+    QScopedPointer<QWidget> w_input(createInputWidget(inputType));
+    QLineEdit *w_lineEdit = qobject_cast<QComboBox *>(w_input.data()) ? qobject_cast<QComboBox *>(w_input.data())->lineEdit()
+                                                                      : qobject_cast<QLineEdit *>(w_input.data());
+
+    VirtualKeyboard w_keyboard;
+    QCOMPARE(w_keyboard.initialisation(w_input.data()), VIRTUALKEYBOARD_SUCCESS);
+
+    int i_count = 0;
+
+    QBENCHMARK
+    {
+        w_keyboard.pressKey(0);
+
+        if (w_lineEdit != NULL && ++i_count % BENCH_LINEEDIT_CLEARPERIOD == 0) w_lineEdit->clear();
+    }
+}
+
+
+void BENCH_VirtualKeyboard::inputTargetDispatch_data()
+{
+    this->keyPressed_data();
+}
+
+
+void BENCH_VirtualKeyboard::inputTargetDispatch()
+{
+    QFETCH(QString, inputType);
+
+    QScopedPointer<QWidget> w_input(createInputWidget(inputType));
+    QScopedPointer<VirtualKeyboardInputTarget> po_inputTarget(VirtualKeyboardInputTarget::create(w_input.data()));
+    QVERIFY(po_inputTarget);
+
+    QBENCHMARK
+    {
+        // The document stays empty : only the dispatch and the widget edit are measured
+        po_inputTarget->insertText("a");
+        po_inputTarget->deletePreviousChar();
+    }
+}
+
+
+void BENCH_VirtualKeyboard::backspaceLargeDocument_data()
+{
+    QTest::addColumn<QString>("inputType");
+    QTest::addColumn<int>("documentSize");
+
+    QTest::newRow("QTextEdit/100k")         << "QTextEdit"      << 100000;
+    QTest::newRow("QTextEdit/1M")           << "QTextEdit"      << 1000000;
+    QTest::newRow("QPlainTextEdit/100k")    << "QPlainTextEdit" << 100000;
+    QTest::newRow("QPlainTextEdit/1M")      << "QPlainTextEdit" << 1000000;
+}
+
+
+void BENCH_VirtualKeyboard::backspaceLargeDocument()
+{
+    QFETCH(QString, inputType);
+    QFETCH(int, documentSize);
+
+    // Lines of 80 characters
+    QString s_line = QString(79, 'x') + '\n';
+    QString s_text;
+    s_text.reserve(documentSize);
+    while (s_text.size() < documentSize) s_text += s_line;
+
+    QScopedPointer<QWidget> w_input(createInputWidget(inputType));
+
+    if (QTextEdit *w_textEdit = qobject_cast<QTextEdit *>(w_input.data()))
+    {
+        w_textEdit->setPlainText(s_text);
+        w_textEdit->moveCursor(QTextCursor::End);
+    }
+    else if (QPlainTextEdit *w_plainTextEdit = qobject_cast<QPlainTextEdit *>(w_input.data()))
+    {
+        w_plainTextEdit->setPlainText(s_text);
+        w_plainTextEdit->moveCursor(QTextCursor::End);
+    }
+
+    VirtualKeyboard w_keyboard;
+    QCOMPARE(w_keyboard.initialisation(w_input.data()), VIRTUALKEYBOARD_SUCCESS);
+
+    QBENCHMARK
+    {
+        w_keyboard.pressKey(VIRTUALKEYBOARD_KEY_BACKSPACE);
+    }
+}
+
+
+void BENCH_VirtualKeyboard::typingBurst_data()
+{
+    QTest::addColumn<QString>("inputType");
+    QTest::addColumn<bool>("isCoalesced");
+
+    const QStringList lists_inputTypes = QStringList() << "QLineEdit" << "QTextEdit" << "QPlainTextEdit" << "QComboBox";
+
+    for (int i_i = 0; i_i < lists_inputTypes.size(); ++i_i)
+    {
+        QTest::newRow(qPrintable(lists_inputTypes.at(i_i) + "/direct"))     << lists_inputTypes.at(i_i) << false;
+        QTest::newRow(qPrintable(lists_inputTypes.at(i_i) + "/coalesced"))  << lists_inputTypes.at(i_i) << true;
+    }
+}
+
+
+void BENCH_VirtualKeyboard::typingBurst()
+{
+    QFETCH(QString, inputType);
+    QFETCH(bool, isCoalesced);
+
+    QScopedPointer<QWidget> w_input(createInputWidget(inputType));
+    QLineEdit *w_lineEdit = qobject_cast<QComboBox *>(w_input.data()) ? qobject_cast<QComboBox *>(w_input.data())->lineEdit()
+                                                                      : qobject_cast<QLineEdit *>(w_input.data());
+
+    // The text edits hold a formatted document : every edit costs a relayout of the block and a contentsChanged
+    QString s_html;
+    while (s_html.size() < BENCH_BURST_DOCUMENTSIZE) s_html += "<p>Lorem <b>ipsum</b> dolor <i>sit</i> amet, consectetur adipiscing elit.</p>";
+
+    if (QTextEdit *w_textEdit = qobject_cast<QTextEdit *>(w_input.data()))
+    {
+        w_textEdit->setHtml(s_html);
+        w_textEdit->moveCursor(QTextCursor::End);
+    }
+    else if (QPlainTextEdit *w_plainTextEdit = qobject_cast<QPlainTextEdit *>(w_input.data()))
+    {
+        w_plainTextEdit->setPlainText(s_html);
+        w_plainTextEdit->moveCursor(QTextCursor::End);
+    }
+
+    VirtualKeyboard w_keyboard;
+    QCOMPARE(w_keyboard.initialisation(w_input.data()), VIRTUALKEYBOARD_SUCCESS);
+    w_keyboard.setCoalescing(isCoalesced);
+
+    int i_count = 0;
+
+    QBENCHMARK
+    {
+        for (int i_i = 0; i_i < BENCH_BURST_KEYCOUNT; ++i_i)
+            w_keyboard.pressKey(0);
+
+        // The frame ends : nothing is left buffered from an iteration to the next
+        w_keyboard.flushCoalescedKeys();
+
+        i_count += BENCH_BURST_KEYCOUNT;
+        if (w_lineEdit != NULL && i_count >= BENCH_LINEEDIT_CLEARPERIOD)
+        {
+            w_lineEdit->clear();
+            i_count = 0;
+        }
+    }
+}
+
+
+void BENCH_VirtualKeyboard::largeDocumentTyping_data()
+{
+    QTest::addColumn<QString>("inputType");
+    QTest::addColumn<int>("documentSize");
+    QTest::addColumn<bool>("isLargeDocumentMode");
+
+    const QStringList lists_inputTypes = QStringList() << "QPlainTextEdit" << "QTextEdit";
+    const QList<int> listi_sizes = QList<int>() << 1000000 << 10000000 << 50000000;
+
+    for (int i_i = 0; i_i < lists_inputTypes.size(); ++i_i)
+    {
+        for (int i_j = 0; i_j < listi_sizes.size(); ++i_j)
+        {
+            const QString s_row = QString("%1/%2M").arg(lists_inputTypes.at(i_i)).arg(listi_sizes.at(i_j) / 1000000);
+
+            QTest::newRow(qPrintable(s_row + "/standard"))  << lists_inputTypes.at(i_i) << listi_sizes.at(i_j) << false;
+            QTest::newRow(qPrintable(s_row + "/large"))     << lists_inputTypes.at(i_i) << listi_sizes.at(i_j) << true;
+        }
+    }
+}
+
+
+void BENCH_VirtualKeyboard::largeDocumentTyping()
+{
+    QFETCH(QString, inputType);
+    QFETCH(int, documentSize);
+    QFETCH(bool, isLargeDocumentMode);
+
+    // Log-like document : lines of 80 characters
+    QString s_text;
+    s_text.reserve(documentSize);
+    const QString s_line = QString(79, 'x') + '\n';
+    while (s_text.size() < documentSize) s_text += s_line;
+
+    QScopedPointer<QWidget> w_input(createInputWidget(inputType));
+
+    if (QTextEdit *w_textEdit = qobject_cast<QTextEdit *>(w_input.data()))
+    {
+        w_textEdit->setPlainText(s_text);
+        w_textEdit->moveCursor(QTextCursor::End);
+    }
+    else if (QPlainTextEdit *w_plainTextEdit = qobject_cast<QPlainTextEdit *>(w_input.data()))
+    {
+        w_plainTextEdit->setPlainText(s_text);
+        w_plainTextEdit->moveCursor(QTextCursor::End);
+    }
+    s_text.clear();
+
+    w_input->show();
+    QVERIFY(QTest::qWaitForWindowExposed(w_input.data()));
+
+    VirtualKeyboard w_keyboard;
+    QCOMPARE(w_keyboard.initialisation(w_input.data()), VIRTUALKEYBOARD_SUCCESS);
+    w_keyboard.setLargeDocumentThreshold(isLargeDocumentMode ? 0 : -1);
+
+    // Single run : the documents are too large to be edited again and again by QBENCHMARK
+    QElapsedTimer o_timer;
+    o_timer.start();
+
+    for (int i_i = 0; i_i < BENCH_LARGEDOCUMENT_KEYCOUNT; ++i_i)
+    {
+        w_keyboard.pressKey(0);
+        if (i_i % BENCH_LARGEDOCUMENT_FRAMEPERIOD == 0) QCoreApplication::processEvents();
+    }
+    for (int i_i = 0; i_i < BENCH_LARGEDOCUMENT_KEYCOUNT; ++i_i)
+    {
+        w_keyboard.pressKey(VIRTUALKEYBOARD_KEY_BACKSPACE);
+        if (i_i % BENCH_LARGEDOCUMENT_FRAMEPERIOD == 0) QCoreApplication::processEvents();
+    }
+    QCoreApplication::processEvents();
+
+    const qint64 i_elapsed = o_timer.nsecsElapsed();
+
+    QTest::setBenchmarkResult(qreal(i_elapsed) / (2 * BENCH_LARGEDOCUMENT_KEYCOUNT), QTest::WalltimeNanoseconds);
+}
+
+
+void BENCH_VirtualKeyboard::undoMemory_data()
+{
+    QTest::addColumn<QString>("inputType");
+    QTest::addColumn<bool>("isGrouped");
+    QTest::addColumn<int>("undoClearThreshold");
+
+    QTest::newRow("QTextEdit/ungrouped")        << "QTextEdit"      << false  << 0;
+    QTest::newRow("QTextEdit/grouped")          << "QTextEdit"      << true   << 0;
+    QTest::newRow("QTextEdit/cleared")          << "QTextEdit"      << true   << BENCH_UNDO_CLEARTHRESHOLD;
+    QTest::newRow("QPlainTextEdit/ungrouped")   << "QPlainTextEdit" << false  << 0;
+    QTest::newRow("QPlainTextEdit/grouped")     << "QPlainTextEdit" << true   << 0;
+    QTest::newRow("QPlainTextEdit/cleared")     << "QPlainTextEdit" << true   << BENCH_UNDO_CLEARTHRESHOLD;
+}
+
+
+void BENCH_VirtualKeyboard::undoMemory()
+{
+#ifndef BENCH_HAS_ALLOCATIONCOUNT
+    QSKIP("Measuring the heap needs glibc");
+#else
+    QFETCH(QString, inputType);
+    QFETCH(bool, isGrouped);
+    QFETCH(int, undoClearThreshold);
+
+    QScopedPointer<QWidget> w_input(createInputWidget(inputType));
+    VirtualKeyboard w_keyboard;
+    QCOMPARE(w_keyboard.initialisation(w_input.data()), VIRTUALKEYBOARD_SUCCESS);
+
+    QByteArray ba_trace = undoSession();
+    QBuffer o_buffer(&ba_trace);
+    o_buffer.open(QIODevice::ReadOnly);
+
+    VirtualKeyboardTraceReplayer o_replayer(&w_keyboard);
+    QVERIFY(o_replayer.load(&o_buffer));
+
+    // --- Replay, the heap is measured around it (the document grows the same way in every row)
+    w_keyboard.setUndoGrouping(isGrouped);
+    w_keyboard.setUndoClearThreshold(undoClearThreshold);
+
+    const qint64 i_heapBefore = heapInUse();
+    o_replayer.replay(VIRTUALKEYBOARDTRACE_REPLAY_FAST);
+    const qint64 i_heapAfter = heapInUse();
+
+    QTest::setBenchmarkResult(qreal(i_heapAfter - i_heapBefore), QTest::BytesAllocated);
+#endif
+}
+
+
+void BENCH_VirtualKeyboard::undoSteps_data()
+{
+    this->undoMemory_data();
+}
+
+
+void BENCH_VirtualKeyboard::undoSteps()
+{
+    QFETCH(QString, inputType);
+    QFETCH(bool, isGrouped);
+    QFETCH(int, undoClearThreshold);
+
+    QScopedPointer<QWidget> w_input(createInputWidget(inputType));
+    VirtualKeyboard w_keyboard;
+    QCOMPARE(w_keyboard.initialisation(w_input.data()), VIRTUALKEYBOARD_SUCCESS);
+
+    QByteArray ba_trace = undoSession();
+    QBuffer o_buffer(&ba_trace);
+    o_buffer.open(QIODevice::ReadOnly);
+
+    VirtualKeyboardTraceReplayer o_replayer(&w_keyboard);
+    QVERIFY(o_replayer.load(&o_buffer));
+
+    w_keyboard.setUndoGrouping(isGrouped);
+    w_keyboard.setUndoClearThreshold(undoClearThreshold);
+    o_replayer.replay(VIRTUALKEYBOARDTRACE_REPLAY_FAST);
+
+    QTextDocument *po_document = qobject_cast<QTextEdit *>(w_input.data()) ? qobject_cast<QTextEdit *>(w_input.data())->document()
+                                                                           : qobject_cast<QPlainTextEdit *>(w_input.data())->document();
+
+    // --- Steps left to undo at the end of the session
+    const int i_undoSteps = po_document->availableUndoSteps();
+    QTest::setBenchmarkResult(i_undoSteps, QTest::Events);
+
+    // --- Every step undone : back to the empty document, unless the threshold cleared the stack on the way (the first words are kept)
+    while (po_document->isUndoAvailable()) po_document->undo();
+
+    if (undoClearThreshold > 0)
+    {
+        QVERIFY(i_undoSteps <= undoClearThreshold);
+        QVERIFY(!po_document->isEmpty());
+    }
+    else
+    {
+        QVERIFY(po_document->isEmpty());
+    }
+}
+
+
+void BENCH_VirtualKeyboard::pasteStall_data()
+{
+    QTest::addColumn<QString>("inputType");
+    QTest::addColumn<bool>("isStreamed");
+
+    QTest::newRow("QTextEdit/direct")           << "QTextEdit"      << false;
+    QTest::newRow("QTextEdit/streamed")         << "QTextEdit"      << true;
+    QTest::newRow("QPlainTextEdit/direct")      << "QPlainTextEdit" << false;
+    QTest::newRow("QPlainTextEdit/streamed")    << "QPlainTextEdit" << true;
+}
+
+
+void BENCH_VirtualKeyboard::pasteStall()
+{
+    QFETCH(QString, inputType);
+    QFETCH(bool, isStreamed);
+
+    QString s_text;
+    s_text.reserve(BENCH_PASTE_SIZE);
+    const QString s_line = QString(79, 'x') + '\n';
+    while (s_text.size() < BENCH_PASTE_SIZE) s_text += s_line;
+    QApplication::clipboard()->setText(s_text);
+    if (QApplication::clipboard()->text().size() != s_text.size()) QSKIP("The platform has no clipboard");
+
+    QScopedPointer<QWidget> w_input(createInputWidget(inputType));
+    w_input->show();
+    QVERIFY(QTest::qWaitForWindowExposed(w_input.data()));
+
+    VirtualKeyboard w_keyboard;
+    QCOMPARE(w_keyboard.initialisation(w_input.data()), VIRTUALKEYBOARD_SUCCESS);
+    w_keyboard.setStreamingPaste(isStreamed);
+
+    // Longest time the event loop is blocked : the paste key, then each event loop pass until the paste is finished
+    QElapsedTimer o_timer;
+    o_timer.start();
+    w_keyboard.pressKey(VIRTUALKEYBOARD_KEY_PASTE);
+    qint64 i_longestStall = o_timer.nsecsElapsed();
+
+    while (w_keyboard.isPasting())
+    {
+        o_timer.restart();
+        QCoreApplication::processEvents();
+        i_longestStall = qMax(i_longestStall, o_timer.nsecsElapsed());
+    }
+
+    QTest::setBenchmarkResult(qreal(i_longestStall) / 1000000, QTest::WalltimeMilliseconds);
+
+    if (!isStreamed) return;
+
+    // --- A key typed during the paste cancels it : the rest of the clipboard does not follow the key
+    QTextDocument *po_document = qobject_cast<QTextEdit *>(w_input.data()) ? qobject_cast<QTextEdit *>(w_input.data())->document()
+                                                                           : qobject_cast<QPlainTextEdit *>(w_input.data())->document();
+    QSignalSpy o_canceledSpy(&w_keyboard, SIGNAL(pasteCanceled(int,int)));
+
+    w_keyboard.pressKey(VIRTUALKEYBOARD_KEY_PASTE);
+    QCoreApplication::processEvents();
+    QVERIFY(w_keyboard.isPasting());
+    w_keyboard.pressKey(VIRTUALKEYBOARD_KEY_SPACE);
+    QVERIFY(!w_keyboard.isPasting());
+    QCOMPARE(o_canceledSpy.count(), 1);
+
+    const int i_characterCount = po_document->characterCount();
+    QCoreApplication::processEvents();
+    QCOMPARE(po_document->characterCount(), i_characterCount);
+    QVERIFY(po_document->toPlainText().endsWith(' '));
+
+    // --- So does a move of the cursor by something else than the keyboard
+    w_keyboard.pressKey(VIRTUALKEYBOARD_KEY_PASTE);
+    QVERIFY(w_keyboard.isPasting());
+    QTextCursor o_cursor(po_document);
+    o_cursor.movePosition(QTextCursor::Start);
+    if (QTextEdit *w_textEdit = qobject_cast<QTextEdit *>(w_input.data()))  w_textEdit->setTextCursor(o_cursor);
+    else                                                                    qobject_cast<QPlainTextEdit *>(w_input.data())->setTextCursor(o_cursor);
+    QVERIFY(!w_keyboard.isPasting());
+    QCOMPARE(o_canceledSpy.count(), 2);
+}
+
+
+void BENCH_VirtualKeyboard::secondaryKeysChurn_data()
+{
+    QTest::addColumn<int>("renderMode");
+
+    QTest::newRow("widgets") << VIRTUALKEYBOARD_RENDER_WIDGETS;
+    QTest::newRow("painted") << VIRTUALKEYBOARD_RENDER_PAINTED;
+}
+
+
+void BENCH_VirtualKeyboard::secondaryKeysChurn()
+{
+    QFETCH(int, renderMode);
+
+    VirtualKeyboard w_keyboard;
+    QCOMPARE(w_keyboard.initialisation(NULL, "EN", true, false, renderMode), VIRTUALKEYBOARD_SUCCESS);
+    w_keyboard.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&w_keyboard));
+
+    QBENCHMARK
+    {
+        for (int i_i = 0; i_i < BENCH_SECONDARYKEYS_COUNT; ++i_i)
+            w_keyboard.addSecondaryKey("Key " + QString::number(i_i), i_i);
+        QCoreApplication::processEvents();
+
+        for (int i_i = 0; i_i < BENCH_SECONDARYKEYS_COUNT; ++i_i)
+            w_keyboard.removeSecondaryKey(i_i);
+        QCoreApplication::processEvents();
+    }
+}
+
+void BENCH_VirtualKeyboard::secondaryKeysSwap_data()
+{
+    QTest::addColumn<QString>("method");
+
+    QTest::newRow("individual")         << "individual";
+    QTest::newRow("batched")            << "batched";
+    QTest::newRow("setSecondaryKeys")   << "setSecondaryKeys";
+}
+
+
+void BENCH_VirtualKeyboard::secondaryKeysSwap()
+{
+    QFETCH(QString, method);
+
+    VirtualKeyboard w_keyboard;
+    QCOMPARE(w_keyboard.initialisation(NULL, "EN", true, false), VIRTUALKEYBOARD_SUCCESS);
+    w_keyboard.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&w_keyboard));
+
+    // Two screens : sets of keys sharing half of their indexes, with other labels
+    QMap<int, QString> tmaps_screens[2];
+    for (int i_i = 0; i_i < BENCH_SECONDARYKEYS_COUNT; ++i_i)
+    {
+        tmaps_screens[0].insert(i_i, "Macro " + QString::number(i_i));
+        tmaps_screens[1].insert(i_i + BENCH_SECONDARYKEYS_COUNT / 2, "Screen " + QString::number(i_i));
+    }
+
+    int i_screen = 0;
+
+    QBENCHMARK
+    {
+        const QMap<int, QString> &maps_current = tmaps_screens[i_screen];
+        const QMap<int, QString> &maps_next = tmaps_screens[1 - i_screen];
+
+        if (method == "setSecondaryKeys")
+        {
+            w_keyboard.setSecondaryKeys(maps_next);
+        }
+        else
+        {
+            if (method == "batched") w_keyboard.beginSecondaryKeysUpdate();
+
+            for (QMap<int, QString>::const_iterator it_key = maps_current.constBegin(); it_key != maps_current.constEnd(); ++it_key)
+                w_keyboard.removeSecondaryKey(it_key.key());
+            for (QMap<int, QString>::const_iterator it_key = maps_next.constBegin(); it_key != maps_next.constEnd(); ++it_key)
+                w_keyboard.addSecondaryKey(it_key.value(), it_key.key());
+
+            if (method == "batched") w_keyboard.endSecondaryKeysUpdate();
+        }
+        QCoreApplication::processEvents();
+
+        i_screen = 1 - i_screen;
+    }
+}
+
+
+void BENCH_VirtualKeyboard::secondaryKeysMany_data()
+{
+    QTest::addColumn<int>("renderMode");
+    QTest::addColumn<int>("keyCount");
+
+    QTest::newRow("widgets/100")    << VIRTUALKEYBOARD_RENDER_WIDGETS << 100;
+    QTest::newRow("widgets/1000")   << VIRTUALKEYBOARD_RENDER_WIDGETS << 1000;
+    QTest::newRow("painted/100")    << VIRTUALKEYBOARD_RENDER_PAINTED << 100;
+    QTest::newRow("painted/1000")   << VIRTUALKEYBOARD_RENDER_PAINTED << 1000;
+}
+
+
+void BENCH_VirtualKeyboard::secondaryKeysMany()
+{
+    QFETCH(int, renderMode);
+    QFETCH(int, keyCount);
+
+    VirtualKeyboard w_keyboard;
+    QCOMPARE(w_keyboard.initialisation(NULL, "EN", true, false, renderMode), VIRTUALKEYBOARD_SUCCESS);
+    w_keyboard.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&w_keyboard));
+
+    QMap<int, QString> maps_keys;
+    for (int i_i = 0; i_i < keyCount; ++i_i)
+        maps_keys.insert(i_i, "Shortcut " + QString::number(i_i));
+
+    // Display of the whole set, then a key added and removed with the set displayed
+    QBENCHMARK
+    {
+        w_keyboard.setSecondaryKeys(maps_keys);
+        w_keyboard.repaint();
+
+        w_keyboard.addSecondaryKey("Extra", keyCount);
+        QCoreApplication::processEvents();
+        w_keyboard.removeSecondaryKey(keyCount);
+        QCoreApplication::processEvents();
+
+        w_keyboard.setSecondaryKeys(QMap<int, QString>());
+        QCoreApplication::processEvents();
+    }
+}
+
+
+void BENCH_VirtualKeyboard::snippetMemory_data()
+{
+    QTest::addColumn<int>("keyboardCount");
+
+    QTest::newRow("1 keyboard")     << 1;
+    QTest::newRow("4 keyboards")    << 4;
+}
+
+
+void BENCH_VirtualKeyboard::snippetMemory()
+{
+#ifndef BENCH_HAS_ALLOCATIONCOUNT
+    QSKIP("Measuring the heap needs glibc");
+#else
+    QFETCH(int, keyboardCount);
+
+    // Painted mode : the keys cost no button, the heap measured is mostly the snippets
+    QList<VirtualKeyboard *> listw_keyboards;
+    for (int i_i = 0; i_i < keyboardCount; ++i_i)
+    {
+        listw_keyboards.append(new VirtualKeyboard());
+        QCOMPARE(listw_keyboards.last()->initialisation(NULL, "EN", true, false, VIRTUALKEYBOARD_RENDER_PAINTED), VIRTUALKEYBOARD_SUCCESS);
+    }
+
+    // Texts as a configuration file would give them : each keyboard decodes its own strings
+    QByteArray ba_configuration;
+    for (int i_key = 0; i_key < BENCH_SNIPPET_KEYCOUNT; ++i_key)
+    {
+        QByteArray ba_snippet = QByteArray::number(i_key) + " {cursor}";
+        ba_configuration += ba_snippet.leftJustified(BENCH_SNIPPET_SIZE, '.') + '\n';
+    }
+
+    const qint64 i_heapBefore = heapInUse();
+    for (int i_i = 0; i_i < keyboardCount; ++i_i)
+    {
+        const QList<QByteArray> listba_snippets = ba_configuration.split('\n');
+
+        for (int i_key = 0; i_key < BENCH_SNIPPET_KEYCOUNT; ++i_key)
+            listw_keyboards.at(i_i)->addSnippetKey(QString::number(i_key), i_key, QString::fromUtf8(listba_snippets.at(i_key)));
+    }
+    const qint64 i_heapAfter = heapInUse();
+
+    QCOMPARE(VirtualKeyboardSnippet::poolSize(), BENCH_SNIPPET_KEYCOUNT);
+
+    qDeleteAll(listw_keyboards);
+    QCOMPARE(VirtualKeyboardSnippet::poolSize(), 0);
+
+    QTest::setBenchmarkResult(qreal(i_heapAfter - i_heapBefore), QTest::BytesAllocated);
+#endif
+}
+
+
+void BENCH_VirtualKeyboard::predictionLookup_data()
+{
+    QTest::addColumn<int>("prefixLength");
+
+    QTest::newRow("1 character")    << 1;
+    QTest::newRow("2 characters")   << 2;
+    QTest::newRow("3 characters")   << 3;
+    QTest::newRow("5 characters")   << 5;
+}
+
+
+void BENCH_VirtualKeyboard::predictionLookup()
+{
+    QFETCH(int, prefixLength);
+
+    const QString s_fileName = predictionDictionary();
+    QVERIFY(!s_fileName.isEmpty());
+
+    const VirtualKeyboardDictionary *po_dictionary = VirtualKeyboardDictionary::find(s_fileName);
+    QVERIFY(po_dictionary != NULL);
+    QCOMPARE(po_dictionary->wordCount(), BENCH_PREDICTION_WORDCOUNT);
+
+    // Prefixes of words spread over the dictionary, from the most to the least frequent
+    QStringList lists_prefixes;
+    for (int i_i = 0; i_i < BENCH_PREDICTION_PREFIXCOUNT; ++i_i)
+        lists_prefixes.append(predictionWord(i_i * 7919 % BENCH_PREDICTION_WORDCOUNT).left(prefixLength));
+
+    // One lookup per iteration : the time of a keystroke
+    int i_prefix = 0;
+    QBENCHMARK
+    {
+        po_dictionary->completions(lists_prefixes.at(i_prefix), VIRTUALKEYBOARD_PREDICTION_SUGGESTIONCOUNT);
+        i_prefix = (i_prefix + 1) % lists_prefixes.size();
+    }
+}
+
+
+void BENCH_VirtualKeyboard::predictionTyping_data()
+{
+    QTest::addColumn<bool>("isPredictionOn");
+
+    QTest::newRow("without prediction") << false;
+    QTest::newRow("with prediction")    << true;
+}
+
+
+void BENCH_VirtualKeyboard::predictionTyping()
+{
+    QFETCH(bool, isPredictionOn);
+
+    QLineEdit w_lineEdit;
+    VirtualKeyboard w_keyboard;
+    QCOMPARE(w_keyboard.initialisation(&w_lineEdit), VIRTUALKEYBOARD_SUCCESS);
+
+    if (isPredictionOn)
+    {
+        const QString s_fileName = predictionDictionary();
+        QVERIFY(!s_fileName.isEmpty());
+        QVERIFY(w_keyboard.setPredictionDictionary(s_fileName));
+    }
+
+    int i_count = 0;
+
+    // Each key press is followed by the event loop pass which checks the word before the cursor
+    QBENCHMARK
+    {
+        w_keyboard.pressKey(0);
+        QCoreApplication::processEvents();
+
+        if (++i_count % BENCH_LINEEDIT_CLEARPERIOD == 0) w_lineEdit.clear();
+    }
+}
+
+
+void BENCH_VirtualKeyboard::startupTime_data()
+{
+    QTest::addColumn<bool>("isAsynchronous");
+    QTest::addColumn<bool>("isWarm");
+
+    QTest::newRow("synchronous/cold")   << false << false;
+    QTest::newRow("synchronous/warm")   << false << true;
+    QTest::newRow("asynchronous/cold")  << true  << false;
+    QTest::newRow("asynchronous/warm")  << true  << true;
+}
+
+
+void BENCH_VirtualKeyboard::startupTime()
+{
+    QFETCH(bool, isAsynchronous);
+    QFETCH(bool, isWarm);
+
+    // A language and a dictionary which have not been loaded yet (they are cached by the process), both sources compiled at load
+    static int si_startupCount = 0;
+    const QString s_language = QString("STARTUP%1").arg(++si_startupCount);
+
+    QTemporaryDir o_directory;
+    QVERIFY(o_directory.isValid());
+
+    QFile o_source(QFINDTESTDATA("../keymaps/EN.vkm"));
+    QVERIFY(o_source.open(QIODevice::ReadOnly));
+
+    QFile o_keymap(o_directory.path() + "/" + s_language + VIRTUALKEYBOARD_KEYMAP_SOURCESUFFIX);
+    QVERIFY(o_keymap.open(QIODevice::WriteOnly));
+    QVERIFY(o_keymap.write(o_source.readAll()) > 0);
+    o_keymap.close();
+
+    VirtualKeyboardKeymap::addSearchPath(o_directory.path());
+
+    QString s_words;
+    for (int i_rank = 0; i_rank < BENCH_STARTUP_WORDCOUNT; ++i_rank)
+        s_words += predictionWord(i_rank) + QLatin1Char(' ') + QString::number(BENCH_STARTUP_WORDCOUNT - i_rank) + QLatin1Char('\n');
+
+    QFile o_dictionary(o_directory.path() + QLatin1String("/BENCH" VIRTUALKEYBOARD_DICTIONARY_SOURCESUFFIX));
+    QVERIFY(o_dictionary.open(QIODevice::WriteOnly));
+    QVERIFY(o_dictionary.write(s_words.toUtf8()) > 0);
+    o_dictionary.close();
+
+    // Warm start : loaded by a previous keyboard of the process
+    if (isWarm)
+    {
+        QVERIFY(VirtualKeyboardKeymap::find(s_language) != NULL);
+        QVERIFY(VirtualKeyboardDictionary::find(o_dictionary.fileName()) != NULL);
+    }
+
+    QLineEdit w_lineEdit;
+    VirtualKeyboard w_keyboard;
+    QSignalSpy o_readySpy(&w_keyboard, SIGNAL(ready()));
+    w_keyboard.setAsynchronousLoading(isAsynchronous);
+
+    // Time during which the application can not paint its first frame
+    QElapsedTimer o_timer;
+    o_timer.start();
+
+    QCOMPARE(w_keyboard.initialisation(&w_lineEdit, s_language), VIRTUALKEYBOARD_SUCCESS);
+    QVERIFY(w_keyboard.setPredictionDictionary(o_dictionary.fileName()));
+
+    const qint64 i_elapsed = o_timer.nsecsElapsed();
+
+    // The language and the dictionary are in use in the end, whatever the loading
+    if (isAsynchronous) QTRY_VERIFY_WITH_TIMEOUT(o_readySpy.count() > 0 && w_keyboard.isReady(), 60000);
+    QCOMPARE(w_keyboard.language(), s_language);
+
+    QTest::setBenchmarkResult(qreal(i_elapsed) / 1000000, QTest::WalltimeMilliseconds);
+}
+
+
+void BENCH_VirtualKeyboard::tapCorrection_data()
+{
+    QTest::addColumn<int>("firstRank");
+
+    // Short frequent words, longer rare words
+    QTest::newRow("frequent words") << 20;
+    QTest::newRow("rare words")     << 100000;
+}
+
+
+void BENCH_VirtualKeyboard::tapCorrection()
+{
+    QFETCH(int, firstRank);
+
+    const QString s_fileName = predictionDictionary();
+    QVERIFY(!s_fileName.isEmpty());
+
+    const VirtualKeyboardDictionary *po_dictionary = VirtualKeyboardDictionary::find(s_fileName);
+    QVERIFY(po_dictionary != NULL);
+
+    // --- Letters of the EN keymap, laid out like the painted keyboard
+    const VirtualKeyboardKeymap *po_keymap = VirtualKeyboardKeymap::find("EN");
+    QVERIFY(po_keymap != NULL);
+
+    VirtualKeyboardGeometry o_geometry;
+    o_geometry.layout(QSizeF(800, 250), po_keymap, VIRTUALKEYBOARD_LAYER_LOWER);
+
+    QString s_characters;
+    QVector<QRectF> veco_rects;
+    letterKeys(o_geometry, po_keymap, &s_characters, &veco_rects);
+
+    VirtualKeyboardTapModel o_model;
+    o_model.setKeys(s_characters, veco_rects);
+    QCOMPARE(o_model.keyCount(), 26);
+
+    // --- Words of the dictionary, each letter tapped off the centre of its key (towards the left and the right in turn) :
+    // the words typed are made of the letters of the keys hit
+    QStringList lists_words;
+    QVector<QVector<QPointF> > vecveco_taps;
+
+    for (int i_i = 0; i_i < BENCH_TAPCORRECTION_WORDCOUNT; ++i_i)
+    {
+        const QString s_word = predictionWord(firstRank + i_i * 7);
+        QString s_typed = s_word;
+        QVector<QPointF> veco_taps;
+
+        for (int i_char = 0; i_char < s_word.size(); ++i_char)
+        {
+            const QRectF o_rect = veco_rects.at(s_characters.indexOf(s_word.at(i_char)));
+            const qreal r_offset = (i_char % 2 == 0 ? 1 : -1) * BENCH_TAPCORRECTION_OFFSET * o_rect.width();
+            const QPointF o_tap = o_rect.center() + QPointF(r_offset, 0);
+
+            const int i_keyId = o_geometry.keyAt(o_tap);
+            const QString s_key = i_keyId >= 0 ? po_keymap->keyText(VIRTUALKEYBOARD_LAYER_LOWER, i_keyId) : QString();
+            if (s_key.size() == 1 && s_characters.contains(s_key.at(0))) s_typed[i_char] = s_key.at(0);
+
+            veco_taps.append(o_tap);
+        }
+
+        lists_words.append(s_typed);
+        vecveco_taps.append(veco_taps);
+    }
+
+    int i_word = 0;
+    QBENCHMARK
+    {
+        o_model.correct(vecveco_taps.at(i_word), lists_words.at(i_word), po_dictionary);
+        i_word = (i_word + 1) % lists_words.size();
+    }
+}
+
+
+void BENCH_VirtualKeyboard::gestureDecoding_data()
+{
+    QTest::addColumn<int>("firstRank");
+
+    // Short frequent words, longer rare words
+    QTest::newRow("frequent words") << 20;
+    QTest::newRow("rare words")     << 100000;
+}
+
+
+void BENCH_VirtualKeyboard::gestureDecoding()
+{
+    QFETCH(int, firstRank);
+
+    const QString s_fileName = predictionDictionary();
+    QVERIFY(!s_fileName.isEmpty());
+
+    const VirtualKeyboardDictionary *po_dictionary = VirtualKeyboardDictionary::find(s_fileName);
+    QVERIFY(po_dictionary != NULL);
+
+    // --- Letters of the EN keymap, laid out like the painted keyboard
+    const VirtualKeyboardKeymap *po_keymap = VirtualKeyboardKeymap::find("EN");
+    QVERIFY(po_keymap != NULL);
+
+    VirtualKeyboardGeometry o_geometry;
+    o_geometry.layout(QSizeF(800, 250), po_keymap, VIRTUALKEYBOARD_LAYER_LOWER);
+
+    QString s_characters;
+    QVector<QRectF> veco_rects;
+    letterKeys(o_geometry, po_keymap, &s_characters, &veco_rects);
+
+    VirtualKeyboardGestureDecoder o_decoder;
+    o_decoder.setKeys(s_characters, veco_rects);
+    QCOMPARE(o_decoder.keyCount(), 26);
+
+    // --- Paths to decode
+    QVector<QVector<QPointF> > vecveco_paths;
+    const QString s_pathFile = QString::fromLocal8Bit(qgetenv("VIRTUALKEYBOARD_GESTURES"));
+
+    if (!s_pathFile.isEmpty())
+    {
+        QFile o_file(s_pathFile);
+        QVERIFY2(o_file.open(QIODevice::ReadOnly | QIODevice::Text), qPrintable("Can not open " + s_pathFile));
+
+        while (!o_file.atEnd())
+        {
+            const QString s_line = QString::fromUtf8(o_file.readLine()).trimmed();
+            if (s_line.isEmpty() || s_line.startsWith(QLatin1Char('#'))) continue;
+
+            QVector<QPointF> veco_path;
+            foreach (const QString &s_point, s_line.split(QLatin1Char(' '), QString::SkipEmptyParts))
+            {
+                const QStringList lists_coordinates = s_point.split(QLatin1Char(','));
+                if (lists_coordinates.size() == 2) veco_path.append(QPointF(lists_coordinates.at(0).toDouble(), lists_coordinates.at(1).toDouble()));
+            }
+
+            if (veco_path.size() >= 2) vecveco_paths.append(veco_path);
+        }
+    }
+    else
+    {
+        // Paths recorded here : words of the dictionary traced through the centres of their keys, each corner off the centre
+        // (same offsets on every run), one point every BENCH_GESTURE_POINTSPACING pixels like the pointer events of a finger
+        quint32 i_seed = 1;
+
+        for (int i_i = 0; i_i < BENCH_GESTURE_WORDCOUNT; ++i_i)
+        {
+            const QString s_word = predictionWord(firstRank + i_i * 7);
+            QVector<QPointF> veco_corners;
+
+            for (int i_char = 0; i_char < s_word.size(); ++i_char)
+            {
+                if (i_char > 0 && s_word.at(i_char) == s_word.at(i_char - 1)) continue;
+
+                const QRectF o_rect = veco_rects.at(s_characters.indexOf(s_word.at(i_char)));
+                qreal tr_offsets[2];
+
+                for (int i_axis = 0; i_axis < 2; ++i_axis)
+                {
+                    i_seed = i_seed * 1103515245 + 12345;
+                    tr_offsets[i_axis] = BENCH_GESTURE_JITTER * (qreal((i_seed >> 16) & 0x7FFF) / 0x3FFF - 1);
+                }
+                veco_corners.append(o_rect.center() + QPointF(tr_offsets[0] * o_rect.width(), tr_offsets[1] * o_rect.height()));
+            }
+
+            QVector<QPointF> veco_path;
+            for (int i_corner = 0; i_corner + 1 < veco_corners.size(); ++i_corner)
+            {
+                const QLineF o_segment(veco_corners.at(i_corner), veco_corners.at(i_corner + 1));
+                const int i_pointCount = qMax(1, int(o_segment.length() / BENCH_GESTURE_POINTSPACING));
+
+                for (int i_point = 0; i_point < i_pointCount; ++i_point) veco_path.append(o_segment.pointAt(qreal(i_point) / i_pointCount));
+            }
+            veco_path.append(veco_corners.last());
+
+            if (veco_path.size() >= 2) vecveco_paths.append(veco_path);
+        }
+    }
+
+    QVERIFY(!vecveco_paths.isEmpty());
+
+    int i_path = 0;
+    QBENCHMARK
+    {
+        o_decoder.decode(vecveco_paths.at(i_path), po_dictionary, VIRTUALKEYBOARD_PREDICTION_SUGGESTIONCOUNT);
+        i_path = (i_path + 1) % vecveco_paths.size();
+    }
+}
+
+
+void BENCH_VirtualKeyboard::focusNavigation_data()
+{
+    QTest::addColumn<bool>("isScoped");
+
+    QTest::newRow("unscoped")   << false;
+    QTest::newRow("scoped")     << true;
+}
+
+
+void BENCH_VirtualKeyboard::focusNavigation()
+{
+    QFETCH(bool, isScoped);
+
+    // Form : line edits and buttons alternately, the keyboards are scoped to another subtree of the window in the "scoped" row
+    QWidget w_window;
+    QVBoxLayout *po_layout = new QVBoxLayout(&w_window);
+    QWidget *w_otherScope = new QWidget(&w_window);
+    QList<QWidget *> listw_formWidgets;
+
+    po_layout->addWidget(w_otherScope);
+    for (int i_i = 0; i_i < BENCH_FOCUS_WIDGETCOUNT; ++i_i)
+    {
+        QWidget *w_widget = (i_i % 2 == 0) ? static_cast<QWidget *>(new QLineEdit()) : new QPushButton("Button");
+        w_widget->setFocusPolicy(Qt::StrongFocus);
+        po_layout->addWidget(w_widget);
+        listw_formWidgets.append(w_widget);
+    }
+
+    QList<VirtualKeyboard *> listw_keyboards;
+    for (int i_i = 0; i_i < BENCH_FOCUS_KEYBOARDCOUNT; ++i_i)
+    {
+        VirtualKeyboard *w_keyboard = new VirtualKeyboard(&w_window);
+        QCOMPARE(w_keyboard->initialisation(NULL, "EN", true, false, VIRTUALKEYBOARD_RENDER_PAINTED), VIRTUALKEYBOARD_SUCCESS);
+        if (isScoped) w_keyboard->setFocusScope(w_otherScope);
+        listw_keyboards.append(w_keyboard);
+    }
+
+    w_window.show();
+    w_window.activateWindow();
+    if (!QTest::qWaitForWindowActive(&w_window)) QSKIP("The platform does not activate the windows");
+
+    QBENCHMARK
+    {
+        for (int i_i = 0; i_i < listw_formWidgets.size(); ++i_i)
+            listw_formWidgets.at(i_i)->setFocus();
+    }
+
+    QCOMPARE(listw_keyboards.first()->inputWidget(), isScoped ? static_cast<QWidget *>(NULL) : listw_formWidgets.at(BENCH_FOCUS_WIDGETCOUNT - 2));
+}
+
+
+void BENCH_VirtualKeyboard::replayTrace()
+{
+    QTextEdit w_textEdit;
+    VirtualKeyboard w_keyboard;
+    QCOMPARE(w_keyboard.initialisation(&w_textEdit), VIRTUALKEYBOARD_SUCCESS);
+
+    // --- Trace to replay
+    QByteArray ba_trace;
+    const QString s_traceFile = QString::fromLocal8Bit(qgetenv("VIRTUALKEYBOARD_TRACE"));
+
+    if (!s_traceFile.isEmpty())
+    {
+        QFile o_file(s_traceFile);
+        QVERIFY2(o_file.open(QIODevice::ReadOnly), qPrintable("Can not open " + s_traceFile));
+        ba_trace = o_file.readAll();
+    }
+    else
+    {
+        // Session recorded here : every principal key, caps lock, space and backspace
+        QBuffer o_buffer(&ba_trace);
+        o_buffer.open(QIODevice::WriteOnly);
+
+        VirtualKeyboardTraceRecorder o_recorder(&w_keyboard);
+        QVERIFY(o_recorder.start(&o_buffer));
+
+        for (int i_i = 0; i_i < 100; ++i_i)
+        {
+            for (int i_key = 0; i_key < 27; ++i_key) w_keyboard.pressKey(i_key);
+            w_keyboard.pressKey(VIRTUALKEYBOARD_KEY_SPACE);
+            w_keyboard.pressKey(VIRTUALKEYBOARD_KEY_CAPS);
+            w_keyboard.pressKey(VIRTUALKEYBOARD_KEY_BACKSPACE);
+        }
+        o_recorder.stop();
+    }
+
+    // --- Replay
+    QBuffer o_buffer(&ba_trace);
+    o_buffer.open(QIODevice::ReadOnly);
+
+    VirtualKeyboardTraceReplayer o_replayer(&w_keyboard);
+    QVERIFY(o_replayer.load(&o_buffer));
+    QVERIFY(!o_replayer.events().isEmpty());
+
+    QBENCHMARK
+    {
+        o_replayer.replay(VIRTUALKEYBOARDTRACE_REPLAY_FAST);
+    }
+}
+
+
+
+int main(int argc, char *argv[])
+{
+    // Headless by default
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+    BENCH_VirtualKeyboard o_benchmark;
+
+    return QTest::qExec(&o_benchmark, argc, argv);
+}
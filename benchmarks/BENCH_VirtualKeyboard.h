@@ -0,0 +1,226 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+#ifndef BENCH_VIRTUALKEYBOARD_H
+#define BENCH_VIRTUALKEYBOARD_H
+
+#include <QObject>
+#include <QtTest>
+
+#include "VirtualKeyboard.h"
+#include "VirtualKeyboardTrace.h"
+
+
+/**
+ * \brief Benchmarks of the hot paths of the virtual keyboard
+ *
+ * Run headless (the "offscreen" platform is used unless QT_QPA_PLATFORM is set).
+ * The results can be written in a machine-readable format with the QtTest options, for example :
+ *      BENCH_VirtualKeyboard -o results.xml,xml
+ *      BENCH_VirtualKeyboard -o results.csv,csv
+ */
+class BENCH_VirtualKeyboard : public QObject
+{
+    Q_OBJECT
+
+
+    // Private Functions
+private:
+
+    /**
+     * \brief Create an input widget of the type given
+     * \param[in] s_type : "QLineEdit", "QTextEdit", "QPlainTextEdit" or "QComboBox"
+     * \return The widget (editable for a QComboBox), to delete by the caller
+     */
+    static QWidget *createInputWidget(const QString &s_type);
+
+    /**
+     * \brief Get a compiled dictionary of BENCH_PREDICTION_WORDCOUNT words, written on first use in a temporary directory
+     * \return File name of the dictionary, empty if it can not be written
+     */
+    static QString predictionDictionary();
+
+    /**
+     * \brief Get the trace of the long session replayed by undoMemory and undoSteps, recorded on first use
+     * \return Trace, empty if it can not be recorded
+     */
+    static QByteArray undoSession();
+
+
+    // Private Slots (test functions)
+private slots:
+
+    /**
+     * \brief Construction and initialisation() of a keyboard, in both rendering modes
+     */
+    void initialisation_data();
+    void initialisation();
+
+    /**
+     * \brief Heap allocations done to get a keymap : built-in table, compiled file (memory-mapped) or source file
+     *
+     * The result is a number of allocations (glibc only : malloc, calloc and realloc are interposed by the benchmark)
+     */
+    void keymapAllocations_data();
+    void keymapAllocations();
+
+    /**
+     * \brief Caps lock, numbers and punctuation toggles (on then off), repaint included, in both rendering modes
+     */
+    void layerToggle_data();
+    void layerToggle();
+
+    /**
+     * \brief Language switched (EN to FR and back) with setLanguage, repaint included, in both rendering modes
+     */
+    void languageSwitch_data();
+    void languageSwitch();
+
+    /**
+     * \brief Principal key committed into each supported input widget
+     */
+    void keyPressed_data();
+    void keyPressed();
+
+    /**
+     * \brief Character inserted then deleted through the input target of each supported input widget, without the keyboard
+     */
+    void inputTargetDispatch_data();
+    void inputTargetDispatch();
+
+    /**
+     * \brief Backspace at the end of large documents
+     */
+    void backspaceLargeDocument_data();
+    void backspaceLargeDocument();
+
+    /**
+     * \brief Burst of 32 principal keys committed into each supported input widget, directly or coalesced into one edit
+     */
+    void typingBurst_data();
+    void typingBurst();
+
+    /**
+     * \brief 10k characters typed then deleted at the end of 1 MB, 10 MB and 50 MB documents, with and without the large document mode
+     *
+     * The result is the time of one keystroke
+     */
+    void largeDocumentTyping_data();
+    void largeDocumentTyping();
+
+    /**
+     * \brief Heap used by a long replayed session typed into the text edits : undo steps not grouped, grouped, grouped and cleared
+     *      above BENCH_UNDO_CLEARTHRESHOLD steps
+     */
+    void undoMemory_data();
+    void undoMemory();
+
+    /**
+     * \brief Undo steps left after the same session, then checked by undoing every one of them
+     */
+    void undoSteps_data();
+    void undoSteps();
+
+    /**
+     * \brief Longest event loop stall while 4 MB of clipboard text are pasted into the text edits, directly or streamed
+     *
+     * The streamed rows then check that a key typed, or a move of the cursor, during the paste cancels it
+     */
+    void pasteStall_data();
+    void pasteStall();
+
+    /**
+     * \brief 40 secondary keys added then removed
+     */
+    void secondaryKeysChurn_data();
+    void secondaryKeysChurn();
+
+    /**
+     * \brief Screen change swapping two sets of 40 secondary keys : key by key, in a batch, or with setSecondaryKeys()
+     */
+    void secondaryKeysSwap_data();
+    void secondaryKeysSwap();
+
+    /**
+     * \brief Hundreds of secondary keys displayed, one added and removed, then all removed : buttons or virtualized column
+     */
+    void secondaryKeysMany_data();
+    void secondaryKeysMany();
+
+    /**
+     * \brief Heap used by BENCH_SNIPPET_KEYCOUNT snippet keys on 1 to 4 keyboards, their texts read separately by each keyboard
+     */
+    void snippetMemory_data();
+    void snippetMemory();
+
+    /**
+     * \brief Completions of a prefix of 1 to 5 characters in a dictionary of BENCH_PREDICTION_WORDCOUNT words (one lookup per keystroke)
+     */
+    void predictionLookup_data();
+    void predictionLookup();
+
+    /**
+     * \brief Key presses into a line edit, without and with word prediction (time spent in the GUI thread, the lookups are in the worker)
+     */
+    void predictionTyping_data();
+    void predictionTyping();
+
+    /**
+     * \brief Time before initialisation() and setPredictionDictionary() return, with a keymap and a dictionary to compile at load :
+     *      cold (first start, never loaded by the process) or warm (already loaded), synchronous or asynchronous loading
+     */
+    void startupTime_data();
+    void startupTime();
+
+    /**
+     * \brief Correction of a word typed with near-miss taps, against the dictionary of predictionLookup (one correction per word finished)
+     */
+    void tapCorrection_data();
+    void tapCorrection();
+
+    /**
+     * \brief Decoding of a path traced over the keys, against the dictionary of predictionLookup (one decoding per path released)
+     *
+     * The paths decoded are read from the file given by the VIRTUALKEYBOARD_GESTURES environment variable (one path per line, its points
+     * as "x,y" separated by spaces, in the coordinates of the EN keymap laid out in 800 x 250), or recorded by the benchmark
+     */
+    void gestureDecoding_data();
+    void gestureDecoding();
+
+    /**
+     * \brief Focus moved through a form of line edits and buttons followed by several keyboards, unscoped or scoped to another subtree
+     */
+    void focusNavigation_data();
+    void focusNavigation();
+
+    /**
+     * \brief Replay of a keystroke trace as fast as possible into a QTextEdit
+     *
+     * The trace replayed is the file given by the VIRTUALKEYBOARD_TRACE environment variable, or a session recorded by the benchmark
+     */
+    void replayTrace();
+};
+
+#endif // BENCH_VIRTUALKEYBOARD_H
@@ -23,60 +23,160 @@ SOFTWARE.
 -----------------------------------------------------------------------------------------------------------------------------------*/
 
 #include "VirtualKeyboard.h"
+#include "VirtualKeyboardFocusDispatcher.h"
+
+#include <QApplication>
+#include <QClipboard>
+#include <QCursor>
+#include <QEvent>
+
+
+/**
+ * Principal keys of each row of VirtualKeyboard.ui (pushButton_principalKey_00 to pushButton_principalKey_26, in order)
+ */
+static const int sti_widgetsRowKeyCounts[] = { 10, 10, 7 };
 
 
 
 VirtualKeyboard::VirtualKeyboard(QWidget *w_parent) :
     QFrame(w_parent),
     ui(new Ui::VirtualKeyboard),
-    mi_inputType(VIRTUALKEYBOARD_INPUT_UNKNOWINPUTTYPE)
+    mw_surface(NULL),
+    mw_frameSecondary(NULL),
+    mw_secondaryBar(NULL),
+    mpo_inputTarget(new VirtualKeyboardInputTarget()),
+    mb_isFocusScoped(false),
+    mi_secondaryKeysUpdateDepth(0),
+    mpo_keymap(NULL),
+    mi_currentLayer(VIRTUALKEYBOARD_LAYER_LOWER),
+    mi_renderMode(VIRTUALKEYBOARD_RENDER_WIDGETS),
+    mi_commitMode(VIRTUALKEYBOARD_COMMIT_ONRELEASE),
+    mb_isCharactersAutoRepeatOn(false),
+    mi_autoRepeatDelay(VIRTUALKEYBOARD_AUTOREPEAT_DELAY),
+    mi_autoRepeatInterval(VIRTUALKEYBOARD_AUTOREPEAT_INTERVAL),
+    mi_autoRepeatMinimumInterval(VIRTUALKEYBOARD_AUTOREPEAT_MINIMUMINTERVAL),
+    mr_autoRepeatAcceleration(VIRTUALKEYBOARD_AUTOREPEAT_ACCELERATION),
+    mi_autoRepeatCurrentInterval(VIRTUALKEYBOARD_AUTOREPEAT_INTERVAL),
+    mi_heldKeyId(VIRTUALKEYBOARD_KEY_NONE),
+    mb_hasHeldKeyRepeated(false),
+    mb_isLatencyInstrumentationOn(false),
+    mi_latencyPressTime(-1),
+    mi_latencyPendingType(-1),
+    mi_latencyPendingPressTime(0),
+    mi_latencyPendingDispatch(0),
+    mi_largeDocumentThreshold(VIRTUALKEYBOARD_LARGEDOCUMENT_THRESHOLD),
+    mb_isUndoGroupingOn(false),
+    mi_undoGroupingMaximumGap(VIRTUALKEYBOARD_UNDOGROUPING_MAXIMUMGAP),
+    mi_undoClearThreshold(0),
+    mi_undoGroup(VIRTUALKEYBOARD_UNDOGROUP_NONE),
+    mb_isStreamingPasteOn(false),
+    mi_pasteStreamingThreshold(VIRTUALKEYBOARD_PASTE_STREAMINGTHRESHOLD),
+    mi_pasteChunkSize(VIRTUALKEYBOARD_PASTE_CHUNKSIZE),
+    mi_pastePosition(0),
+    mb_isPasteChunkInserting(false),
+    mb_isKeyFilteringOn(false),
+    mb_isNumbersLayerAutomatic(false),
+    mb_isCoalescingOn(false),
+    mi_coalescingMaximumDelay(VIRTUALKEYBOARD_COALESCING_MAXIMUMDELAY),
+    mi_coalescedBackspaceCount(0),
+    mpo_dictionary(NULL),
+    mw_frameSuggestions(NULL),
+    mpo_predictionThread(NULL),
+    mpo_predictionWorker(NULL),
+    mi_predictionSequence(0),
+    mb_isPredictionDesynchronized(false),
+    mb_isAsynchronousLoadingOn(false),
+    mi_tapCorrectionMode(VIRTUALKEYBOARD_TAPCORRECTION_OFF),
+    mi_correctionSequence(0),
+    mb_isKeyModelDirty(true),
+    mb_isTapPositionSet(false),
+    mb_isGestureTypingOn(false),
+    mi_gestureSequence(0)
 {
+    this->mo_timerAutoRepeat.setSingleShot(true);
+    this->mo_timerCoalescing.setSingleShot(true);
+    this->mo_timerPaste.setSingleShot(true);
+    this->mo_timerPrediction.setSingleShot(true);
+
+    connect(&this->mo_timerAutoRepeat,  SIGNAL(timeout()),
+            this,                       SLOT(autoRepeat()));
+    connect(&this->mo_timerCoalescing,  SIGNAL(timeout()),
+            this,                       SLOT(flushCoalescedKeys()));
+    connect(&this->mo_timerPaste,       SIGNAL(timeout()),
+            this,                       SLOT(pasteNextChunk()));
+    connect(&this->mo_keyFilter,        SIGNAL(acceptedKeysChanged()),
+            this,                       SLOT(applyKeyFilter()));
+    connect(&this->mo_timerPrediction,  SIGNAL(timeout()),
+            this,                       SLOT(synchronizePrediction()));
+    connect(&this->mo_mapperSuggestions, SIGNAL(mapped(int)),
+            this,                       SLOT(suggestionClicked(int)));
 }
 
 
 VirtualKeyboard::~VirtualKeyboard()
 {
+    this->disconnectFocusChanged();
+    this->flushCoalescedKeys();
+
+    // The worker is deleted once its thread has stopped : no lookup in progress
+    if (this->mpo_predictionThread != NULL)
+    {
+        this->mpo_predictionThread->quit();
+        this->mpo_predictionThread->wait();
+        delete this->mpo_predictionWorker;
+    }
+
     if (this->ui != NULL) delete this->ui;
 }
 
 
-int VirtualKeyboard::initialisation(QWidget *w_inputWidget, QString s_language, bool b_displaySecondaryKeys, bool b_displayBorder)
+int VirtualKeyboard::initialisation(QWidget *w_inputWidget, QString s_language, bool b_displaySecondaryKeys, bool b_displayBorder, int i_renderMode, int i_commitMode)
 {
     if (w_inputWidget != NULL)
     {
         // --- Check type of the input field to bind to the keyboard
-        if ((this->mw_lineEdit = qobject_cast<QLineEdit *>(w_inputWidget)))
-        {
-            this->mi_inputType = VIRTUALKEYBOARD_INPUT_LINEEDIT;
-        }
-        else if ((this->mw_textEdit = qobject_cast<QTextEdit *>(w_inputWidget)))
-        {
-            this->mi_inputType = VIRTUALKEYBOARD_INPUT_TEXTEDIT;
-        }
-        else if ((this->mw_plainTextEdit = qobject_cast<QPlainTextEdit *>(w_inputWidget)))
-        {
-            this->mi_inputType = VIRTUALKEYBOARD_INPUT_PLAINTEXTEDIT;
-        }
-        // If the control is a combobox and the combobox can be edited
-        else if ((this->mw_comboBox = qobject_cast<QComboBox *>(w_inputWidget)) && this->mw_comboBox->isEditable())
-        {
-            // Writing in a combobox is in fact writing in a lineEdit, so we use the lineEdit
-            this->mi_inputType = VIRTUALKEYBOARD_INPUT_LINEEDIT;
-            this->mw_lineEdit = this->mw_comboBox->lineEdit();
-        }
-        else
-            return VIRTUALKEYBOARD_INIT_FAILED;
+        VirtualKeyboardInputTarget *po_inputTarget = VirtualKeyboardInputTarget::create(w_inputWidget);
+
+        if (po_inputTarget == NULL) return VIRTUALKEYBOARD_INIT_FAILED;
+
+        po_inputTarget->setLargeDocumentThreshold(this->mi_largeDocumentThreshold);
+        po_inputTarget->setUndoClearThreshold(this->mi_undoClearThreshold);
+        this->mpo_inputTarget.reset(po_inputTarget);
     }
 
     // --- Keymaps Initialisation
     if (!this->initialisationKeymaps(s_language)) return VIRTUALKEYBOARD_UNKNOWLANGUAGE;
 
+    // The buttons of VirtualKeyboard.ui would drop the extra keys, or show the keys in the wrong rows
+    if (!VirtualKeyboard::isKeymapShown(this->mpo_keymap, i_renderMode))
+    {
+        this->mpo_keymap = NULL;
+        this->ms_language.clear();
+        return VIRTUALKEYBOARD_KEYMAPNOTSHOWN;
+    }
+
 
     // --- Setup widget's UI
-    this->ui->setupUi(this);
+    this->mi_renderMode = i_renderMode;
+    this->mi_commitMode = i_commitMode;
+
+    if (this->mi_renderMode == VIRTUALKEYBOARD_RENDER_PAINTED)
+    {
+        this->setupPaintedUi();
+    }
+    else
+    {
+        this->ui->setupUi(this);
+        this->mw_frameSecondary = this->ui->frame_secondary;
+        // Font used for the secondary keys added programmatically
+        this->mw_frameSecondary->setFont(this->ui->pushButton_secondaryKey_paste->font());
+    }
 
     // Display secondary keys ?
-    this->ui->frame_secondary->setVisible(b_displaySecondaryKeys);
+    this->mw_frameSecondary->setVisible(b_displaySecondaryKeys);
+
+    // Suggestions of the word prediction, hidden until a dictionary is set
+    this->setupSuggestionsUi();
 
     // Display border around keyboard ?
     this->setFrameShape(b_displayBorder ? QFrame::StyledPanel : QFrame::NoFrame);
@@ -88,414 +188,1885 @@ int VirtualKeyboard::initialisation(QWidget *w_inputWidget, QString s_language,
     this->mb_isPunctuationOn = false;
 
 
-    // Extraction of every QPushButton matching the regex "pushButton_principalKey_\\d\\d" into a list
+    // Extraction of every QPushButton matching the regex "pushButton_principalKey_\\d\\d" into a list (none in VIRTUALKEYBOARD_RENDER_PAINTED mode)
     this->mlistw_principalKeys = this->findChildren<QPushButton *>(QRegExp("pushButton_principalKey_\\d\\d"));
 
-    // --- Signals Mapping for non specific keys
+    // --- Signals Mapping for non specific keys, space and backspace (pressed / released / clicked, to handle the commit mode and the auto-repeat)
     connect(&this->mo_mapperPrimaryKeys,    SIGNAL(mapped(int)),
-            this,                           SLOT(keyPressed(int)));
+            this,                           SLOT(keyClicked(int)));
+    connect(&this->mo_mapperKeysDown,       SIGNAL(mapped(int)),
+            this,                           SLOT(keyDown(int)));
+    connect(&this->mo_mapperKeysUp,         SIGNAL(mapped(int)),
+            this,                           SLOT(keyUp(int)));
 
     for (int i_i = 0; i_i < this->mlistw_principalKeys.size(); ++i_i)
     {
-        // Connection between the button and the signal mapper
-        connect(this->mlistw_principalKeys.at(i_i), SIGNAL(clicked()),
-                &this->mo_mapperPrimaryKeys,        SLOT(map()));
         // Map the button with the index of the list to be able to link a key press to a specific key
-        this->mo_mapperPrimaryKeys.setMapping(this->mlistw_principalKeys.at(i_i), i_i);
+        this->mapKeyButton(this->mlistw_principalKeys.at(i_i), i_i);
+    }
+
+    // Moves and resizes of the principal keys and of their frames : the keys posted to the prediction worker are outdated
+    QList<QWidget *> listw_principalWidgets;
+
+    if (this->mw_surface != NULL) listw_principalWidgets.append(this->mw_surface);
+    for (int i_i = 0; i_i < this->mlistw_principalKeys.size(); ++i_i) listw_principalWidgets.append(this->mlistw_principalKeys.at(i_i));
+
+    for (int i_i = 0; i_i < listw_principalWidgets.size(); ++i_i)
+    {
+        for (QWidget *w_widget = listw_principalWidgets.at(i_i); w_widget != NULL && w_widget != this; w_widget = w_widget->parentWidget())
+            w_widget->installEventFilter(this);
+    }
+
+    if (this->mi_renderMode != VIRTUALKEYBOARD_RENDER_PAINTED)
+    {
+        this->mapKeyButton(this->ui->pushButton_principalKey_space,     VIRTUALKEYBOARD_KEY_SPACE);
+        this->mapKeyButton(this->ui->pushButton_principalKey_backspace, VIRTUALKEYBOARD_KEY_BACKSPACE);
     }
 
     // --- Signals Mapping for secondary keys
     connect(&this->mo_mapperSecondaryKeys,  SIGNAL(mapped(int)),
-            this,                           SIGNAL(secondaryKeyPressed(int)));
+            this,                           SLOT(secondaryKeyClicked(int)));
 
 
     // --- Connection to change the input widget dynamically
     this->connectFocusChanged();
+    this->connectLatencySource();
+    this->connectPredictionSource();
 
     // --- Set the initial keymap
-    this->setKeymap(this->mlists_lowerKeymap);
+    this->setKeymap(VIRTUALKEYBOARD_LAYER_LOWER);
+    this->updateKeyFilterTarget();
+
+    // ready() emitted once the caller has had the chance to connect it, now if nothing is loaded in the background
+    if (this->mb_isAsynchronousLoadingOn) QTimer::singleShot(0, this, SLOT(checkReady()));
 
 
     return VIRTUALKEYBOARD_SUCCESS;
 }
 
 
-bool VirtualKeyboard::addSecondaryKey(QString s_keyText, int i_indexMapping)
+int VirtualKeyboard::setLanguage(const QString &s_language)
 {
-    // If no key has previously been added with the index i_indexMapping we add the key
-    if (!this->mmapw_secondaryKeys.contains(i_indexMapping))
-    {
-        // Button creation with the text passed as parameter
-        QPushButton *w_pushButtonSecondary = new QPushButton(s_keyText);
+    if (this->mpo_keymap == NULL) return VIRTUALKEYBOARD_INIT_FAILED;
 
-        // Set minimum height for the button
-        w_pushButtonSecondary->setMinimumHeight(50);
-        // Set the same font as the others secondary buttons
-        w_pushButtonSecondary->setFont(this->ui->pushButton_secondaryKey_paste->font());
+    const VirtualKeyboardKeymap *po_keymap = VirtualKeyboardKeymap::find(s_language);
 
-        // Insertion of the button in a map indexed by the mapping index, to be able to remove or modify a button
-        this->mmapw_secondaryKeys.insert(i_indexMapping, w_pushButtonSecondary);
+    if (po_keymap == NULL) return VIRTUALKEYBOARD_UNKNOWLANGUAGE;
 
-        // Add a new secondary key
-        this->ui->frame_secondary->layout()->addWidget(w_pushButtonSecondary);
+    // Same check as initialisation() : the buttons reused must be able to show the keys of the new keymap
+    if (!VirtualKeyboard::isKeymapShown(po_keymap, this->mi_renderMode)) return VIRTUALKEYBOARD_KEYMAPNOTSHOWN;
 
-        // Connection between the button and the signal mapper
-        connect(w_pushButtonSecondary,          SIGNAL(clicked()),
-                &this->mo_mapperSecondaryKeys,  SLOT(map()));
+    // The language loaded in the background, if any, is not wanted anymore
+    if (!this->ms_loadingLanguage.isEmpty())
+    {
+        this->ms_loadingLanguage.clear();
+        this->checkReady();
+    }
 
-        // Map the button with the index passed as parameter
-        this->mo_mapperSecondaryKeys.setMapping(w_pushButtonSecondary, i_indexMapping);
+    this->ms_language = s_language;
 
-        return true;
+    if (po_keymap != this->mpo_keymap)
+    {
+        // Same layer in the new keymap : only the labels of the keys change
+        this->mpo_keymap = po_keymap;
+        this->setKeymap(this->mi_currentLayer);
     }
-    // If a key has previously been added with the index i_indexMapping we just return false
-    else
-        return false;
+
+    return VIRTUALKEYBOARD_SUCCESS;
 }
 
 
-bool VirtualKeyboard::removeSecondaryKey(int i_indexMapping)
+QWidget *VirtualKeyboard::inputWidget() const
 {
-    // If a key has previously been added with the index i_indexMapping we remove it
-    if (this->mmapw_secondaryKeys.contains(i_indexMapping))
-    {
-        // Remove the button from the map
-        QPushButton *w_pushButtonSecondary = this->mmapw_secondaryKeys.take(i_indexMapping);
+    return this->mpo_inputTarget->widget();
+}
 
-        // Remove the button from the widget
-        this->ui->frame_secondary->layout()->removeWidget(w_pushButtonSecondary);
 
-        delete w_pushButtonSecondary;
+QString VirtualKeyboard::language() const
+{
+    return this->ms_language;
+}
 
-        return true;
-    }
-    // If no key has previously been added with the index i_indexMapping we just return false
-    else
-        return false;
+
+void VirtualKeyboard::setAutoRepeat(bool b_repeatCharacters, int i_initialDelay, int i_interval, int i_minimumInterval, qreal r_acceleration)
+{
+    this->mb_isCharactersAutoRepeatOn = b_repeatCharacters;
+    this->mi_autoRepeatDelay = i_initialDelay;
+    this->mi_autoRepeatInterval = i_interval;
+    this->mi_autoRepeatMinimumInterval = qMin(i_minimumInterval, i_interval);
+    this->mr_autoRepeatAcceleration = qBound(qreal(0.1), r_acceleration, qreal(1));
 }
 
 
-bool VirtualKeyboard::initialisationKeymaps(QString s_language)
+void VirtualKeyboard::setLargeDocumentThreshold(int i_characterCount)
 {
-    this->mlists_numbersKeymap << "1" << "2" << "3" << "4" << "5" << "6" << "7" << "8" << "9" << "0"
-                               << "!" << "@" << "#" << "$" << "%" << "&&" << "*" << "(" << ")" << ""
-                               << "," << "-" << "_" << "[" << "]" << "?" << ".";
+    this->mi_largeDocumentThreshold = i_characterCount;
+    this->mpo_inputTarget->setLargeDocumentThreshold(i_characterCount);
+}
 
-    this->mlists_punctuationKeymap << "!" << "@" << "#" << "$" << "%" << "&&" << "*" << "(" << ")" << ""
-                                   << ";" << "-" << "_" << "[" << "]" << "?" << "."  << "/" << "\\";
 
-    // If the language is not EN or FR then return false
-    if (s_language == "EN")
-    {
-        this->mlists_lowerKeymap << "q" << "w" << "e" << "r" << "t" << "y" << "u" << "i" << "o" << "p"
-                                 << "a" << "s" << "d" << "f" << "g" << "h" << "j" << "k" << "l" << ""
-                                 << "z" << "x" << "c" << "v" << "b" << "n" << "m";
+void VirtualKeyboard::setUndoGrouping(bool b_enabled, int i_maximumGap)
+{
+    this->mb_isUndoGroupingOn = b_enabled;
+    this->mi_undoGroupingMaximumGap = qMax(0, i_maximumGap);
+    this->mi_undoGroup = VIRTUALKEYBOARD_UNDOGROUP_NONE;
+}
 
-        this->mlists_upperKeymap << "Q" << "W" << "E" << "R" << "T" << "Y" << "U" << "I" << "O" << "P"
-                                 << "A" << "S" << "D" << "F" << "G" << "H" << "J" << "K" << "L" << ""
-                                 << "Z" << "X" << "C" << "V" << "B" << "N" << "M";
-    }
-    else if (s_language == "FR")
-    {
-        this->mlists_lowerKeymap << "a" << "z" << "e" << "r" << "t" << "y" << "u" << "i" << "o" << "p"
-                                 << "q" << "s" << "d" << "f" << "g" << "h" << "j" << "k" << "l" << "m"
-                                 << "w" << "x" << "c" << "v" << "b" << "n" ;
 
-        this->mlists_upperKeymap << "A" << "Z" << "E" << "R" << "T" << "Y" << "U" << "I" << "O" << "P"
-                                 << "Q" << "S" << "D" << "F" << "G" << "H" << "J" << "K" << "L" << "M"
-                                 << "W" << "X" << "C" << "V" << "B" << "N" ;
-    }
-    else
-        return false;
+void VirtualKeyboard::setUndoClearThreshold(int i_stepCount)
+{
+    this->mi_undoClearThreshold = qMax(0, i_stepCount);
+    this->mpo_inputTarget->setUndoClearThreshold(this->mi_undoClearThreshold);
+}
 
-    return true;
+
+void VirtualKeyboard::setStreamingPaste(bool b_enabled, int i_threshold, int i_chunkSize)
+{
+    if (!b_enabled) this->cancelPaste();
+
+    this->mb_isStreamingPasteOn = b_enabled;
+    this->mi_pasteStreamingThreshold = qMax(1, i_threshold);
+    this->mi_pasteChunkSize = qMax(1, i_chunkSize);
 }
 
 
-void VirtualKeyboard::setKeymap(QList<QString> &lists_keys)
+bool VirtualKeyboard::isPasting() const
 {
-    for (int i_i = 0; i_i < this->mlistw_principalKeys.size(); ++i_i)
-    {
-        // if the index is superior to the size of "lists_keys" OR if the string at i_i in "lists_keys" is empty, we hide the button
-        if (i_i >= lists_keys.size() || lists_keys.at(i_i).isEmpty())
-        {
-            this->mlistw_principalKeys.at(i_i)->hide();
-        }
-        else // We set the text of the key to the value of lists_keys[i_i]
-        {
-            this->mlistw_principalKeys.at(i_i)->setText(lists_keys.at(i_i));
-            if (this->mlistw_principalKeys.at(i_i)->isHidden()) this->mlistw_principalKeys.at(i_i)->show();
-        }
-    }
+    return !this->ms_pasteText.isEmpty();
 }
 
 
-void VirtualKeyboard::toggleCapsLock()
+void VirtualKeyboard::setKeyFiltering(bool b_enabled)
 {
-    // We change the state of the caps lock and reset to false the others states and buttons
-    this->mb_isCapsOn = !this->mb_isCapsOn;
-    this->mb_isNumberOn = false;
-    this->ui->pushButton_principalKey_numbers->setText(VIRTUALKEYBOARD_BUTTONTEXT_NUMBERS_OFF);
-    this->mb_isPunctuationOn = false;
-    this->ui->pushButton_principalKey_punctuation->setText(VIRTUALKEYBOARD_BUTTONTEXT_PUNCTUATION_OFF);
+    this->mb_isKeyFilteringOn = b_enabled;
+    this->updateKeyFilterTarget();
+}
 
-    if (this->mb_isCapsOn)
+
+void VirtualKeyboard::updateKeyFilterTarget()
+{
+    // Not initialised yet
+    if (this->mw_frameSecondary == NULL) return;
+
+    this->mo_keyFilter.setLineEdit(this->mb_isKeyFilteringOn ? this->mpo_inputTarget->lineEdit() : NULL);
+
+    const bool b_isNumeric = this->mo_keyFilter.isNumeric();
+
+    if (b_isNumeric && !this->mb_isNumberOn)
     {
-        this->setKeymap(this->mlists_upperKeymap);
-        this->ui->pushButton_principalKey_caps->setStyleSheet("QPushButton { background-color: cyan; border-radius: 3px; }");
+        this->toggleNumbers();
+        this->mb_isNumbersLayerAutomatic = true;
     }
-    else
+    else if (!b_isNumeric && this->mb_isNumbersLayerAutomatic)
     {
-        this->setKeymap(this->mlists_lowerKeymap);
-        this->ui->pushButton_principalKey_caps->setStyleSheet("");
+        // Unless the layer has been changed by hand since
+        if (this->mb_isNumberOn) this->toggleNumbers();
+        this->mb_isNumbersLayerAutomatic = false;
     }
 }
 
 
-void VirtualKeyboard::toggleNumbers()
+void VirtualKeyboard::applyKeyFilter()
 {
-    // We change the state of the "numbers" boolean and reset to false the others states and buttons
-    this->mb_isNumberOn = !this->mb_isNumberOn;
-    this->mb_isCapsOn = false;
-    this->ui->pushButton_principalKey_caps->setStyleSheet("");
-    this->mb_isPunctuationOn = false;
-    this->ui->pushButton_principalKey_punctuation->setText(VIRTUALKEYBOARD_BUTTONTEXT_PUNCTUATION_OFF);
-
-    if (this->mb_isNumberOn)
-    {
-        this->setKeymap(this->mlists_numbersKeymap);
-        this->ui->pushButton_principalKey_numbers->setText(VIRTUALKEYBOARD_BUTTONTEXT_NUMBERS_ON);
-    }
-    else
+    for (int i_key = 0; i_key < this->mpo_keymap->keyCount(); ++i_key)
     {
-        this->setKeymap(this->mlists_lowerKeymap);
-        this->ui->pushButton_principalKey_numbers->setText(VIRTUALKEYBOARD_BUTTONTEXT_NUMBERS_OFF);
+        const bool b_isEnabled = this->mo_keyFilter.isKeyAccepted(i_key);
+
+        if (this->mw_surface != NULL)                       this->mw_surface->setKeyEnabled(i_key, b_isEnabled);
+        else if (i_key < this->mlistw_principalKeys.size()) this->mlistw_principalKeys.at(i_key)->setEnabled(b_isEnabled);
     }
-    this->ui->pushButton_principalKey_caps->setEnabled(!this->mb_isNumberOn);
 }
 
 
-void VirtualKeyboard::togglePunctuation()
+void VirtualKeyboard::setCoalescing(bool b_enabled, int i_maximumDelay)
 {
-    // We change the state of the "Punctuation" boolean and reset to false the others states and buttons
-    this->mb_isPunctuationOn = !this->mb_isPunctuationOn;
-    this->mb_isCapsOn = false;
-    this->ui->pushButton_principalKey_caps->setStyleSheet("");
-    this->mb_isNumberOn = false;
-    this->ui->pushButton_principalKey_numbers->setText(VIRTUALKEYBOARD_BUTTONTEXT_NUMBERS_OFF);
+    if (!b_enabled) this->flushCoalescedKeys();
 
-    if (this->mb_isPunctuationOn)
-    {
-        this->setKeymap(this->mlists_punctuationKeymap);
-        this->ui->pushButton_principalKey_punctuation->setText(VIRTUALKEYBOARD_BUTTONTEXT_PUNCTUATION_ON);
-    }
-    else
-    {
-        this->setKeymap(this->mlists_lowerKeymap);
-        this->ui->pushButton_principalKey_punctuation->setText(VIRTUALKEYBOARD_BUTTONTEXT_PUNCTUATION_OFF);
-    }
-    this->ui->pushButton_principalKey_caps->setEnabled(!this->mb_isPunctuationOn);
+    this->mb_isCoalescingOn = b_enabled;
+    this->mi_coalescingMaximumDelay = qMax(0, i_maximumDelay);
 }
 
 
-void VirtualKeyboard::toggleSecondaryKeysVisibility()
+bool VirtualKeyboard::isCoalescing() const
 {
-    this->ui->frame_secondary->setVisible(!this->ui->frame_secondary->isVisible());
+    if (!this->mb_isCoalescingOn) return false;
+
+    // Checked on each key : the validator or the input mask can be set while the line edit has the focus
+    const QLineEdit *w_lineEdit = this->mpo_inputTarget->lineEdit();
+    return w_lineEdit == NULL || (w_lineEdit->validator() == NULL && w_lineEdit->inputMask().isEmpty());
 }
 
 
-void VirtualKeyboard::setInputWidget(QWidget *w_old, QWidget *w_new)
+bool VirtualKeyboard::setPredictionDictionary(const QString &s_fileName)
 {
-    Q_UNUSED(w_old)
+    const bool b_wasLoading = !this->ms_loadingDictionary.isEmpty();
+    this->ms_loadingDictionary.clear();
 
-    // Line Edit
-    if ((this->mw_lineEdit = qobject_cast<QLineEdit *>(w_new)))
-    {
-        this->mi_inputType = VIRTUALKEYBOARD_INPUT_LINEEDIT;
-        return;
-    }
-    // Text Edit
-    else if ((this->mw_textEdit = qobject_cast<QTextEdit *>(w_new)))
-    {
-        this->mi_inputType = VIRTUALKEYBOARD_INPUT_TEXTEDIT;
-        return;
-    }
-    // Plain Text Edit
-    else if ((this->mw_plainTextEdit = qobject_cast<QPlainTextEdit *>(w_new)))
+    const VirtualKeyboardDictionary *po_dictionary = NULL;
+
+    if (!s_fileName.isEmpty() && !this->mb_isAsynchronousLoadingOn)
     {
-        this->mi_inputType = VIRTUALKEYBOARD_INPUT_PLAINTEXTEDIT;
-        return;
+        po_dictionary = VirtualKeyboardDictionary::find(s_fileName);
     }
-    // Editable ComboBox
-    else if ((this->mw_comboBox = qobject_cast<QComboBox *>(w_new)))
+    else if (!s_fileName.isEmpty())
     {
-        // If the combobox can be edited
-        if (this->mw_comboBox->isEditable())
+        // Not loaded yet : the prediction is disabled until dictionaryLoaded()
+        po_dictionary = VirtualKeyboardDictionary::findLoaded(s_fileName);
+
+        if (po_dictionary == NULL)
         {
-            // Writing in a combobox is in fact writing in a lineEdit, so we use the lineEdit
-            this->mi_inputType = VIRTUALKEYBOARD_INPUT_LINEEDIT;
-            this->mw_lineEdit = this->mw_comboBox->lineEdit();
-            return;
+            this->ms_loadingDictionary = s_fileName;
+            VirtualKeyboardLoader::instance()->loadDictionary(s_fileName);
         }
     }
+
+    this->applyPredictionDictionary(po_dictionary);
+
+    if (b_wasLoading) this->checkReady();
+
+    return s_fileName.isEmpty() || po_dictionary != NULL || !this->ms_loadingDictionary.isEmpty();
 }
 
 
-void VirtualKeyboard::keyPressed(int i_indexKey)
+QStringList VirtualKeyboard::suggestions() const
 {
-    // Line Edit
-    if (this->mi_inputType == VIRTUALKEYBOARD_INPUT_LINEEDIT && this->mw_lineEdit)
-    {
-        this->mw_lineEdit->insert(this->mlistw_principalKeys.at(i_indexKey)->text());
-    }
-    // Plain Text Edit
-    else if (this->mi_inputType == VIRTUALKEYBOARD_INPUT_PLAINTEXTEDIT && this->mw_plainTextEdit)
+    return this->mlists_suggestions;
+}
+
+
+void VirtualKeyboard::setAsynchronousLoading(bool b_enabled)
+{
+    if (b_enabled == this->mb_isAsynchronousLoadingOn) return;
+
+    this->mb_isAsynchronousLoadingOn = b_enabled;
+
+    // Queued : emitted in the loader thread
+    if (b_enabled)
     {
-        this->mw_plainTextEdit->insertPlainText(this->mlistw_principalKeys.at(i_indexKey)->text());
+        connect(VirtualKeyboardLoader::instance(),  SIGNAL(keymapLoaded(QString,bool)),
+                this,                               SLOT(keymapLoaded(QString,bool)));
+        connect(VirtualKeyboardLoader::instance(),  SIGNAL(dictionaryLoaded(QString,bool)),
+                this,                               SLOT(dictionaryLoaded(QString,bool)));
     }
-    // Text Edit
-    else if (this->mi_inputType == VIRTUALKEYBOARD_INPUT_TEXTEDIT && this->mw_textEdit)
+    else
     {
-        this->mw_textEdit->insertPlainText(this->mlistw_principalKeys.at(i_indexKey)->text());
+        disconnect(VirtualKeyboardLoader::instance(), 0, this, 0);
     }
 }
 
 
-void VirtualKeyboard::on_pushButton_principalKey_space_clicked()
+bool VirtualKeyboard::isReady() const
 {
-    // Line Edit
-    if (this->mi_inputType == VIRTUALKEYBOARD_INPUT_LINEEDIT && this->mw_lineEdit)
-    {
-        this->mw_lineEdit->insert(" ");
-    }
-    // Plain Text Edit
-    else if (this->mi_inputType == VIRTUALKEYBOARD_INPUT_PLAINTEXTEDIT && this->mw_plainTextEdit)
+    return this->ms_loadingLanguage.isEmpty() && this->ms_loadingDictionary.isEmpty();
+}
+
+
+void VirtualKeyboard::setTapCorrection(int i_mode)
+{
+    this->mi_tapCorrectionMode = i_mode;
+
+    // New sequence number : the correction in progress is dropped
+    ++this->mi_correctionSequence;
+    this->clearTaps();
+    this->ms_correctedWord.clear();
+    this->ms_correction.clear();
+}
+
+
+void VirtualKeyboard::setGestureTyping(bool b_enabled)
+{
+    this->mb_isGestureTypingOn = b_enabled;
+    ++this->mi_gestureSequence;
+
+    if (this->mw_surface != NULL) this->mw_surface->setPathTracing(b_enabled && this->mi_commitMode == VIRTUALKEYBOARD_COMMIT_ONRELEASE);
+}
+
+
+void VirtualKeyboard::applyPredictionDictionary(const VirtualKeyboardDictionary *po_dictionary)
+{
+    this->mpo_dictionary = po_dictionary;
+
+    // --- Worker thread, started with the first dictionary and kept until the keyboard is destroyed
+    if (this->mpo_dictionary != NULL && this->mpo_predictionThread == NULL)
     {
-        this->mw_plainTextEdit->insertPlainText(" ");
+        this->mpo_predictionThread = new QThread(this);
+        this->mpo_predictionWorker = new VirtualKeyboardPredictionWorker(VIRTUALKEYBOARD_PREDICTION_SUGGESTIONCOUNT);
+        this->mpo_predictionWorker->moveToThread(this->mpo_predictionThread);
+
+        // Queued : emitted in the worker thread
+        connect(this->mpo_predictionWorker, SIGNAL(suggestionsReady(int,QStringList)),
+                this,                       SLOT(applySuggestions(int,QStringList)));
+        connect(this->mpo_predictionWorker, SIGNAL(correctionReady(int,QString,QString)),
+                this,                       SLOT(applyTapCorrection(int,QString,QString)));
+        connect(this->mpo_predictionWorker, SIGNAL(gestureReady(int,QStringList)),
+                this,                       SLOT(applyGestureWords(int,QStringList)));
+
+        this->mpo_predictionThread->start();
     }
-    // Text Edit
-    else if (this->mi_inputType == VIRTUALKEYBOARD_INPUT_TEXTEDIT && this->mw_textEdit)
+
+    if (this->mw_frameSuggestions != NULL) this->mw_frameSuggestions->setVisible(this->mpo_dictionary != NULL);
+    this->connectPredictionSource();
+
+    if (this->mpo_predictionWorker != NULL)
     {
-        this->mw_textEdit->insertPlainText(" ");
+        this->mpo_predictionWorker->setDictionary(this->mpo_dictionary);
+
+        // Lookup of the current word in the new dictionary, the suggestions of the previous one are dropped
+        this->postPredictionEvent(VIRTUALKEYBOARD_PREDICTIONEVENT_RESET, this->currentWord());
     }
+
+    // New sequence number : the results of the lookups in progress are dropped
+    if (this->mpo_dictionary == NULL) this->applySuggestions(++this->mi_predictionSequence, QStringList());
 }
 
 
-void VirtualKeyboard::on_pushButton_principalKey_backspace_clicked()
+void VirtualKeyboard::setupSuggestionsUi()
 {
-    // Line Edit
-    if (this->mi_inputType == VIRTUALKEYBOARD_INPUT_LINEEDIT && this->mw_lineEdit)
+    // Same top-level layout in both render modes : principal keys, then secondary keys
+    QBoxLayout *po_layout = qobject_cast<QBoxLayout *>(this->layout());
+    if (po_layout == NULL) return;
+
+    this->mw_frameSuggestions = new QFrame(this);
+    this->mw_frameSuggestions->setObjectName("frame_suggestions");
+    this->mw_frameSuggestions->setFrameShape(QFrame::StyledPanel);
+    this->mw_frameSuggestions->setFrameShadow(QFrame::Raised);
+    this->mw_frameSuggestions->setFont(this->mw_frameSecondary->font());
+
+    QVBoxLayout *w_layoutSuggestions = new QVBoxLayout(this->mw_frameSuggestions);
+
+    for (int i_i = 0; i_i < VIRTUALKEYBOARD_PREDICTION_SUGGESTIONCOUNT; ++i_i)
     {
-        this->mw_lineEdit->backspace();
+        QPushButton *w_pushButtonSuggestion = new QPushButton(this->mw_frameSuggestions);
+        w_pushButtonSuggestion->setObjectName(QString("pushButton_suggestion_%1").arg(i_i));
+        w_pushButtonSuggestion->setMinimumSize(70, 50);
+        w_pushButtonSuggestion->setFocusPolicy(Qt::NoFocus);
+        w_pushButtonSuggestion->setEnabled(false);
+        w_layoutSuggestions->addWidget(w_pushButtonSuggestion);
+
+        this->mlistw_suggestionKeys.append(w_pushButtonSuggestion);
+        this->mo_mapperSuggestions.setMapping(w_pushButtonSuggestion, i_i);
+        connect(w_pushButtonSuggestion,         SIGNAL(clicked()),
+                &this->mo_mapperSuggestions,    SLOT(map()));
     }
-    // Plain Text Edit
-    else if (this->mi_inputType == VIRTUALKEYBOARD_INPUT_PLAINTEXTEDIT && this->mw_plainTextEdit)
+    w_layoutSuggestions->addStretch(1);
+
+    po_layout->insertWidget(po_layout->indexOf(this->mw_frameSecondary), this->mw_frameSuggestions, 1);
+    this->mw_frameSuggestions->setVisible(this->mpo_dictionary != NULL);
+}
+
+
+void VirtualKeyboard::connectPredictionSource()
+{
+    if (this->mpo_predictionSource)
     {
-        this->mw_plainTextEdit->textCursor().deletePreviousChar();
+        disconnect(this->mpo_predictionSource, 0, this, SLOT(schedulePrediction()));
+        this->mpo_predictionSource.clear();
     }
-    // Text Edit
-    else if (this->mi_inputType == VIRTUALKEYBOARD_INPUT_TEXTEDIT && this->mw_textEdit)
+
+    if (this->mpo_dictionary == NULL) return;
+
+    const char *pc_signal;
+    QObject *po_notifier = this->mpo_inputTarget->changeNotifier(&pc_signal);
+
+    if (po_notifier != NULL)
     {
-        this->mw_textEdit->textCursor().deletePreviousChar();
+        this->mpo_predictionSource = po_notifier;
+        connect(po_notifier,    pc_signal,
+                this,           SLOT(schedulePrediction()));
     }
 }
 
 
-void VirtualKeyboard::on_pushButton_principalKey_caps_clicked()
+QString VirtualKeyboard::currentWord() const
 {
-    this->toggleCapsLock();
-}
+    // One character more than the longest word completed : to know if the word starts before
+    const QString s_text = this->mpo_inputTarget->textBeforeCursor(VIRTUALKEYBOARD_PREDICTION_MAXIMUMWORDLENGTH + 1);
 
+    int i_start = s_text.size();
+    while (i_start > 0 && VirtualKeyboardPredictionWorker::isWordCharacter(s_text.at(i_start - 1))) --i_start;
 
-void VirtualKeyboard::on_pushButton_principalKey_numbers_clicked()
-{
-    this->toggleNumbers();
+    if (i_start == 0 && s_text.size() > VIRTUALKEYBOARD_PREDICTION_MAXIMUMWORDLENGTH) return QString();
+    return s_text.mid(i_start);
 }
 
 
-void VirtualKeyboard::on_pushButton_principalKey_punctuation_clicked()
+void VirtualKeyboard::pressKeyWithTap(int i_keyId, const QPointF &o_position)
 {
-    this->togglePunctuation();
+    this->mo_tapPosition = o_position;
+    this->mb_isTapPositionSet = true;
+
+    this->keyDown(i_keyId);
+    this->keyUp(i_keyId);
+    this->keyClicked(i_keyId);
+
+    this->mb_isTapPositionSet = false;
 }
 
 
-void VirtualKeyboard::on_pushButton_principalKey_enter_clicked()
+QPointF VirtualKeyboard::pointerPosition() const
 {
-    emit this->enterKeyPressed();
+    if (this->mw_surface != NULL) return QPointF(this->mw_surface->pos()) + this->mw_surface->pressPosition();
+
+    return QPointF(this->mapFromGlobal(QCursor::pos()));
 }
 
 
-void VirtualKeyboard::on_pushButton_secondaryKey_copy_clicked()
+QRectF VirtualKeyboard::principalKeyRect(int i_indexKey) const
 {
-    // Line Edit
-    if (this->mi_inputType == VIRTUALKEYBOARD_INPUT_LINEEDIT && this->mw_lineEdit)
+    if (this->mw_surface != NULL)
     {
-        this->mw_lineEdit->copy();
+        const QRectF o_rect = this->mw_surface->geometry().keyRect(i_indexKey);
+        return o_rect.isNull() ? o_rect : o_rect.translated(this->mw_surface->pos());
     }
-    // Plain Text Edit
-    else if (this->mi_inputType == VIRTUALKEYBOARD_INPUT_PLAINTEXTEDIT && this->mw_plainTextEdit)
-    {
-        this->mw_plainTextEdit->copy();
-    }
-    // Text Edit
-    else if (this->mi_inputType == VIRTUALKEYBOARD_INPUT_TEXTEDIT && this->mw_textEdit)
+
+    if (i_indexKey < 0 || i_indexKey >= this->mlistw_principalKeys.size() || this->mlistw_principalKeys.at(i_indexKey)->isHidden())
+        return QRectF();
+
+    const QPushButton *w_pushButton = this->mlistw_principalKeys.at(i_indexKey);
+    return QRectF(w_pushButton->mapTo(this, QPoint(0, 0)), QSizeF(w_pushButton->size()));
+}
+
+
+void VirtualKeyboard::recordTap(const QString &s_text)
+{
+    // Only the words of letters are corrected
+    if (s_text.size() != 1 || !s_text.at(0).isLetter())
     {
-        this->mw_textEdit->copy();
+        this->clearTaps();
+        return;
     }
+
+    // Words longer than the longest word completed : not recorded, the word of the taps will not match the text
+    if (this->mveco_taps.size() > VIRTUALKEYBOARD_PREDICTION_MAXIMUMWORDLENGTH) return;
+
+    this->mveco_taps.append(this->mo_tapPosition);
+    this->ms_tapWord += s_text;
 }
 
 
-void VirtualKeyboard::on_pushButton_secondaryKey_cut_clicked()
+void VirtualKeyboard::clearTaps()
+{
+    this->mveco_taps.clear();
+    this->ms_tapWord.clear();
+}
+
+
+void VirtualKeyboard::letterKeys(QString *ps_characters, QVector<QRectF> *pveco_rects) const
 {
-    // Line Edit
-    if (this->mi_inputType == VIRTUALKEYBOARD_INPUT_LINEEDIT && this->mw_lineEdit)
+    ps_characters->clear();
+    pveco_rects->clear();
+
+    for (int i_i = 0; i_i < this->mpo_keymap->keyCount(); ++i_i)
     {
-        this->mw_lineEdit->cut();
+        if (this->mpo_keymap->isKeyEmpty(this->mi_currentLayer, i_i)) continue;
+
+        const QString s_key = this->mpo_keymap->keyText(this->mi_currentLayer, i_i);
+        const QRectF o_rect = this->principalKeyRect(i_i);
+
+        if (s_key.size() != 1 || !s_key.at(0).isLetter() || o_rect.isEmpty()) continue;
+
+        *ps_characters += s_key.at(0);
+        pveco_rects->append(o_rect);
     }
-    // Plain Text Edit
-    else if (this->mi_inputType == VIRTUALKEYBOARD_INPUT_PLAINTEXTEDIT && this->mw_plainTextEdit)
+}
+
+
+void VirtualKeyboard::correctWord()
+{
+    const QVector<QPointF> veco_taps = this->mveco_taps;
+    const QString s_tapWord = this->ms_tapWord;
+
+    this->clearTaps();
+    this->ms_correction.clear();
+
+    // New sequence number : the correction of the previous word is dropped if it has not come yet
+    ++this->mi_correctionSequence;
+
+    if (this->mpo_dictionary == NULL) return;
+
+    // The word before the cursor must be the one of the taps (no cursor move, paste, ... since its first letter)
+    this->flushCoalescedKeys();
+    if (this->currentWord() != s_tapWord) return;
+
+    // The candidates are scored in the worker thread : a space never waits for the walk of the dictionary
+    if (!this->postKeys()) return;
+
+    VirtualKeyboardPredictionEvent o_event;
+    o_event.i_type = VIRTUALKEYBOARD_PREDICTIONEVENT_CORRECTION;
+    o_event.i_sequence = this->mi_correctionSequence;
+    o_event.s_text = s_tapWord;
+    o_event.veco_points = veco_taps;
+
+    this->mpo_predictionWorker->post(o_event);
+}
+
+
+bool VirtualKeyboard::postKeys()
+{
+    if (!this->mb_isKeyModelDirty) return true;
+
+    VirtualKeyboardPredictionEvent o_event;
+    o_event.i_type = VIRTUALKEYBOARD_PREDICTIONEVENT_KEYS;
+    o_event.i_sequence = 0;
+    this->letterKeys(&o_event.s_text, &o_event.veco_rects);
+
+    // Queue full : posted again with the next word
+    this->mb_isKeyModelDirty = !this->mpo_predictionWorker->post(o_event);
+    return !this->mb_isKeyModelDirty;
+}
+
+
+void VirtualKeyboard::schedulePrediction()
+{
+    if (this->mpo_dictionary != NULL && !this->mo_timerPrediction.isActive()) this->mo_timerPrediction.start(0);
+}
+
+
+void VirtualKeyboard::postPredictionEvent(int i_type, const QString &s_text)
+{
+    if (this->mpo_dictionary == NULL) return;
+
+    VirtualKeyboardPredictionEvent o_event;
+    o_event.i_type = i_type;
+    o_event.i_sequence = ++this->mi_predictionSequence;
+    o_event.s_text = s_text;
+
+    // Word the worker will have : kept here to send it whole when an event is lost
+    VirtualKeyboardPredictionWorker::applyEvent(this->ms_predictionWord, o_event);
+
+    if (this->mb_isPredictionDesynchronized)
     {
-        this->mw_plainTextEdit->cut();
+        o_event.i_type = VIRTUALKEYBOARD_PREDICTIONEVENT_RESET;
+        o_event.s_text = this->ms_predictionWord;
     }
-    // Text Edit
-    else if (this->mi_inputType == VIRTUALKEYBOARD_INPUT_TEXTEDIT && this->mw_textEdit)
+
+    this->mb_isPredictionDesynchronized = !this->mpo_predictionWorker->post(o_event);
+}
+
+
+void VirtualKeyboard::synchronizePrediction()
+{
+    this->mo_timerPrediction.stop();
+
+    // Keys still buffered : the input widget changes again when they are flushed
+    if (this->mpo_dictionary == NULL || this->mi_coalescedBackspaceCount > 0 || !this->ms_coalescedText.isEmpty()) return;
+
+    const QString s_word = this->currentWord();
+    if (s_word != this->ms_predictionWord || this->mb_isPredictionDesynchronized)
+        this->postPredictionEvent(VIRTUALKEYBOARD_PREDICTIONEVENT_RESET, s_word);
+}
+
+
+void VirtualKeyboard::applySuggestions(int i_sequence, const QStringList &lists_suggestions)
+{
+    // Answer to an older event : the word has changed since
+    if (i_sequence != this->mi_predictionSequence) return;
+
+    if (lists_suggestions == this->mlists_suggestions) return;
+    this->mlists_suggestions = lists_suggestions;
+
+    for (int i_i = 0; i_i < this->mlistw_suggestionKeys.size(); ++i_i)
     {
-        this->mw_textEdit->cut();
+        QPushButton *w_pushButtonSuggestion = this->mlistw_suggestionKeys.at(i_i);
+        w_pushButtonSuggestion->setText(i_i < lists_suggestions.size() ? lists_suggestions.at(i_i) : QString());
+        w_pushButtonSuggestion->setEnabled(i_i < lists_suggestions.size());
     }
+
+    emit this->suggestionsChanged(lists_suggestions);
 }
 
 
-void VirtualKeyboard::on_pushButton_secondaryKey_paste_clicked()
+void VirtualKeyboard::applyTapCorrection(int i_sequence, const QString &s_word, const QString &s_correction)
 {
-    // Line Edit
-    if (this->mi_inputType == VIRTUALKEYBOARD_INPUT_LINEEDIT && this->mw_lineEdit)
+    // Correction of an older word, or the mode / the input widget has changed since
+    if (i_sequence != this->mi_correctionSequence || s_correction.isEmpty()) return;
+
+    if (this->mi_tapCorrectionMode == VIRTUALKEYBOARD_TAPCORRECTION_AUTOCORRECT)
     {
-        this->mw_lineEdit->paste();
+        // Undo step of its own : undoing it gives back the word typed (nothing if the text has changed after its space)
+        if (!this->pressCorrection(s_word, s_correction)) return;
     }
-    // Plain Text Edit
-    else if (this->mi_inputType == VIRTUALKEYBOARD_INPUT_PLAINTEXTEDIT && this->mw_plainTextEdit)
+    else if (this->mi_tapCorrectionMode == VIRTUALKEYBOARD_TAPCORRECTION_SUGGEST)
     {
-        this->mw_plainTextEdit->paste();
+        this->ms_correctedWord = s_word;
+        this->ms_correction = s_correction;
     }
-    // Text Edit
-    else if (this->mi_inputType == VIRTUALKEYBOARD_INPUT_TEXTEDIT && this->mw_textEdit)
+    else
     {
-        this->mw_textEdit->paste();
+        return;
     }
+
+    emit this->correctionFound(s_word, s_correction, this->mi_tapCorrectionMode == VIRTUALKEYBOARD_TAPCORRECTION_AUTOCORRECT);
 }
 
 
-void VirtualKeyboard::connectFocusChanged()
+void VirtualKeyboard::pathTraced(const QVector<QPointF> &veco_path)
 {
-    // --- Connection to change the input widget dynamically
-    this->connect(qApp, &QApplication::focusChanged,
-                  this, &VirtualKeyboard::setInputWidget);
+    QVector<QPointF> veco_keyboardPath(veco_path);
+    const QPointF o_offset(this->mw_surface->pos());
+
+    for (int i_i = 0; i_i < veco_keyboardPath.size(); ++i_i) veco_keyboardPath[i_i] += o_offset;
+
+    this->traceGesture(veco_keyboardPath);
 }
 
 
-void VirtualKeyboard::disconnectFocusChanged()
+void VirtualKeyboard::keymapLoaded(const QString &s_language, bool b_isFound)
 {
-    // --- Disconnection to stop changing the input widget dynamically
-    this->disconnect(qApp, &QApplication::focusChanged,
-                     this, &VirtualKeyboard::setInputWidget);
+    if (s_language != this->ms_loadingLanguage) return;
+
+    this->ms_loadingLanguage.clear();
+
+    // In the registry now : setLanguage() does not read the file again. An unknown language keeps the fallback keymap
+    if (b_isFound) this->setLanguage(s_language);
+
+    this->checkReady();
+}
+
+
+void VirtualKeyboard::dictionaryLoaded(const QString &s_fileName, bool b_isFound)
+{
+    if (s_fileName != this->ms_loadingDictionary) return;
+
+    this->ms_loadingDictionary.clear();
+    this->applyPredictionDictionary(b_isFound ? VirtualKeyboardDictionary::findLoaded(s_fileName) : NULL);
+
+    this->checkReady();
+}
+
+
+void VirtualKeyboard::checkReady()
+{
+    if (this->isReady()) emit this->ready();
+}
+
+
+void VirtualKeyboard::suggestionClicked(int i_index)
+{
+    if (i_index < 0 || i_index >= this->mlists_suggestions.size()) return;
+
+    // Copy : the edit updates the suggestions if the input widget emits its signals synchronously
+    this->pressSuggestion(QString(this->mlists_suggestions.at(i_index)));
+}
+
+
+void VirtualKeyboard::setLatencyInstrumentationEnabled(bool b_enabled)
+{
+    this->mb_isLatencyInstrumentationOn = b_enabled;
+    this->mi_latencyPressTime = -1;
+    this->mi_latencyPendingType = -1;
+
+    if (b_enabled && !this->mo_latencyClock.isValid()) this->mo_latencyClock.start();
+
+    this->connectLatencySource();
+}
+
+
+VirtualKeyboardLatencyStatistics VirtualKeyboard::latencyStatistics(int i_latencyType, int i_stage) const
+{
+    Q_ASSERT(i_latencyType >= 0 && i_latencyType < VIRTUALKEYBOARD_LATENCY_TYPECOUNT);
+    Q_ASSERT(i_stage >= 0 && i_stage < VIRTUALKEYBOARD_LATENCY_STAGECOUNT);
+
+    return this->mtto_latencyHistograms[i_latencyType][i_stage].statistics();
+}
+
+
+void VirtualKeyboard::resetLatencyStatistics()
+{
+    for (int i_type = 0; i_type < VIRTUALKEYBOARD_LATENCY_TYPECOUNT; ++i_type)
+    {
+        for (int i_stage = 0; i_stage < VIRTUALKEYBOARD_LATENCY_STAGECOUNT; ++i_stage)
+            this->mtto_latencyHistograms[i_type][i_stage].reset();
+    }
+}
+
+
+bool VirtualKeyboard::addSecondaryKey(QString s_keyText, int i_indexMapping)
+{
+    if (this->mw_secondaryBar != NULL) return this->mw_secondaryBar->addKey(s_keyText, i_indexMapping);
+
+    // If a key has previously been added with the index i_indexMapping we just return false
+    if (this->mmapw_secondaryKeys.contains(i_indexMapping)) return false;
+
+    // Button with the text passed as parameter, reused from the pool if possible
+    QPushButton *w_pushButtonSecondary = this->takeSecondaryKeyButton(s_keyText);
+
+    // Insertion of the button in a map indexed by the mapping index, to be able to remove or modify a button
+    this->mmapw_secondaryKeys.insert(i_indexMapping, w_pushButtonSecondary);
+
+    // Add a new secondary key
+    this->mw_frameSecondary->layout()->addWidget(w_pushButtonSecondary);
+    w_pushButtonSecondary->show();
+
+    // Map the button with the index passed as parameter
+    this->mo_mapperSecondaryKeys.setMapping(w_pushButtonSecondary, i_indexMapping);
+
+    return true;
+}
+
+
+bool VirtualKeyboard::addSnippetKey(QString s_keyText, int i_indexMapping, QString s_snippet, bool b_isTemplate)
+{
+    if (!this->addSecondaryKey(s_keyText, i_indexMapping)) return false;
+
+    this->mhasho_snippets.insert(i_indexMapping, VirtualKeyboardSnippet(s_snippet, b_isTemplate));
+    return true;
+}
+
+
+bool VirtualKeyboard::removeSecondaryKey(int i_indexMapping)
+{
+    this->mhasho_snippets.remove(i_indexMapping);
+
+    if (this->mw_secondaryBar != NULL) return this->mw_secondaryBar->removeKey(i_indexMapping);
+
+    // If no key has previously been added with the index i_indexMapping we just return false
+    if (!this->mmapw_secondaryKeys.contains(i_indexMapping)) return false;
+
+    // Remove the button from the map and from the widget
+    this->releaseSecondaryKeyButton(this->mmapw_secondaryKeys.take(i_indexMapping));
+
+    return true;
+}
+
+
+void VirtualKeyboard::setSecondaryKeys(const QMap<int, QString> &maps_keys)
+{
+    this->mhasho_snippets.clear();
+
+    if (this->mw_secondaryBar != NULL)
+    {
+        this->mw_secondaryBar->setKeys(maps_keys);
+        return;
+    }
+
+    this->beginSecondaryKeysUpdate();
+
+    // --- Keys which are not in the new set : their buttons go back to the pool
+    const QList<int> listi_indexes = this->mmapw_secondaryKeys.keys();
+
+    for (int i_i = 0; i_i < listi_indexes.size(); ++i_i)
+    {
+        if (!maps_keys.contains(listi_indexes.at(i_i)))
+            this->releaseSecondaryKeyButton(this->mmapw_secondaryKeys.take(listi_indexes.at(i_i)));
+    }
+
+    // --- Keys of the new set, appended to the layout in the order of their indexes (the keys kept are moved)
+    QLayout *po_layout = this->mw_frameSecondary->layout();
+
+    for (QMap<int, QString>::const_iterator it_key = maps_keys.constBegin(); it_key != maps_keys.constEnd(); ++it_key)
+    {
+        QPushButton *w_pushButtonSecondary = this->mmapw_secondaryKeys.value(it_key.key(), NULL);
+
+        if (w_pushButtonSecondary == NULL)
+        {
+            w_pushButtonSecondary = this->takeSecondaryKeyButton(it_key.value());
+            this->mmapw_secondaryKeys.insert(it_key.key(), w_pushButtonSecondary);
+            this->mo_mapperSecondaryKeys.setMapping(w_pushButtonSecondary, it_key.key());
+        }
+        else
+        {
+            if (w_pushButtonSecondary->text() != it_key.value()) w_pushButtonSecondary->setText(it_key.value());
+            po_layout->removeWidget(w_pushButtonSecondary);
+        }
+
+        po_layout->addWidget(w_pushButtonSecondary);
+        w_pushButtonSecondary->show();
+    }
+
+    this->endSecondaryKeysUpdate();
+}
+
+
+void VirtualKeyboard::beginSecondaryKeysUpdate()
+{
+    if (this->mi_secondaryKeysUpdateDepth++ > 0) return;
+
+    this->mw_frameSecondary->setUpdatesEnabled(false);
+    this->mw_frameSecondary->layout()->setEnabled(false);
+}
+
+
+void VirtualKeyboard::endSecondaryKeysUpdate()
+{
+    if (this->mi_secondaryKeysUpdateDepth == 0 || --this->mi_secondaryKeysUpdateDepth > 0) return;
+
+    // Single layout pass for the whole batch
+    QLayout *po_layout = this->mw_frameSecondary->layout();
+    po_layout->setEnabled(true);
+    po_layout->activate();
+
+    this->mw_frameSecondary->setUpdatesEnabled(true);
+}
+
+
+QPushButton *VirtualKeyboard::takeSecondaryKeyButton(const QString &s_keyText)
+{
+    if (!this->mlistw_secondaryKeysPool.isEmpty())
+    {
+        QPushButton *w_pushButtonSecondary = this->mlistw_secondaryKeysPool.takeLast();
+        w_pushButtonSecondary->setText(s_keyText);
+        return w_pushButtonSecondary;
+    }
+
+    // Button creation with the text passed as parameter
+    QPushButton *w_pushButtonSecondary = new QPushButton(s_keyText, this->mw_frameSecondary);
+
+    // Set minimum height for the button
+    w_pushButtonSecondary->setMinimumHeight(50);
+    // Set the same font as the others secondary buttons
+    w_pushButtonSecondary->setFont(this->mw_frameSecondary->font());
+
+    // Connection between the button and the signal mapper (kept while the button is in the pool, the mapping is replaced on reuse)
+    connect(w_pushButtonSecondary,          SIGNAL(clicked()),
+            &this->mo_mapperSecondaryKeys,  SLOT(map()));
+
+    return w_pushButtonSecondary;
+}
+
+
+void VirtualKeyboard::releaseSecondaryKeyButton(QPushButton *w_pushButtonSecondary)
+{
+    this->mw_frameSecondary->layout()->removeWidget(w_pushButtonSecondary);
+
+    if (this->mlistw_secondaryKeysPool.size() < VIRTUALKEYBOARD_SECONDARYKEYS_POOLSIZE)
+    {
+        w_pushButtonSecondary->hide();
+        this->mlistw_secondaryKeysPool.append(w_pushButtonSecondary);
+    }
+    else
+        delete w_pushButtonSecondary;
+}
+
+
+void VirtualKeyboard::setupPaintedUi()
+{
+    QHBoxLayout *w_layout = new QHBoxLayout(this);
+
+    // --- Principal keys
+    this->mw_surface = new VirtualKeyboardSurface(this);
+    this->mw_surface->setKeyText(VIRTUALKEYBOARD_KEY_CAPS,          "Caps");
+    this->mw_surface->setKeyText(VIRTUALKEYBOARD_KEY_NUMBERS,       VIRTUALKEYBOARD_BUTTONTEXT_NUMBERS_OFF);
+    this->mw_surface->setKeyText(VIRTUALKEYBOARD_KEY_PUNCTUATION,   ".,;!");
+    this->mw_surface->setKeyText(VIRTUALKEYBOARD_KEY_SPACE,         "Space");
+    this->mw_surface->setKeyIcon(VIRTUALKEYBOARD_KEY_BACKSPACE,     QIcon(":/keys/backspace"));
+    this->mw_surface->setKeyIcon(VIRTUALKEYBOARD_KEY_ENTER,         QIcon(":/keys/enter"));
+    w_layout->addWidget(this->mw_surface, 6);
+
+    connect(this->mw_surface,   SIGNAL(keyDown(int)),
+            this,               SLOT(keyDown(int)));
+    connect(this->mw_surface,   SIGNAL(keyUp(int)),
+            this,               SLOT(keyUp(int)));
+    connect(this->mw_surface,   SIGNAL(keyClicked(int)),
+            this,               SLOT(keyClicked(int)));
+    connect(this->mw_surface,   SIGNAL(pathTraced(QVector<QPointF>)),
+            this,               SLOT(pathTraced(QVector<QPointF>)));
+    this->mw_surface->setPathTracing(this->mb_isGestureTypingOn && this->mi_commitMode == VIRTUALKEYBOARD_COMMIT_ONRELEASE);
+
+    // --- Secondary keys, same properties as in VirtualKeyboard.ui
+    this->mw_frameSecondary = new QFrame(this);
+    this->mw_frameSecondary->setObjectName("frame_secondary");
+    this->mw_frameSecondary->setFrameShape(QFrame::StyledPanel);
+    this->mw_frameSecondary->setFrameShadow(QFrame::Raised);
+    this->mw_frameSecondary->setFont(this->mw_surface->font());
+
+    QVBoxLayout *w_layoutSecondary = new QVBoxLayout(this->mw_frameSecondary);
+    const char *tc_secondaryKeys[][2] = {{"pushButton_secondaryKey_cut",   "Cut"},
+                                         {"pushButton_secondaryKey_copy",  "Copy"},
+                                         {"pushButton_secondaryKey_paste", "Paste"}};
+
+    for (int i_i = 0; i_i < 3; ++i_i)
+    {
+        QPushButton *w_pushButtonSecondary = new QPushButton(tc_secondaryKeys[i_i][1], this->mw_frameSecondary);
+        w_pushButtonSecondary->setObjectName(tc_secondaryKeys[i_i][0]);
+        w_pushButtonSecondary->setMinimumSize(70, 50);
+        w_pushButtonSecondary->setFocusPolicy(Qt::NoFocus);
+        w_layoutSecondary->addWidget(w_pushButtonSecondary);
+    }
+
+    // Secondary keys added programmatically : scrollable column below cut / copy / paste
+    this->mw_secondaryBar = new VirtualKeyboardSecondaryBar(this->mw_frameSecondary);
+    w_layoutSecondary->addWidget(this->mw_secondaryBar, 1);
+
+    connect(this->mw_secondaryBar,  SIGNAL(keyClicked(int)),
+            this,                   SLOT(secondaryKeyClicked(int)));
+
+    w_layout->addWidget(this->mw_frameSecondary, 1);
+
+    // Connect the on_pushButton_secondaryKey_*_clicked slots, as done by setupUi in the VIRTUALKEYBOARD_RENDER_WIDGETS mode
+    QMetaObject::connectSlotsByName(this);
+}
+
+
+int VirtualKeyboard::keyAt(const QPoint &o_position) const
+{
+    // Painted surface : hit-testing grid
+    if (this->mw_surface != NULL)
+    {
+        return this->mw_surface->geometry().keyAt(this->mw_surface->mapFrom(this, o_position));
+    }
+
+    // Widgets : Qt hit-testing, then lookup of the button
+    QPushButton *w_pushButton = qobject_cast<QPushButton *>(this->childAt(o_position));
+
+    if (w_pushButton == NULL) return VIRTUALKEYBOARD_KEY_NONE;
+
+    const int i_indexKey = this->mlistw_principalKeys.indexOf(w_pushButton);
+    if (i_indexKey >= 0) return i_indexKey;
+
+    for (int i_keyId = VIRTUALKEYBOARD_KEY_CAPS; i_keyId <= VIRTUALKEYBOARD_KEY_ENTER; ++i_keyId)
+    {
+        if (this->specialKeyButton(i_keyId) == w_pushButton) return i_keyId;
+    }
+    return VIRTUALKEYBOARD_KEY_NONE;
+}
+
+
+bool VirtualKeyboard::initialisationKeymaps(QString s_language)
+{
+    this->ms_loadingLanguage.clear();
+
+    // Asynchronous loading : a keymap not loaded yet is loaded in the background, the built-in fallback keymap is used meanwhile
+    if (this->mb_isAsynchronousLoadingOn && VirtualKeyboardKeymap::findLoaded(s_language) == NULL)
+    {
+        this->ms_loadingLanguage = s_language;
+        VirtualKeyboardLoader::instance()->loadKeymap(s_language);
+        s_language = VIRTUALKEYBOARD_LOADING_FALLBACKLANGUAGE;
+    }
+
+    // Loaded on first use and shared by every keyboard, NULL if no keymap file exists for the language
+    this->mpo_keymap = VirtualKeyboardKeymap::find(s_language);
+    this->ms_language = this->mpo_keymap != NULL ? s_language : QString();
+
+    return this->mpo_keymap != NULL;
+}
+
+
+bool VirtualKeyboard::isKeymapShown(const VirtualKeyboardKeymap *po_keymap, int i_renderMode)
+{
+    if (i_renderMode == VIRTUALKEYBOARD_RENDER_PAINTED) return true;
+
+    const int i_rowCount = po_keymap->rowCount();
+    if (i_rowCount > int(sizeof(sti_widgetsRowKeyCounts) / sizeof(sti_widgetsRowKeyCounts[0]))) return false;
+
+    // The keys are mapped in order on the buttons : every row but the last one must be full
+    for (int i_row = 0; i_row < i_rowCount; ++i_row)
+    {
+        const int i_keyCount = po_keymap->rowKeyCount(i_row);
+
+        if (i_keyCount > sti_widgetsRowKeyCounts[i_row] || (i_row < i_rowCount - 1 && i_keyCount < sti_widgetsRowKeyCounts[i_row]))
+            return false;
+    }
+    return true;
+}
+
+
+void VirtualKeyboard::setKeymap(int i_layer)
+{
+    this->mi_currentLayer = i_layer;
+    this->mb_isKeyModelDirty = true;
+    this->mo_keyFilter.setKeymap(this->mpo_keymap, i_layer);
+
+    // Painted surface : the layer is pre-rendered, switching is a blit
+    if (this->mw_surface != NULL)
+    {
+        this->mw_surface->setKeymap(this->mpo_keymap, i_layer);
+        return;
+    }
+
+    // Widgets : repaint the keyboard once, after every button has been updated
+    // (the keys of the keymap are mapped in order on the buttons of VirtualKeyboard.ui, whose rows it has : see isKeymapShown())
+    this->setUpdatesEnabled(false);
+
+    for (int i_i = 0; i_i < this->mlistw_principalKeys.size(); ++i_i)
+    {
+        // if there is no key at i_i in the layer, we hide the button
+        if (this->mpo_keymap->isKeyEmpty(i_layer, i_i))
+        {
+            this->mlistw_principalKeys.at(i_i)->hide();
+        }
+        else // We set the text of the key ('&' is doubled, else the button would take it as a shortcut marker)
+        {
+            const QString s_key = this->mpo_keymap->keyText(i_layer, i_i);
+            this->mlistw_principalKeys.at(i_i)->setText(s_key.contains('&') ? QString(s_key).replace("&", "&&") : s_key);
+            if (this->mlistw_principalKeys.at(i_i)->isHidden()) this->mlistw_principalKeys.at(i_i)->show();
+        }
+    }
+
+    this->setUpdatesEnabled(true);
+}
+
+
+void VirtualKeyboard::toggleCapsLock()
+{
+    // We change the state of the caps lock and reset to false the others states and buttons
+    this->mb_isCapsOn = !this->mb_isCapsOn;
+    this->mb_isNumberOn = false;
+    this->setSpecialKeyText(VIRTUALKEYBOARD_KEY_NUMBERS, VIRTUALKEYBOARD_BUTTONTEXT_NUMBERS_OFF);
+    this->mb_isPunctuationOn = false;
+    this->setSpecialKeyText(VIRTUALKEYBOARD_KEY_PUNCTUATION, VIRTUALKEYBOARD_BUTTONTEXT_PUNCTUATION_OFF);
+
+    if (this->mb_isCapsOn)
+    {
+        this->setKeymap(VIRTUALKEYBOARD_LAYER_UPPER);
+        this->setSpecialKeyChecked(VIRTUALKEYBOARD_KEY_CAPS, true);
+    }
+    else
+    {
+        this->setKeymap(VIRTUALKEYBOARD_LAYER_LOWER);
+        this->setSpecialKeyChecked(VIRTUALKEYBOARD_KEY_CAPS, false);
+    }
+}
+
+
+void VirtualKeyboard::toggleNumbers()
+{
+    // We change the state of the "numbers" boolean and reset to false the others states and buttons
+    this->mb_isNumberOn = !this->mb_isNumberOn;
+    this->mb_isCapsOn = false;
+    this->setSpecialKeyChecked(VIRTUALKEYBOARD_KEY_CAPS, false);
+    this->mb_isPunctuationOn = false;
+    this->setSpecialKeyText(VIRTUALKEYBOARD_KEY_PUNCTUATION, VIRTUALKEYBOARD_BUTTONTEXT_PUNCTUATION_OFF);
+
+    if (this->mb_isNumberOn)
+    {
+        this->setKeymap(VIRTUALKEYBOARD_LAYER_NUMBERS);
+        this->setSpecialKeyText(VIRTUALKEYBOARD_KEY_NUMBERS, VIRTUALKEYBOARD_BUTTONTEXT_NUMBERS_ON);
+    }
+    else
+    {
+        this->setKeymap(VIRTUALKEYBOARD_LAYER_LOWER);
+        this->setSpecialKeyText(VIRTUALKEYBOARD_KEY_NUMBERS, VIRTUALKEYBOARD_BUTTONTEXT_NUMBERS_OFF);
+    }
+    this->setSpecialKeyEnabled(VIRTUALKEYBOARD_KEY_CAPS, !this->mb_isNumberOn);
+}
+
+
+void VirtualKeyboard::togglePunctuation()
+{
+    // We change the state of the "Punctuation" boolean and reset to false the others states and buttons
+    this->mb_isPunctuationOn = !this->mb_isPunctuationOn;
+    this->mb_isCapsOn = false;
+    this->setSpecialKeyChecked(VIRTUALKEYBOARD_KEY_CAPS, false);
+    this->mb_isNumberOn = false;
+    this->setSpecialKeyText(VIRTUALKEYBOARD_KEY_NUMBERS, VIRTUALKEYBOARD_BUTTONTEXT_NUMBERS_OFF);
+
+    if (this->mb_isPunctuationOn)
+    {
+        this->setKeymap(VIRTUALKEYBOARD_LAYER_PUNCTUATION);
+        this->setSpecialKeyText(VIRTUALKEYBOARD_KEY_PUNCTUATION, VIRTUALKEYBOARD_BUTTONTEXT_PUNCTUATION_ON);
+    }
+    else
+    {
+        this->setKeymap(VIRTUALKEYBOARD_LAYER_LOWER);
+        this->setSpecialKeyText(VIRTUALKEYBOARD_KEY_PUNCTUATION, VIRTUALKEYBOARD_BUTTONTEXT_PUNCTUATION_OFF);
+    }
+    this->setSpecialKeyEnabled(VIRTUALKEYBOARD_KEY_CAPS, !this->mb_isPunctuationOn);
+}
+
+
+void VirtualKeyboard::toggleSecondaryKeysVisibility()
+{
+    this->mw_frameSecondary->setVisible(!this->mw_frameSecondary->isVisible());
+}
+
+
+void VirtualKeyboard::mapKeyButton(QPushButton *w_pushButton, int i_keyId)
+{
+    connect(w_pushButton,               SIGNAL(pressed()),
+            &this->mo_mapperKeysDown,   SLOT(map()));
+    connect(w_pushButton,               SIGNAL(released()),
+            &this->mo_mapperKeysUp,     SLOT(map()));
+    connect(w_pushButton,               SIGNAL(clicked()),
+            &this->mo_mapperPrimaryKeys, SLOT(map()));
+
+    this->mo_mapperKeysDown.setMapping(w_pushButton, i_keyId);
+    this->mo_mapperKeysUp.setMapping(w_pushButton, i_keyId);
+    this->mo_mapperPrimaryKeys.setMapping(w_pushButton, i_keyId);
+}
+
+
+bool VirtualKeyboard::isCommitKey(int i_keyId) const
+{
+    return i_keyId >= 0 || i_keyId == VIRTUALKEYBOARD_KEY_SPACE || i_keyId == VIRTUALKEYBOARD_KEY_BACKSPACE;
+}
+
+
+bool VirtualKeyboard::isAutoRepeatKey(int i_keyId) const
+{
+    // Backspace is always repeated (as it was with the autoRepeat property of its button), the characters only if enabled
+    return i_keyId == VIRTUALKEYBOARD_KEY_BACKSPACE
+            || (this->mb_isCharactersAutoRepeatOn && (i_keyId >= 0 || i_keyId == VIRTUALKEYBOARD_KEY_SPACE));
+}
+
+
+void VirtualKeyboard::connectLatencySource()
+{
+    if (this->mpo_latencySource)
+    {
+        disconnect(this->mpo_latencySource, 0, this, SLOT(inputChanged()));
+        this->mpo_latencySource.clear();
+    }
+
+    if (!this->mb_isLatencyInstrumentationOn) return;
+
+    const char *pc_signal;
+    QObject *po_notifier = this->mpo_inputTarget->changeNotifier(&pc_signal);
+
+    if (po_notifier != NULL)
+    {
+        this->mpo_latencySource = po_notifier;
+        connect(po_notifier,    pc_signal,
+                this,           SLOT(inputChanged()));
+    }
+}
+
+
+void VirtualKeyboard::connectPasteSources(bool b_isConnected)
+{
+    if (this->mpo_pasteChangeSource)
+    {
+        disconnect(this->mpo_pasteChangeSource, 0, this, SLOT(pasteTargetChanged()));
+        this->mpo_pasteChangeSource.clear();
+    }
+    if (this->mpo_pasteCursorSource)
+    {
+        disconnect(this->mpo_pasteCursorSource, 0, this, SLOT(pasteTargetChanged()));
+        this->mpo_pasteCursorSource.clear();
+    }
+
+    if (!b_isConnected) return;
+
+    const char *pc_signal;
+    QObject *po_notifier = this->mpo_inputTarget->changeNotifier(&pc_signal);
+
+    if (po_notifier != NULL)
+    {
+        this->mpo_pasteChangeSource = po_notifier;
+        connect(po_notifier,    pc_signal,
+                this,           SLOT(pasteTargetChanged()));
+    }
+
+    po_notifier = this->mpo_inputTarget->cursorNotifier(&pc_signal);
+
+    if (po_notifier != NULL)
+    {
+        this->mpo_pasteCursorSource = po_notifier;
+        connect(po_notifier,    pc_signal,
+                this,           SLOT(pasteTargetChanged()));
+    }
+}
+
+
+QPushButton *VirtualKeyboard::specialKeyButton(int i_keyId) const
+{
+    switch (i_keyId)
+    {
+    case VIRTUALKEYBOARD_KEY_CAPS:          return this->ui->pushButton_principalKey_caps;
+    case VIRTUALKEYBOARD_KEY_BACKSPACE:     return this->ui->pushButton_principalKey_backspace;
+    case VIRTUALKEYBOARD_KEY_NUMBERS:       return this->ui->pushButton_principalKey_numbers;
+    case VIRTUALKEYBOARD_KEY_PUNCTUATION:   return this->ui->pushButton_principalKey_punctuation;
+    case VIRTUALKEYBOARD_KEY_SPACE:         return this->ui->pushButton_principalKey_space;
+    case VIRTUALKEYBOARD_KEY_ENTER:         return this->ui->pushButton_principalKey_enter;
+    default:                                return NULL;
+    }
+}
+
+
+void VirtualKeyboard::setSpecialKeyText(int i_keyId, const QString &s_text)
+{
+    if (this->mw_surface != NULL)   this->mw_surface->setKeyText(i_keyId, s_text);
+    else                            this->specialKeyButton(i_keyId)->setText(s_text);
+}
+
+
+void VirtualKeyboard::setSpecialKeyChecked(int i_keyId, bool b_checked)
+{
+    if (this->mw_surface != NULL)   this->mw_surface->setKeyChecked(i_keyId, b_checked);
+    else                            this->specialKeyButton(i_keyId)->setStyleSheet(b_checked ? "QPushButton { background-color: cyan; border-radius: 3px; }" : "");
+}
+
+
+void VirtualKeyboard::setSpecialKeyEnabled(int i_keyId, bool b_enabled)
+{
+    if (this->mw_surface != NULL)   this->mw_surface->setKeyEnabled(i_keyId, b_enabled);
+    else                            this->specialKeyButton(i_keyId)->setEnabled(b_enabled);
+}
+
+
+void VirtualKeyboard::setInputTarget(QWidget *w_widget, int i_type)
+{
+    // The widgets which can not be edited (buttons, non-editable combo boxes, ...) do not change the input widget
+    VirtualKeyboardInputTarget *po_inputTarget = VirtualKeyboardInputTarget::create(w_widget, i_type);
+
+    if (po_inputTarget == NULL) return;
+
+    // The keys buffered go to the widget they have been typed in, the paste in progress too
+    this->flushCoalescedKeys();
+    this->cancelPaste();
+
+    po_inputTarget->setLargeDocumentThreshold(this->mi_largeDocumentThreshold);
+    po_inputTarget->setUndoClearThreshold(this->mi_undoClearThreshold);
+    this->mpo_inputTarget.reset(po_inputTarget);
+    this->mi_undoGroup = VIRTUALKEYBOARD_UNDOGROUP_NONE;
+    this->updateKeyFilterTarget();
+    this->connectLatencySource();
+    this->connectPredictionSource();
+    this->schedulePrediction();
+
+    // The taps, the corrections offered or in progress and the paths being decoded belong to the text of the previous widget
+    ++this->mi_correctionSequence;
+    ++this->mi_gestureSequence;
+    this->clearTaps();
+    this->ms_correction.clear();
+}
+
+
+void VirtualKeyboard::keyPressed(int i_indexKey)
+{
+    // The filter probes the text of the line edit : the keys buffered before it had a validator / input mask are applied first
+    // (its state is then being updated and the key is tried)
+    if (this->mb_isKeyFilteringOn && this->mo_keyFilter.isFiltering()) this->flushCoalescedKeys();
+
+    // Key rejected by the validator / input mask of the line edit : not even tried
+    if (this->mb_isKeyFilteringOn && !this->mo_keyFilter.isKeyAccepted(i_indexKey)) return;
+
+    const QString s_text = this->mpo_keymap->keyText(this->mi_currentLayer, i_indexKey);
+
+    if (this->mi_tapCorrectionMode != VIRTUALKEYBOARD_TAPCORRECTION_OFF) this->recordTap(s_text);
+
+    this->commitText(s_text);
+}
+
+
+void VirtualKeyboard::dispatchKey(int i_keyId)
+{
+    emit this->keyDispatched(i_keyId);
+
+    // --- Latency instrumentation : press => dispatch
+    if (this->mb_isLatencyInstrumentationOn && this->isCommitKey(i_keyId))
+    {
+        const qint64 i_now = this->mo_latencyClock.nsecsElapsed();
+
+        // Keys dispatched without a press (programmatically) are measured from their dispatch
+        this->mi_latencyPendingPressTime = this->mi_latencyPressTime >= 0 ? this->mi_latencyPressTime : i_now;
+        this->mi_latencyPendingDispatch = (i_now - this->mi_latencyPendingPressTime) / 1000;
+        this->mi_latencyPressTime = -1;
+
+        if (i_keyId == VIRTUALKEYBOARD_KEY_SPACE)           this->mi_latencyPendingType = VIRTUALKEYBOARD_LATENCY_SPACE;
+        else if (i_keyId == VIRTUALKEYBOARD_KEY_BACKSPACE)  this->mi_latencyPendingType = VIRTUALKEYBOARD_LATENCY_BACKSPACE;
+        else                                                this->mi_latencyPendingType = VIRTUALKEYBOARD_LATENCY_CHARACTER;
+
+        this->mtto_latencyHistograms[this->mi_latencyPendingType][VIRTUALKEYBOARD_LATENCY_STAGE_DISPATCH].addSample(this->mi_latencyPendingDispatch);
+    }
+
+    // The keys reading or validating the text see every key typed before them
+    if (i_keyId == VIRTUALKEYBOARD_KEY_ENTER || i_keyId == VIRTUALKEYBOARD_KEY_CUT
+            || i_keyId == VIRTUALKEYBOARD_KEY_COPY || i_keyId == VIRTUALKEYBOARD_KEY_PASTE)
+    {
+        this->flushCoalescedKeys();
+        this->mi_undoGroup = VIRTUALKEYBOARD_UNDOGROUP_NONE;
+    }
+
+    switch (i_keyId)
+    {
+    case VIRTUALKEYBOARD_KEY_CAPS:          this->toggleCapsLock();         break;
+    case VIRTUALKEYBOARD_KEY_BACKSPACE:     this->sendBackspace();          break;
+    case VIRTUALKEYBOARD_KEY_NUMBERS:       this->toggleNumbers();          break;
+    case VIRTUALKEYBOARD_KEY_PUNCTUATION:   this->togglePunctuation();      break;
+    case VIRTUALKEYBOARD_KEY_SPACE:         this->sendSpace();              break;
+    case VIRTUALKEYBOARD_KEY_ENTER:         emit this->enterKeyPressed();   break;
+    case VIRTUALKEYBOARD_KEY_CUT:           this->sendCut();                break;
+    case VIRTUALKEYBOARD_KEY_COPY:          this->sendCopy();               break;
+    case VIRTUALKEYBOARD_KEY_PASTE:         this->sendPaste();              break;
+    default:                                this->keyPressed(i_keyId);      break;
+    }
+
+    // Key buffered by the coalescing : its commit is measured when it is flushed
+    if (this->isCoalescing() && this->mi_latencyPendingType >= 0)
+    {
+        VirtualKeyboardLatencyPendingKey o_key;
+        o_key.i_type = this->mi_latencyPendingType;
+        o_key.i_pressTime = this->mi_latencyPendingPressTime;
+        o_key.i_pressToDispatch = this->mi_latencyPendingDispatch;
+        this->mvec_coalescedLatencies.append(o_key);
+    }
+
+    // The input widgets change synchronously : a key still pending did not change the text (e.g. backspace at the start of the text)
+    this->mi_latencyPendingType = -1;
+}
+
+
+void VirtualKeyboard::pressKey(int i_keyId)
+{
+    // Principal keys which are not displayed on the current keymap can not be pressed
+    if (i_keyId >= 0 && (this->mpo_keymap == NULL || this->mpo_keymap->isKeyEmpty(this->mi_currentLayer, i_keyId)))
+        return;
+
+    // No pointer : the tap is on the centre of the key
+    const bool b_isTapped = i_keyId >= 0 && this->mi_tapCorrectionMode != VIRTUALKEYBOARD_TAPCORRECTION_OFF;
+    this->pressKeyWithTap(i_keyId, b_isTapped ? this->principalKeyRect(i_keyId).center() : QPointF());
+}
+
+
+int VirtualKeyboard::pressKeyAt(const QPointF &o_position)
+{
+    if (this->mpo_keymap == NULL) return VIRTUALKEYBOARD_KEY_NONE;
+
+    // Painted surface : hit-testing grid, only the principal keys are pressed
+    if (this->mw_surface != NULL)
+    {
+        const int i_keyId = this->mw_surface->geometry().keyAt(o_position - QPointF(this->mw_surface->pos()));
+
+        if (i_keyId < 0 || i_keyId >= this->mpo_keymap->keyCount() || this->mpo_keymap->isKeyEmpty(this->mi_currentLayer, i_keyId))
+            return VIRTUALKEYBOARD_KEY_NONE;
+
+        this->pressKeyWithTap(i_keyId, o_position);
+        return i_keyId;
+    }
+
+    // Widgets : scan of the principal keys
+    for (int i_i = 0; i_i < this->mpo_keymap->keyCount(); ++i_i)
+    {
+        if (this->mpo_keymap->isKeyEmpty(this->mi_currentLayer, i_i) || !this->principalKeyRect(i_i).contains(o_position)) continue;
+
+        this->pressKeyWithTap(i_i, o_position);
+        return i_i;
+    }
+
+    return VIRTUALKEYBOARD_KEY_NONE;
+}
+
+
+bool VirtualKeyboard::traceGesture(const QVector<QPointF> &veco_path)
+{
+    // New sequence number : the previous path is dropped if its words have not come yet
+    ++this->mi_gestureSequence;
+
+    if (!this->mb_isGestureTypingOn || this->mpo_dictionary == NULL || this->mpo_keymap == NULL) return false;
+
+    // The dictionary is walked in the worker thread : a release never waits for the decoding
+    if (!this->postKeys()) return false;
+
+    VirtualKeyboardPredictionEvent o_event;
+    o_event.i_type = VIRTUALKEYBOARD_PREDICTIONEVENT_GESTURE;
+    o_event.i_sequence = this->mi_gestureSequence;
+    o_event.veco_points = veco_path;
+
+    return this->mpo_predictionWorker->post(o_event);
+}
+
+
+void VirtualKeyboard::applyGestureWords(int i_sequence, const QStringList &lists_words)
+{
+    // Words of an older path, or a key has been typed / the input widget has changed since
+    if (i_sequence != this->mi_gestureSequence || lists_words.isEmpty()) return;
+
+    const QString s_word = this->mi_currentLayer == VIRTUALKEYBOARD_LAYER_UPPER ? lists_words.first().toUpper() : lists_words.first();
+    this->pressGestureWord(s_word);
+
+    emit this->gestureDecoded(lists_words);
+}
+
+
+bool VirtualKeyboard::pressGestureWord(const QString &s_word)
+{
+    if (s_word.isEmpty()) return false;
+
+    emit this->gestureWordDispatched(s_word);
+
+    // The word goes after the keys typed before it, in an undo step of its own, separated from the word before the cursor
+    this->cancelPaste();
+    this->flushCoalescedKeys();
+    this->groupUndo(VIRTUALKEYBOARD_UNDOGROUP_NONE, true);
+
+    const QString s_before = this->mpo_inputTarget->textBeforeCursor(1);
+    QString s_text = s_word;
+    if (!s_before.isEmpty() && VirtualKeyboardPredictionWorker::isWordCharacter(s_before.at(0))) s_text.prepend(QLatin1Char(' '));
+
+    // Not typed with taps : no tap correction of this word
+    this->clearTaps();
+
+    this->postPredictionEvent(VIRTUALKEYBOARD_PREDICTIONEVENT_TEXT, s_text);
+    this->mpo_inputTarget->insertText(s_text);
+    return true;
+}
+
+
+bool VirtualKeyboard::pressSuggestion(int i_index)
+{
+    if (i_index < 0 || i_index >= this->mlists_suggestions.size()) return false;
+
+    this->suggestionClicked(i_index);
+    return true;
+}
+
+
+bool VirtualKeyboard::pressSuggestion(const QString &s_suggestion)
+{
+    if (s_suggestion.isEmpty()) return false;
+
+    emit this->suggestionDispatched(s_suggestion);
+
+    // The keys buffered are part of the word completed
+    this->cancelPaste();
+    this->flushCoalescedKeys();
+    this->groupUndo(VIRTUALKEYBOARD_UNDOGROUP_NONE, true);
+    this->clearTaps();
+
+    // Rest of the word, or the whole word replacing the one typed if it does not start it anymore
+    const QString s_word = this->currentWord();
+
+    if (s_suggestion.startsWith(s_word))
+        this->mpo_inputTarget->applyEdit(0, s_suggestion.mid(s_word.size()) + QLatin1Char(' '));
+    else
+        this->mpo_inputTarget->applyEdit(s_word.size(), s_suggestion + QLatin1Char(' '));
+    return true;
+}
+
+
+bool VirtualKeyboard::pressSecondaryKey(int i_indexMapping)
+{
+    if (this->mw_secondaryBar != NULL)
+    {
+        if (!this->mw_secondaryBar->containsKey(i_indexMapping)) return false;
+
+        this->secondaryKeyClicked(i_indexMapping);
+        return true;
+    }
+
+    if (!this->mmapw_secondaryKeys.contains(i_indexMapping)) return false;
+
+    this->mmapw_secondaryKeys.value(i_indexMapping)->click();
+    return true;
+}
+
+
+void VirtualKeyboard::secondaryKeyClicked(int i_indexMapping)
+{
+    QHash<int, VirtualKeyboardSnippet>::const_iterator it_snippet = this->mhasho_snippets.constFind(i_indexMapping);
+
+    if (it_snippet == this->mhasho_snippets.constEnd())
+    {
+        emit this->secondaryKeyPressed(i_indexMapping);
+        return;
+    }
+
+    // Copy (shared text) : the slots connected to the input widget may remove the key
+    const VirtualKeyboardSnippet o_snippet = it_snippet.value();
+
+    emit this->snippetDispatched(i_indexMapping);
+
+    // The snippet goes after the keys typed before it, in an undo step of its own
+    this->cancelPaste();
+    this->flushCoalescedKeys();
+    this->groupUndo(VIRTUALKEYBOARD_UNDOGROUP_NONE, true);
+    this->clearTaps();
+
+    this->mpo_inputTarget->insertSnippet(o_snippet.text(), o_snippet.cursorPosition());
+}
+
+
+bool VirtualKeyboard::applyCorrection()
+{
+    if (this->ms_correction.isEmpty()) return false;
+
+    const QString s_word = this->ms_correctedWord;
+    const QString s_correction = this->ms_correction;
+    this->ms_correctedWord.clear();
+    this->ms_correction.clear();
+
+    return this->pressCorrection(s_word, s_correction);
+}
+
+
+bool VirtualKeyboard::pressCorrection(const QString &s_word, const QString &s_correction)
+{
+    const QString s_finishedWord = s_word + QLatin1Char(' ');
+
+    this->flushCoalescedKeys();
+
+    // Still the word and the space which finished it right before the cursor, the word not being the end of a longer one
+    const QString s_text = this->mpo_inputTarget->textBeforeCursor(s_finishedWord.size() + 1);
+    if (s_word.isEmpty() || !s_text.endsWith(s_finishedWord)) return false;
+    if (s_text.size() > s_finishedWord.size() && VirtualKeyboardPredictionWorker::isWordCharacter(s_text.at(0))) return false;
+
+    emit this->correctionDispatched(s_word, s_correction);
+
+    this->cancelPaste();
+    this->groupUndo(VIRTUALKEYBOARD_UNDOGROUP_NONE, true);
+    this->clearTaps();
+    this->mpo_inputTarget->applyEdit(s_finishedWord.size(), s_correction + QLatin1Char(' '));
+    return true;
+}
+
+
+void VirtualKeyboard::keyDown(int i_keyId)
+{
+    // Raw position of the press, for the tap correction
+    if (i_keyId >= 0 && this->mi_tapCorrectionMode != VIRTUALKEYBOARD_TAPCORRECTION_OFF && !this->mb_isTapPositionSet)
+        this->mo_tapPosition = this->pointerPosition();
+
+    if (this->mb_isLatencyInstrumentationOn) this->mi_latencyPressTime = this->mo_latencyClock.nsecsElapsed();
+
+    this->mi_heldKeyId = i_keyId;
+    this->mb_hasHeldKeyRepeated = false;
+
+    if (this->mi_commitMode == VIRTUALKEYBOARD_COMMIT_ONPRESS && this->isCommitKey(i_keyId))
+        this->dispatchKey(i_keyId);
+
+    if (this->isAutoRepeatKey(i_keyId))
+    {
+        this->mi_autoRepeatCurrentInterval = this->mi_autoRepeatInterval;
+        this->mo_timerAutoRepeat.start(this->mi_autoRepeatDelay);
+    }
+}
+
+
+void VirtualKeyboard::keyUp(int i_keyId)
+{
+    if (i_keyId != this->mi_heldKeyId) return;
+
+    // Released or slid off : stop repeating, the click (if any) is handled by keyClicked
+    this->mo_timerAutoRepeat.stop();
+}
+
+
+void VirtualKeyboard::keyClicked(int i_keyId)
+{
+    if (this->isCommitKey(i_keyId))
+    {
+        // Already committed on press, or by the auto-repeat
+        if (this->mi_commitMode == VIRTUALKEYBOARD_COMMIT_ONPRESS) return;
+        if (i_keyId == this->mi_heldKeyId && this->mb_hasHeldKeyRepeated) return;
+    }
+    this->dispatchKey(i_keyId);
+}
+
+
+void VirtualKeyboard::autoRepeat()
+{
+    if (this->mi_heldKeyId == VIRTUALKEYBOARD_KEY_NONE) return;
+
+    this->mb_hasHeldKeyRepeated = true;
+    if (this->mb_isLatencyInstrumentationOn) this->mi_latencyPressTime = this->mo_latencyClock.nsecsElapsed();
+    this->dispatchKey(this->mi_heldKeyId);
+
+    // Accelerate until the minimum interval is reached
+    this->mo_timerAutoRepeat.start(this->mi_autoRepeatCurrentInterval);
+    this->mi_autoRepeatCurrentInterval = qMax(this->mi_autoRepeatMinimumInterval,
+                                              qRound(this->mi_autoRepeatCurrentInterval * this->mr_autoRepeatAcceleration));
+}
+
+
+void VirtualKeyboard::inputChanged()
+{
+    // Keys buffered by the coalescing are measured by flushCoalescedKeys (the change may come from the keys flushed before this one)
+    if (this->mi_latencyPendingType < 0 || this->isCoalescing()) return;
+
+    const qint64 i_pressToCommit = (this->mo_latencyClock.nsecsElapsed() - this->mi_latencyPendingPressTime) / 1000;
+
+    this->mtto_latencyHistograms[this->mi_latencyPendingType][VIRTUALKEYBOARD_LATENCY_STAGE_COMMIT].addSample(i_pressToCommit);
+    emit this->latencyMeasured(this->mi_latencyPendingType, this->mi_latencyPendingDispatch, i_pressToCommit);
+
+    this->mi_latencyPendingType = -1;
+}
+
+
+void VirtualKeyboard::sendSpace()
+{
+    // End of the word of the taps : corrected before its space is typed
+    if (!this->mveco_taps.isEmpty()) this->correctWord();
+
+    this->commitText(" ");
+}
+
+
+void VirtualKeyboard::sendBackspace()
+{
+    this->commitBackspace();
+}
+
+
+void VirtualKeyboard::commitText(const QString &s_text)
+{
+    // The keys typed during a streaming paste stop it : its next chunks would follow them. The path being decoded is dropped too
+    this->cancelPaste();
+    ++this->mi_gestureSequence;
+    this->postPredictionEvent(VIRTUALKEYBOARD_PREDICTIONEVENT_TEXT, s_text);
+
+    if (!this->isCoalescing())
+    {
+        // Keys buffered before the validator or the input mask has been set
+        this->flushCoalescedKeys();
+        this->groupUndo(VIRTUALKEYBOARD_UNDOGROUP_CHARACTERS, s_text.endsWith(' '));
+        this->mpo_inputTarget->insertText(s_text);
+        return;
+    }
+
+    this->ms_coalescedText += s_text;
+    this->scheduleCoalescedFlush();
+}
+
+
+void VirtualKeyboard::commitBackspace()
+{
+    this->cancelPaste();
+    ++this->mi_gestureSequence;
+
+    if (!this->mveco_taps.isEmpty())
+    {
+        this->mveco_taps.removeLast();
+        this->ms_tapWord.chop(1);
+    }
+
+    this->postPredictionEvent(VIRTUALKEYBOARD_PREDICTIONEVENT_BACKSPACE, QString());
+
+    if (!this->isCoalescing())
+    {
+        this->flushCoalescedKeys();
+        this->groupUndo(VIRTUALKEYBOARD_UNDOGROUP_BACKSPACES, false);
+        this->mpo_inputTarget->deletePreviousChar();
+        return;
+    }
+
+    // The backspaces are applied before the text : a backspace after buffered text is applied with it
+    // (removing the last character of the buffer would not delete the selection the text replaces)
+    if (!this->ms_coalescedText.isEmpty()) this->flushCoalescedKeys();
+
+    ++this->mi_coalescedBackspaceCount;
+    this->scheduleCoalescedFlush();
+}
+
+
+void VirtualKeyboard::groupUndo(int i_group, bool b_isClosing)
+{
+    if (!this->mb_isUndoGroupingOn) return;
+
+    const bool b_isJoined = i_group != VIRTUALKEYBOARD_UNDOGROUP_NONE && i_group == this->mi_undoGroup
+                            && this->mo_undoGroupTimer.isValid() && this->mo_undoGroupTimer.elapsed() <= this->mi_undoGroupingMaximumGap;
+
+    this->mpo_inputTarget->groupNextEdit(b_isJoined);
+
+    this->mi_undoGroup = b_isClosing ? VIRTUALKEYBOARD_UNDOGROUP_NONE : i_group;
+    this->mo_undoGroupTimer.start();
+}
+
+
+void VirtualKeyboard::scheduleCoalescedFlush()
+{
+    if (!this->mo_timerCoalescing.isActive()) this->mo_timerCoalescing.start(this->mi_coalescingMaximumDelay);
+}
+
+
+void VirtualKeyboard::flushCoalescedKeys()
+{
+    if (this->mi_coalescedBackspaceCount == 0 && this->ms_coalescedText.isEmpty()) return;
+
+    this->mo_timerCoalescing.stop();
+
+    // Cleared before the edit : the input widget may emit signals handled by slots pressing other keys
+    const int i_backspaceCount = this->mi_coalescedBackspaceCount;
+    const QString s_text = this->ms_coalescedText;
+    this->mi_coalescedBackspaceCount = 0;
+    this->ms_coalescedText.clear();
+
+    // Backspaces followed by a text : a group of their own
+    if (i_backspaceCount == 0)      this->groupUndo(VIRTUALKEYBOARD_UNDOGROUP_CHARACTERS, s_text.endsWith(' '));
+    else if (s_text.isEmpty())      this->groupUndo(VIRTUALKEYBOARD_UNDOGROUP_BACKSPACES, false);
+    else                            this->groupUndo(VIRTUALKEYBOARD_UNDOGROUP_NONE, false);
+
+    this->mpo_inputTarget->applyEdit(i_backspaceCount, s_text);
+
+    // --- Latency instrumentation : press => commit of every key applied
+    if (!this->mvec_coalescedLatencies.isEmpty())
+    {
+        const qint64 i_now = this->mo_latencyClock.nsecsElapsed();
+
+        for (int i_i = 0; i_i < this->mvec_coalescedLatencies.size(); ++i_i)
+        {
+            const VirtualKeyboardLatencyPendingKey &o_key = this->mvec_coalescedLatencies.at(i_i);
+            const qint64 i_pressToCommit = (i_now - o_key.i_pressTime) / 1000;
+
+            this->mtto_latencyHistograms[o_key.i_type][VIRTUALKEYBOARD_LATENCY_STAGE_COMMIT].addSample(i_pressToCommit);
+            emit this->latencyMeasured(o_key.i_type, o_key.i_pressToDispatch, i_pressToCommit);
+        }
+        this->mvec_coalescedLatencies.resize(0);
+    }
+}
+
+
+void VirtualKeyboard::on_pushButton_principalKey_caps_clicked()
+{
+    this->dispatchKey(VIRTUALKEYBOARD_KEY_CAPS);
+}
+
+
+void VirtualKeyboard::on_pushButton_principalKey_numbers_clicked()
+{
+    this->dispatchKey(VIRTUALKEYBOARD_KEY_NUMBERS);
+}
+
+
+void VirtualKeyboard::on_pushButton_principalKey_punctuation_clicked()
+{
+    this->dispatchKey(VIRTUALKEYBOARD_KEY_PUNCTUATION);
+}
+
+
+void VirtualKeyboard::on_pushButton_principalKey_enter_clicked()
+{
+    this->dispatchKey(VIRTUALKEYBOARD_KEY_ENTER);
+}
+
+
+void VirtualKeyboard::on_pushButton_secondaryKey_copy_clicked()
+{
+    this->dispatchKey(VIRTUALKEYBOARD_KEY_COPY);
+}
+
+
+void VirtualKeyboard::on_pushButton_secondaryKey_cut_clicked()
+{
+    this->dispatchKey(VIRTUALKEYBOARD_KEY_CUT);
+}
+
+
+void VirtualKeyboard::on_pushButton_secondaryKey_paste_clicked()
+{
+    this->dispatchKey(VIRTUALKEYBOARD_KEY_PASTE);
+}
+
+
+void VirtualKeyboard::sendCopy()
+{
+    this->mpo_inputTarget->copy();
+}
+
+
+void VirtualKeyboard::sendCut()
+{
+    this->cancelPaste();
+    this->clearTaps();
+    this->mpo_inputTarget->cut();
+}
+
+
+void VirtualKeyboard::sendPaste()
+{
+    // A new paste replaces the one in progress
+    this->cancelPaste();
+    this->clearTaps();
+
+    const QString s_text = this->mb_isStreamingPasteOn ? QApplication::clipboard()->text() : QString();
+
+    if (s_text.size() < this->mi_pasteStreamingThreshold)
+    {
+        this->mpo_inputTarget->paste();
+        return;
+    }
+
+    this->ms_pasteText = s_text;
+    this->mi_pastePosition = 0;
+    this->mi_undoGroup = VIRTUALKEYBOARD_UNDOGROUP_NONE;
+
+    // Any other change of the text or of the cursor cancels the paste : the chunks are inserted at the cursor
+    this->connectPasteSources(true);
+
+    // The first chunk replaces the selection, synchronously
+    this->pasteNextChunk();
+}
+
+
+void VirtualKeyboard::pasteNextChunk()
+{
+    if (this->ms_pasteText.isEmpty()) return;
+
+    int i_chunkSize = qMin(this->mi_pasteChunkSize, this->ms_pasteText.size() - this->mi_pastePosition);
+
+    // A surrogate pair is not split between two chunks
+    if (this->ms_pasteText.at(this->mi_pastePosition + i_chunkSize - 1).isHighSurrogate()
+            && this->mi_pastePosition + i_chunkSize < this->ms_pasteText.size())
+        ++i_chunkSize;
+
+    // Every chunk after the first one is joined to its undo step
+    this->mb_isPasteChunkInserting = true;
+    this->mpo_inputTarget->groupNextEdit(this->mi_pastePosition > 0);
+    this->mpo_inputTarget->insertText(this->ms_pasteText.mid(this->mi_pastePosition, i_chunkSize));
+    this->mb_isPasteChunkInserting = false;
+
+    // Canceled by a slot connected to the input widget
+    if (this->ms_pasteText.isEmpty()) return;
+
+    this->mi_pastePosition += i_chunkSize;
+
+    const int i_totalCount = this->ms_pasteText.size();
+    emit this->pasteProgress(this->mi_pastePosition, i_totalCount);
+
+    if (this->mi_pastePosition < i_totalCount)
+    {
+        this->mo_timerPaste.start(0);
+        return;
+    }
+
+    this->connectPasteSources(false);
+    this->ms_pasteText.clear();
+    this->mi_pastePosition = 0;
+    emit this->pasteFinished();
+}
+
+
+void VirtualKeyboard::pasteTargetChanged()
+{
+    if (!this->mb_isPasteChunkInserting) this->cancelPaste();
+}
+
+
+void VirtualKeyboard::cancelPaste()
+{
+    if (this->ms_pasteText.isEmpty()) return;
+
+    this->mo_timerPaste.stop();
+    this->connectPasteSources(false);
+
+    const int i_insertedCount = this->mi_pastePosition;
+    const int i_totalCount = this->ms_pasteText.size();
+    this->ms_pasteText.clear();
+    this->mi_pastePosition = 0;
+
+    emit this->pasteCanceled(i_insertedCount, i_totalCount);
+}
+
+
+void VirtualKeyboard::connectFocusChanged()
+{
+    // --- One connection to QApplication::focusChanged is shared by all the keyboards
+    VirtualKeyboardFocusDispatcher::addKeyboard(this);
+}
+
+
+void VirtualKeyboard::disconnectFocusChanged()
+{
+    VirtualKeyboardFocusDispatcher::removeKeyboard(this);
+}
+
+
+void VirtualKeyboard::setFocusScope(QWidget *w_scope)
+{
+    this->mpw_focusScope = w_scope;
+    this->mb_isFocusScoped = w_scope != NULL;
+}
+
+
+QWidget *VirtualKeyboard::focusScope() const
+{
+    return this->mpw_focusScope;
+}
+
+
+bool VirtualKeyboard::eventFilter(QObject *po_watched, QEvent *po_event)
+{
+    if (po_event->type() == QEvent::Move || po_event->type() == QEvent::Resize) this->mb_isKeyModelDirty = true;
+
+    return QFrame::eventFilter(po_watched, po_event);
 }
@@ -32,20 +32,85 @@ SOFTWARE.
 #include <QPlainTextEdit>
 #include <QComboBox>
 #include <QPointer>
+#include <QScopedPointer>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QThread>
+#include <QHash>
 
 #include "ui_VirtualKeyboard.h"
+#include "VirtualKeyboardInputTarget.h"
+#include "VirtualKeyboardKeyFilter.h"
+#include "VirtualKeyboardKeymap.h"
+#include "VirtualKeyboardSurface.h"
+#include "VirtualKeyboardSecondaryBar.h"
+#include "VirtualKeyboardSnippet.h"
+#include "VirtualKeyboardDictionary.h"
+#include "VirtualKeyboardPredictionWorker.h"
+#include "VirtualKeyboardLatency.h"
+#include "VirtualKeyboardLoader.h"
 
 
 // Exit codes for initialisation
 #define VIRTUALKEYBOARD_SUCCESS 0
 #define VIRTUALKEYBOARD_UNKNOWLANGUAGE  1
 #define VIRTUALKEYBOARD_INIT_FAILED     2
+#define VIRTUALKEYBOARD_KEYMAPNOTSHOWN  3
 
-// Types of input widget
-#define VIRTUALKEYBOARD_INPUT_LINEEDIT      0
-#define VIRTUALKEYBOARD_INPUT_TEXTEDIT      1
-#define VIRTUALKEYBOARD_INPUT_PLAINTEXTEDIT 2
-#define VIRTUALKEYBOARD_INPUT_UNKNOWINPUTTYPE -1
+// Rendering modes of the principal keys
+#define VIRTUALKEYBOARD_RENDER_WIDGETS  0
+#define VIRTUALKEYBOARD_RENDER_PAINTED  1
+
+// Commit modes of the principal keys, space and backspace
+#define VIRTUALKEYBOARD_COMMIT_ONRELEASE    0
+#define VIRTUALKEYBOARD_COMMIT_ONPRESS      1
+
+// Default auto-repeat timings, in ms (delay and interval are the default values of QAbstractButton)
+#define VIRTUALKEYBOARD_AUTOREPEAT_DELAY            300
+#define VIRTUALKEYBOARD_AUTOREPEAT_INTERVAL         100
+#define VIRTUALKEYBOARD_AUTOREPEAT_MINIMUMINTERVAL  100
+#define VIRTUALKEYBOARD_AUTOREPEAT_ACCELERATION     1.0
+
+// Default maximum delay of the keystroke coalescing, in ms (one frame at 60 Hz)
+#define VIRTUALKEYBOARD_COALESCING_MAXIMUMDELAY     16
+
+// Default maximum delay between two keys of an undo group, in ms
+#define VIRTUALKEYBOARD_UNDOGROUPING_MAXIMUMGAP     1000
+
+// Undo groups : keys undone together
+#define VIRTUALKEYBOARD_UNDOGROUP_NONE              0
+#define VIRTUALKEYBOARD_UNDOGROUP_CHARACTERS        1
+#define VIRTUALKEYBOARD_UNDOGROUP_BACKSPACES        2
+
+// Default streaming paste : size from which a paste is streamed, and size of the chunks inserted, in characters
+#define VIRTUALKEYBOARD_PASTE_STREAMINGTHRESHOLD    65536
+#define VIRTUALKEYBOARD_PASTE_CHUNKSIZE             8192
+
+// Maximum number of secondary key buttons kept hidden for reuse after their key has been removed
+#define VIRTUALKEYBOARD_SECONDARYKEYS_POOLSIZE      64
+
+// Number of suggestions displayed by the word prediction
+#define VIRTUALKEYBOARD_PREDICTION_SUGGESTIONCOUNT  3
+
+// Built-in language displayed while the keymap requested is loaded in the background
+#define VIRTUALKEYBOARD_LOADING_FALLBACKLANGUAGE    "EN"
+
+// Tap correction modes
+#define VIRTUALKEYBOARD_TAPCORRECTION_OFF           0
+#define VIRTUALKEYBOARD_TAPCORRECTION_SUGGEST       1
+#define VIRTUALKEYBOARD_TAPCORRECTION_AUTOCORRECT   2
+
+// Input types of the latency instrumentation
+#define VIRTUALKEYBOARD_LATENCY_CHARACTER   0
+#define VIRTUALKEYBOARD_LATENCY_SPACE       1
+#define VIRTUALKEYBOARD_LATENCY_BACKSPACE   2
+#define VIRTUALKEYBOARD_LATENCY_TYPECOUNT   3
+
+// Stages measured by the latency instrumentation (both measured from the key press)
+#define VIRTUALKEYBOARD_LATENCY_STAGE_DISPATCH  0
+#define VIRTUALKEYBOARD_LATENCY_STAGE_COMMIT    1
+#define VIRTUALKEYBOARD_LATENCY_STAGECOUNT      2
 
 // String used on some special keys
 #define VIRTUALKEYBOARD_BUTTONTEXT_NUMBERS_ON       "A/a"
@@ -54,199 +119,1103 @@ SOFTWARE.
 #define VIRTUALKEYBOARD_BUTTONTEXT_PUNCTUATION_ON   "A/a"
 
 
-namespace Ui {
-class VirtualKeyboard;
-}
+namespace Ui {
+class VirtualKeyboard;
+}
+
+/**
+ * \brief Virtual Keyboard widget
+ */
+class VirtualKeyboard : public QFrame
+{
+    Q_OBJECT
+
+    // The dispatcher gives the focused widgets to the keyboard (setInputTarget) according to its focus scope
+    friend class VirtualKeyboardFocusDispatcher;
+
+
+    // Private Members
+private:
+
+    /**
+     * User interface for the virtual keyboard
+     */
+    Ui::VirtualKeyboard *ui;
+
+    /**
+     * Surface on which the principal keys are drawn (VIRTUALKEYBOARD_RENDER_PAINTED mode only, else NULL)
+     */
+    VirtualKeyboardSurface *mw_surface;
+
+    /**
+     * Frame containing the secondary keys (from the UI in VIRTUALKEYBOARD_RENDER_WIDGETS mode, created programmatically in VIRTUALKEYBOARD_RENDER_PAINTED mode)
+     */
+    QFrame *mw_frameSecondary;
+
+    /**
+     * Input widget written by the keyboard, resolved when the input widget changes (never NULL : a target doing nothing when there is no input widget)
+     */
+    QScopedPointer<VirtualKeyboardInputTarget> mpo_inputTarget;
+
+    /**
+     * Widget subtree in which the focus is followed (see setFocusScope)
+     */
+    QPointer<QWidget> mpw_focusScope;
+
+    /**
+     * True if the focus is only followed inside mpw_focusScope
+     */
+    bool mb_isFocusScoped;
+
+    /**
+     * Map the clicked signal of the non specific "primary" keys, space and backspace to the keyClicked slot
+     */
+    QSignalMapper mo_mapperPrimaryKeys;
+
+    /**
+     * Map the pressed signal of the non specific keys, space and backspace to the keyDown slot
+     */
+    QSignalMapper mo_mapperKeysDown;
+
+    /**
+     * Map the released signal of the non specific keys, space and backspace to the keyUp slot
+     */
+    QSignalMapper mo_mapperKeysUp;
+
+    /**
+     * Map the "secondary" keys to the secondaryKeyClicked slot
+     */
+    QSignalMapper mo_mapperSecondaryKeys;
+
+    /**
+     * List of non specific buttons ([A - Z], [0 - 9], ...), empty in VIRTUALKEYBOARD_RENDER_PAINTED mode
+     */
+    QList<QPushButton *> mlistw_principalKeys;
+
+    /**
+     * Map containing the secondary keys added programmatically (via addSecondaryKey), in VIRTUALKEYBOARD_RENDER_WIDGETS mode
+     */
+    QMap<int, QPushButton *> mmapw_secondaryKeys;
+
+    /**
+     * Column of the secondary keys added programmatically in VIRTUALKEYBOARD_RENDER_PAINTED mode (NULL in VIRTUALKEYBOARD_RENDER_WIDGETS mode)
+     */
+    VirtualKeyboardSecondaryBar *mw_secondaryBar;
+
+    /**
+     * Buttons of the secondary keys removed, hidden and kept for the next keys added
+     */
+    QList<QPushButton *> mlistw_secondaryKeysPool;
+
+    /**
+     * Nesting depth of beginSecondaryKeysUpdate(), the layout of the secondary keys is suspended while it is not 0
+     */
+    int mi_secondaryKeysUpdateDepth;
+
+    /**
+     * Snippet of the secondary keys added by addSnippetKey, indexed by mapping index
+     */
+    QHash<int, VirtualKeyboardSnippet> mhasho_snippets;
+
+    /**
+     * Keymap of the language, shared with the other keyboards of the process
+     */
+    const VirtualKeyboardKeymap *mpo_keymap;
+
+    /**
+     * Language of the keymap
+     */
+    QString ms_language;
+
+    /**
+     * Layer of the keymap currently displayed (VIRTUALKEYBOARD_LAYER_*)
+     */
+    int mi_currentLayer;
+
+    /**
+     * Caps lock state
+     */
+    bool mb_isCapsOn;
+
+    /**
+     * Numbers state
+     */
+    bool mb_isNumberOn;
+
+    /**
+     * Punctuation state
+     */
+    bool mb_isPunctuationOn;
+
+    /**
+     * Rendering mode of the principal keys
+     *
+     * Possible values :
+     *  \li VIRTUALKEYBOARD_RENDER_WIDGETS
+     *  \li VIRTUALKEYBOARD_RENDER_PAINTED
+     */
+    int mi_renderMode;
+
+    /**
+     * Commit mode of the principal keys, space and backspace
+     *
+     * Possible values :
+     *  \li VIRTUALKEYBOARD_COMMIT_ONRELEASE
+     *  \li VIRTUALKEYBOARD_COMMIT_ONPRESS
+     */
+    int mi_commitMode;
+
+    /**
+     * True if the principal keys and space are repeated while held down (backspace is always repeated)
+     */
+    bool mb_isCharactersAutoRepeatOn;
+
+    /**
+     * Delay before the first repetition, in ms
+     */
+    int mi_autoRepeatDelay;
+
+    /**
+     * Interval between the first two repetitions, in ms
+     */
+    int mi_autoRepeatInterval;
+
+    /**
+     * Minimum interval between two repetitions, in ms
+     */
+    int mi_autoRepeatMinimumInterval;
+
+    /**
+     * Factor applied to the interval after each repetition
+     */
+    qreal mr_autoRepeatAcceleration;
+
+    /**
+     * Interval before the next repetition, in ms
+     */
+    int mi_autoRepeatCurrentInterval;
+
+    /**
+     * Timer used to repeat the held key
+     */
+    QTimer mo_timerAutoRepeat;
+
+    /**
+     * Key currently held down, VIRTUALKEYBOARD_KEY_NONE if none
+     */
+    int mi_heldKeyId;
+
+    /**
+     * True if the held key has been repeated at least once
+     */
+    bool mb_hasHeldKeyRepeated;
+
+    /**
+     * True if the latency instrumentation is enabled
+     */
+    bool mb_isLatencyInstrumentationOn;
+
+    /**
+     * Monotonic clock of the latency instrumentation
+     */
+    QElapsedTimer mo_latencyClock;
+
+    /**
+     * Time of the last key press (or auto-repeat), in ns on mo_latencyClock, -1 if already consumed by a dispatch
+     */
+    qint64 mi_latencyPressTime;
+
+    /**
+     * Input type of the key dispatched and waiting for the input widget to change, -1 if none
+     */
+    int mi_latencyPendingType;
+
+    /**
+     * Press time of the key waiting for the input widget to change, in ns on mo_latencyClock
+     */
+    qint64 mi_latencyPendingPressTime;
+
+    /**
+     * Press to dispatch latency of the key waiting for the input widget to change, in us
+     */
+    qint64 mi_latencyPendingDispatch;
+
+    /**
+     * Latency histograms, per input type and stage
+     */
+    VirtualKeyboardLatencyHistogram mtto_latencyHistograms[VIRTUALKEYBOARD_LATENCY_TYPECOUNT][VIRTUALKEYBOARD_LATENCY_STAGECOUNT];
+
+    /**
+     * Object whose change signal is connected to inputChanged (the lineEdit, or the document of the text edit)
+     */
+    QPointer<QObject> mpo_latencySource;
+
+    /**
+     * Size of the documents edited in large document mode, in characters (0 => always, negative => never)
+     */
+    int mi_largeDocumentThreshold;
+
+    /**
+     * Undo grouping state
+     */
+    bool mb_isUndoGroupingOn;
+
+    /**
+     * Maximum delay between two keys of an undo group, in ms
+     */
+    int mi_undoGroupingMaximumGap;
+
+    /**
+     * Number of undo steps of the documents of the text edits above which their undo stack is cleared, 0 => never cleared
+     */
+    int mi_undoClearThreshold;
+
+    /**
+     * Undo group of the last edit (VIRTUALKEYBOARD_UNDOGROUP_*), VIRTUALKEYBOARD_UNDOGROUP_NONE if the next edit can not join it
+     */
+    int mi_undoGroup;
+
+    /**
+     * Time since the last edit of the undo group
+     */
+    QElapsedTimer mo_undoGroupTimer;
+
+    /**
+     * Streaming paste state
+     */
+    bool mb_isStreamingPasteOn;
+
+    /**
+     * Size from which a paste is streamed, in characters
+     */
+    int mi_pasteStreamingThreshold;
+
+    /**
+     * Size of the chunks inserted by the streaming paste, in characters
+     */
+    int mi_pasteChunkSize;
+
+    /**
+     * Text of the streaming paste in progress, empty if there is none
+     */
+    QString ms_pasteText;
+
+    /**
+     * Number of characters of ms_pasteText already inserted
+     */
+    int mi_pastePosition;
+
+    /**
+     * Timer inserting the next chunk of the streaming paste on the next event loop pass
+     */
+    QTimer mo_timerPaste;
+
+    /**
+     * Objects whose change and cursor signals are connected to pasteTargetChanged during the streaming paste
+     *      (the lineEdit, or the document and the text edit)
+     */
+    QPointer<QObject> mpo_pasteChangeSource;
+    QPointer<QObject> mpo_pasteCursorSource;
+
+    /**
+     * True while a chunk of the streaming paste is inserted : its own changes do not cancel it
+     */
+    bool mb_isPasteChunkInserting;
+
+    /**
+     * Key filtering state
+     */
+    bool mb_isKeyFilteringOn;
+
+    /**
+     * Keys which can produce acceptable input in the line edit written (validator or input mask)
+     */
+    VirtualKeyboardKeyFilter mo_keyFilter;
+
+    /**
+     * The numbers layer has been displayed by the key filtering for a numeric line edit
+     */
+    bool mb_isNumbersLayerAutomatic;
+
+    /**
+     * Keystroke coalescing state
+     */
+    bool mb_isCoalescingOn;
+
+    /**
+     * Maximum delay between a key and the edit applying it when the coalescing is on, in ms
+     */
+    int mi_coalescingMaximumDelay;
+
+    /**
+     * Keys buffered : backspaces, applied before the text
+     */
+    int mi_coalescedBackspaceCount;
+
+    /**
+     * Keys buffered : text, inserted after the backspaces
+     */
+    QString ms_coalescedText;
+
+    /**
+     * Timer flushing the keys buffered after mi_coalescingMaximumDelay
+     */
+    QTimer mo_timerCoalescing;
+
+    /**
+     * Keys buffered whose press => commit latency is measured when they are flushed
+     */
+    QVector<VirtualKeyboardLatencyPendingKey> mvec_coalescedLatencies;
+
+    /**
+     * Dictionary of the word prediction, shared with the other keyboards of the process (NULL => no prediction)
+     */
+    const VirtualKeyboardDictionary *mpo_dictionary;
+
+    /**
+     * Column of the suggestions, next to the secondary keys (hidden while there is no dictionary)
+     */
+    QFrame *mw_frameSuggestions;
+
+    /**
+     * Buttons of the suggestions, in mlists_suggestions order
+     */
+    QList<QPushButton *> mlistw_suggestionKeys;
+
+    /**
+     * Map the suggestion buttons to the suggestionClicked slot
+     */
+    QSignalMapper mo_mapperSuggestions;
+
+    /**
+     * Completions of the word before the cursor, most frequent first
+     */
+    QStringList mlists_suggestions;
+
+    /**
+     * Timer checking the word before the cursor on the next event loop pass, once for all the changes of the input widget until then
+     */
+    QTimer mo_timerPrediction;
+
+    /**
+     * Object notifying the changes of the input widget to the word prediction
+     */
+    QPointer<QObject> mpo_predictionSource;
+
+    /**
+     * Thread of the word prediction, started with the first dictionary
+     */
+    QThread *mpo_predictionThread;
+
+    /**
+     * Lookups of the word prediction, living in mpo_predictionThread
+     */
+    VirtualKeyboardPredictionWorker *mpo_predictionWorker;
+
+    /**
+     * Word before the cursor, as known by the worker once it has applied the events posted
+     */
+    QString ms_predictionWord;
+
+    /**
+     * Sequence number of the last event posted to the worker
+     */
+    int mi_predictionSequence;
+
+    /**
+     * An event could not be posted (queue full) : the next event posted carries the whole word
+     */
+    bool mb_isPredictionDesynchronized;
+
+    /**
+     * Asynchronous loading state
+     */
+    bool mb_isAsynchronousLoadingOn;
+
+    /**
+     * Language whose keymap is loaded in the background (empty => none)
+     */
+    QString ms_loadingLanguage;
+
+    /**
+     * Dictionary loaded in the background (empty => none)
+     */
+    QString ms_loadingDictionary;
+
+    /**
+     * Tap correction mode (VIRTUALKEYBOARD_TAPCORRECTION_*)
+     */
+    int mi_tapCorrectionMode;
+
+    /**
+     * Sequence number of the last word posted to the tap correction of the prediction worker
+     */
+    int mi_correctionSequence;
+
+    /**
+     * The keymap, the layer or the geometry of the principal keys have changed since the keys were last posted to the worker
+     */
+    bool mb_isKeyModelDirty;
+
+    /**
+     * Position of the last press on a principal key, in the coordinates of the keyboard
+     */
+    QPointF mo_tapPosition;
+
+    /**
+     * The position of the key pressed is given by pressKey() / pressKeyAt(), not read from the pointer
+     */
+    bool mb_isTapPositionSet;
+
+    /**
+     * Taps of the characters of the word being typed
+     */
+    QVector<QPointF> mveco_taps;
+
+    /**
+     * Characters typed with mveco_taps
+     */
+    QString ms_tapWord;
+
+    /**
+     * Last word finished with a correction offered (VIRTUALKEYBOARD_TAPCORRECTION_SUGGEST), and the correction (empty => none)
+     */
+    QString ms_correctedWord;
+    QString ms_correction;
+
+    /**
+     * Gesture typing enabled
+     */
+    bool mb_isGestureTypingOn;
+
+    /**
+     * Sequence number of the last path posted to the gesture decoder of the prediction worker
+     */
+    int mi_gestureSequence;
+
+
+    // Public Functions
+public:
+
+    /**
+     * \brief Constructor
+     * \param w_parent : parent Widget (default 0)
+     */
+    explicit VirtualKeyboard(QWidget *w_parent = 0);
+
+    /**
+     * \brief Destructor
+     *
+     * Delete member pointers
+     */
+    ~VirtualKeyboard();
+
+    /**
+     * \brief initialisation
+     *
+     * \param[in] w_inputWidget : Widget to interact with. Can be of the following types :
+     *      \li QLineEdit
+     *      \li QTextEdit
+     *      \li QPlainTextEdit
+     *      \li QComboBox (editable)
+     *
+     * \param[in] s_language : Language used to set the keymaps. Built-in choices are :
+     *      \li "EN" (=> qwerty, default value)
+     *      \li "FR" (=> azerty)
+     *      Other languages are loaded from keymap files (see VirtualKeyboardKeymap)
+     *
+     * \param[in] b_displaySecondaryKeys : if true, the secondary keys will be displayed (default true)
+     *
+     * \param[in] b_displayBorder : if true, a border will be displayed around the keyboard (default false)
+     *
+     * \param[in] i_renderMode : Rendering mode of the principal keys. Possible choices are :
+     *      \li VIRTUALKEYBOARD_RENDER_WIDGETS (=> one QPushButton per key, default value)
+     *      \li VIRTUALKEYBOARD_RENDER_PAINTED (=> every key is drawn on a single surface, cheaper to build and to repaint)
+     *
+     * \param[in] i_commitMode : When the principal keys, space and backspace are committed. Possible choices are :
+     *      \li VIRTUALKEYBOARD_COMMIT_ONRELEASE (=> when the key is released, sliding off the key cancels it, default value)
+     *      \li VIRTUALKEYBOARD_COMMIT_ONPRESS (=> as soon as the key is pressed, lowest latency)
+     *
+     * With the asynchronous loading (setAsynchronousLoading()), a keymap file which is not loaded yet is loaded in the background :
+     * the keyboard is usable at once with the built-in VIRTUALKEYBOARD_LOADING_FALLBACKLANGUAGE keymap, then switches to the language
+     * requested and emits ready(). The language is then not checked : an unknown language keeps the fallback keymap, as does a
+     * keymap which the buttons can not show.
+     *
+     * In VIRTUALKEYBOARD_RENDER_WIDGETS mode the keys of the keymap are shown on the fixed buttons of VirtualKeyboard.ui, in order :
+     * the keymap must have their rows (10, 10 and 7 keys, the last row may be shorter). The VIRTUALKEYBOARD_RENDER_PAINTED mode
+     * lays out the rows of any keymap.
+     *
+     * \return
+     *      \li VIRTUALKEYBOARD_SUCCESS if no error occured
+     *      \li VIRTUALKEYBOARD_UNKNOWLANGUAGE if the language passed is unknown
+     *      \li VIRTUALKEYBOARD_KEYMAPNOTSHOWN if the rows of the keymap of the language do not match the buttons (VIRTUALKEYBOARD_RENDER_WIDGETS mode)
+     */
+    int initialisation(QWidget *w_inputWidget = NULL, QString s_language = "EN", bool b_displaySecondaryKeys = true, bool b_displayBorder = false,
+                       int i_renderMode = VIRTUALKEYBOARD_RENDER_WIDGETS, int i_commitMode = VIRTUALKEYBOARD_COMMIT_ONRELEASE);
+
+    /**
+     * \brief Change the language of the keymaps in place, after initialisation()
+     *
+     * The keys (buttons or painted surface) are reused and the layer displayed (caps lock, numbers, punctuation) is kept.
+     * The keymaps and, in VIRTUALKEYBOARD_RENDER_PAINTED mode, the rendered layers of each language stay cached after their first use.
+     *
+     * \param[in] s_language : Language used to set the keymaps (see initialisation())
+     * \return
+     *      \li VIRTUALKEYBOARD_SUCCESS if the language has been changed
+     *      \li VIRTUALKEYBOARD_UNKNOWLANGUAGE if the language passed is unknown (the current language is kept)
+     *      \li VIRTUALKEYBOARD_KEYMAPNOTSHOWN if the rows of the keymap of the language do not match the buttons (VIRTUALKEYBOARD_RENDER_WIDGETS
+     *          mode, see initialisation()), the current language is kept
+     *      \li VIRTUALKEYBOARD_INIT_FAILED if the keyboard has not been initialised
+     */
+    int setLanguage(const QString &s_language);
+
+    /**
+     * \brief Get the input widget written by the keyboard
+     * \return Input widget, NULL if there is none or if it has been destroyed
+     */
+    QWidget *inputWidget() const;
+
+    /**
+     * \brief Get the language of the keymaps
+     * \return Language, empty before initialisation()
+     */
+    QString language() const;
+
+    /**
+     * \brief Configure the auto-repeat of the keys held down
+     *
+     * Backspace is always repeated. After i_initialDelay the key is repeated every i_interval ms,
+     * the interval being multiplied by r_acceleration after each repetition until it reaches i_minimumInterval.
+     *
+     * \param[in] b_repeatCharacters : if true, the principal keys and space are repeated too
+     * \param[in] i_initialDelay : Delay before the first repetition, in ms
+     * \param[in] i_interval : Interval between the first two repetitions, in ms
+     * \param[in] i_minimumInterval : Minimum interval between two repetitions, in ms
+     * \param[in] r_acceleration : Factor applied to the interval after each repetition, in [0.1, 1] (1 => constant rate)
+     */
+    void setAutoRepeat(bool b_repeatCharacters,
+                       int i_initialDelay = VIRTUALKEYBOARD_AUTOREPEAT_DELAY,
+                       int i_interval = VIRTUALKEYBOARD_AUTOREPEAT_INTERVAL,
+                       int i_minimumInterval = VIRTUALKEYBOARD_AUTOREPEAT_MINIMUMINTERVAL,
+                       qreal r_acceleration = VIRTUALKEYBOARD_AUTOREPEAT_ACCELERATION);
+
+    /**
+     * \brief Set the size from which the documents of the QTextEdit and QPlainTextEdit are edited in large document mode
+     *
+     * In large document mode the keys go through a cursor kept between the keys instead of the editing functions of the widget
+     * (see VirtualKeyboardInputTarget::setLargeDocumentThreshold()). Default : VIRTUALKEYBOARD_LARGEDOCUMENT_THRESHOLD
+     *
+     * \param[in] i_characterCount : Number of characters of the document (0 => always, negative => never)
+     */
+    void setLargeDocumentThreshold(int i_characterCount);
+
+    /**
+     * \brief Enable or disable the grouping of the keys into undo steps of the QTextEdit and QPlainTextEdit
+     *
+     * When the grouping is on, the characters of a word (with the space ending it) are undone together, as are the runs of backspaces.
+     * A group also ends on enter, cut / paste, a change of input widget, or when no key is typed for i_maximumGap.
+     *
+     * \param[in] b_enabled : True to group the keys
+     * \param[in] i_maximumGap : Maximum delay between two keys of a group, in ms
+     */
+    void setUndoGrouping(bool b_enabled, int i_maximumGap = VIRTUALKEYBOARD_UNDOGROUPING_MAXIMUMGAP);
+
+    /**
+     * \brief Set the number of undo steps above which the undo stack of the documents of the QTextEdit and QPlainTextEdit is cleared
+     *
+     * \warning This is not a depth limit : QTextDocument can not drop its oldest undo steps, so the edit of the keyboard creating the
+     * step i_stepCount + 1 clears the whole undo stack of the document (see VirtualKeyboardInputTarget::setUndoClearThreshold()),
+     * right after it nothing can be undone. The threshold bounds the memory of the undo stack, not the number of steps left to undo.
+     *
+     * \param[in] i_stepCount : Number of undo steps, 0 => never cleared (default)
+     */
+    void setUndoClearThreshold(int i_stepCount);
+
+    /**
+     * \brief Enable or disable the streaming paste of the paste key
+     *
+     * When the streaming paste is on, a clipboard text of i_threshold characters or more is inserted in chunks of i_chunkSize characters,
+     * one chunk per event loop pass, in a single undo group (QTextEdit and QPlainTextEdit). The smaller pastes call paste() on the widget.
+     * The paste can be followed with pasteProgress() and stopped with cancelPaste() : it is also canceled when the input widget changes,
+     * when a key edits the text, and when the text or the cursor of the input widget is changed by anything else (the next chunks
+     * would be inserted at the wrong place).
+     *
+     * \param[in] b_enabled : True to stream the large pastes
+     * \param[in] i_threshold : Size from which a paste is streamed, in characters
+     * \param[in] i_chunkSize : Size of the chunks inserted, in characters
+     */
+    void setStreamingPaste(bool b_enabled, int i_threshold = VIRTUALKEYBOARD_PASTE_STREAMINGTHRESHOLD,
+                           int i_chunkSize = VIRTUALKEYBOARD_PASTE_CHUNKSIZE);
+
+    /**
+     * \brief Check if a streaming paste is in progress
+     */
+    bool isPasting() const;
+
+    /**
+     * \brief Enable or disable the key filtering of the line edits with a QValidator or an input mask
+     *
+     * When the filtering is on, the principal keys which can not produce acceptable input at the cursor of the line edit are disabled
+     * (dimmed in VIRTUALKEYBOARD_RENDER_PAINTED mode), see VirtualKeyboardKeyFilter. The numbers layer is displayed for the line edits
+     * which only accept numbers, and hidden again when the input widget changes.
+     *
+     * \param[in] b_enabled : True to filter the keys
+     */
+    void setKeyFiltering(bool b_enabled);
+
+    /**
+     * \brief Enable or disable the keystroke coalescing
+     *
+     * When the coalescing is on, the principal keys, space and backspace are buffered and applied to the input widget as a single edit
+     * (a QTextCursor edit block for the text edits) : on the next event loop pass at the earliest, after i_maximumDelay at the latest.
+     * The keys buffered are always flushed before a focus change, enter, cut / copy / paste, and when the coalescing is disabled.
+     * The line edits with a QValidator or an input mask are not coalesced : the validator would reject a whole burst for one of its keys.
+     *
+     * \param[in] b_enabled : True to buffer the keys
+     * \param[in] i_maximumDelay : Maximum delay between a key and its edit, in ms (0 => next event loop pass)
+     */
+    void setCoalescing(bool b_enabled, int i_maximumDelay = VIRTUALKEYBOARD_COALESCING_MAXIMUMDELAY);
+
+    /**
+     * \brief Enable the word prediction : the most frequent completions of the word before the cursor are displayed next to the secondary keys
+     *
+     * Clicking a suggestion inserts the rest of the word and a space in one edit. The lookups run in a thread of the keyboard
+     * (VirtualKeyboardPredictionWorker), fed with the keys committed : the GUI thread never waits for them, the suggestions are
+     * displayed when the lookup of the last key is done. The dictionary is memory-mapped and shared by every keyboard of the process
+     * (see VirtualKeyboardDictionary).
+     *
+     * With the asynchronous loading (setAsynchronousLoading()), a dictionary which is not loaded yet is loaded in the background :
+     * the prediction stays disabled until then, ready() is emitted once it is enabled (or not, if the file is invalid).
+     *
+     * \param[in] s_fileName : Dictionary, compiled (.vkdc) or source (.vkd), empty to disable the prediction
+     * \return False if the dictionary can not be loaded (the prediction is then disabled), else True (always when it is loaded in the background)
+     */
+    bool setPredictionDictionary(const QString &s_fileName);
+
+    /**
+     * \brief Get the suggestions displayed
+     * \return Words, most frequent first
+     */
+    QStringList suggestions() const;
+
+    /**
+     * \brief Enable or disable the asynchronous loading of the keymaps and dictionaries, to call before initialisation()
+     *
+     * When the loading is asynchronous, initialisation() and setPredictionDictionary() do not read files : the keymaps and dictionaries
+     * which are not loaded yet by the process are loaded in a background thread (VirtualKeyboardLoader). Meanwhile the keyboard works
+     * in a degraded mode : built-in VIRTUALKEYBOARD_LOADING_FALLBACKLANGUAGE keymap (returned by language()), no word prediction.
+     * ready() is emitted when everything requested is loaded. setLanguage() stays synchronous. Default : disabled.
+     *
+     * \param[in] b_enabled : True to load in the background
+     */
+    void setAsynchronousLoading(bool b_enabled);
+
+    /**
+     * \brief Check if the keymap and the dictionary requested are loaded (always true when the loading is synchronous)
+     */
+    bool isReady() const;
+
+    /**
+     * \brief Set the correction of the near-miss taps
+     *
+     * The raw position of each tap on a letter is recorded (VIRTUALKEYBOARD_RENDER_WIDGETS mode : the position of the mouse cursor).
+     * When the word is finished by space, the words of the prediction dictionary which the keys near the taps can spell are scored
+     * with a Gaussian model of the taps over the geometry of the keys and with their frequency (see VirtualKeyboardTapModel).
+     * If a word scores clearly better than the one typed, correctionFound() is emitted, and the word is replaced (in an undo step
+     * of its own) in VIRTUALKEYBOARD_TAPCORRECTION_AUTOCORRECT mode, or can be replaced with applyCorrection() in
+     * VIRTUALKEYBOARD_TAPCORRECTION_SUGGEST mode. Needs a prediction dictionary (setPredictionDictionary()). Default : off.
+     *
+     * The candidates are scored in the thread of the word prediction : the space is typed at once, the correction comes later and
+     * replaces the word with its space only if they are still right before the cursor.
+     *
+     * \param[in] i_mode : VIRTUALKEYBOARD_TAPCORRECTION_*
+     */
+    void setTapCorrection(int i_mode);
+
+    /**
+     * \brief Enable or disable the gesture typing : one word typed by a path traced over the letters, in a single stroke
+     *
+     * A press sliding off its letter traces a path instead of clicking the key (VIRTUALKEYBOARD_RENDER_PAINTED mode with the
+     * VIRTUALKEYBOARD_COMMIT_ONRELEASE commit mode : a key committed on press can not become a path). On release, the path is
+     * decoded against the words of the prediction dictionary (see VirtualKeyboardGestureDecoder) and the best word is typed,
+     * after a space if the cursor follows a word, in an undo step of its own. gestureDecoded() gives the other candidates.
+     * Needs a prediction dictionary (setPredictionDictionary()). Default : off.
+     *
+     * The paths are decoded in the thread of the word prediction : the word is typed when the decoding comes back, unless a key
+     * has been typed, another path traced or the input widget changed meanwhile.
+     *
+     * \param[in] b_enabled : True to enable the gesture typing
+     */
+    void setGestureTyping(bool b_enabled);
+
+    /**
+     * \brief Add a secondary key with the label s_keyText and mapped at the index i_indexMapping in the signal mapper mo_mapperSecondaryKeys
+     *
+     * If the index is already used the function returns False and no button is added
+     *
+     * In VIRTUALKEYBOARD_RENDER_PAINTED mode the key is not a button but an entry of a scrollable column (VirtualKeyboardSecondaryBar)
+     * which only draws the keys visible : hundreds of keys cost no widget and no layout.
+     *
+     * \param[in] s_keyText : Key label
+     * \param[in] i_indexMapping : Index on which to map the key
+     * \return : False if the index is already used, else True
+     */
+    bool addSecondaryKey(QString s_keyText, int i_indexMapping);
+
+    /**
+     * \brief Add a secondary key inserting a text in the input widget, instead of emitting secondaryKeyPressed
+     *
+     * The text replaces the selection as a single edit (one undo step), through the same input target as the other keys.
+     * A template places the cursor at its VIRTUALKEYBOARDSNIPPET_CURSOR placeholder, e.g. "<b>{cursor}</b>".
+     * The texts are shared by all the snippet keys of the application (see VirtualKeyboardSnippet).
+     *
+     * \param[in] s_keyText : Key label
+     * \param[in] i_indexMapping : Index on which to map the key
+     * \param[in] s_snippet : Text inserted
+     * \param[in] b_isTemplate : If true, s_snippet is a template with a cursor placeholder, else a literal text (default true)
+     * \return : False if the index is already used, else True
+     */
+    bool addSnippetKey(QString s_keyText, int i_indexMapping, QString s_snippet, bool b_isTemplate = true);
+
+    /**
+     * \brief Remove a secondary key based on its index
+     *
+     * If the index does not match a key function returns False and nothing else is done
+     *
+     * \param[in] i_indexMapping : Index of the key to remove
+     * \return False if the index is not used, else True
+     */
+    bool removeSecondaryKey(int i_indexMapping);
+
+    /**
+     * \brief Replace the secondary keys added programmatically by a set of keys, in a single layout pass
+     *
+     * The keys whose index is in both sets keep their button (its label is updated), the buttons of the keys removed are reused
+     * for the keys added. The keys are displayed in the order of their indexes.
+     * The keys set are plain keys : the snippets of the keys added by addSnippetKey are removed.
+     *
+     * \param[in] maps_keys : Label of each key, indexed by the index on which the key is mapped
+     */
+    void setSecondaryKeys(const QMap<int, QString> &maps_keys);
+
+    /**
+     * \brief Start a batch of addSecondaryKey() / removeSecondaryKey() : the secondary keys are laid out and repainted once, by endSecondaryKeysUpdate()
+     *
+     * The calls can be nested, the batch ends with the last endSecondaryKeysUpdate()
+     */
+    void beginSecondaryKeysUpdate();
+
+    /**
+     * \brief End a batch started by beginSecondaryKeysUpdate()
+     */
+    void endSecondaryKeysUpdate();
+
+    /**
+     * \brief Get the key at a position of the keyboard
+     *
+     * In VIRTUALKEYBOARD_RENDER_PAINTED mode the lookup goes through the precomputed hit-testing grid of the key-geometry table,
+     * and does not need the keyboard to be shown.
+     *
+     * \param[in] o_position : Position, in the keyboard coordinates
+     * \return Index of the key in the keymap (as passed to keyPressed) for a principal key, one of the VIRTUALKEYBOARD_KEY_* values for the other keys,
+     *         VIRTUALKEYBOARD_KEY_NONE if there is no principal key at this position
+     */
+    int keyAt(const QPoint &o_position) const;
+
+    /**
+     * \brief Enable or disable the latency instrumentation (disabled by default)
+     *
+     * When enabled, the time of each key press, of the dispatch of the key and of the change of the input widget
+     * (QLineEdit::textChanged or QTextDocument::contentsChange) are taken on a monotonic clock, and the latencies are
+     * counted in histograms per input type. Each measure is also emitted through latencyMeasured.
+     *
+     * \param[in] b_enabled : True to enable the instrumentation
+     */
+    void setLatencyInstrumentationEnabled(bool b_enabled);
+
+    /**
+     * \brief Get the latency statistics of an input type
+     * \param[in] i_latencyType : VIRTUALKEYBOARD_LATENCY_CHARACTER, VIRTUALKEYBOARD_LATENCY_SPACE or VIRTUALKEYBOARD_LATENCY_BACKSPACE
+     * \param[in] i_stage : VIRTUALKEYBOARD_LATENCY_STAGE_DISPATCH (press => dispatch) or VIRTUALKEYBOARD_LATENCY_STAGE_COMMIT (press => text changed, default)
+     * \return Number of samples, p50, p95, p99 and maximum, in microseconds
+     */
+    VirtualKeyboardLatencyStatistics latencyStatistics(int i_latencyType, int i_stage = VIRTUALKEYBOARD_LATENCY_STAGE_COMMIT) const;
+
+    /**
+     * \brief Remove every latency sample
+     */
+    void resetLatencyStatistics();
+
+    /**
+     * \brief Follow the focus of the application to change the input widget dynamically (through the shared VirtualKeyboardFocusDispatcher)
+     */
+    void connectFocusChanged();
+
+    /**
+     * \brief Stop following the focus of the application
+     */
+    void disconnectFocusChanged();
+
+    /**
+     * \brief Restrict the focus followed to a widget subtree
+     *
+     * Only the input widgets which are \a w_scope or one of its descendants (in the same window) become the input widget when they get the focus.
+     *
+     * \param[in] w_scope : Root of the subtree, NULL to follow the focus in the whole application (default)
+     */
+    void setFocusScope(QWidget *w_scope);
+
+    /**
+     * \brief Get the widget subtree in which the focus is followed
+     * \return Root of the subtree, NULL if the focus is followed in the whole application
+     */
+    QWidget *focusScope() const;
+
+
+    // Protected Functions
+protected:
+
+    /**
+     * \brief Reimplemented from QObject, follow the moves and resizes of the principal keys (the keys posted to the worker are outdated)
+     */
+    bool eventFilter(QObject *po_watched, QEvent *po_event);
+
+
+    // Private Functions
+private:
+
+    /**
+     * \brief initialise the keymaps
+     * \param[in] s_language : Language used to set the keymaps (see VirtualKeyboardKeymap::find). Built-in choices are :
+     *      \li "EN" (=> qwerty, default value)
+     *      \li "FR" (=> azerty)
+     * \return True if a keymap has been found for the language, else False
+     */
+    bool initialisationKeymaps(QString s_language);
+
+    /**
+     * \brief Check if a keymap can be shown in a rendering mode
+     * \param[in] po_keymap : Keymap
+     * \param[in] i_renderMode : VIRTUALKEYBOARD_RENDER_*
+     * \return True in VIRTUALKEYBOARD_RENDER_PAINTED mode, True in VIRTUALKEYBOARD_RENDER_WIDGETS mode if the rows of the keymap are the
+     *      rows of the buttons of VirtualKeyboard.ui (the last row may be shorter), else False
+     */
+    static bool isKeymapShown(const VirtualKeyboardKeymap *po_keymap, int i_renderMode);
+
+    /**
+     * \brief Build the user interface of the VIRTUALKEYBOARD_RENDER_PAINTED mode : a VirtualKeyboardSurface and the secondary keys frame
+     *
+     * The secondary keys have the same object names as in VirtualKeyboard.ui, so that their slots are connected by name
+     */
+    void setupPaintedUi();
+
+    /**
+     * \brief Map the pressed, released and clicked signals of a button to the keyDown, keyUp and keyClicked slots (VIRTUALKEYBOARD_RENDER_WIDGETS mode)
+     * \param[in] w_pushButton : Button of the key
+     * \param[in] i_keyId : Index of the key in the keymap for a principal key, else one of the VIRTUALKEYBOARD_KEY_* values
+     */
+    void mapKeyButton(QPushButton *w_pushButton, int i_keyId);
 
-/**
- * \brief Virtual Keyboard widget
- */
-class VirtualKeyboard : public QFrame
-{
-    Q_OBJECT
+    /**
+     * \brief Check if a key follows the commit mode (principal keys, space and backspace)
+     * \param[in] i_keyId : Identifier of the key
+     * \return True if the key follows the commit mode, false if it is always committed on click
+     */
+    bool isCommitKey(int i_keyId) const;
 
+    /**
+     * \brief Check if a key is repeated while held down
+     * \param[in] i_keyId : Identifier of the key
+     * \return True if the key is repeated
+     */
+    bool isAutoRepeatKey(int i_keyId) const;
 
-    // Private Members
-private:
+    /**
+     * \brief Execute the action of a key : dispatch to keyPressed or to the slot of the corresponding special key
+     * \param[in] i_keyId : Index of the key in the keymap for a principal key, else one of the VIRTUALKEYBOARD_KEY_* values
+     */
+    void dispatchKey(int i_keyId);
 
     /**
-     * User interface for the virtual keyboard
+     * \brief Insert a text in the input widget, or buffer it if the coalescing is on
+     * \param[in] s_text : Text
      */
-    Ui::VirtualKeyboard *ui;
+    void commitText(const QString &s_text);
 
     /**
-     * Pointer used to interact with a lineEdit
+     * \brief Delete the character before the cursor of the input widget, or buffer the backspace if the coalescing is on
      */
-    QLineEdit *mw_lineEdit;
+    void commitBackspace();
 
     /**
-     * Pointer used to interact with a TextEdit
+     * \brief Join the next edit of the input widget to the current undo group, or start a new group
+     * \param[in] i_group : Undo group of the edit (VIRTUALKEYBOARD_UNDOGROUP_*, NONE => joined to nothing)
+     * \param[in] b_isClosing : True if the edit ends the group (space)
      */
-    QTextEdit *mw_textEdit;
+    void groupUndo(int i_group, bool b_isClosing);
 
     /**
-     * Pointer used to interact with a PlainTextEdit
+     * \brief Start the timer flushing the keys buffered, if it is not running
      */
-    QPlainTextEdit *mw_plainTextEdit;
+    void scheduleCoalescedFlush();
 
     /**
-     * Pointer used ONLY to test if the widget is a comboBox. If it is, we use the lineEdit pointer to save the comboBox's lineEdit
+     * \brief Get a button for a secondary key : from the pool, else created
+     * \param[in] s_keyText : Key label
+     * \return Button, child of the secondary keys frame, not in its layout
      */
-    QComboBox *mw_comboBox;
+    QPushButton *takeSecondaryKeyButton(const QString &s_keyText);
 
     /**
-     * Map the non specific "primary" keys to the keyPressed slot
+     * \brief Remove the button of a secondary key from the layout and put it back in the pool (deleted if the pool is full)
+     * \param[in] w_pushButtonSecondary : Button
      */
-    QSignalMapper mo_mapperPrimaryKeys;
+    void releaseSecondaryKeyButton(QPushButton *w_pushButtonSecondary);
 
     /**
-     * Map the "secondary" keys to the secondaryKeyPressed slot
+     * \brief Give the line edit written to the key filter, and display or hide the numbers layer for the numeric line edits
      */
-    QSignalMapper mo_mapperSecondaryKeys;
+    void updateKeyFilterTarget();
 
     /**
-     * List of non specific buttons ([A - Z], [0 - 9], ...)
+     * \brief Change the widget to interact with, called by VirtualKeyboardFocusDispatcher when a widget receives the focus
+     * \param[in] w_widget : Newly focused widget
+     * \param[in] i_type : Type of the widget class (VirtualKeyboardInputTarget::widgetType)
      */
-    QList<QPushButton *> mlistw_principalKeys;
+    void setInputTarget(QWidget *w_widget, int i_type);
 
     /**
-     * Map containing the secondary keys added programmatically (via addSecondaryKey)
+     * \brief Connect the change signal of the input widget to inputChanged, for the latency instrumentation
      */
-    QMap<int, QPushButton *> mmapw_secondaryKeys;
+    void connectLatencySource();
 
     /**
-     * Lower letters Keys list
+     * \brief Check if the keys typed are buffered : coalescing on, and the input widget is not a line edit with a validator or an input mask
      */
-    QList<QString> mlists_lowerKeymap;
+    bool isCoalescing() const;
 
     /**
-     * Upper letters Keys list
+     * \brief Connect the change and cursor signals of the input widget to pasteTargetChanged, or disconnect them
+     * \param[in] b_isConnected : True while a streaming paste is in progress
      */
-    QList<QString> mlists_upperKeymap;
+    void connectPasteSources(bool b_isConnected);
 
     /**
-     * Numbers Keys list
+     * \brief Create the column of the suggestions, next to the secondary keys
      */
-    QList<QString> mlists_numbersKeymap;
+    void setupSuggestionsUi();
 
     /**
-     * Punctuation Keys list
+     * \brief Connect the change signal of the input widget to schedulePrediction, when the prediction is enabled
      */
-    QList<QString> mlists_punctuationKeymap;
+    void connectPredictionSource();
 
     /**
-     * Caps lock state
+     * \brief Get the word before the cursor of the input widget, completed by the prediction
+     * \return Word, empty if the cursor does not follow a word (or follows a word too long)
      */
-    bool mb_isCapsOn;
+    QString currentWord() const;
 
     /**
-     * Numbers state
+     * \brief Click a key as pressed at a position : the position is recorded by the tap correction instead of the pointer's
+     * \param[in] i_keyId : Index of the key in the keymap for a principal key, else one of the VIRTUALKEYBOARD_KEY_* values
+     * \param[in] o_position : Position of the press, in the coordinates of the keyboard
      */
-    bool mb_isNumberOn;
+    void pressKeyWithTap(int i_keyId, const QPointF &o_position);
 
     /**
-     * Punctuation state
+     * \brief Get the position of the pointer pressing a key : raw touch point of the painted surface, else mouse cursor
+     * \return Position, in the coordinates of the keyboard
      */
-    bool mb_isPunctuationOn;
+    QPointF pointerPosition() const;
 
     /**
-     * Type of input widget
-     *
-     * Possible values :
-     *  \li VIRTUALKEYBOARD_INPUT_LINEEDIT
-     *  \li VIRTUALKEYBOARD_INPUT_PLAINTEXTEDIT
-     *  \li VIRTUALKEYBOARD_INPUT_TEXTEDIT
+     * \brief Get the rectangle of a principal key displayed
+     * \param[in] i_indexKey : Index of the key in the keymap
+     * \return Rectangle, in the coordinates of the keyboard, null if the key is not displayed
      */
-    int mi_inputType;
+    QRectF principalKeyRect(int i_indexKey) const;
 
+    /**
+     * \brief Get the principal keys of the layer displayed which type a letter
+     * \param[out] ps_characters : Letter of each key
+     * \param[out] pveco_rects : Rectangle of each key, in the coordinates of the keyboard
+     */
+    void letterKeys(QString *ps_characters, QVector<QRectF> *pveco_rects) const;
 
-    // Public Functions
-public:
+    /**
+     * \brief Record the tap of a principal key committed : a letter extends the word of the taps, another key ends it
+     * \param[in] s_text : Text of the key
+     */
+    void recordTap(const QString &s_text);
 
     /**
-     * \brief Constructor
-     * \param w_parent : parent Widget (default 0)
+     * \brief Forget the taps of the word being typed : called by every edit which does not go through keyPressed
+     *      (the word before the cursor is not the word of the taps anymore)
      */
-    explicit VirtualKeyboard(QWidget *w_parent = 0);
+    void clearTaps();
 
     /**
-     * \brief Destructor
-     *
-     * Delete member pointers
+     * \brief Post the word of the taps, finished by space, to the tap correction of the prediction worker
+     *      (nothing if the text before the cursor is not this word anymore)
      */
-    ~VirtualKeyboard();
+    void correctWord();
 
     /**
-     * \brief initialisation
+     * \brief Post the principal keys displayed to the prediction worker, if they have changed since the last ones posted
      *
-     * \param[in] w_inputWidget : Widget to interact with. Can be of the following types :
-     *      \li QLineEdit
-     *      \li QTextEdit
-     *      \li QPlainTextEdit
-     *      \li QComboBox (editable)
-     *
-     * \param[in] s_language : Language used to set the keymaps. Possible choices are :
-     *      \li "EN" (=> qwerty, default value)
-     *      \li "FR" (=> azerty)
+     * The spatial models of the worker are rebuilt only when the keymap, the layer or the geometry of the keys change, not for each word.
      *
-     * \param[in] b_displaySecondaryKeys : if true, the secondary keys will be displayed (default true)
-     *
-     * \param[in] b_displayBorder : if true, a border will be displayed around the keyboard (default false)
-     *
-     * \return
-     *      \li VIRTUALKEYBOARD_SUCCESS if no error occured
-     *      \li VIRTUALKEYBOARD_UNKNOWLANGUAGE if the language passed is unknown
+     * \return False if the keys could not be posted (queue full), else True
      */
-    int initialisation(QWidget *w_inputWidget = NULL, QString s_language = "EN", bool b_displaySecondaryKeys = true, bool b_displayBorder = false);
+    bool postKeys();
 
     /**
-     * \brief Add a secondary key with the label s_keyText and mapped at the index i_indexMapping in the signal mapper mo_mapperSecondaryKeys
-     *
-     * If the index is already used the function returns False and no button is added
-     *
-     * \param[in] s_keyText : Key label
-     * \param[in] i_indexMapping : Index on which to map the key
-     * \return : False if the index is already used, else True
+     * \brief Post a change of the word before the cursor to the prediction worker (nothing if the prediction is disabled)
+     * \param[in] i_type : VIRTUALKEYBOARD_PREDICTIONEVENT_*
+     * \param[in] s_text : Text committed, or new word
      */
-    bool addSecondaryKey(QString s_keyText, int i_indexMapping);
+    void postPredictionEvent(int i_type, const QString &s_text);
 
     /**
-     * \brief Remove a secondary key based on its index
-     *
-     * If the index does not match a key function returns False and nothing else is done
-     *
-     * \param[in] i_indexMapping : Index of the key to remove
-     * \return False if the index is not used, else True
+     * \brief Set the dictionary of the prediction, show or hide the suggestions and look up the word before the cursor
+     * \param[in] po_dictionary : Dictionary, NULL to disable the prediction
      */
-    bool removeSecondaryKey(int i_indexMapping);
+    void applyPredictionDictionary(const VirtualKeyboardDictionary *po_dictionary);
 
     /**
-     * \brief Connect QApplication::focusChanged to VirtualKeyboard::setInputWidget to change the input widget dynamically
+     * \brief Get the button of a key which is not a principal key (VIRTUALKEYBOARD_RENDER_WIDGETS mode)
+     * \param[in] i_keyId : Identifier of the key (VIRTUALKEYBOARD_KEY_*)
+     * \return Button of the key, NULL if the identifier is unknown
      */
-    void connectFocusChanged();
+    QPushButton *specialKeyButton(int i_keyId) const;
 
     /**
-     * \brief Disconnect QApplication::focusChanged from VirtualKeyboard::setInputWidget to stop changing the input widget dynamically
+     * \brief Set the label of a key which is not a principal key, whatever the rendering mode
+     * \param[in] i_keyId : Identifier of the key (VIRTUALKEYBOARD_KEY_*)
+     * \param[in] s_text : Label
      */
-    void disconnectFocusChanged();
+    void setSpecialKeyText(int i_keyId, const QString &s_text);
 
-    // Private Functions
-private:
+    /**
+     * \brief Display a key which is not a principal key as checked or not, whatever the rendering mode
+     * \param[in] i_keyId : Identifier of the key (VIRTUALKEYBOARD_KEY_*)
+     * \param[in] b_checked : True to display the key as checked
+     */
+    void setSpecialKeyChecked(int i_keyId, bool b_checked);
 
     /**
-     * \brief initialise the keymaps
-     * \param[in] s_language : Language used to set the keymaps. Possible choices are :
-     *      \li "EN" (=> qwerty, default value)
-     *      \li "FR" (=> azerty)
-     * \return True if the language is supported and the keymaps have been set, else False
+     * \brief Enable or disable a key which is not a principal key, whatever the rendering mode
+     * \param[in] i_keyId : Identifier of the key (VIRTUALKEYBOARD_KEY_*)
+     * \param[in] b_enabled : True to enable the key
      */
-    bool initialisationKeymaps(QString s_language);
+    void setSpecialKeyEnabled(int i_keyId, bool b_enabled);
 
     /**
-     * \brief Set the keymap from a list of QString
-     * \param[in] lists_keys : list of keys
+     * \brief Display a layer of the keymap
+     * \param[in] i_layer : Layer (VIRTUALKEYBOARD_LAYER_*)
      */
-    void setKeymap(QList<QString> &lists_keys);
+    void setKeymap(int i_layer);
 
     /**
      * \brief Toggle the Caps lock state
@@ -278,6 +1247,106 @@ signals:
      */
     void enterKeyPressed();
 
+    /**
+     * \brief Signal emitted each time a key of the keyboard is dispatched (principal keys, special keys, cut / copy / paste)
+     *
+     * Used by VirtualKeyboardTraceRecorder
+     *
+     * \param[in] i_keyId : Index of the key in the keymap for a principal key, else one of the VIRTUALKEYBOARD_KEY_* values
+     */
+    void keyDispatched(int i_keyId);
+
+    /**
+     * \brief Signal emitted each time a snippet key inserts its snippet (no secondaryKeyPressed for these keys)
+     *
+     * Used by VirtualKeyboardTraceRecorder
+     *
+     * \param[in] i_indexMapping : Index of the key
+     */
+    void snippetDispatched(int i_indexMapping);
+
+    /**
+     * \brief Signal emitted each time a suggestion of the word prediction is typed
+     *
+     * Used by VirtualKeyboardTraceRecorder
+     *
+     * \param[in] s_suggestion : Word of the suggestion
+     */
+    void suggestionDispatched(const QString &s_suggestion);
+
+    /**
+     * \brief Signal emitted each time a word is replaced by its tap correction (autocorrection, or applyCorrection())
+     *
+     * Used by VirtualKeyboardTraceRecorder. An autocorrection is emitted before the space finishing the word is typed.
+     *
+     * \param[in] s_word : Word typed
+     * \param[in] s_correction : Correction
+     */
+    void correctionDispatched(const QString &s_word, const QString &s_correction);
+
+    /**
+     * \brief Signal emitted each time the word of a path traced over the keys is typed
+     *
+     * Used by VirtualKeyboardTraceRecorder
+     *
+     * \param[in] s_word : Word typed, in the case of the current layer
+     */
+    void gestureWordDispatched(const QString &s_word);
+
+    /**
+     * \brief Signal emitted when the latency of a key has been measured (latency instrumentation enabled)
+     * \param[in] i_latencyType : Input type (VIRTUALKEYBOARD_LATENCY_*)
+     * \param[in] i_pressToDispatch : Time between the press and the dispatch of the key, in us
+     * \param[in] i_pressToCommit : Time between the press and the change of the input widget, in us
+     */
+    void latencyMeasured(int i_latencyType, qint64 i_pressToDispatch, qint64 i_pressToCommit);
+
+    /**
+     * \brief Signal emitted after each chunk inserted by a streaming paste
+     * \param[in] i_insertedCount : Number of characters inserted
+     * \param[in] i_totalCount : Number of characters of the paste
+     */
+    void pasteProgress(int i_insertedCount, int i_totalCount);
+
+    /**
+     * \brief Signal emitted when a streaming paste has been entirely inserted
+     */
+    void pasteFinished();
+
+    /**
+     * \brief Signal emitted when a streaming paste is canceled, the characters already inserted stay in the input widget
+     * \param[in] i_insertedCount : Number of characters inserted
+     * \param[in] i_totalCount : Number of characters of the paste
+     */
+    void pasteCanceled(int i_insertedCount, int i_totalCount);
+
+    /**
+     * \brief Signal emitted when the suggestions of the word prediction change
+     * \param[in] lists_suggestions : Words, most frequent first
+     */
+    void suggestionsChanged(const QStringList &lists_suggestions);
+
+    /**
+     * \brief Signal emitted when the keymap and the dictionary loaded in the background are in use (see setAsynchronousLoading())
+     *
+     * Emitted on the event loop pass after initialisation() if there is nothing to load, then each time the loads requested are all done.
+     */
+    void ready();
+
+    /**
+     * \brief Signal emitted when the word finished by space has a correction (see setTapCorrection())
+     * \param[in] s_word : Word typed
+     * \param[in] s_correction : Correction
+     * \param[in] b_isApplied : True if the word has been replaced (VIRTUALKEYBOARD_TAPCORRECTION_AUTOCORRECT)
+     */
+    void correctionFound(const QString &s_word, const QString &s_correction, bool b_isApplied);
+
+    /**
+     * \brief Signal emitted when a path traced over the keys has been decoded and its word typed (see setGestureTyping())
+     * \param[in] lists_words : Words the path may trace, best first : the first one has been typed
+     */
+    void gestureDecoded(const QStringList &lists_words);
+
 
     // Public Slots
 public slots:
@@ -287,20 +1356,104 @@ public slots:
      */
     void toggleSecondaryKeysVisibility();
 
+    /**
+     * \brief Apply the keys buffered by the keystroke coalescing to the input widget (nothing if there are none)
+     */
+    void flushCoalescedKeys();
 
-    // Private Slots
-private slots:
+    /**
+     * \brief Stop the streaming paste in progress (nothing if there is none)
+     */
+    void cancelPaste();
+
+    /**
+     * \brief Simulate a click on a key (press then release on the key), following the commit mode
+     *
+     * Allow to drive the keyboard without a display (benchmarks, replay of recorded sessions)
+     *
+     * \param[in] i_keyId : Index of the key in the keymap for a principal key, else one of the VIRTUALKEYBOARD_KEY_* values
+     */
+    void pressKey(int i_keyId);
+
+    /**
+     * \brief Simulate a tap on the principal key at a position, recorded at this position by the tap correction
+     * \param[in] o_position : Position, in the coordinates of the keyboard
+     * \return Index of the key pressed in the keymap, VIRTUALKEYBOARD_KEY_NONE if there is no principal key at this position
+     */
+    int pressKeyAt(const QPointF &o_position);
+
+    /**
+     * \brief Simulate a path traced over the principal keys : type the word it traces (see setGestureTyping())
+     *
+     * Works in both render modes, only the paths traced on the VIRTUALKEYBOARD_RENDER_PAINTED surface are followed live.
+     * The path is decoded in the thread of the word prediction, gestureDecoded() is emitted once its word has been typed.
+     *
+     * \param[in] veco_path : Points of the path, in the coordinates of the keyboard
+     * \return False if the gesture typing is disabled or the path could not be posted to the decoder, else True
+     */
+    bool traceGesture(const QVector<QPointF> &veco_path);
+
+    /**
+     * \brief Simulate a click on a secondary key added programmatically (secondaryKeyPressed is emitted, or the snippet of the key inserted)
+     * \param[in] i_indexMapping : Index of the key
+     * \return False if the index is not used, else True
+     */
+    bool pressSecondaryKey(int i_indexMapping);
+
+    /**
+     * \brief Simulate a click on a suggestion of the word prediction
+     * \param[in] i_index : Index of the suggestion, in suggestions()
+     * \return False if there is no suggestion at this index, else True
+     */
+    bool pressSuggestion(int i_index);
+
+    /**
+     * \brief Type a suggestion given by its word, as a click on it would : the rest of the word before the cursor, or the whole word
+     *      replacing it, then a space
+     *
+     * Used by the replay of the traces : the suggestions displayed at a given time depend on the prediction worker
+     *
+     * \param[in] s_suggestion : Word of the suggestion
+     * \return False if the word is empty, else True
+     */
+    bool pressSuggestion(const QString &s_suggestion);
+
+    /**
+     * \brief Type the word of a path traced over the keys, as traceGesture() does once the path is decoded
+     *
+     * Used by the replay of the traces : the word is typed without decoding the path again
+     *
+     * \param[in] s_word : Word typed, after a space if the cursor follows a word
+     * \return False if the word is empty, else True
+     */
+    bool pressGestureWord(const QString &s_word);
 
     /**
-     * \brief Slot connected to the QApplication::focusChanged(QWidget old, QWidget new) signal
+     * \brief Replace a word finished by a space before the cursor by a correction, in an undo step of its own
      *
-     * It allows to dynamically change the widget to interact with, depending on wich widget has received the focus
+     * Used by applyCorrection() and by the replay of the traces
      *
-     * \param[in] w_old : last focused widget (Unused here)
-     * \param[in] w_new : Newly focused widget
-     * \return true if \a w_new is of supported type, false if not
+     * \param[in] s_word : Word typed
+     * \param[in] s_correction : Correction
+     * \return False if the word and its space are not before the cursor, else True
+     */
+    bool pressCorrection(const QString &s_word, const QString &s_correction);
+
+    /**
+     * \brief Replace the last word finished by the correction offered (VIRTUALKEYBOARD_TAPCORRECTION_SUGGEST), in an undo step of its own
+     * \return False if there is no correction offered, or if the word and its space are not before the cursor anymore, else True
+     */
+    bool applyCorrection();
+
+
+    // Private Slots
+private slots:
+
+    /**
+     * \brief Slot called when a secondary key added programmatically is clicked : insert its snippet, else emit secondaryKeyPressed
+     * \param[in] i_indexMapping : Index of the key
      */
-    void setInputWidget(QWidget *w_old, QWidget *w_new);
+    void secondaryKeyClicked(int i_indexMapping);
 
     /**
      * \brief Slot called on each non specific key press
@@ -308,6 +1461,50 @@ private slots:
      */
     void keyPressed(int i_indexKey);
 
+    /**
+     * \brief Slot called when a key goes down
+     *
+     * Commit the key in VIRTUALKEYBOARD_COMMIT_ONPRESS mode and start the auto-repeat
+     *
+     * \param[in] i_keyId : Index of the key in the keymap for a principal key, else one of the VIRTUALKEYBOARD_KEY_* values
+     */
+    void keyDown(int i_keyId);
+
+    /**
+     * \brief Slot called when a key goes up (released or slid off)
+     *
+     * Stop the auto-repeat
+     *
+     * \param[in] i_keyId : Index of the key in the keymap for a principal key, else one of the VIRTUALKEYBOARD_KEY_* values
+     */
+    void keyUp(int i_keyId);
+
+    /**
+     * \brief Slot called when a key is clicked (released on the key)
+     *
+     * Commit the key, unless it has already been committed on press or by the auto-repeat
+     *
+     * \param[in] i_keyId : Index of the key in the keymap for a principal key, else one of the VIRTUALKEYBOARD_KEY_* values
+     */
+    void keyClicked(int i_keyId);
+
+    /**
+     * \brief Slot called by mo_timerAutoRepeat, repeat the held key
+     */
+    void autoRepeat();
+
+    /**
+     * \brief Enable the principal keys accepted by the key filter, disable the others
+     */
+    void applyKeyFilter();
+
+    /**
+     * \brief Slot called when the text of the input widget changes (latency instrumentation enabled)
+     *
+     * Count the press to commit latency of the key dispatched
+     */
+    void inputChanged();
+
     /**
      * \brief Slot called when pushButton_principalKey_caps is clicked
      *
@@ -330,18 +1527,18 @@ private slots:
     void on_pushButton_principalKey_punctuation_clicked();
 
     /**
-     * \brief Slot called when pushButton_principalKey_space is clicked
+     * \brief Slot called when the space key is committed
      *
      * Send a space
      */
-    void on_pushButton_principalKey_space_clicked();
+    void sendSpace();
 
     /**
-     * \brief Slot called when pushButton_principalKey_backspace is clicked
+     * \brief Slot called when the backspace key is committed
      *
      * Simulate a backspace press (erase selected text / text to the right of the cursor)
      */
-    void on_pushButton_principalKey_backspace_clicked();
+    void sendBackspace();
 
     /**
      * \brief Slot called when pushButton_principalKey_enter is clicked
@@ -371,6 +1568,98 @@ private slots:
      * Paste text currently in clipboard to the selected text input zone
      */
     void on_pushButton_secondaryKey_paste_clicked();
+
+    /**
+     * \brief Copy selected text to clipboard
+     */
+    void sendCopy();
+
+    /**
+     * \brief Cut selected text to clipboard
+     */
+    void sendCut();
+
+    /**
+     * \brief Paste text currently in clipboard to the selected text input zone
+     */
+    void sendPaste();
+
+    /**
+     * \brief Insert the next chunk of the streaming paste in progress
+     */
+    void pasteNextChunk();
+
+    /**
+     * \brief Cancel the streaming paste when the text or the cursor of the input widget is changed by something else than the paste
+     */
+    void pasteTargetChanged();
+
+    /**
+     * \brief Check the word before the cursor on the next event loop pass
+     */
+    void schedulePrediction();
+
+    /**
+     * \brief Send the word before the cursor to the prediction worker if the keys committed do not give it
+     *      (cursor moved, paste, snippet, suggestion, text typed by other means)
+     */
+    void synchronizePrediction();
+
+    /**
+     * \brief Display the suggestions computed by the prediction worker, if they answer the last event posted
+     * \param[in] i_sequence : Sequence number of the last event applied by the worker
+     * \param[in] lists_suggestions : Words, most frequent first
+     */
+    void applySuggestions(int i_sequence, const QStringList &lists_suggestions);
+
+    /**
+     * \brief Apply or offer the correction computed by the prediction worker, if it answers the last word posted
+     *
+     * The word has been finished by its space meanwhile : it is replaced with its space, if they are still before the cursor.
+     *
+     * \param[in] i_sequence : Sequence number of the word corrected
+     * \param[in] s_word : Word typed
+     * \param[in] s_correction : Correction, empty if the word typed is the best candidate
+     */
+    void applyTapCorrection(int i_sequence, const QString &s_word, const QString &s_correction);
+
+    /**
+     * \brief Type the best word decoded by the prediction worker, if it answers the last path posted
+     * \param[in] i_sequence : Sequence number of the path decoded
+     * \param[in] lists_words : Words the path may trace, best first
+     */
+    void applyGestureWords(int i_sequence, const QStringList &lists_words);
+
+    /**
+     * \brief Slot called when a path traced over the painted surface is released : type the word it traces
+     * \param[in] veco_path : Points of the path, in the coordinates of the surface
+     */
+    void pathTraced(const QVector<QPointF> &veco_path);
+
+    /**
+     * \brief Switch to the language loaded in the background if it is still the one requested
+     * \param[in] s_language : Language
+     * \param[in] b_isFound : False if the language is unknown
+     */
+    void keymapLoaded(const QString &s_language, bool b_isFound);
+
+    /**
+     * \brief Enable the prediction with the dictionary loaded in the background if it is still the one requested
+     * \param[in] s_fileName : Dictionary file
+     * \param[in] b_isFound : False if the file can not be read or is invalid
+     */
+    void dictionaryLoaded(const QString &s_fileName, bool b_isFound);
+
+    /**
+     * \brief Emit ready() if nothing is loaded in the background anymore
+     */
+    void checkReady();
+
+    /**
+     * \brief Slot called when a suggestion is clicked : insert the rest of the word and a space, in one edit
+     * \param[in] i_index : Index of the suggestion
+     */
+    void suggestionClicked(int i_index);
 };
 
 #endif // VIRTUALKEYBOARD_H
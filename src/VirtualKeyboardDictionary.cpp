@@ -0,0 +1,749 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+#include "VirtualKeyboardDictionary.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPair>
+#include <QTextStream>
+#include <QVector>
+#include <QtEndian>
+
+
+// Header of a compiled dictionary
+#define VIRTUALKEYBOARDDICTIONARY_MAGIC         "VKDC"
+#define VIRTUALKEYBOARDDICTIONARY_VERSION       1
+#define VIRTUALKEYBOARDDICTIONARY_HEADERSIZE    32
+#define VIRTUALKEYBOARDDICTIONARY_NODESIZE      12
+
+
+/**
+ * \brief Header of a compiled dictionary, all the fields are little-endian
+ */
+struct VirtualKeyboardDictionaryHeader
+{
+    char    tc_magic[4];
+    quint16 i_version;
+    quint16 i_reserved;
+    quint32 i_nodeCount;
+    quint32 i_wordCount;
+    quint32 i_maximumWordLength;
+    quint32 ti_reserved[3];
+};
+Q_STATIC_ASSERT(sizeof(VirtualKeyboardDictionaryHeader) == VIRTUALKEYBOARDDICTIONARY_HEADERSIZE);
+
+
+/**
+ * \brief Node of a compiled dictionary, all the fields are little-endian
+ */
+struct VirtualKeyboardDictionaryNode
+{
+    quint32 i_firstChild;
+    quint16 i_childCount;
+    quint16 i_character;
+    quint8  i_frequency;
+    quint8  i_bestFrequency;
+    quint16 i_reserved;
+};
+Q_STATIC_ASSERT(sizeof(VirtualKeyboardDictionaryNode) == VIRTUALKEYBOARDDICTIONARY_NODESIZE);
+
+
+/**
+ * \brief Registry of the loaded dictionaries, shared by the whole process
+ */
+struct VirtualKeyboardDictionaryRegistry
+{
+    QMutex o_mutex;
+    QMutex o_loadMutex;     // Held while a dictionary is loaded, o_mutex is not : the loaded dictionaries stay available meanwhile
+    QHash<QString, VirtualKeyboardDictionary*> hash_dictionaries;
+};
+Q_GLOBAL_STATIC(VirtualKeyboardDictionaryRegistry, st_registry)
+
+
+/**
+ * \brief Get a dictionary of the registry
+ * \return Dictionary, NULL if the file is not in the registry
+ */
+static const VirtualKeyboardDictionary *findRegistered(VirtualKeyboardDictionaryRegistry *po_registry, const QString &s_path)
+{
+    QMutexLocker o_locker(&po_registry->o_mutex);
+    return po_registry->hash_dictionaries.value(s_path, NULL);
+}
+
+
+/**
+ * \brief Node of the tree built by compile(), before its layout
+ */
+struct VirtualKeyboardDictionaryBuildNode
+{
+    int     i_parent;
+    int     i_firstChild;
+    int     i_lastChild;
+    int     i_nextSibling;
+    int     i_childCount;
+    ushort  i_character;
+    quint8  i_frequency;
+    quint8  i_bestFrequency;
+};
+
+
+/**
+ * \brief Step of the walk of completions() : a node, and the step it has been reached from (-1 for the node of the prefix)
+ */
+struct VirtualKeyboardDictionaryTrail
+{
+    quint32 i_node;
+    int     i_parent;
+};
+
+
+/**
+ * \brief Step of the walks of matches() : the children of the node reached at a depth which have not been visited yet
+ */
+struct VirtualKeyboardDictionaryMatchStep
+{
+    quint32 i_nextChild;
+    quint32 i_endChild;
+};
+
+
+/**
+ * \brief Candidate of the walk of completions() : the word of a node, or the words of its subtree
+ */
+struct VirtualKeyboardDictionaryCandidate
+{
+    int     i_frequency;
+    bool    b_isWord;
+    int     i_trail;
+
+    /**
+     * \brief Order of the heap : highest frequency first, then the words before the subtrees, then the first reached
+     */
+    bool operator<(const VirtualKeyboardDictionaryCandidate &o_other) const
+    {
+        if (this->i_frequency != o_other.i_frequency) return this->i_frequency < o_other.i_frequency;
+        if (this->b_isWord != o_other.b_isWord) return !this->b_isWord;
+        return this->i_trail > o_other.i_trail;
+    }
+};
+
+
+/**
+ * \brief Word found by the walks of matches() : the most frequent words found are kept in a heap, the one dropped first on top
+ */
+struct VirtualKeyboardDictionaryMatch
+{
+    int     i_frequency;
+    int     i_order;
+    QString s_word;
+
+    /**
+     * \brief Order of the heap : highest frequency first, then the first found
+     */
+    bool operator<(const VirtualKeyboardDictionaryMatch &o_other) const
+    {
+        if (this->i_frequency != o_other.i_frequency) return this->i_frequency > o_other.i_frequency;
+        return this->i_order < o_other.i_order;
+    }
+};
+
+
+/**
+ * \brief Check if a word found now, or the best word of a subtree, would be among the i_maximumCount most frequent words found
+ *      (the words found later lose the ties)
+ */
+static bool isMatchKept(const QVector<VirtualKeyboardDictionaryMatch> &veco_matches, int i_maximumCount, int i_frequency)
+{
+    return veco_matches.size() < i_maximumCount || i_frequency > veco_matches.first().i_frequency;
+}
+
+
+/**
+ * \brief Keep a word found, dropping the least frequent word kept if there are i_maximumCount of them (checked by isMatchKept())
+ */
+static void keepMatch(QVector<VirtualKeyboardDictionaryMatch> &veco_matches, int i_maximumCount, int i_frequency, int i_order, const QString &s_word)
+{
+    if (veco_matches.size() == i_maximumCount)
+    {
+        std::pop_heap(veco_matches.begin(), veco_matches.end());
+        veco_matches.removeLast();
+    }
+
+    VirtualKeyboardDictionaryMatch o_match = { i_frequency, i_order, s_word };
+    veco_matches.append(o_match);
+    std::push_heap(veco_matches.begin(), veco_matches.end());
+}
+
+
+/**
+ * \brief Get the words kept by a walk of matches(), most frequent first
+ */
+static QStringList sortedMatches(QVector<VirtualKeyboardDictionaryMatch> &veco_matches, QVector<int> *pveci_frequencies)
+{
+    std::sort_heap(veco_matches.begin(), veco_matches.end());
+
+    QStringList lists_words;
+    lists_words.reserve(veco_matches.size());
+    if (pveci_frequencies != NULL) pveci_frequencies->reserve(veco_matches.size());
+
+    for (int i_i = 0; i_i < veco_matches.size(); ++i_i)
+    {
+        lists_words.append(veco_matches.at(i_i).s_word);
+        if (pveci_frequencies != NULL) pveci_frequencies->append(veco_matches.at(i_i).i_frequency);
+    }
+    return lists_words;
+}
+
+
+
+VirtualKeyboardDictionary::VirtualKeyboardDictionary() :
+    mpo_file(NULL),
+    mpc_nodes(NULL),
+    mi_nodeCount(0),
+    mi_wordCount(0)
+{
+}
+
+
+VirtualKeyboardDictionary::~VirtualKeyboardDictionary()
+{
+    delete this->mpo_file;
+}
+
+
+const VirtualKeyboardDictionary *VirtualKeyboardDictionary::find(const QString &s_fileName)
+{
+    const QString s_path = QFileInfo(s_fileName).absoluteFilePath();
+
+    VirtualKeyboardDictionaryRegistry *po_registry = st_registry();
+
+    const VirtualKeyboardDictionary *po_loadedDictionary = findRegistered(po_registry, s_path);
+    if (po_loadedDictionary != NULL) return po_loadedDictionary;
+
+    // One load at a time : the dictionary may have been loaded by another thread while this one was waiting
+    QMutexLocker o_loadLocker(&po_registry->o_loadMutex);
+
+    po_loadedDictionary = findRegistered(po_registry, s_path);
+    if (po_loadedDictionary != NULL) return po_loadedDictionary;
+
+    // The invalid files are not remembered : they may be written later
+    VirtualKeyboardDictionary *po_dictionary = VirtualKeyboardDictionary::load(s_path);
+
+    if (po_dictionary != NULL)
+    {
+        QMutexLocker o_locker(&po_registry->o_mutex);
+        po_registry->hash_dictionaries.insert(s_path, po_dictionary);
+    }
+
+    return po_dictionary;
+}
+
+
+const VirtualKeyboardDictionary *VirtualKeyboardDictionary::findLoaded(const QString &s_fileName)
+{
+    return findRegistered(st_registry(), QFileInfo(s_fileName).absoluteFilePath());
+}
+
+
+bool VirtualKeyboardDictionary::compile(const QString &s_source, QByteArray *pba_compiled, QString *ps_error)
+{
+    if (pba_compiled == NULL) return false;
+
+    QString s_error;
+    QVector<QPair<QString, double> > vec_words;
+    int i_line = 0;
+
+    foreach (const QStringRef &o_rawLine, s_source.splitRef(QLatin1Char('\n')))
+    {
+        ++i_line;
+        const QStringRef o_line = o_rawLine.trimmed();
+
+        if (o_line.isEmpty() || o_line.startsWith(QLatin1Char('#'))) continue;
+
+        int i_wordEnd = 0;
+        while (i_wordEnd < o_line.size() && !o_line.at(i_wordEnd).isSpace()) ++i_wordEnd;
+
+        double r_frequency = 1.0;
+        if (i_wordEnd < o_line.size())
+        {
+            bool b_ok;
+            const QStringRef o_frequency = o_line.mid(i_wordEnd).trimmed();
+            r_frequency = o_frequency.toDouble(&b_ok);
+            if (!b_ok || r_frequency <= 0.0)
+            {
+                s_error = QString("line %1 : invalid frequency \"%2\"").arg(i_line).arg(o_frequency.toString());
+                break;
+            }
+        }
+
+        vec_words.append(qMakePair(o_line.left(i_wordEnd).toString(), r_frequency));
+    }
+
+    if (!s_error.isEmpty())
+    {
+        if (ps_error != NULL) *ps_error = s_error;
+        return false;
+    }
+
+    // --- Words sorted by UTF-16 code units (the order of the children), the duplicates merged
+    std::sort(vec_words.begin(), vec_words.end());
+
+    int i_wordCount = 0;
+    double r_maximumFrequency = 0.0;
+    for (int i = 0; i < vec_words.size(); ++i)
+    {
+        if (i_wordCount > 0 && vec_words.at(i).first == vec_words.at(i_wordCount - 1).first)
+            vec_words[i_wordCount - 1].second += vec_words.at(i).second;
+        else
+            vec_words[i_wordCount++] = vec_words.at(i);
+
+        r_maximumFrequency = qMax(r_maximumFrequency, vec_words.at(i_wordCount - 1).second);
+    }
+    vec_words.resize(i_wordCount);
+
+    // --- Tree : the words are sorted, a word shares the path of the previous one up to their common prefix
+    QVector<VirtualKeyboardDictionaryBuildNode> veco_nodes;
+    QVector<int> veci_path;
+    VirtualKeyboardDictionaryBuildNode o_root = { -1, -1, -1, -1, 0, 0, 0, 0 };
+    veco_nodes.append(o_root);
+    veci_path.append(0);
+    int i_maximumWordLength = 0;
+
+    for (int i_word = 0; i_word < vec_words.size(); ++i_word)
+    {
+        const QString &s_word = vec_words.at(i_word).first;
+
+        int i_common = 0;
+        if (i_word > 0)
+        {
+            const QString &s_previous = vec_words.at(i_word - 1).first;
+            while (i_common < s_word.size() && i_common < s_previous.size() && s_word.at(i_common) == s_previous.at(i_common)) ++i_common;
+        }
+        veci_path.resize(i_common + 1);
+
+        for (int i = i_common; i < s_word.size(); ++i)
+        {
+            const int i_parent = veci_path.last();
+            VirtualKeyboardDictionaryBuildNode o_node = { i_parent, -1, -1, -1, 0, s_word.at(i).unicode(), 0, 0 };
+            const int i_node = veco_nodes.size();
+            veco_nodes.append(o_node);
+
+            if (veco_nodes.at(i_parent).i_lastChild >= 0) veco_nodes[veco_nodes.at(i_parent).i_lastChild].i_nextSibling = i_node;
+            else veco_nodes[i_parent].i_firstChild = i_node;
+            veco_nodes[i_parent].i_lastChild = i_node;
+            ++veco_nodes[i_parent].i_childCount;
+
+            veci_path.append(i_node);
+        }
+
+        // Frequency quantized on a logarithmic scale, in [1, 255]
+        const double r_scale = std::log1p(vec_words.at(i_word).second) / std::log1p(r_maximumFrequency);
+        veco_nodes[veci_path.last()].i_frequency = quint8(qBound(1, 1 + qRound(254.0 * r_scale), 255));
+        i_maximumWordLength = qMax(i_maximumWordLength, s_word.size());
+    }
+
+    if (veco_nodes.size() > 0x7FFFFFFF / VIRTUALKEYBOARDDICTIONARY_NODESIZE)
+    {
+        if (ps_error != NULL) *ps_error = QString("too many words");
+        return false;
+    }
+
+    for (int i_node = 0; i_node < veco_nodes.size(); ++i_node)
+    {
+        if (veco_nodes.at(i_node).i_childCount > 0xFFFF)
+        {
+            if (ps_error != NULL) *ps_error = QString("more than 65535 different characters after a prefix");
+            return false;
+        }
+    }
+
+    // Highest frequency of each subtree : the children are created after their parent
+    for (int i_node = veco_nodes.size() - 1; i_node >= 0; --i_node)
+    {
+        VirtualKeyboardDictionaryBuildNode &o_node = veco_nodes[i_node];
+        o_node.i_bestFrequency = qMax(o_node.i_bestFrequency, o_node.i_frequency);
+        if (o_node.i_parent >= 0)
+            veco_nodes[o_node.i_parent].i_bestFrequency = qMax(veco_nodes.at(o_node.i_parent).i_bestFrequency, o_node.i_bestFrequency);
+    }
+
+    // --- Layout : the children of a node are contiguous, the blocks of children are placed depth first
+    QVector<int> veci_layoutIndexes(veco_nodes.size(), 0);
+    QVector<int> veci_stack;
+    int i_nextIndex = 1;
+    veci_stack.append(0);
+
+    while (!veci_stack.isEmpty())
+    {
+        const int i_node = veci_stack.takeLast();
+        const int i_stackSize = veci_stack.size();
+
+        for (int i_child = veco_nodes.at(i_node).i_firstChild; i_child >= 0; i_child = veco_nodes.at(i_child).i_nextSibling)
+        {
+            veci_layoutIndexes[i_child] = i_nextIndex++;
+            veci_stack.insert(i_stackSize, i_child);
+        }
+    }
+
+    QVector<VirtualKeyboardDictionaryNode> veco_layout(veco_nodes.size());
+    for (int i_node = 0; i_node < veco_nodes.size(); ++i_node)
+    {
+        const VirtualKeyboardDictionaryBuildNode &o_node = veco_nodes.at(i_node);
+        VirtualKeyboardDictionaryNode &o_compiledNode = veco_layout[veci_layoutIndexes.at(i_node)];
+
+        o_compiledNode.i_firstChild = qToLittleEndian<quint32>(o_node.i_firstChild >= 0 ? veci_layoutIndexes.at(o_node.i_firstChild) : 0);
+        o_compiledNode.i_childCount = qToLittleEndian<quint16>(o_node.i_childCount);
+        o_compiledNode.i_character = qToLittleEndian<quint16>(o_node.i_character);
+        o_compiledNode.i_frequency = o_node.i_frequency;
+        o_compiledNode.i_bestFrequency = o_node.i_bestFrequency;
+        o_compiledNode.i_reserved = 0;
+    }
+
+    // Header
+    VirtualKeyboardDictionaryHeader o_header;
+    memset(&o_header, 0, sizeof(o_header));
+    memcpy(o_header.tc_magic, VIRTUALKEYBOARDDICTIONARY_MAGIC, sizeof(o_header.tc_magic));
+    o_header.i_version = qToLittleEndian<quint16>(VIRTUALKEYBOARDDICTIONARY_VERSION);
+    o_header.i_nodeCount = qToLittleEndian<quint32>(veco_layout.size());
+    o_header.i_wordCount = qToLittleEndian<quint32>(i_wordCount);
+    o_header.i_maximumWordLength = qToLittleEndian<quint32>(i_maximumWordLength);
+
+    pba_compiled->clear();
+    pba_compiled->reserve(int(sizeof(o_header)) + veco_layout.size() * VIRTUALKEYBOARDDICTIONARY_NODESIZE);
+    pba_compiled->append(reinterpret_cast<const char*>(&o_header), sizeof(o_header));
+    pba_compiled->append(reinterpret_cast<const char*>(veco_layout.constData()), veco_layout.size() * VIRTUALKEYBOARDDICTIONARY_NODESIZE);
+
+    return true;
+}
+
+
+int VirtualKeyboardDictionary::wordCount() const
+{
+    return this->mi_wordCount;
+}
+
+
+QStringList VirtualKeyboardDictionary::completions(const QString &s_prefix, int i_count) const
+{
+    QStringList lists_words;
+
+    if (this->mpc_nodes == NULL || s_prefix.isEmpty() || i_count <= 0) return lists_words;
+
+    const VirtualKeyboardDictionaryNode *po_nodes = reinterpret_cast<const VirtualKeyboardDictionaryNode*>(this->mpc_nodes);
+
+    // --- Node of the prefix : binary search in the children of each node of the path
+    quint32 i_node = 0;
+    foreach (const QChar &o_char, s_prefix)
+    {
+        const quint32 i_firstChild = qFromLittleEndian(po_nodes[i_node].i_firstChild);
+        const quint32 i_childCount = qFromLittleEndian(po_nodes[i_node].i_childCount);
+
+        // Children after their parent and in the tree : the walk ends even on a corrupted file
+        if (i_childCount == 0 || i_firstChild <= i_node || i_firstChild + i_childCount > quint32(this->mi_nodeCount)) return lists_words;
+
+        quint32 i_low = i_firstChild;
+        quint32 i_high = i_firstChild + i_childCount;
+        while (i_low < i_high)
+        {
+            const quint32 i_middle = (i_low + i_high) / 2;
+            if (qFromLittleEndian(po_nodes[i_middle].i_character) < o_char.unicode()) i_low = i_middle + 1;
+            else i_high = i_middle;
+        }
+        if (i_low == i_firstChild + i_childCount || qFromLittleEndian(po_nodes[i_low].i_character) != o_char.unicode()) return lists_words;
+
+        i_node = i_low;
+    }
+
+    // --- Best-first walk of the subtree : a subtree is opened only when its best word can be among the next ones
+    QVector<VirtualKeyboardDictionaryTrail> veco_trail;
+    QVector<VirtualKeyboardDictionaryCandidate> veco_heap;
+    veco_trail.reserve(64);
+    veco_heap.reserve(64);
+
+    VirtualKeyboardDictionaryTrail o_start = { i_node, -1 };
+    VirtualKeyboardDictionaryCandidate o_subtree = { po_nodes[i_node].i_bestFrequency, false, 0 };
+    veco_trail.append(o_start);
+    veco_heap.append(o_subtree);
+
+    while (!veco_heap.isEmpty() && lists_words.size() < i_count)
+    {
+        std::pop_heap(veco_heap.begin(), veco_heap.end());
+        const VirtualKeyboardDictionaryCandidate o_candidate = veco_heap.last();
+        veco_heap.removeLast();
+
+        if (o_candidate.b_isWord)
+        {
+            // The prefix itself is not a completion
+            if (o_candidate.i_trail == 0) continue;
+
+            int i_length = 0;
+            for (int i_trail = o_candidate.i_trail; i_trail > 0; i_trail = veco_trail.at(i_trail).i_parent) ++i_length;
+
+            QString s_word(s_prefix.size() + i_length, Qt::Uninitialized);
+            QChar *po_end = std::copy(s_prefix.constBegin(), s_prefix.constEnd(), s_word.data()) + i_length;
+            for (int i_trail = o_candidate.i_trail; i_trail > 0; i_trail = veco_trail.at(i_trail).i_parent)
+                *--po_end = QChar(qFromLittleEndian(po_nodes[veco_trail.at(i_trail).i_node].i_character));
+
+            lists_words.append(s_word);
+            continue;
+        }
+
+        const quint32 i_opened = veco_trail.at(o_candidate.i_trail).i_node;
+        const quint32 i_firstChild = qFromLittleEndian(po_nodes[i_opened].i_firstChild);
+        const quint32 i_childCount = qFromLittleEndian(po_nodes[i_opened].i_childCount);
+
+        if (po_nodes[i_opened].i_frequency > 0)
+        {
+            VirtualKeyboardDictionaryCandidate o_word = { po_nodes[i_opened].i_frequency, true, o_candidate.i_trail };
+            veco_heap.append(o_word);
+            std::push_heap(veco_heap.begin(), veco_heap.end());
+        }
+
+        if (i_childCount == 0 || i_firstChild <= i_opened || i_firstChild + i_childCount > quint32(this->mi_nodeCount)) continue;
+
+        for (quint32 i_child = i_firstChild; i_child < i_firstChild + i_childCount; ++i_child)
+        {
+            VirtualKeyboardDictionaryTrail o_step = { i_child, o_candidate.i_trail };
+            VirtualKeyboardDictionaryCandidate o_child = { po_nodes[i_child].i_bestFrequency, false, veco_trail.size() };
+            veco_trail.append(o_step);
+            veco_heap.append(o_child);
+            std::push_heap(veco_heap.begin(), veco_heap.end());
+        }
+    }
+
+    return lists_words;
+}
+
+
+QStringList VirtualKeyboardDictionary::matches(const QStringList &lists_characters, int i_maximumCount, QVector<int> *pveci_frequencies) const
+{
+    QStringList lists_words;
+    if (pveci_frequencies != NULL) pveci_frequencies->clear();
+
+    if (this->mpc_nodes == NULL || lists_characters.isEmpty() || i_maximumCount <= 0) return lists_words;
+
+    const VirtualKeyboardDictionaryNode *po_nodes = reinterpret_cast<const VirtualKeyboardDictionaryNode*>(this->mpc_nodes);
+    const int i_length = lists_characters.size();
+
+    // --- Depth-first walk : one step per depth, holding the children of the node reached which are not visited yet.
+    //     Once i_maximumCount words are kept, the subtrees whose best word is not more frequent than all of them are skipped
+    QVector<VirtualKeyboardDictionaryMatchStep> veco_path;
+    QVector<VirtualKeyboardDictionaryMatch> veco_matches;
+    veco_path.reserve(i_length);
+    int i_matchCount = 0;
+
+    QString s_word(i_length, Qt::Uninitialized);
+
+    const quint32 i_rootFirstChild = qFromLittleEndian(po_nodes[0].i_firstChild);
+    const quint32 i_rootChildCount = qFromLittleEndian(po_nodes[0].i_childCount);
+    if (i_rootChildCount == 0 || i_rootFirstChild == 0 || i_rootFirstChild + i_rootChildCount > quint32(this->mi_nodeCount)) return lists_words;
+
+    VirtualKeyboardDictionaryMatchStep o_root = { i_rootFirstChild, i_rootFirstChild + i_rootChildCount };
+    veco_path.append(o_root);
+
+    while (!veco_path.isEmpty())
+    {
+        VirtualKeyboardDictionaryMatchStep &o_step = veco_path.last();
+
+        if (o_step.i_nextChild == o_step.i_endChild)
+        {
+            veco_path.removeLast();
+            continue;
+        }
+
+        const quint32 i_node = o_step.i_nextChild++;
+        const int i_depth = veco_path.size() - 1;
+        const QChar o_char(qFromLittleEndian(po_nodes[i_node].i_character));
+
+        if (!isMatchKept(veco_matches, i_maximumCount, po_nodes[i_node].i_bestFrequency)) continue;
+        if (!lists_characters.at(i_depth).contains(o_char)) continue;
+
+        s_word[i_depth] = o_char;
+
+        // Last position : the node must end a word
+        if (i_depth + 1 == i_length)
+        {
+            if (po_nodes[i_node].i_frequency == 0 || !isMatchKept(veco_matches, i_maximumCount, po_nodes[i_node].i_frequency)) continue;
+
+            keepMatch(veco_matches, i_maximumCount, po_nodes[i_node].i_frequency, i_matchCount++, s_word);
+            continue;
+        }
+
+        // Children after their parent and in the tree : the walk ends even on a corrupted file
+        const quint32 i_firstChild = qFromLittleEndian(po_nodes[i_node].i_firstChild);
+        const quint32 i_childCount = qFromLittleEndian(po_nodes[i_node].i_childCount);
+        if (i_childCount == 0 || i_firstChild <= i_node || i_firstChild + i_childCount > quint32(this->mi_nodeCount)) continue;
+
+        VirtualKeyboardDictionaryMatchStep o_child = { i_firstChild, i_firstChild + i_childCount };
+        veco_path.append(o_child);
+    }
+
+    return sortedMatches(veco_matches, pveci_frequencies);
+}
+
+
+QStringList VirtualKeyboardDictionary::matches(VirtualKeyboardDictionaryFilter *po_filter, int i_maximumLength, int i_maximumCount, QVector<int> *pveci_frequencies) const
+{
+    QStringList lists_words;
+    if (pveci_frequencies != NULL) pveci_frequencies->clear();
+
+    if (this->mpc_nodes == NULL || po_filter == NULL || i_maximumLength <= 0 || i_maximumCount <= 0) return lists_words;
+
+    const VirtualKeyboardDictionaryNode *po_nodes = reinterpret_cast<const VirtualKeyboardDictionaryNode*>(this->mpc_nodes);
+
+    // --- Depth-first walk : one step per depth, holding the children of the node reached which are not visited yet.
+    //     Once i_maximumCount words are kept, the subtrees whose best word is not more frequent than all of them are skipped
+    QVector<VirtualKeyboardDictionaryMatchStep> veco_path;
+    QVector<VirtualKeyboardDictionaryMatch> veco_matches;
+    veco_path.reserve(i_maximumLength);
+    int i_matchCount = 0;
+
+    QString s_word(i_maximumLength, Qt::Uninitialized);
+
+    const quint32 i_rootFirstChild = qFromLittleEndian(po_nodes[0].i_firstChild);
+    const quint32 i_rootChildCount = qFromLittleEndian(po_nodes[0].i_childCount);
+    if (i_rootChildCount == 0 || i_rootFirstChild == 0 || i_rootFirstChild + i_rootChildCount > quint32(this->mi_nodeCount)) return lists_words;
+
+    VirtualKeyboardDictionaryMatchStep o_root = { i_rootFirstChild, i_rootFirstChild + i_rootChildCount };
+    veco_path.append(o_root);
+
+    while (!veco_path.isEmpty())
+    {
+        VirtualKeyboardDictionaryMatchStep &o_step = veco_path.last();
+
+        if (o_step.i_nextChild == o_step.i_endChild)
+        {
+            veco_path.removeLast();
+            continue;
+        }
+
+        const quint32 i_node = o_step.i_nextChild++;
+        const int i_depth = veco_path.size() - 1;
+        const QChar o_char(qFromLittleEndian(po_nodes[i_node].i_character));
+
+        if (!isMatchKept(veco_matches, i_maximumCount, po_nodes[i_node].i_bestFrequency)) continue;
+        if (!po_filter->acceptPrefix(i_depth, o_char)) continue;
+
+        s_word[i_depth] = o_char;
+
+        if (po_nodes[i_node].i_frequency != 0 && isMatchKept(veco_matches, i_maximumCount, po_nodes[i_node].i_frequency)
+                && po_filter->acceptWord(i_depth + 1))
+            keepMatch(veco_matches, i_maximumCount, po_nodes[i_node].i_frequency, i_matchCount++, s_word.left(i_depth + 1));
+
+        if (i_depth + 1 == i_maximumLength) continue;
+
+        // Children after their parent and in the tree : the walk ends even on a corrupted file
+        const quint32 i_firstChild = qFromLittleEndian(po_nodes[i_node].i_firstChild);
+        const quint32 i_childCount = qFromLittleEndian(po_nodes[i_node].i_childCount);
+        if (i_childCount == 0 || i_firstChild <= i_node || i_firstChild + i_childCount > quint32(this->mi_nodeCount)) continue;
+
+        VirtualKeyboardDictionaryMatchStep o_child = { i_firstChild, i_firstChild + i_childCount };
+        veco_path.append(o_child);
+    }
+
+    return sortedMatches(veco_matches, pveci_frequencies);
+}
+
+
+VirtualKeyboardDictionary *VirtualKeyboardDictionary::load(const QString &s_fileName)
+{
+    VirtualKeyboardDictionary *po_dictionary = new VirtualKeyboardDictionary();
+    bool b_isAttached = false;
+
+    if (s_fileName.endsWith(QLatin1String(VIRTUALKEYBOARD_DICTIONARY_COMPILEDSUFFIX)))
+    {
+        // Memory-mapped (files and uncompressed resources), else read
+        po_dictionary->mpo_file = new QFile(s_fileName);
+        if (po_dictionary->mpo_file->open(QIODevice::ReadOnly))
+        {
+            const uchar *pc_data = po_dictionary->mpo_file->map(0, po_dictionary->mpo_file->size());
+            if (pc_data != NULL)
+            {
+                b_isAttached = po_dictionary->attach(pc_data, po_dictionary->mpo_file->size());
+            }
+            else
+            {
+                po_dictionary->mba_data = po_dictionary->mpo_file->readAll();
+                b_isAttached = po_dictionary->attach(reinterpret_cast<const uchar*>(po_dictionary->mba_data.constData()), po_dictionary->mba_data.size());
+                delete po_dictionary->mpo_file;
+                po_dictionary->mpo_file = NULL;
+            }
+        }
+    }
+    else
+    {
+        QFile o_file(s_fileName);
+        QString s_error;
+
+        if (o_file.open(QIODevice::ReadOnly | QIODevice::Text))
+        {
+            QTextStream o_stream(&o_file);
+            o_stream.setCodec("UTF-8");
+
+            if (VirtualKeyboardDictionary::compile(o_stream.readAll(), &po_dictionary->mba_data, &s_error))
+                b_isAttached = po_dictionary->attach(reinterpret_cast<const uchar*>(po_dictionary->mba_data.constData()), po_dictionary->mba_data.size());
+            else
+                qWarning("VirtualKeyboardDictionary: %s: %s", qPrintable(s_fileName), qPrintable(s_error));
+        }
+    }
+
+    if (!b_isAttached)
+    {
+        delete po_dictionary;
+        return NULL;
+    }
+    return po_dictionary;
+}
+
+
+bool VirtualKeyboardDictionary::attach(const uchar *pc_data, qint64 i_size)
+{
+    // The nodes are read in place : the compiled dictionaries are little-endian
+    if (QSysInfo::ByteOrder != QSysInfo::LittleEndian) return false;
+    if (pc_data == NULL || i_size < VIRTUALKEYBOARDDICTIONARY_HEADERSIZE + VIRTUALKEYBOARDDICTIONARY_NODESIZE || (quintptr(pc_data) & 3) != 0) return false;
+
+    const VirtualKeyboardDictionaryHeader *po_header = reinterpret_cast<const VirtualKeyboardDictionaryHeader*>(pc_data);
+
+    if (memcmp(po_header->tc_magic, VIRTUALKEYBOARDDICTIONARY_MAGIC, sizeof(po_header->tc_magic)) != 0
+            || qFromLittleEndian(po_header->i_version) != VIRTUALKEYBOARDDICTIONARY_VERSION)
+        return false;
+
+    // The nodes are not checked here (it would read the whole file) : their links are checked when they are followed
+    const qint64 i_nodeCount = qFromLittleEndian(po_header->i_nodeCount);
+    if (i_nodeCount < 1 || i_nodeCount > 0x7FFFFFFF / VIRTUALKEYBOARDDICTIONARY_NODESIZE
+            || i_size < VIRTUALKEYBOARDDICTIONARY_HEADERSIZE + i_nodeCount * VIRTUALKEYBOARDDICTIONARY_NODESIZE)
+        return false;
+
+    this->mpc_nodes = pc_data + VIRTUALKEYBOARDDICTIONARY_HEADERSIZE;
+    this->mi_nodeCount = int(i_nodeCount);
+    this->mi_wordCount = int(qMin<quint32>(qFromLittleEndian(po_header->i_wordCount), 0x7FFFFFFF));
+
+    return true;
+}
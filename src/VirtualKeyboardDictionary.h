@@ -0,0 +1,242 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+#ifndef VIRTUALKEYBOARDDICTIONARY_H
+#define VIRTUALKEYBOARDDICTIONARY_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QFile>
+#include <QVector>
+
+
+// File extensions of the dictionaries
+#define VIRTUALKEYBOARD_DICTIONARY_SOURCESUFFIX     ".vkd"
+#define VIRTUALKEYBOARD_DICTIONARY_COMPILEDSUFFIX   ".vkdc"
+
+
+/**
+ * \brief Filter of a walk of a dictionary (VirtualKeyboardDictionary::matches()) : decides which prefixes the walk follows
+ *
+ * The walk is depth first : acceptPrefix() is called for the children of the last prefix accepted, in the order of the tree,
+ * so a filter can keep its state per depth (the state of a depth is overwritten by the next sibling accepted). Some children may
+ * be skipped without calling acceptPrefix() (subtrees too rare to be returned).
+ */
+class VirtualKeyboardDictionaryFilter
+{
+    // Public Functions
+public:
+
+    /**
+     * \brief Destructor
+     */
+    virtual ~VirtualKeyboardDictionaryFilter() {}
+
+    /**
+     * \brief Check the last prefix accepted extended by one character
+     * \param[in] i_depth : Position of the character (0 for the first character of the words)
+     * \param[in] o_character : Character
+     * \return True to follow the prefix extended : its word and its subtree
+     */
+    virtual bool acceptPrefix(int i_depth, const QChar &o_character) = 0;
+
+    /**
+     * \brief Check the word of the last prefix accepted
+     * \param[in] i_length : Length of the word
+     * \return True to return the word
+     */
+    virtual bool acceptWord(int i_length) = 0;
+};
+
+
+/**
+ * \brief Word list of the prediction : prefix tree of the words, with their frequencies, read in place
+ *
+ * A dictionary is a read-only view over a compiled dictionary (.vkdc), memory-mapped from a file or a Qt resource, or compiled
+ * in memory from a source dictionary (.vkd). Only the pages of the tree visited by the lookups are loaded by the system :
+ * a lexicon of 500k words costs a few hundred kB of resident memory, and nothing is parsed when it is opened.
+ * The dictionaries are loaded by find() and shared by every keyboard of the process, they are never unloaded.
+ *
+ * Source format (UTF-8) :
+ * \code
+ * # Comment : line starting with '#'
+ * # One word per line, followed by its frequency (any positive count, 1 if omitted)
+ * the 23135851162
+ * keyboard 3482671
+ * \endcode
+ *
+ * Compiled format (little-endian) : a 32 bytes header (magic "VKDC", version, number of nodes, number of words, length of the
+ * longest word), then the nodes of the tree (12 bytes each, the root first). A node holds the UTF-16 code unit leading to it,
+ * the index and number of its children (contiguous, sorted by code unit), the frequency of its word (0 if it ends no word) and
+ * the highest frequency of its subtree. The frequencies are quantized on a logarithmic scale to [1, 255].
+ * The blocks of children are laid out depth first : the completions of a prefix are read from a few neighbouring pages.
+ */
+class VirtualKeyboardDictionary
+{
+    // Private Members
+private:
+
+    /**
+     * Compiled dictionary, when compiled in memory or read from a device which can not be mapped
+     */
+    QByteArray mba_data;
+
+    /**
+     * File mapped, when the dictionary is memory-mapped
+     */
+    QFile *mpo_file;
+
+    /**
+     * Nodes of the tree, the root first
+     */
+    const uchar *mpc_nodes;
+
+    /**
+     * Number of nodes of the tree
+     */
+    int mi_nodeCount;
+
+    /**
+     * Number of words
+     */
+    int mi_wordCount;
+
+
+    // Public Functions
+public:
+
+    /**
+     * \brief Destructor
+     */
+    ~VirtualKeyboardDictionary();
+
+    /**
+     * \brief Get a dictionary, loading it on first use
+     *
+     * A compiled dictionary (VIRTUALKEYBOARD_DICTIONARY_COMPILEDSUFFIX) is memory-mapped, the other files are compiled in memory.
+     * This function is thread-safe.
+     *
+     * \param[in] s_fileName : Dictionary file (or Qt resource)
+     * \return Dictionary shared by the whole process, NULL if the file can not be read or is invalid
+     */
+    static const VirtualKeyboardDictionary *find(const QString &s_fileName);
+
+    /**
+     * \brief Get a dictionary if it is already loaded, without loading it
+     *
+     * Never waits for a dictionary being loaded by another thread. This function is thread-safe.
+     *
+     * \param[in] s_fileName : Dictionary file (or Qt resource)
+     * \return Dictionary shared by the whole process, NULL if it is not loaded (yet)
+     */
+    static const VirtualKeyboardDictionary *findLoaded(const QString &s_fileName);
+
+    /**
+     * \brief Compile a source dictionary
+     * \param[in] s_source : Source dictionary
+     * \param[out] pba_compiled : Compiled dictionary
+     * \param[out] ps_error : Error message if the compilation fails (optional)
+     * \return True if the source has been compiled
+     */
+    static bool compile(const QString &s_source, QByteArray *pba_compiled, QString *ps_error = NULL);
+
+    /**
+     * \brief Get the number of words of the dictionary
+     */
+    int wordCount() const;
+
+    /**
+     * \brief Get the most frequent words starting with a prefix (the prefix itself excluded), most frequent first
+     *
+     * The prefix is matched exactly (case included). The lookup is a best-first walk of the subtree of the prefix, guided by
+     * the highest frequency of each subtree : it visits the nodes of the words returned and their siblings, not the whole subtree.
+     * This function is reentrant, the dictionary can be read by several threads.
+     *
+     * \param[in] s_prefix : Beginning of the words
+     * \param[in] i_count : Maximum number of words
+     * \return Words, at most i_count
+     */
+    QStringList completions(const QString &s_prefix, int i_count) const;
+
+    /**
+     * \brief Get the words spelt by a pattern : one set of characters allowed at each position
+     *
+     * The walk only follows the children whose character is allowed at their depth : its cost is bounded by the number of prefixes
+     * of the dictionary the pattern can spell, not by the size of the dictionary. When more than i_maximumCount words match, the most
+     * frequent ones are returned : once i_maximumCount words are kept, the subtrees whose highest frequency can not beat them are
+     * skipped. The words are returned most frequent first (in the order of the tree for equal frequencies).
+     * This function is reentrant, the dictionary can be read by several threads.
+     *
+     * \param[in] lists_characters : Characters allowed at each position, the words returned have its length
+     * \param[in] i_maximumCount : Maximum number of words
+     * \param[out] pveci_frequencies : Quantized frequency of each word returned, in [1, 255] (optional)
+     * \return Words, at most i_maximumCount
+     */
+    QStringList matches(const QStringList &lists_characters, int i_maximumCount, QVector<int> *pveci_frequencies = NULL) const;
+
+    /**
+     * \brief Get the words accepted by a filter
+     *
+     * The walk only follows the prefixes accepted by the filter : its cost is bounded by the number of prefixes it accepts, not by
+     * the size of the dictionary. When more than i_maximumCount words are accepted, the most frequent ones are returned : once
+     * i_maximumCount words are kept, the subtrees whose highest frequency can not beat them are skipped (not passed to the filter).
+     * The words are returned most frequent first (in the order of the tree for equal frequencies).
+     * This function is reentrant, the dictionary can be read by several threads (each with its own filter).
+     *
+     * \param[in] po_filter : Filter of the prefixes and of the words
+     * \param[in] i_maximumLength : Maximum length of the words
+     * \param[in] i_maximumCount : Maximum number of words
+     * \param[out] pveci_frequencies : Quantized frequency of each word returned, in [1, 255] (optional)
+     * \return Words, at most i_maximumCount
+     */
+    QStringList matches(VirtualKeyboardDictionaryFilter *po_filter, int i_maximumLength, int i_maximumCount, QVector<int> *pveci_frequencies = NULL) const;
+
+
+    // Private Functions
+private:
+
+    /**
+     * \brief Constructor, use find() to get a dictionary
+     */
+    VirtualKeyboardDictionary();
+
+    /**
+     * \brief Load a dictionary file : memory-mapped if possible, else read, compiled first if it is a source dictionary
+     * \param[in] s_fileName : File to load
+     * \return Dictionary, NULL if the file can not be read or is invalid
+     */
+    static VirtualKeyboardDictionary *load(const QString &s_fileName);
+
+    /**
+     * \brief Check a compiled dictionary and set the pointers of the view
+     * \param[in] pc_data : Compiled dictionary
+     * \param[in] i_size : Size of the compiled dictionary
+     * \return True if the compiled dictionary is valid
+     */
+    bool attach(const uchar *pc_data, qint64 i_size);
+};
+
+#endif // VIRTUALKEYBOARDDICTIONARY_H
@@ -0,0 +1,126 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+
+#include "VirtualKeyboardFocusDispatcher.h"
+#include "VirtualKeyboard.h"
+
+#include <QApplication>
+#include <QPointer>
+
+
+/**
+ * Dispatcher of the application (child of the application, destroyed with it)
+ */
+static QPointer<VirtualKeyboardFocusDispatcher> spo_instance;
+
+
+
+VirtualKeyboardFocusDispatcher::VirtualKeyboardFocusDispatcher(QObject *o_parent) :
+    QObject(o_parent)
+{
+    connect(qApp,   SIGNAL(focusChanged(QWidget*,QWidget*)),
+            this,   SLOT(focusChanged(QWidget*,QWidget*)));
+}
+
+
+VirtualKeyboardFocusDispatcher *VirtualKeyboardFocusDispatcher::instance()
+{
+    if (spo_instance.isNull() && qApp != NULL)
+        spo_instance = new VirtualKeyboardFocusDispatcher(qApp);
+
+    return spo_instance;
+}
+
+
+void VirtualKeyboardFocusDispatcher::addKeyboard(VirtualKeyboard *w_keyboard)
+{
+    VirtualKeyboardFocusDispatcher *po_dispatcher = VirtualKeyboardFocusDispatcher::instance();
+
+    if (po_dispatcher != NULL && !po_dispatcher->mlistw_keyboards.contains(w_keyboard))
+        po_dispatcher->mlistw_keyboards.append(w_keyboard);
+}
+
+
+void VirtualKeyboardFocusDispatcher::removeKeyboard(VirtualKeyboard *w_keyboard)
+{
+    // Not instance() : nothing to do if the dispatcher does not exist (anymore)
+    if (!spo_instance.isNull())
+        spo_instance->mlistw_keyboards.removeOne(w_keyboard);
+}
+
+
+int VirtualKeyboardFocusDispatcher::widgetType(const QMetaObject *po_metaObject)
+{
+    QHash<const QMetaObject *, int>::const_iterator it_type = this->mhashi_widgetTypes.constFind(po_metaObject);
+
+    if (it_type == this->mhashi_widgetTypes.constEnd())
+        it_type = this->mhashi_widgetTypes.insert(po_metaObject, VirtualKeyboardInputTarget::widgetType(po_metaObject));
+
+    return it_type.value();
+}
+
+
+void VirtualKeyboardFocusDispatcher::focusChanged(QWidget *w_old, QWidget *w_new)
+{
+    Q_UNUSED(w_old)
+
+    // The slots connected to the signals of a keyboard (flush, input target change) can destroy keyboards or unregister them :
+    // the keyboards are iterated from a snapshot, the destroyed ones are skipped
+    QList<QPointer<VirtualKeyboard> > listpo_keyboards;
+
+    for (int i_i = 0; i_i < this->mlistw_keyboards.size(); ++i_i)
+        listpo_keyboards.append(this->mlistw_keyboards.at(i_i));
+
+    // The keys buffered by the coalescing are applied before the focus leaves their input widget
+    for (int i_i = 0; i_i < listpo_keyboards.size(); ++i_i)
+    {
+        if (listpo_keyboards.at(i_i) != NULL) listpo_keyboards.at(i_i)->flushCoalescedKeys();
+    }
+
+    if (w_new == NULL || this->mlistw_keyboards.isEmpty()) return;
+
+    // The widgets which can not be edited (buttons, ...) do not change the input widget
+    const int i_type = this->widgetType(w_new->metaObject());
+
+    if (i_type == VIRTUALKEYBOARD_INPUT_UNKNOWINPUTTYPE) return;
+
+    const QPointer<QWidget> po_new(w_new);
+
+    for (int i_i = 0; i_i < listpo_keyboards.size() && po_new != NULL; ++i_i)
+    {
+        VirtualKeyboard *w_keyboard = listpo_keyboards.at(i_i);
+
+        if (w_keyboard == NULL || !this->mlistw_keyboards.contains(w_keyboard)) continue;
+
+        QWidget *w_scope = w_keyboard->mpw_focusScope;
+
+        // Keyboard restricted to a subtree (nothing is followed anymore once the scope has been destroyed)
+        if (w_keyboard->mb_isFocusScoped && (w_scope == NULL || (w_scope != w_new && !w_scope->isAncestorOf(w_new))))
+            continue;
+
+        w_keyboard->setInputTarget(w_new, i_type);
+    }
+}
@@ -0,0 +1,114 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+#ifndef VIRTUALKEYBOARDFOCUSDISPATCHER_H
+#define VIRTUALKEYBOARDFOCUSDISPATCHER_H
+
+#include <QObject>
+#include <QWidget>
+#include <QList>
+#include <QHash>
+
+class VirtualKeyboard;
+
+
+/**
+ * \brief Follow the focus of the application for every virtual keyboard
+ *
+ * A single connection to QApplication::focusChanged serves all the keyboards (instead of one connection per keyboard).
+ * The type of the newly focused widget is resolved once per focus change, through a cache indexed by QMetaObject :
+ * the widgets which can not be edited (buttons, labels, ...) cost a hash lookup, without any qobject_cast.
+ * The widget is then given to the keyboards whose focus scope contains it (see VirtualKeyboard::setFocusScope).
+ */
+class VirtualKeyboardFocusDispatcher : public QObject
+{
+    Q_OBJECT
+
+
+    // Private Members
+private:
+
+    /**
+     * Keyboards following the focus
+     */
+    QList<VirtualKeyboard *> mlistw_keyboards;
+
+    /**
+     * Type of input widget (VIRTUALKEYBOARD_INPUT_*) of each widget class already focused
+     */
+    QHash<const QMetaObject *, int> mhashi_widgetTypes;
+
+
+    // Public Functions
+public:
+
+    /**
+     * \brief Get the dispatcher of the application, created on first use
+     * \return Dispatcher, child of the application
+     */
+    static VirtualKeyboardFocusDispatcher *instance();
+
+    /**
+     * \brief Make a keyboard follow the focus (once, even if called several times)
+     * \param[in] w_keyboard : Keyboard
+     */
+    static void addKeyboard(VirtualKeyboard *w_keyboard);
+
+    /**
+     * \brief Make a keyboard stop following the focus
+     * \param[in] w_keyboard : Keyboard
+     */
+    static void removeKeyboard(VirtualKeyboard *w_keyboard);
+
+    /**
+     * \brief Get the type of input widget of a widget class, from the cache
+     * \param[in] po_metaObject : Meta-object of the widget class
+     * \return VIRTUALKEYBOARD_INPUT_*, VIRTUALKEYBOARD_INPUT_UNKNOWINPUTTYPE if the class is not supported
+     */
+    int widgetType(const QMetaObject *po_metaObject);
+
+
+    // Private Functions
+private:
+
+    /**
+     * \brief Constructor, use instance()
+     * \param o_parent : parent Object
+     */
+    explicit VirtualKeyboardFocusDispatcher(QObject *o_parent);
+
+
+    // Private Slots
+private slots:
+
+    /**
+     * \brief Slot connected to the QApplication::focusChanged signal, give the focused widget to the keyboards concerned
+     * \param[in] w_old : last focused widget (Unused here)
+     * \param[in] w_new : Newly focused widget
+     */
+    void focusChanged(QWidget *w_old, QWidget *w_new);
+};
+
+#endif // VIRTUALKEYBOARDFOCUSDISPATCHER_H
@@ -0,0 +1,243 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+#include "VirtualKeyboardGeometry.h"
+
+#include <QtMath>
+
+
+/**
+ * \brief Definition of a key in the key-geometry table
+ */
+struct KeyDefinition
+{
+    /**
+     * Index of the key in the keymap for a principal key, else one of the VIRTUALKEYBOARD_KEY_* values
+     */
+    int i_keyId;
+
+    /**
+     * Row of the key, from top (0) to bottom
+     */
+    int i_row;
+
+    /**
+     * Minimum width of the key, also used as its stretch factor inside its row
+     */
+    int i_minimumWidth;
+};
+
+
+/**
+ * \brief Build the key-geometry table of a keymap, in the same order as the buttons of VirtualKeyboard.ui :
+ *      the rows of principal keys of the keymap, the caps lock and backspace keys around the last one, then the row of the special keys
+ * \return Number of rows
+ */
+static int keyDefinitions(const VirtualKeyboardKeymap *po_keymap, QVector<KeyDefinition> &vec_definitions)
+{
+    vec_definitions.clear();
+
+    if (po_keymap == NULL) return 0;
+
+    const int i_principalRowCount = po_keymap->rowCount();
+    int i_keyId = 0;
+
+    for (int i_row = 0; i_row < i_principalRowCount; ++i_row)
+    {
+        const bool b_isLastRow = i_row == i_principalRowCount - 1;
+        const KeyDefinition o_caps = {VIRTUALKEYBOARD_KEY_CAPS, i_row, 100};
+        const KeyDefinition o_backspace = {VIRTUALKEYBOARD_KEY_BACKSPACE, i_row, 150};
+
+        if (b_isLastRow) vec_definitions.append(o_caps);
+        for (int i_i = 0; i_i < po_keymap->rowKeyCount(i_row); ++i_i)
+        {
+            const KeyDefinition o_key = {i_keyId++, i_row, po_keymap->rowKeyWidth(i_row)};
+            vec_definitions.append(o_key);
+        }
+        if (b_isLastRow) vec_definitions.append(o_backspace);
+    }
+
+    const KeyDefinition t_specialKeys[] =
+    {
+        {VIRTUALKEYBOARD_KEY_NUMBERS,       i_principalRowCount, 100},
+        {VIRTUALKEYBOARD_KEY_PUNCTUATION,   i_principalRowCount, 100},
+        {VIRTUALKEYBOARD_KEY_SPACE,         i_principalRowCount, 300},
+        {VIRTUALKEYBOARD_KEY_ENTER,         i_principalRowCount, 100}
+    };
+    for (unsigned int i_i = 0; i_i < sizeof(t_specialKeys) / sizeof(t_specialKeys[0]); ++i_i)
+        vec_definitions.append(t_specialKeys[i_i]);
+
+    return i_principalRowCount + 1;
+}
+
+
+
+VirtualKeyboardGeometry::VirtualKeyboardGeometry() :
+    mi_rowCount(0),
+    mi_gridWidth(0)
+{
+}
+
+
+void VirtualKeyboardGeometry::layout(const QSizeF &o_size, const VirtualKeyboardKeymap *po_keymap, int i_layer)
+{
+    this->mo_size = o_size;
+    this->mvec_keys.clear();
+
+    QVector<KeyDefinition> vec_definitions;
+    this->mi_rowCount = keyDefinitions(po_keymap, vec_definitions);
+
+    const qreal r_rowHeight = this->mi_rowCount == 0 ? 0 : (o_size.height() - (this->mi_rowCount - 1) * VIRTUALKEYBOARD_GEOMETRY_SPACING) / this->mi_rowCount;
+
+    for (int i_row = 0; i_row < this->mi_rowCount; ++i_row)
+    {
+        // --- Select the keys of the row which are displayed, a principal key without text is hidden
+        QVector<const KeyDefinition *> vecp_rowKeys;
+        int i_totalWidth = 0;
+
+        for (int i_i = 0; i_i < vec_definitions.size(); ++i_i)
+        {
+            const KeyDefinition &o_definition = vec_definitions.at(i_i);
+
+            if (o_definition.i_row != i_row) continue;
+
+            if (o_definition.i_keyId >= 0 && po_keymap->isKeyEmpty(i_layer, o_definition.i_keyId))
+                continue;
+
+            vecp_rowKeys.append(&o_definition);
+            i_totalWidth += o_definition.i_minimumWidth;
+        }
+
+        if (vecp_rowKeys.isEmpty()) continue;
+
+        // --- Share the width of the row between its keys, proportionally to their minimum width
+        const qreal r_availableWidth = o_size.width() - (vecp_rowKeys.size() - 1) * VIRTUALKEYBOARD_GEOMETRY_SPACING;
+        const qreal r_y = i_row * (r_rowHeight + VIRTUALKEYBOARD_GEOMETRY_SPACING);
+        qreal r_x = 0;
+
+        for (int i_i = 0; i_i < vecp_rowKeys.size(); ++i_i)
+        {
+            Key o_key;
+            const qreal r_width = r_availableWidth * vecp_rowKeys.at(i_i)->i_minimumWidth / i_totalWidth;
+
+            o_key.i_keyId = vecp_rowKeys.at(i_i)->i_keyId;
+            o_key.o_rect = QRectF(r_x, r_y, r_width, r_rowHeight);
+            this->mvec_keys.append(o_key);
+
+            r_x += r_width + VIRTUALKEYBOARD_GEOMETRY_SPACING;
+        }
+    }
+
+    this->buildGrid();
+}
+
+
+int VirtualKeyboardGeometry::keyAt(const QPointF &o_position) const
+{
+    if (o_position.x() < 0 || o_position.y() < 0) return VIRTUALKEYBOARD_KEY_NONE;
+
+    const int i_x = int(o_position.x());
+    const int i_y = int(o_position.y());
+
+    if (i_x >= this->mi_gridWidth || i_y >= this->mveci_rowAtY.size()) return VIRTUALKEYBOARD_KEY_NONE;
+
+    const int i_row = this->mveci_rowAtY.at(i_y);
+
+    if (i_row < 0) return VIRTUALKEYBOARD_KEY_NONE;
+
+    return this->mveci_keyAtX.at(i_row * this->mi_gridWidth + i_x);
+}
+
+
+QRectF VirtualKeyboardGeometry::keyRect(int i_keyId) const
+{
+    for (int i_i = 0; i_i < this->mvec_keys.size(); ++i_i)
+    {
+        if (this->mvec_keys.at(i_i).i_keyId == i_keyId)
+            return this->mvec_keys.at(i_i).o_rect;
+    }
+    return QRectF();
+}
+
+
+const QVector<VirtualKeyboardGeometry::Key> &VirtualKeyboardGeometry::keys() const
+{
+    return this->mvec_keys;
+}
+
+
+QSizeF VirtualKeyboardGeometry::size() const
+{
+    return this->mo_size;
+}
+
+
+QSizeF VirtualKeyboardGeometry::minimumSize(const VirtualKeyboardKeymap *po_keymap)
+{
+    QVector<KeyDefinition> vec_definitions;
+    const int i_rowCount = keyDefinitions(po_keymap, vec_definitions);
+    int i_width = 0;
+
+    for (int i_row = 0; i_row < i_rowCount; ++i_row)
+    {
+        int i_rowWidth = 0;
+        int i_rowKeys = 0;
+
+        for (int i_i = 0; i_i < vec_definitions.size(); ++i_i)
+        {
+            if (vec_definitions.at(i_i).i_row != i_row) continue;
+            i_rowWidth += vec_definitions.at(i_i).i_minimumWidth;
+            ++i_rowKeys;
+        }
+        i_width = qMax(i_width, i_rowWidth + (i_rowKeys - 1) * VIRTUALKEYBOARD_GEOMETRY_SPACING);
+    }
+
+    return QSizeF(i_width, i_rowCount * VIRTUALKEYBOARD_GEOMETRY_KEYHEIGHT + qMax(0, i_rowCount - 1) * VIRTUALKEYBOARD_GEOMETRY_SPACING);
+}
+
+
+void VirtualKeyboardGeometry::buildGrid()
+{
+    this->mi_gridWidth = qMax(0, qCeil(this->mo_size.width()));
+    this->mveci_rowAtY.fill(-1, qMax(0, qCeil(this->mo_size.height())));
+    this->mveci_keyAtX.fill(VIRTUALKEYBOARD_KEY_NONE, this->mi_rowCount * this->mi_gridWidth);
+
+    // Each pixel cell belongs to the key containing its centre
+    for (int i_i = 0; i_i < this->mvec_keys.size(); ++i_i)
+    {
+        const Key &o_key = this->mvec_keys.at(i_i);
+        const int i_row = int(o_key.o_rect.top() / (o_key.o_rect.height() + VIRTUALKEYBOARD_GEOMETRY_SPACING) + 0.5);
+
+        const int i_top = qMax(0, qCeil(o_key.o_rect.top() - 0.5));
+        const int i_bottom = qMin(this->mveci_rowAtY.size(), qCeil(o_key.o_rect.bottom() - 0.5));
+        for (int i_y = i_top; i_y < i_bottom; ++i_y)
+            this->mveci_rowAtY[i_y] = i_row;
+
+        const int i_left = qMax(0, qCeil(o_key.o_rect.left() - 0.5));
+        const int i_right = qMin(this->mi_gridWidth, qCeil(o_key.o_rect.right() - 0.5));
+        for (int i_x = i_left; i_x < i_right; ++i_x)
+            this->mveci_keyAtX[i_row * this->mi_gridWidth + i_x] = o_key.i_keyId;
+    }
+}
@@ -0,0 +1,179 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+#ifndef VIRTUALKEYBOARDGEOMETRY_H
+#define VIRTUALKEYBOARDGEOMETRY_H
+
+#include <QVector>
+#include <QRectF>
+#include <QSizeF>
+
+#include "VirtualKeyboardKeymap.h"
+
+
+// Identifiers of the keys which are not principal keys (below zero : the principal keys are identified by their index in the keymap)
+#define VIRTUALKEYBOARD_KEY_NONE            -1
+#define VIRTUALKEYBOARD_KEY_CAPS            -2
+#define VIRTUALKEYBOARD_KEY_BACKSPACE       -3
+#define VIRTUALKEYBOARD_KEY_NUMBERS         -4
+#define VIRTUALKEYBOARD_KEY_PUNCTUATION     -5
+#define VIRTUALKEYBOARD_KEY_SPACE           -6
+#define VIRTUALKEYBOARD_KEY_ENTER           -7
+#define VIRTUALKEYBOARD_KEY_CUT             -8
+#define VIRTUALKEYBOARD_KEY_COPY            -9
+#define VIRTUALKEYBOARD_KEY_PASTE           -10
+
+// Layout of the painted keyboard (mirror the values used in VirtualKeyboard.ui)
+#define VIRTUALKEYBOARD_GEOMETRY_KEYHEIGHT  50
+#define VIRTUALKEYBOARD_GEOMETRY_SPACING    6
+
+
+/**
+ * \brief Key-geometry table of the principal part of the keyboard
+ *
+ * Compute the rectangle of every key from a table of key definitions (row and minimum width of each key) built from the rows of the keymap.
+ * Like the QHBoxLayout rows of VirtualKeyboard.ui, the principal keys without text are not displayed and the other keys of the row share the space left.
+ *
+ * The hit-testing is done in constant time through a grid precomputed by layout() : a table giving the row at each pixel line,
+ * and for each row a table giving the key at each pixel column.
+ *
+ * This class only depends on QtCore, it can be used without a display.
+ */
+class VirtualKeyboardGeometry
+{
+    // Public Types
+public:
+
+    /**
+     * \brief Position of a displayed key
+     */
+    struct Key
+    {
+        /**
+         * Index of the key in the keymap for a principal key, else one of the VIRTUALKEYBOARD_KEY_* values
+         */
+        int i_keyId;
+
+        /**
+         * Rectangle of the key
+         */
+        QRectF o_rect;
+    };
+
+
+    // Private Members
+private:
+
+    /**
+     * Keys displayed with the current size and keymap
+     */
+    QVector<Key> mvec_keys;
+
+    /**
+     * Size used for the last layout
+     */
+    QSizeF mo_size;
+
+    /**
+     * Number of rows of keys (rows of the keymap and row of the special keys)
+     */
+    int mi_rowCount;
+
+    /**
+     * Hit-testing grid : row at each pixel line, -1 between the rows
+     */
+    QVector<qint8> mveci_rowAtY;
+
+    /**
+     * Hit-testing grid : key identifier at each pixel column of each row (row after row), VIRTUALKEYBOARD_KEY_NONE between the keys
+     */
+    QVector<qint16> mveci_keyAtX;
+
+    /**
+     * Width of the hit-testing grid, in pixels
+     */
+    int mi_gridWidth;
+
+
+    // Public Functions
+public:
+
+    /**
+     * \brief Constructor
+     */
+    VirtualKeyboardGeometry();
+
+    /**
+     * \brief Compute the rectangles of the keys
+     * \param[in] o_size : Size of the area in which the keys are displayed
+     * \param[in] po_keymap : Keymap displayed, gives the rows of principal keys
+     * \param[in] i_layer : Layer of the keymap displayed (VIRTUALKEYBOARD_LAYER_*), used to know which principal keys are hidden
+     */
+    void layout(const QSizeF &o_size, const VirtualKeyboardKeymap *po_keymap, int i_layer);
+
+    /**
+     * \brief Get the key at a position, in constant time
+     * \param[in] o_position : Position, in the coordinates of the area passed to layout()
+     * \return Identifier of the key, VIRTUALKEYBOARD_KEY_NONE if there is no key at this position
+     */
+    int keyAt(const QPointF &o_position) const;
+
+    /**
+     * \brief Get the rectangle of a key
+     * \param[in] i_keyId : Identifier of the key
+     * \return Rectangle of the key, a null rectangle if the key is not displayed
+     */
+    QRectF keyRect(int i_keyId) const;
+
+    /**
+     * \brief Get the keys displayed
+     * \return Keys displayed with the current size and keymap
+     */
+    const QVector<Key> &keys() const;
+
+    /**
+     * \brief Get the size used for the last layout
+     * \return Size passed to the last call of layout()
+     */
+    QSizeF size() const;
+
+    /**
+     * \brief Get the minimum size needed to display every key at its minimum width
+     * \param[in] po_keymap : Keymap displayed
+     * \return Minimum size
+     */
+    static QSizeF minimumSize(const VirtualKeyboardKeymap *po_keymap);
+
+
+    // Private Functions
+private:
+
+    /**
+     * \brief Build the hit-testing grid from the rectangles of the keys
+     */
+    void buildGrid();
+};
+
+#endif // VIRTUALKEYBOARDGEOMETRY_H
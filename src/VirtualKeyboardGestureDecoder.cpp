@@ -0,0 +1,344 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+
+#include "VirtualKeyboardGestureDecoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <QVarLengthArray>
+
+#ifdef VIRTUALKEYBOARD_HAS_SSE
+#include <xmmintrin.h>
+#endif
+
+
+/**
+ * \brief Filter of the walk of the dictionary : the letters of the words are on keys near the path, in the order of the path,
+ * and their templates are about as long as the path
+ *
+ * Each letter is matched to the first point of the path, not before the point of the previous letter, near its key :
+ * the earliest match leaves the most of the path to the next letters.
+ */
+class VirtualKeyboardGestureFilter : public VirtualKeyboardDictionaryFilter
+{
+public:
+
+    /**
+     * \brief Constructor
+     * \param[in] s_keyCharacters : Lowercase character of each key
+     * \param[in] pr_keyX, pr_keyY : Centre of each key, in standard deviations
+     * \param[in] pi_nearKeys : Keys near each point of the path, one bit per key, VIRTUALKEYBOARD_GESTURE_SAMPLECOUNT
+     * \param[in] r_minimumLength, r_maximumLength : Lengths allowed for the templates of the words, in standard deviations
+     */
+    VirtualKeyboardGestureFilter(const QString &s_keyCharacters, const float *pr_keyX, const float *pr_keyY, const quint64 *pi_nearKeys,
+                                 float r_minimumLength, float r_maximumLength) :
+        ms_keyCharacters(s_keyCharacters),
+        mpr_keyX(pr_keyX),
+        mpr_keyY(pr_keyY),
+        mpi_nearKeys(pi_nearKeys),
+        mr_minimumLength(r_minimumLength),
+        mr_maximumLength(r_maximumLength)
+    {
+    }
+
+    /**
+     * \brief Reimplemented from VirtualKeyboardDictionaryFilter
+     */
+    bool acceptPrefix(int i_depth, const QChar &o_character)
+    {
+        const int i_key = this->ms_keyCharacters.indexOf(o_character.toLower());
+        if (i_key < 0) return false;
+
+        const quint64 i_bit = Q_UINT64_C(1) << i_key;
+
+        // The first letter at the start of the path
+        if (i_depth == 0)
+        {
+            if ((this->mpi_nearKeys[0] & i_bit) == 0) return false;
+
+            this->mti_keys[0] = i_key;
+            this->mti_samples[0] = 0;
+            this->mtr_lengths[0] = 0;
+            return true;
+        }
+
+        // Template already longer than the path
+        const int i_previousKey = this->mti_keys[i_depth - 1];
+        const float r_dx = this->mpr_keyX[i_key] - this->mpr_keyX[i_previousKey];
+        const float r_dy = this->mpr_keyY[i_key] - this->mpr_keyY[i_previousKey];
+        const float r_length = this->mtr_lengths[i_depth - 1] + std::sqrt(r_dx * r_dx + r_dy * r_dy);
+
+        if (r_length > this->mr_maximumLength) return false;
+
+        for (int i_sample = this->mti_samples[i_depth - 1]; i_sample < VIRTUALKEYBOARD_GESTURE_SAMPLECOUNT; ++i_sample)
+        {
+            if ((this->mpi_nearKeys[i_sample] & i_bit) == 0) continue;
+
+            this->mti_keys[i_depth] = i_key;
+            this->mti_samples[i_depth] = i_sample;
+            this->mtr_lengths[i_depth] = r_length;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * \brief Reimplemented from VirtualKeyboardDictionaryFilter
+     */
+    bool acceptWord(int i_length)
+    {
+        // The last letter at the end of the path, a single letter is typed with a tap
+        return i_length >= 2 && this->mtr_lengths[i_length - 1] >= this->mr_minimumLength
+               && (this->mpi_nearKeys[VIRTUALKEYBOARD_GESTURE_SAMPLECOUNT - 1] & (Q_UINT64_C(1) << this->mti_keys[i_length - 1])) != 0;
+    }
+
+private:
+
+    /**
+     * Keys of the decoder, keys near each point of the path and lengths allowed for the templates
+     */
+    const QString &ms_keyCharacters;
+    const float *mpr_keyX;
+    const float *mpr_keyY;
+    const quint64 *mpi_nearKeys;
+    float mr_minimumLength;
+    float mr_maximumLength;
+
+    /**
+     * Key, point of the path and length of the template of the letter at each depth of the prefix accepted
+     */
+    int mti_keys[VIRTUALKEYBOARD_GESTURE_MAXIMUMLENGTH];
+    int mti_samples[VIRTUALKEYBOARD_GESTURE_MAXIMUMLENGTH];
+    float mtr_lengths[VIRTUALKEYBOARD_GESTURE_MAXIMUMLENGTH];
+};
+
+
+/**
+ * \brief Order of the candidates : highest score first
+ */
+struct VirtualKeyboardGestureCandidateOrder
+{
+    const float *pr_scores;
+
+    bool operator()(int i_first, int i_second) const
+    {
+        return this->pr_scores[i_first] > this->pr_scores[i_second];
+    }
+};
+
+
+
+VirtualKeyboardGestureDecoder::VirtualKeyboardGestureDecoder() :
+    mo_keyModel(VIRTUALKEYBOARD_GESTURE_SIGMA, VIRTUALKEYBOARD_GESTURE_MAXIMUMKEYCOUNT)
+{
+}
+
+
+void VirtualKeyboardGestureDecoder::setKeys(const QString &s_characters, const QVector<QRectF> &veco_rects)
+{
+    this->mo_keyModel.setKeys(s_characters, veco_rects);
+}
+
+
+int VirtualKeyboardGestureDecoder::keyCount() const
+{
+    return this->mo_keyModel.keyCount();
+}
+
+
+QStringList VirtualKeyboardGestureDecoder::decode(const QVector<QPointF> &veco_path, const VirtualKeyboardDictionary *po_dictionary, int i_count) const
+{
+    const QString &s_keyCharacters = this->mo_keyModel.keyCharacters();
+    const float *pr_keyX = this->mo_keyModel.keyX();
+    const float *pr_keyY = this->mo_keyModel.keyY();
+
+    if (po_dictionary == NULL || s_keyCharacters.isEmpty() || veco_path.size() < 2 || i_count <= 0) return QStringList();
+
+    // --- Path resampled, in standard deviations
+    QVector<float> vecr_x(veco_path.size());
+    QVector<float> vecr_y(veco_path.size());
+
+    for (int i_i = 0; i_i < veco_path.size(); ++i_i)
+    {
+        vecr_x[i_i] = this->mo_keyModel.toModelX(veco_path.at(i_i).x());
+        vecr_y[i_i] = this->mo_keyModel.toModelY(veco_path.at(i_i).y());
+    }
+
+    float tr_pathX[VIRTUALKEYBOARD_GESTURE_SAMPLECOUNT];
+    float tr_pathY[VIRTUALKEYBOARD_GESTURE_SAMPLECOUNT];
+    VirtualKeyboardGestureDecoder::resample(vecr_x.constData(), vecr_y.constData(), veco_path.size(), VIRTUALKEYBOARD_GESTURE_SAMPLECOUNT, 1, tr_pathX, tr_pathY);
+
+    // --- Keys near each point of the path
+    const float r_radius = float(VIRTUALKEYBOARD_GESTURE_KEYRADIUS / VIRTUALKEYBOARD_GESTURE_SIGMA);
+    quint64 ti_nearKeys[VIRTUALKEYBOARD_GESTURE_SAMPLECOUNT];
+
+    for (int i_sample = 0; i_sample < VIRTUALKEYBOARD_GESTURE_SAMPLECOUNT; ++i_sample)
+    {
+        ti_nearKeys[i_sample] = 0;
+
+        for (int i_key = 0; i_key < s_keyCharacters.size(); ++i_key)
+        {
+            const float r_dx = tr_pathX[i_sample] - pr_keyX[i_key];
+            const float r_dy = tr_pathY[i_sample] - pr_keyY[i_key];
+
+            if (r_dx * r_dx + r_dy * r_dy <= r_radius * r_radius) ti_nearKeys[i_sample] |= Q_UINT64_C(1) << i_key;
+        }
+    }
+
+    if (ti_nearKeys[0] == 0 || ti_nearKeys[VIRTUALKEYBOARD_GESTURE_SAMPLECOUNT - 1] == 0) return QStringList();
+
+    // --- Length of the path, and lengths allowed for the templates
+    float r_pathLength = 0;
+    for (int i_sample = 1; i_sample < VIRTUALKEYBOARD_GESTURE_SAMPLECOUNT; ++i_sample)
+    {
+        const float r_dx = tr_pathX[i_sample] - tr_pathX[i_sample - 1];
+        const float r_dy = tr_pathY[i_sample] - tr_pathY[i_sample - 1];
+        r_pathLength += std::sqrt(r_dx * r_dx + r_dy * r_dy);
+    }
+
+    const float r_slack = float(VIRTUALKEYBOARD_GESTURE_LENGTHSLACK / VIRTUALKEYBOARD_GESTURE_SIGMA);
+    const float r_minimumLength = r_pathLength * float(1 - VIRTUALKEYBOARD_GESTURE_LENGTHTOLERANCE) - r_slack;
+    const float r_maximumLength = r_pathLength * float(1 + VIRTUALKEYBOARD_GESTURE_LENGTHTOLERANCE) + r_slack;
+
+    // --- Candidates : the words whose letters follow the path
+    VirtualKeyboardGestureFilter o_filter(s_keyCharacters, pr_keyX, pr_keyY, ti_nearKeys, r_minimumLength, r_maximumLength);
+    QVector<int> veci_frequencies;
+    const QStringList lists_candidates = po_dictionary->matches(&o_filter, VIRTUALKEYBOARD_GESTURE_MAXIMUMLENGTH,
+                                                                VIRTUALKEYBOARD_GESTURE_MAXIMUMCANDIDATES, &veci_frequencies);
+    if (lists_candidates.isEmpty()) return QStringList();
+
+    // --- Templates of the candidates by point, padded to a multiple of 4 with the first candidate
+    const int i_candidateCount = lists_candidates.size();
+    const int i_stride = (i_candidateCount + 3) & ~3;
+
+    QVector<float> vecr_templateX(VIRTUALKEYBOARD_GESTURE_SAMPLECOUNT * i_stride);
+    QVector<float> vecr_templateY(VIRTUALKEYBOARD_GESTURE_SAMPLECOUNT * i_stride);
+    QVector<float> vecr_priors(i_stride);
+    QVector<float> vecr_scores(i_stride);
+
+    float tr_keyX[VIRTUALKEYBOARD_GESTURE_MAXIMUMLENGTH];
+    float tr_keyY[VIRTUALKEYBOARD_GESTURE_MAXIMUMLENGTH];
+
+    for (int i_candidate = 0; i_candidate < i_stride; ++i_candidate)
+    {
+        const int i_source = i_candidate < i_candidateCount ? i_candidate : 0;
+        const QString &s_candidate = lists_candidates.at(i_source);
+
+        vecr_priors[i_candidate] = float(VIRTUALKEYBOARD_GESTURE_PRIORWEIGHT * veci_frequencies.at(i_source));
+
+        // Centres of the keys of the letters, a key once for a double letter : every letter has been matched to a key by the filter
+        int i_pointCount = 0;
+        int i_previousKey = -1;
+
+        for (int i_i = 0; i_i < s_candidate.size(); ++i_i)
+        {
+            const int i_key = s_keyCharacters.indexOf(s_candidate.at(i_i).toLower());
+            if (i_key == i_previousKey) continue;
+
+            tr_keyX[i_pointCount] = pr_keyX[i_key];
+            tr_keyY[i_pointCount] = pr_keyY[i_key];
+            ++i_pointCount;
+            i_previousKey = i_key;
+        }
+
+        VirtualKeyboardGestureDecoder::resample(tr_keyX, tr_keyY, i_pointCount, VIRTUALKEYBOARD_GESTURE_SAMPLECOUNT, i_stride,
+                                                vecr_templateX.data() + i_candidate, vecr_templateY.data() + i_candidate);
+    }
+
+    // Log-likelihood of the points : -(dx² + dy²) / 2 each, their mean counted VIRTUALKEYBOARD_GESTURE_EFFECTIVEPOINTCOUNT times
+    const float r_weight = float(0.5 * VIRTUALKEYBOARD_GESTURE_EFFECTIVEPOINTCOUNT / VIRTUALKEYBOARD_GESTURE_SAMPLECOUNT);
+    VirtualKeyboardKeyModel::scoreDistances(tr_pathX, tr_pathY, VIRTUALKEYBOARD_GESTURE_SAMPLECOUNT, vecr_templateX.constData(),
+                                            vecr_templateY.constData(), i_stride, r_weight, vecr_priors.constData(), vecr_scores.data());
+
+    // --- Best candidates first
+    QVector<int> veci_order(i_candidateCount);
+    for (int i_i = 0; i_i < i_candidateCount; ++i_i) veci_order[i_i] = i_i;
+
+    const int i_resultCount = qMin(i_count, i_candidateCount);
+    const VirtualKeyboardGestureCandidateOrder o_order = { vecr_scores.constData() };
+    std::partial_sort(veci_order.begin(), veci_order.begin() + i_resultCount, veci_order.end(), o_order);
+
+    QStringList lists_words;
+    for (int i_i = 0; i_i < i_resultCount; ++i_i) lists_words.append(lists_candidates.at(veci_order.at(i_i)));
+
+    return lists_words;
+}
+
+
+void VirtualKeyboardGestureDecoder::resample(const float *pr_x, const float *pr_y, int i_count, int i_sampleCount, int i_stride, float *pr_sampleX, float *pr_sampleY)
+{
+    // --- Distance along the polyline of each point
+    QVarLengthArray<float, 256> vecr_lengths(i_count);
+    vecr_lengths[0] = 0;
+
+    int i_segment = 0;
+#ifdef VIRTUALKEYBOARD_HAS_SSE
+    // Lengths of four segments at a time, the point i + 1 ending the segment i
+    for (; i_segment + 4 < i_count; i_segment += 4)
+    {
+        const __m128 o_dx = _mm_sub_ps(_mm_loadu_ps(pr_x + i_segment + 1), _mm_loadu_ps(pr_x + i_segment));
+        const __m128 o_dy = _mm_sub_ps(_mm_loadu_ps(pr_y + i_segment + 1), _mm_loadu_ps(pr_y + i_segment));
+        _mm_storeu_ps(vecr_lengths.data() + i_segment + 1, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(o_dx, o_dx), _mm_mul_ps(o_dy, o_dy))));
+    }
+#endif
+    for (; i_segment + 1 < i_count; ++i_segment)
+    {
+        const float r_dx = pr_x[i_segment + 1] - pr_x[i_segment];
+        const float r_dy = pr_y[i_segment + 1] - pr_y[i_segment];
+        vecr_lengths[i_segment + 1] = std::sqrt(r_dx * r_dx + r_dy * r_dy);
+    }
+
+    for (int i_i = 1; i_i < i_count; ++i_i) vecr_lengths[i_i] += vecr_lengths.at(i_i - 1);
+
+    const float r_length = vecr_lengths.at(i_count - 1);
+
+    // --- A single point (or the same point repeated) : every sample on it
+    if (r_length <= 0)
+    {
+        for (int i_i = 0; i_i < i_sampleCount; ++i_i)
+        {
+            pr_sampleX[i_i * i_stride] = pr_x[0];
+            pr_sampleY[i_i * i_stride] = pr_y[0];
+        }
+        return;
+    }
+
+    // --- Samples equally spaced : the segment of each sample is after the segment of the previous one
+    i_segment = 0;
+    for (int i_i = 0; i_i < i_sampleCount; ++i_i)
+    {
+        const float r_distance = r_length * float(i_i) / float(i_sampleCount - 1);
+
+        while (i_segment + 2 < i_count && vecr_lengths.at(i_segment + 1) < r_distance) ++i_segment;
+
+        const float r_segmentLength = vecr_lengths.at(i_segment + 1) - vecr_lengths.at(i_segment);
+        const float r_t = r_segmentLength > 0 ? qBound(0.0f, (r_distance - vecr_lengths.at(i_segment)) / r_segmentLength, 1.0f) : 0.0f;
+
+        pr_sampleX[i_i * i_stride] = pr_x[i_segment] + r_t * (pr_x[i_segment + 1] - pr_x[i_segment]);
+        pr_sampleY[i_i * i_stride] = pr_y[i_segment] + r_t * (pr_y[i_segment + 1] - pr_y[i_segment]);
+    }
+}
+
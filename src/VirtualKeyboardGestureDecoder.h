@@ -0,0 +1,142 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+
+#ifndef VIRTUALKEYBOARDGESTUREDECODER_H
+#define VIRTUALKEYBOARDGESTUREDECODER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QPointF>
+#include <QRectF>
+
+#include "VirtualKeyboardDictionary.h"
+#include "VirtualKeyboardKeyModel.h"
+
+
+// Number of points the paths and the templates of the words are resampled to (multiple of 4)
+#define VIRTUALKEYBOARD_GESTURE_SAMPLECOUNT         32
+
+// Standard deviation of the points of a path around the template of the word traced, in key widths (horizontally) and key heights (vertically)
+#define VIRTUALKEYBOARD_GESTURE_SIGMA               0.3
+
+// Number of independent points a path is worth : its points are correlated, the mean of their log-likelihoods is counted this number of times
+#define VIRTUALKEYBOARD_GESTURE_EFFECTIVEPOINTCOUNT 8
+
+// Distance from a path within which a key may have been traced over, in key widths (horizontally) and key heights (vertically)
+#define VIRTUALKEYBOARD_GESTURE_KEYRADIUS           0.8
+
+// Difference allowed between the length of a path and the length of the template of a word : relative, plus a slack in key widths
+#define VIRTUALKEYBOARD_GESTURE_LENGTHTOLERANCE     0.2
+#define VIRTUALKEYBOARD_GESTURE_LENGTHSLACK         0.5
+
+// Weight of the frequency of the words in their score, in natural log units per step of the quantized frequency
+#define VIRTUALKEYBOARD_GESTURE_PRIORWEIGHT         0.1
+
+// Maximum length of the words decoded
+#define VIRTUALKEYBOARD_GESTURE_MAXIMUMLENGTH       24
+
+// Maximum number of words scored for a path : the most frequent of the words following the path
+#define VIRTUALKEYBOARD_GESTURE_MAXIMUMCANDIDATES   4096
+
+// Maximum number of keys of a decoder (one bit per key in the masks of the keys near the path)
+#define VIRTUALKEYBOARD_GESTURE_MAXIMUMKEYCOUNT     64
+
+
+/**
+ * \brief Decoder of the gesture typing : the word traced by a continuous path over the letters
+ *
+ * The path is resampled to VIRTUALKEYBOARD_GESTURE_SAMPLECOUNT points equally spaced along its length. The template of a word is the
+ * polyline through the centres of the keys of its letters, resampled the same way. The score of a word is the log-likelihood of
+ * the points of the path around the points of its template (a Gaussian of VIRTUALKEYBOARD_GESTURE_SIGMA key sizes, averaged over
+ * the points and counted VIRTUALKEYBOARD_GESTURE_EFFECTIVEPOINTCOUNT times), plus its frequency in the dictionary.
+ *
+ * Only a few words are scored : the walk of the dictionary follows the prefixes whose letters are on keys near the path
+ * (VIRTUALKEYBOARD_GESTURE_KEYRADIUS), in the order of the path, the first letter near its start and the last letter near its end,
+ * and whose template is not longer than the path (VIRTUALKEYBOARD_GESTURE_LENGTHTOLERANCE). The cost of a decoding is bounded by
+ * the number of these prefixes, not by the size of the dictionary.
+ *
+ * The keys are modeled by VirtualKeyboardKeyModel. The resampling and the scoring work on coordinates laid out by point (structure
+ * of arrays), the templates of four words are scored at once by VirtualKeyboardKeyModel::scoreDistances() with SSE on x86, one at
+ * a time elsewhere.
+ *
+ * This class only depends on QtCore, it can be used without a display.
+ */
+class VirtualKeyboardGestureDecoder
+{
+    // Private Members
+private:
+
+    /**
+     * Keys of the decoder, VIRTUALKEYBOARD_GESTURE_SIGMA key sizes of standard deviation, VIRTUALKEYBOARD_GESTURE_MAXIMUMKEYCOUNT keys at most
+     */
+    VirtualKeyboardKeyModel mo_keyModel;
+
+
+    // Public Functions
+public:
+
+    /**
+     * \brief Constructor of a decoder without keys
+     */
+    VirtualKeyboardGestureDecoder();
+
+    /**
+     * \brief Set the keys of the decoder, the standard deviation is taken from their median size
+     *
+     * Only the first VIRTUALKEYBOARD_GESTURE_MAXIMUMKEYCOUNT keys are used.
+     *
+     * \param[in] s_characters : Character of each key (compared in lowercase)
+     * \param[in] veco_rects : Rectangle of each key, in the coordinates of the paths
+     */
+    void setKeys(const QString &s_characters, const QVector<QRectF> &veco_rects);
+
+    /**
+     * \brief Get the number of keys of the decoder
+     */
+    int keyCount() const;
+
+    /**
+     * \brief Decode a path
+     * \param[in] veco_path : Points of the path, in the order they have been traced
+     * \param[in] po_dictionary : Dictionary of the words
+     * \param[in] i_count : Maximum number of words
+     * \return Words the path may trace (as written in the dictionary), best first, empty if no word matches the path
+     */
+    QStringList decode(const QVector<QPointF> &veco_path, const VirtualKeyboardDictionary *po_dictionary, int i_count) const;
+
+    /**
+     * \brief Resample a polyline to points equally spaced along its length (the first and the last points are kept)
+     * \param[in] pr_x, pr_y : Points of the polyline, i_count each
+     * \param[in] i_count : Number of points of the polyline, at least 1
+     * \param[in] i_sampleCount : Number of points to resample to, at least 2
+     * \param[in] i_stride : Distance between two consecutive points in the output arrays
+     * \param[out] pr_sampleX, pr_sampleY : Points resampled, the point i at i * i_stride
+     */
+    static void resample(const float *pr_x, const float *pr_y, int i_count, int i_sampleCount, int i_stride, float *pr_sampleX, float *pr_sampleY);
+};
+
+#endif // VIRTUALKEYBOARDGESTUREDECODER_H
@@ -0,0 +1,521 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+
+#include "VirtualKeyboardInputTarget.h"
+
+#include <QPointer>
+#include <QLineEdit>
+#include <QTextEdit>
+#include <QPlainTextEdit>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QComboBox>
+
+
+/**
+ * \brief Delete characters before the cursor of a line edit then insert a text : the characters are selected and replaced by the text
+ *
+ * The line edits with a validator or an input mask are edited key by key
+ */
+static void applyLineEdit(QLineEdit *w_lineEdit, int i_backspaceCount, const QString &s_text)
+{
+    // Validator or input mask : one key at a time, as typed (a single insert is rejected as a whole for one invalid character)
+    if (w_lineEdit->validator() != NULL || !w_lineEdit->inputMask().isEmpty())
+    {
+        for (int i_i = 0; i_i < i_backspaceCount; ++i_i)
+            w_lineEdit->backspace();
+        for (int i_i = 0; i_i < s_text.size(); ++i_i)
+        {
+            // A surrogate pair is one key
+            const int i_length = s_text.at(i_i).isHighSurrogate() && i_i + 1 < s_text.size() ? 2 : 1;
+            w_lineEdit->insert(s_text.mid(i_i, i_length));
+            i_i += i_length - 1;
+        }
+        return;
+    }
+
+    // The first backspace deletes the selection, if there is one
+    if (i_backspaceCount > 0 && w_lineEdit->hasSelectedText())
+    {
+        w_lineEdit->del();
+        --i_backspaceCount;
+    }
+    if (i_backspaceCount > 0)
+    {
+        const int i_position = w_lineEdit->cursorPosition();
+        w_lineEdit->setSelection(i_position, -qMin(i_backspaceCount, i_position));
+    }
+
+    // Replace the selection (only remove it if the text is empty)
+    w_lineEdit->insert(s_text);
+}
+
+
+/**
+ * \brief Insert a text at the cursor of a line edit, replacing the selection, then move the cursor back inside the text
+ */
+static void insertLineEditSnippet(QLineEdit *w_lineEdit, const QString &s_text, int i_cursorPosition)
+{
+    const int i_start = w_lineEdit->hasSelectedText() ? w_lineEdit->selectionStart() : w_lineEdit->cursorPosition();
+
+    // One undo step of the line edit
+    w_lineEdit->insert(s_text);
+
+    // Not if the validator or the input mask changed the text inserted
+    if (i_cursorPosition >= 0 && i_cursorPosition < s_text.size() && w_lineEdit->cursorPosition() == i_start + s_text.size())
+        w_lineEdit->setCursorPosition(i_start + i_cursorPosition);
+}
+
+
+/**
+ * \brief Get the text before the cursor of a line edit, nothing if the line edit hides its text
+ */
+static QString lineEditTextBeforeCursor(const QLineEdit *w_lineEdit, int i_maximumLength)
+{
+    if (w_lineEdit->echoMode() != QLineEdit::Normal) return QString();
+
+    const int i_position = w_lineEdit->cursorPosition();
+    return w_lineEdit->text().mid(qMax(0, i_position - i_maximumLength), qMin(i_position, i_maximumLength));
+}
+
+
+/**
+ * \brief Backend of a QLineEdit
+ */
+class LineEditInputTarget : public VirtualKeyboardInputTarget
+{
+private:
+
+    /**
+     * Input widget
+     */
+    QPointer<QLineEdit> mpw_lineEdit;
+
+public:
+
+    explicit LineEditInputTarget(QLineEdit *w_lineEdit) : mpw_lineEdit(w_lineEdit) {}
+
+    int type() const                            { return VIRTUALKEYBOARD_INPUT_LINEEDIT; }
+    QWidget *widget() const                     { return this->mpw_lineEdit; }
+    QLineEdit *lineEdit() const                 { return this->mpw_lineEdit; }
+    void insertText(const QString &s_text)      { if (this->mpw_lineEdit) this->mpw_lineEdit->insert(s_text); }
+    void deletePreviousChar()                   { if (this->mpw_lineEdit) this->mpw_lineEdit->backspace(); }
+    void applyEdit(int i_backspaceCount, const QString &s_text) { if (this->mpw_lineEdit) applyLineEdit(this->mpw_lineEdit, i_backspaceCount, s_text); }
+    void insertSnippet(const QString &s_text, int i_cursorPosition) { if (this->mpw_lineEdit) insertLineEditSnippet(this->mpw_lineEdit, s_text, i_cursorPosition); }
+    QString textBeforeCursor(int i_maximumLength) const { return this->mpw_lineEdit ? lineEditTextBeforeCursor(this->mpw_lineEdit, i_maximumLength) : QString(); }
+    void copy()                                 { if (this->mpw_lineEdit) this->mpw_lineEdit->copy(); }
+    void cut()                                  { if (this->mpw_lineEdit) this->mpw_lineEdit->cut(); }
+    void paste()                                { if (this->mpw_lineEdit) this->mpw_lineEdit->paste(); }
+
+    QObject *changeNotifier(const char **pc_signal) const
+    {
+        *pc_signal = SIGNAL(textChanged(QString));
+        return this->mpw_lineEdit;
+    }
+
+    QObject *cursorNotifier(const char **pc_signal) const
+    {
+        *pc_signal = SIGNAL(cursorPositionChanged(int,int));
+        return this->mpw_lineEdit;
+    }
+};
+
+
+/**
+ * \brief Backend of an editable QComboBox : its line edit, resolved on each call (it is replaced when the combo box is made editable again)
+ */
+class ComboBoxInputTarget : public VirtualKeyboardInputTarget
+{
+private:
+
+    /**
+     * Input widget
+     */
+    QPointer<QComboBox> mpw_comboBox;
+
+public:
+
+    explicit ComboBoxInputTarget(QComboBox *w_comboBox) : mpw_comboBox(w_comboBox) {}
+
+    // NULL if the combo box has been destroyed or is not editable anymore
+    QLineEdit *lineEdit() const                 { return this->mpw_comboBox ? this->mpw_comboBox->lineEdit() : NULL; }
+
+    int type() const                            { return VIRTUALKEYBOARD_INPUT_COMBOBOX; }
+    QWidget *widget() const                     { return this->mpw_comboBox; }
+    void insertText(const QString &s_text)      { if (QLineEdit *w_lineEdit = this->lineEdit()) w_lineEdit->insert(s_text); }
+    void deletePreviousChar()                   { if (QLineEdit *w_lineEdit = this->lineEdit()) w_lineEdit->backspace(); }
+    void applyEdit(int i_backspaceCount, const QString &s_text) { if (QLineEdit *w_lineEdit = this->lineEdit()) applyLineEdit(w_lineEdit, i_backspaceCount, s_text); }
+    void insertSnippet(const QString &s_text, int i_cursorPosition) { if (QLineEdit *w_lineEdit = this->lineEdit()) insertLineEditSnippet(w_lineEdit, s_text, i_cursorPosition); }
+    QString textBeforeCursor(int i_maximumLength) const { QLineEdit *w_lineEdit = this->lineEdit(); return w_lineEdit ? lineEditTextBeforeCursor(w_lineEdit, i_maximumLength) : QString(); }
+    void copy()                                 { if (QLineEdit *w_lineEdit = this->lineEdit()) w_lineEdit->copy(); }
+    void cut()                                  { if (QLineEdit *w_lineEdit = this->lineEdit()) w_lineEdit->cut(); }
+    void paste()                                { if (QLineEdit *w_lineEdit = this->lineEdit()) w_lineEdit->paste(); }
+
+    QObject *changeNotifier(const char **pc_signal) const
+    {
+        *pc_signal = SIGNAL(textChanged(QString));
+        return this->lineEdit();
+    }
+
+    QObject *cursorNotifier(const char **pc_signal) const
+    {
+        *pc_signal = SIGNAL(cursorPositionChanged(int,int));
+        return this->lineEdit();
+    }
+};
+
+
+/**
+ * \brief Backend of a QTextEdit or a QPlainTextEdit (same editing API), edited through its QTextCursor
+ */
+template <class TextEdit, int i_type>
+class TextCursorInputTarget : public VirtualKeyboardInputTarget
+{
+private:
+
+    /**
+     * Input widget
+     */
+    QPointer<TextEdit> mpw_textEdit;
+
+    /**
+     * Size of the documents edited in large document mode (0 => always, negative => never)
+     */
+    int mi_largeDocumentThreshold;
+
+    /**
+     * Cursor kept between the keys in large document mode, moved by the document like the cursor of the widget
+     */
+    QTextCursor mo_cursor;
+
+    /**
+     * Undo group of the next edit : -1 => none (edit through the widget), 0 => starts a group, 1 => joined to the previous undo step
+     */
+    int mi_nextEditGroup;
+
+    /**
+     * Undo steps available after the last edit of the target, -1 if there has been none
+     */
+    int mi_undoStepsAfterEdit;
+
+    /**
+     * Number of undo steps of the document above which its undo stack is cleared, 0 => never cleared
+     */
+    int mi_undoClearThreshold;
+
+    /**
+     * \brief Check if the document of the widget is edited in large document mode
+     */
+    bool isLargeDocument() const
+    {
+        return this->mi_largeDocumentThreshold >= 0 && this->mpw_textEdit->document()->characterCount() >= this->mi_largeDocumentThreshold;
+    }
+
+    /**
+     * \brief Get the cursor kept by the target, taken again from the widget if its cursor has been moved (or its document replaced)
+     */
+    QTextCursor &cursor()
+    {
+        // Copy of the cursor of the widget : shared, not detached
+        const QTextCursor o_widgetCursor = this->mpw_textEdit->textCursor();
+
+        if (this->mo_cursor.document() != o_widgetCursor.document() || this->mo_cursor.position() != o_widgetCursor.position()
+                || this->mo_cursor.anchor() != o_widgetCursor.anchor())
+            this->mo_cursor = o_widgetCursor;
+
+        return this->mo_cursor;
+    }
+
+    /**
+     * \brief Delete characters before the cursor then insert a text, in one edit block (joined to the previous one if requested)
+     *
+     * The cursor is then placed at i_cursorPosition in the text inserted (negative => after the text)
+     */
+    void edit(int i_backspaceCount, const QString &s_text, int i_cursorPosition = -1)
+    {
+        QTextDocument *po_document = this->mpw_textEdit->document();
+        const bool b_isLargeDocument = this->isLargeDocument();
+
+        QTextCursor o_widgetCursor = b_isLargeDocument ? QTextCursor() : this->mpw_textEdit->textCursor();
+        QTextCursor &o_cursor = b_isLargeDocument ? this->cursor() : o_widgetCursor;
+
+        // One edit block : a single undo step, and the document is laid out once
+        if (this->mi_nextEditGroup > 0 && po_document->availableUndoSteps() == this->mi_undoStepsAfterEdit)
+            o_cursor.joinPreviousEditBlock();
+        else
+            o_cursor.beginEditBlock();
+        for (int i_i = 0; i_i < i_backspaceCount; ++i_i)
+            o_cursor.deletePreviousChar();
+        if (!s_text.isEmpty())
+            o_cursor.insertText(s_text);
+        o_cursor.endEditBlock();
+
+        const bool b_isCursorMoved = i_cursorPosition >= 0 && i_cursorPosition < s_text.size();
+        if (b_isCursorMoved)
+            o_cursor.setPosition(o_cursor.position() - s_text.size() + i_cursorPosition);
+
+        // The cursor of the widget follows the document, not the moves of the cursor of the target
+        if (b_isLargeDocument && !b_isCursorMoved)
+            this->mpw_textEdit->ensureCursorVisible();
+        else
+            this->mpw_textEdit->setTextCursor(o_cursor);
+
+        this->editDone();
+    }
+
+    /**
+     * \brief Apply the undo clear threshold and remember the undo state after an edit of the target
+     */
+    void editDone()
+    {
+        QTextDocument *po_document = this->mpw_textEdit->document();
+
+        if (this->mi_undoClearThreshold > 0 && po_document->availableUndoSteps() > this->mi_undoClearThreshold)
+            po_document->clearUndoRedoStacks(QTextDocument::UndoStack);
+
+        this->mi_nextEditGroup = -1;
+        this->mi_undoStepsAfterEdit = po_document->availableUndoSteps();
+    }
+
+public:
+
+    explicit TextCursorInputTarget(TextEdit *w_textEdit) : mpw_textEdit(w_textEdit), mi_largeDocumentThreshold(VIRTUALKEYBOARD_LARGEDOCUMENT_THRESHOLD),
+                                                         mi_nextEditGroup(-1), mi_undoStepsAfterEdit(-1), mi_undoClearThreshold(0) {}
+
+    int type() const                            { return i_type; }
+    QWidget *widget() const                     { return this->mpw_textEdit; }
+
+    void insertText(const QString &s_text)
+    {
+        if (!this->mpw_textEdit) return;
+
+        // Through the widget when there is nothing particular to do : it handles the formats of the text edits
+        if (this->mi_nextEditGroup >= 0 || this->isLargeDocument())
+            this->edit(0, s_text);
+        else
+        {
+            this->mpw_textEdit->insertPlainText(s_text);
+            this->editDone();
+        }
+    }
+
+    void deletePreviousChar()
+    {
+        if (!this->mpw_textEdit) return;
+
+        if (this->mi_nextEditGroup >= 0 || this->isLargeDocument())
+            this->edit(1, QString());
+        else
+        {
+            this->mpw_textEdit->textCursor().deletePreviousChar();
+            this->editDone();
+        }
+    }
+
+    void applyEdit(int i_backspaceCount, const QString &s_text) { if (this->mpw_textEdit) this->edit(i_backspaceCount, s_text); }
+    void insertSnippet(const QString &s_text, int i_cursorPosition) { if (this->mpw_textEdit) this->edit(0, s_text, i_cursorPosition); }
+
+    QString textBeforeCursor(int i_maximumLength) const
+    {
+        if (!this->mpw_textEdit) return QString();
+
+        // Text of the paragraph of the cursor only : not the whole document
+        const QTextCursor o_cursor = this->mpw_textEdit->textCursor();
+        const int i_position = o_cursor.positionInBlock();
+        return o_cursor.block().text().mid(qMax(0, i_position - i_maximumLength), qMin(i_position, i_maximumLength));
+    }
+
+    void copy()                                 { if (this->mpw_textEdit) this->mpw_textEdit->copy(); }
+    void cut()                                  { if (this->mpw_textEdit) this->mpw_textEdit->cut(); }
+    void paste()                                { if (this->mpw_textEdit) this->mpw_textEdit->paste(); }
+
+    QObject *changeNotifier(const char **pc_signal) const
+    {
+        *pc_signal = SIGNAL(contentsChange(int,int,int));
+        return this->mpw_textEdit ? this->mpw_textEdit->document() : NULL;
+    }
+
+    QObject *cursorNotifier(const char **pc_signal) const
+    {
+        *pc_signal = SIGNAL(cursorPositionChanged());
+        return this->mpw_textEdit;
+    }
+
+    void setLargeDocumentThreshold(int i_characterCount) { this->mi_largeDocumentThreshold = i_characterCount; }
+    void groupNextEdit(bool b_isJoinedToPrevious) { this->mi_nextEditGroup = b_isJoinedToPrevious ? 1 : 0; }
+    void setUndoClearThreshold(int i_stepCount) { this->mi_undoClearThreshold = qMax(0, i_stepCount); }
+};
+
+
+
+VirtualKeyboardInputTarget::VirtualKeyboardInputTarget()
+{
+}
+
+
+VirtualKeyboardInputTarget::~VirtualKeyboardInputTarget()
+{
+}
+
+
+VirtualKeyboardInputTarget *VirtualKeyboardInputTarget::create(QWidget *w_widget)
+{
+    if (w_widget == NULL) return NULL;
+
+    return VirtualKeyboardInputTarget::create(w_widget, VirtualKeyboardInputTarget::widgetType(w_widget->metaObject()));
+}
+
+
+VirtualKeyboardInputTarget *VirtualKeyboardInputTarget::create(QWidget *w_widget, int i_type)
+{
+    switch (i_type)
+    {
+    case VIRTUALKEYBOARD_INPUT_LINEEDIT:
+        return new LineEditInputTarget(static_cast<QLineEdit *>(w_widget));
+    case VIRTUALKEYBOARD_INPUT_TEXTEDIT:
+        return new TextCursorInputTarget<QTextEdit, VIRTUALKEYBOARD_INPUT_TEXTEDIT>(static_cast<QTextEdit *>(w_widget));
+    case VIRTUALKEYBOARD_INPUT_PLAINTEXTEDIT:
+        return new TextCursorInputTarget<QPlainTextEdit, VIRTUALKEYBOARD_INPUT_PLAINTEXTEDIT>(static_cast<QPlainTextEdit *>(w_widget));
+    case VIRTUALKEYBOARD_INPUT_COMBOBOX:
+        // Writing in a combobox is in fact writing in its lineEdit, only if it can be edited
+        if (static_cast<QComboBox *>(w_widget)->isEditable()) return new ComboBoxInputTarget(static_cast<QComboBox *>(w_widget));
+        return NULL;
+    default:
+        return NULL;
+    }
+}
+
+
+int VirtualKeyboardInputTarget::widgetType(const QMetaObject *po_metaObject)
+{
+    // Walk up the class hierarchy : the widgets derived from the supported classes are supported too
+    for (const QMetaObject *po_class = po_metaObject; po_class != NULL; po_class = po_class->superClass())
+    {
+        if (po_class == &QLineEdit::staticMetaObject)         return VIRTUALKEYBOARD_INPUT_LINEEDIT;
+        if (po_class == &QTextEdit::staticMetaObject)         return VIRTUALKEYBOARD_INPUT_TEXTEDIT;
+        if (po_class == &QPlainTextEdit::staticMetaObject)    return VIRTUALKEYBOARD_INPUT_PLAINTEXTEDIT;
+        if (po_class == &QComboBox::staticMetaObject)         return VIRTUALKEYBOARD_INPUT_COMBOBOX;
+    }
+    return VIRTUALKEYBOARD_INPUT_UNKNOWINPUTTYPE;
+}
+
+
+int VirtualKeyboardInputTarget::type() const
+{
+    return VIRTUALKEYBOARD_INPUT_UNKNOWINPUTTYPE;
+}
+
+
+QWidget *VirtualKeyboardInputTarget::widget() const
+{
+    return NULL;
+}
+
+
+void VirtualKeyboardInputTarget::insertText(const QString &s_text)
+{
+    Q_UNUSED(s_text)
+}
+
+
+void VirtualKeyboardInputTarget::deletePreviousChar()
+{
+}
+
+
+void VirtualKeyboardInputTarget::applyEdit(int i_backspaceCount, const QString &s_text)
+{
+    Q_UNUSED(i_backspaceCount)
+    Q_UNUSED(s_text)
+}
+
+
+void VirtualKeyboardInputTarget::insertSnippet(const QString &s_text, int i_cursorPosition)
+{
+    Q_UNUSED(s_text)
+    Q_UNUSED(i_cursorPosition)
+}
+
+
+void VirtualKeyboardInputTarget::copy()
+{
+}
+
+
+void VirtualKeyboardInputTarget::cut()
+{
+}
+
+
+void VirtualKeyboardInputTarget::paste()
+{
+}
+
+
+QString VirtualKeyboardInputTarget::textBeforeCursor(int i_maximumLength) const
+{
+    Q_UNUSED(i_maximumLength)
+    return QString();
+}
+
+
+QLineEdit *VirtualKeyboardInputTarget::lineEdit() const
+{
+    return NULL;
+}
+
+
+QObject *VirtualKeyboardInputTarget::changeNotifier(const char **pc_signal) const
+{
+    *pc_signal = NULL;
+    return NULL;
+}
+
+
+QObject *VirtualKeyboardInputTarget::cursorNotifier(const char **pc_signal) const
+{
+    *pc_signal = NULL;
+    return NULL;
+}
+
+
+void VirtualKeyboardInputTarget::setLargeDocumentThreshold(int i_characterCount)
+{
+    Q_UNUSED(i_characterCount)
+}
+
+
+void VirtualKeyboardInputTarget::groupNextEdit(bool b_isJoinedToPrevious)
+{
+    Q_UNUSED(b_isJoinedToPrevious)
+}
+
+
+void VirtualKeyboardInputTarget::setUndoClearThreshold(int i_stepCount)
+{
+    Q_UNUSED(i_stepCount)
+}
@@ -0,0 +1,211 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+#ifndef VIRTUALKEYBOARDINPUTTARGET_H
+#define VIRTUALKEYBOARDINPUTTARGET_H
+
+#include <QString>
+#include <QWidget>
+#include <QLineEdit>
+
+
+// Types of input widget
+#define VIRTUALKEYBOARD_INPUT_LINEEDIT      0
+#define VIRTUALKEYBOARD_INPUT_TEXTEDIT      1
+#define VIRTUALKEYBOARD_INPUT_PLAINTEXTEDIT 2
+#define VIRTUALKEYBOARD_INPUT_COMBOBOX      3
+#define VIRTUALKEYBOARD_INPUT_UNKNOWINPUTTYPE -1
+
+// Default size of the documents edited in large document mode, in characters (0 => always, negative => never)
+#define VIRTUALKEYBOARD_LARGEDOCUMENT_THRESHOLD 1000000
+
+
+/**
+ * \brief Input widget written by the virtual keyboard
+ *
+ * The type of the widget is resolved once by create() (when the input widget changes), the keys are then sent through
+ * the virtual functions of a backend specialised for the widget : no type test and no qobject_cast on each key.
+ *
+ * The backends follow the lifetime of their widget (QPointer) : once the widget is destroyed they do nothing.
+ * This base class is the target used when there is no input widget, every function does nothing.
+ */
+class VirtualKeyboardInputTarget
+{
+    // Public Functions
+public:
+
+    /**
+     * \brief Constructor of a target without input widget
+     */
+    VirtualKeyboardInputTarget();
+
+    /**
+     * \brief Destructor
+     */
+    virtual ~VirtualKeyboardInputTarget();
+
+    /**
+     * \brief Create the backend of an input widget
+     * \param[in] w_widget : Input widget, supported types are QLineEdit, QTextEdit, QPlainTextEdit and editable QComboBox
+     * \return Backend to delete by the caller, NULL if the widget is not supported
+     */
+    static VirtualKeyboardInputTarget *create(QWidget *w_widget);
+
+    /**
+     * \brief Create the backend of an input widget whose type is already known
+     * \param[in] w_widget : Input widget
+     * \param[in] i_type : Type of the widget class, as returned by widgetType()
+     * \return Backend to delete by the caller, NULL if the widget is not supported
+     */
+    static VirtualKeyboardInputTarget *create(QWidget *w_widget, int i_type);
+
+    /**
+     * \brief Get the type of input widget of a widget class
+     * \param[in] po_metaObject : Meta-object of the widget class
+     * \return VIRTUALKEYBOARD_INPUT_*, VIRTUALKEYBOARD_INPUT_UNKNOWINPUTTYPE if the class is not supported
+     *      (an editable QComboBox is still checked by create())
+     */
+    static int widgetType(const QMetaObject *po_metaObject);
+
+    /**
+     * \brief Get the type of the input widget
+     * \return VIRTUALKEYBOARD_INPUT_*
+     */
+    virtual int type() const;
+
+    /**
+     * \brief Get the input widget
+     * \return Input widget, NULL if there is none or if it has been destroyed
+     */
+    virtual QWidget *widget() const;
+
+    /**
+     * \brief Insert a text at the cursor, replacing the selection
+     * \param[in] s_text : Text
+     */
+    virtual void insertText(const QString &s_text);
+
+    /**
+     * \brief Delete the selection, or the character before the cursor
+     */
+    virtual void deletePreviousChar();
+
+    /**
+     * \brief Delete characters before the cursor then insert a text, as a single edit (one undo step, one layout for the text edits)
+     *
+     * Same result as i_backspaceCount calls to deletePreviousChar() followed by insertText(s_text). The line edits with a validator or an
+     * input mask are edited key by key, each one validated as if it was typed.
+     *
+     * \param[in] i_backspaceCount : Number of characters deleted before the cursor (the selection counts for one)
+     * \param[in] s_text : Text inserted at the cursor
+     */
+    virtual void applyEdit(int i_backspaceCount, const QString &s_text);
+
+    /**
+     * \brief Insert a text at the cursor, replacing the selection, as a single edit, then place the cursor inside the text
+     * \param[in] s_text : Text
+     * \param[in] i_cursorPosition : Position of the cursor in s_text after the insertion, negative => after the text
+     */
+    virtual void insertSnippet(const QString &s_text, int i_cursorPosition);
+
+    /**
+     * \brief Copy the selection to the clipboard
+     */
+    virtual void copy();
+
+    /**
+     * \brief Cut the selection to the clipboard
+     */
+    virtual void cut();
+
+    /**
+     * \brief Paste the clipboard at the cursor
+     */
+    virtual void paste();
+
+    /**
+     * \brief Get the text before the cursor, in its line or paragraph (used by the word prediction)
+     * \param[in] i_maximumLength : Maximum number of characters returned, the closest to the cursor
+     * \return Text, empty for the line edits which do not display their text (passwords)
+     */
+    virtual QString textBeforeCursor(int i_maximumLength) const;
+
+    /**
+     * \brief Get the line edit written (QLineEdit, or line edit of an editable QComboBox)
+     * \return Line edit, NULL for the other widgets
+     */
+    virtual QLineEdit *lineEdit() const;
+
+    /**
+     * \brief Get the object notifying the modifications of the text, used to measure the latency
+     * \param[out] pc_signal : Signal emitted on each modification (SIGNAL() syntax)
+     * \return Object emitting the signal, NULL if there is none
+     */
+    virtual QObject *changeNotifier(const char **pc_signal) const;
+
+    /**
+     * \brief Get the object notifying the moves of the cursor, used to cancel the streaming paste
+     * \param[out] pc_signal : Signal emitted on each move of the cursor (SIGNAL() syntax)
+     * \return Object emitting the signal, NULL if there is none
+     */
+    virtual QObject *cursorNotifier(const char **pc_signal) const;
+
+    /**
+     * \brief Set the size from which a document is edited in large document mode (text edits only)
+     *
+     * In large document mode the keys are applied through a cursor kept by the target : no copy of the cursor of the widget, no
+     * intermediate document fragment and no setTextCursor() on each key. The change sent to the layout and to the syntax highlighter
+     * is limited to the characters typed, the widget only scrolls to keep its cursor visible.
+     *
+     * \param[in] i_characterCount : Number of characters of the document (0 => always, negative => never)
+     */
+    virtual void setLargeDocumentThreshold(int i_characterCount);
+
+    /**
+     * \brief Make the next edit a step of an undo group (text edits only) : the edits of a group are undone together
+     *
+     * Nothing is joined if the document has been edited by something else since the last edit of the target
+     *
+     * \param[in] b_isJoinedToPrevious : True to join the edit to the previous undo step, false to start a new group
+     */
+    virtual void groupNextEdit(bool b_isJoinedToPrevious);
+
+    /**
+     * \brief Set the number of undo steps above which the undo stack of the document of the widget is cleared (text edits only)
+     *
+     * QTextDocument can not drop its oldest undo steps : the edit of the target exceeding the threshold clears the whole undo stack.
+     *
+     * \param[in] i_stepCount : Number of undo steps, 0 => never cleared
+     */
+    virtual void setUndoClearThreshold(int i_stepCount);
+
+
+    // Private Functions
+private:
+
+    Q_DISABLE_COPY(VirtualKeyboardInputTarget)
+};
+
+#endif // VIRTUALKEYBOARDINPUTTARGET_H
@@ -0,0 +1,259 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+
+#include "VirtualKeyboardKeyFilter.h"
+
+#include <QValidator>
+#include <QHash>
+
+
+
+VirtualKeyboardKeyFilter::VirtualKeyboardKeyFilter(QObject *o_parent) :
+    QObject(o_parent),
+    mpo_keymap(NULL),
+    mi_layer(VIRTUALKEYBOARD_LAYER_LOWER),
+    mi_probedPosition(-1),
+    mi_probedSelectionLength(0),
+    mpo_probedValidator(NULL)
+{
+    this->mo_timerUpdate.setSingleShot(true);
+
+    connect(&this->mo_timerUpdate,  SIGNAL(timeout()),
+            this,                   SLOT(update()));
+}
+
+
+void VirtualKeyboardKeyFilter::setLineEdit(QLineEdit *w_lineEdit)
+{
+    if (this->mpw_lineEdit) disconnect(this->mpw_lineEdit, 0, this, 0);
+
+    this->mpw_lineEdit = w_lineEdit;
+    this->mi_probedPosition = -1;
+
+    if (w_lineEdit != NULL)
+    {
+        connect(w_lineEdit, SIGNAL(textChanged(QString)),
+                this,       SLOT(scheduleUpdate()));
+        connect(w_lineEdit, SIGNAL(cursorPositionChanged(int,int)),
+                this,       SLOT(scheduleUpdate()));
+        connect(w_lineEdit, SIGNAL(selectionChanged()),
+                this,       SLOT(scheduleUpdate()));
+    }
+
+    this->update();
+}
+
+
+void VirtualKeyboardKeyFilter::setKeymap(const VirtualKeyboardKeymap *po_keymap, int i_layer)
+{
+    this->mpo_keymap = po_keymap;
+    this->mi_layer = i_layer;
+    this->mi_probedPosition = -1;
+
+    this->update();
+}
+
+
+bool VirtualKeyboardKeyFilter::isFiltering() const
+{
+    return this->mpw_lineEdit && (this->mpo_probedValidator != NULL || !this->ms_maskClasses.isEmpty());
+}
+
+
+bool VirtualKeyboardKeyFilter::isNumeric() const
+{
+    if (!this->mpw_lineEdit) return false;
+
+    if (!this->ms_maskClasses.isEmpty())
+    {
+        bool b_hasDigits = false;
+
+        for (int i_i = 0; i_i < this->ms_maskClasses.size(); ++i_i)
+        {
+            const QChar c_class = this->ms_maskClasses.at(i_i);
+
+            if (c_class.isNull()) continue;
+            if (!QString("90Dd#").contains(c_class)) return false;
+            b_hasDigits = true;
+        }
+        return b_hasDigits;
+    }
+
+    return qobject_cast<const QIntValidator *>(this->mpo_probedValidator) != NULL
+        || qobject_cast<const QDoubleValidator *>(this->mpo_probedValidator) != NULL;
+}
+
+
+bool VirtualKeyboardKeyFilter::isKeyAccepted(int i_key) const
+{
+    // Update pending : the state is not known, the key is tried
+    if (this->mo_timerUpdate.isActive() || i_key < 0 || i_key >= this->mvecb_acceptedKeys.size()) return true;
+
+    return this->mvecb_acceptedKeys.at(i_key);
+}
+
+
+void VirtualKeyboardKeyFilter::parseInputMask()
+{
+    const QString s_inputMask = this->mpw_lineEdit->inputMask();
+
+    if (s_inputMask == this->ms_inputMask) return;
+
+    this->ms_inputMask = s_inputMask;
+    this->ms_maskClasses.clear();
+
+    // One entry per position of the displayed text, up to the ';' introducing the blank character
+    for (int i_i = 0; i_i < s_inputMask.size(); ++i_i)
+    {
+        const QChar c_mask = s_inputMask.at(i_i);
+
+        if (c_mask == '\\')
+        {
+            ++i_i;
+            this->ms_maskClasses += QChar();
+        }
+        else if (c_mask == ';')
+        {
+            break;
+        }
+        else if (c_mask == '>' || c_mask == '<' || c_mask == '!')
+        {
+            // Case modifiers, no position
+        }
+        else
+        {
+            this->ms_maskClasses += QString("AaNnXx90DdHhBb#").contains(c_mask) ? c_mask : QChar();
+        }
+    }
+}
+
+
+bool VirtualKeyboardKeyFilter::isMaskCharacterAccepted(QChar c_class, QChar c_character)
+{
+    switch (c_class.unicode())
+    {
+    case 'A': case 'a':     return c_character.isLetter();
+    case 'N': case 'n':     return c_character.isLetterOrNumber();
+    case 'X': case 'x':     return c_character.isPrint() && !c_character.isSpace();
+    case '9': case '0':     return c_character.isDigit();
+    case 'D': case 'd':     return c_character.isDigit() && c_character != '0';
+    case '#':               return c_character.isDigit() || c_character == '+' || c_character == '-';
+    case 'H': case 'h':     return c_character.isDigit() || QString("abcdefABCDEF").contains(c_character);
+    case 'B': case 'b':     return c_character == '0' || c_character == '1';
+    default:                return false;
+    }
+}
+
+
+bool VirtualKeyboardKeyFilter::isTextAccepted(const QString &s_keyText, int i_position, int i_selectionLength) const
+{
+    // --- Input mask : the character class of the next editable position (the validator is not probed)
+    if (!this->ms_maskClasses.isEmpty())
+    {
+        if (s_keyText.size() != 1) return false;
+
+        for (int i_i = i_position; i_i < this->ms_maskClasses.size(); ++i_i)
+        {
+            if (!this->ms_maskClasses.at(i_i).isNull()) return isMaskCharacterAccepted(this->ms_maskClasses.at(i_i), s_keyText.at(0));
+        }
+        return false;
+    }
+
+    // --- Validator : the text the key would produce
+    if (this->ms_probedText.size() - i_selectionLength + s_keyText.size() > this->mpw_lineEdit->maxLength()) return false;
+
+    QString s_text = this->ms_probedText;
+    s_text.replace(i_position, i_selectionLength, s_keyText);
+    int i_cursor = i_position + s_keyText.size();
+
+    return this->mpo_probedValidator->validate(s_text, i_cursor) != QValidator::Invalid;
+}
+
+
+void VirtualKeyboardKeyFilter::scheduleUpdate()
+{
+    if (!this->mo_timerUpdate.isActive()) this->mo_timerUpdate.start(0);
+}
+
+
+void VirtualKeyboardKeyFilter::update()
+{
+    this->mo_timerUpdate.stop();
+
+    QVector<bool> vecb_acceptedKeys;
+
+    if (this->mpw_lineEdit && this->mpo_keymap != NULL)
+    {
+        this->parseInputMask();
+
+        const QValidator *po_validator = this->mpw_lineEdit->validator();
+        const bool b_hasSelection = this->mpw_lineEdit->hasSelectedText();
+        const int i_position = b_hasSelection ? this->mpw_lineEdit->selectionStart() : this->mpw_lineEdit->cursorPosition();
+        const int i_selectionLength = b_hasSelection ? this->mpw_lineEdit->selectedText().size() : 0;
+        const QString s_text = this->ms_maskClasses.isEmpty() ? this->mpw_lineEdit->text() : this->mpw_lineEdit->displayText();
+
+        // Nothing changed since the last probe (e.g. cursorPositionChanged following textChanged)
+        if (i_position == this->mi_probedPosition && i_selectionLength == this->mi_probedSelectionLength
+                && po_validator == this->mpo_probedValidator && s_text == this->ms_probedText)
+            return;
+
+        this->ms_probedText = s_text;
+        this->mi_probedPosition = i_position;
+        this->mi_probedSelectionLength = i_selectionLength;
+        this->mpo_probedValidator = po_validator;
+
+        if (this->isFiltering())
+        {
+            // Each distinct key text is probed once
+            QHash<QString, bool> hashb_probes;
+            const int i_keyCount = this->mpo_keymap->keyCount();
+            vecb_acceptedKeys.resize(i_keyCount);
+
+            for (int i_key = 0; i_key < i_keyCount; ++i_key)
+            {
+                if (this->mpo_keymap->isKeyEmpty(this->mi_layer, i_key))
+                {
+                    vecb_acceptedKeys[i_key] = true;
+                    continue;
+                }
+
+                const QString s_keyText = this->mpo_keymap->keyText(this->mi_layer, i_key);
+                QHash<QString, bool>::const_iterator it_probe = hashb_probes.constFind(s_keyText);
+
+                if (it_probe == hashb_probes.constEnd())
+                    it_probe = hashb_probes.insert(s_keyText, this->isTextAccepted(s_keyText, i_position, i_selectionLength));
+
+                vecb_acceptedKeys[i_key] = it_probe.value();
+            }
+        }
+    }
+
+    if (vecb_acceptedKeys != this->mvecb_acceptedKeys)
+    {
+        this->mvecb_acceptedKeys = vecb_acceptedKeys;
+        emit this->acceptedKeysChanged();
+    }
+}
@@ -0,0 +1,203 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+
+#ifndef VIRTUALKEYBOARDKEYFILTER_H
+#define VIRTUALKEYBOARDKEYFILTER_H
+
+#include <QObject>
+#include <QLineEdit>
+#include <QPointer>
+#include <QTimer>
+#include <QVector>
+
+#include "VirtualKeyboardKeymap.h"
+
+
+/**
+ * \brief Work out which principal keys can produce acceptable input in a QLineEdit with a QValidator or an input mask
+ *
+ * The keys are probed against the text, the cursor and the selection of the line edit : through QValidator::validate() on the
+ * text the key would produce, or through the character class of the input mask at the next editable position (no probe).
+ *
+ * The probes are updated incrementally : the textChanged / cursorPositionChanged / selectionChanged signals of an edit are merged
+ * into one update on the next event loop pass, nothing is probed if the state of the line edit did not change, and each distinct
+ * key text is probed once. acceptedKeysChanged() is only emitted when the result changed.
+ *
+ * The probes see the text of the line edit : the keyboard does not buffer the keys of the filtered line edits (keystroke coalescing),
+ * and applies the keys buffered before a validator or an input mask was set before checking the next key.
+ */
+class VirtualKeyboardKeyFilter : public QObject
+{
+    Q_OBJECT
+
+
+    // Private Members
+private:
+
+    /**
+     * Line edit filtered, NULL if there is none
+     */
+    QPointer<QLineEdit> mpw_lineEdit;
+
+    /**
+     * Keymap of the keys probed
+     */
+    const VirtualKeyboardKeymap *mpo_keymap;
+
+    /**
+     * Layer of the keys probed
+     */
+    int mi_layer;
+
+    /**
+     * Input mask of the line edit, as parsed in ms_maskClasses
+     */
+    QString ms_inputMask;
+
+    /**
+     * Character class of each position of the displayed text (input mask character), QChar() for the separators
+     */
+    QString ms_maskClasses;
+
+    /**
+     * Keys accepted in the current state, indexed by key
+     */
+    QVector<bool> mvecb_acceptedKeys;
+
+    /**
+     * State of the last probe : text of the line edit (displayed text if there is an input mask)
+     */
+    QString ms_probedText;
+
+    /**
+     * State of the last probe : position of the insertion (start of the selection, or cursor), -1 to probe again
+     */
+    int mi_probedPosition;
+
+    /**
+     * State of the last probe : length of the selection
+     */
+    int mi_probedSelectionLength;
+
+    /**
+     * State of the last probe : validator of the line edit
+     */
+    const QValidator *mpo_probedValidator;
+
+    /**
+     * Timer merging the changes of the line edit into one update
+     */
+    QTimer mo_timerUpdate;
+
+
+    // Public Functions
+public:
+
+    /**
+     * \brief Constructor
+     * \param o_parent : parent Object
+     */
+    explicit VirtualKeyboardKeyFilter(QObject *o_parent = 0);
+
+    /**
+     * \brief Set the line edit filtered
+     * \param[in] w_lineEdit : Line edit, NULL to accept every key
+     */
+    void setLineEdit(QLineEdit *w_lineEdit);
+
+    /**
+     * \brief Set the keys probed : every key of a layer of a keymap (updated synchronously)
+     * \param[in] po_keymap : Keymap
+     * \param[in] i_layer : Layer (VIRTUALKEYBOARD_LAYER_*)
+     */
+    void setKeymap(const VirtualKeyboardKeymap *po_keymap, int i_layer);
+
+    /**
+     * \brief Check if the keys are filtered : the line edit has a validator or an input mask
+     */
+    bool isFiltering() const;
+
+    /**
+     * \brief Check if the line edit only accepts numbers (QIntValidator, QDoubleValidator, or input mask of digits)
+     */
+    bool isNumeric() const;
+
+    /**
+     * \brief Check if a key can produce acceptable input
+     * \param[in] i_key : Index of the key in the layer
+     * \return True if the key is accepted, or if the state is being updated (the key is then tried)
+     */
+    bool isKeyAccepted(int i_key) const;
+
+
+    // Private Functions
+private:
+
+    /**
+     * \brief Parse the input mask of the line edit into ms_maskClasses, if it changed
+     */
+    void parseInputMask();
+
+    /**
+     * \brief Check if a character is accepted by a character class of an input mask
+     * \param[in] c_class : Input mask character
+     * \param[in] c_character : Character
+     */
+    static bool isMaskCharacterAccepted(QChar c_class, QChar c_character);
+
+    /**
+     * \brief Check if a key text is accepted at the insertion position
+     * \param[in] s_keyText : Text of the key
+     * \param[in] i_position : Start of the selection, or position of the cursor
+     * \param[in] i_selectionLength : Length of the selection
+     */
+    bool isTextAccepted(const QString &s_keyText, int i_position, int i_selectionLength) const;
+
+
+    // Signals
+signals:
+
+    /**
+     * \brief Signal emitted when the keys accepted changed
+     */
+    void acceptedKeysChanged();
+
+
+    // Private Slots
+private slots:
+
+    /**
+     * \brief Update the keys accepted on the next event loop pass
+     */
+    void scheduleUpdate();
+
+    /**
+     * \brief Probe the keys if the state of the line edit changed since the last probe
+     */
+    void update();
+};
+
+#endif // VIRTUALKEYBOARDKEYFILTER_H
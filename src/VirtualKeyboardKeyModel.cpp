@@ -0,0 +1,158 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+
+#include "VirtualKeyboardKeyModel.h"
+
+#include <algorithm>
+
+#ifdef VIRTUALKEYBOARD_HAS_SSE
+#include <xmmintrin.h>
+#endif
+
+
+
+VirtualKeyboardKeyModel::VirtualKeyboardKeyModel(qreal r_sigma, int i_maximumKeyCount) :
+    mr_sigma(r_sigma),
+    mi_maximumKeyCount(i_maximumKeyCount),
+    mr_sigmaX(1),
+    mr_sigmaY(1)
+{
+}
+
+
+void VirtualKeyboardKeyModel::setKeys(const QString &s_characters, const QVector<QRectF> &veco_rects)
+{
+    const int i_count = qMin(s_characters.size(), veco_rects.size());
+
+    this->ms_keyCharacters.clear();
+    this->mvecr_keyX.clear();
+    this->mvecr_keyY.clear();
+
+    // --- Median size of the keys : the wide keys (space, last key of a row) do not widen the model
+    QVector<qreal> vecr_widths;
+    QVector<qreal> vecr_heights;
+
+    for (int i_i = 0; i_i < i_count; ++i_i)
+    {
+        if (veco_rects.at(i_i).isEmpty()) continue;
+
+        vecr_widths.append(veco_rects.at(i_i).width());
+        vecr_heights.append(veco_rects.at(i_i).height());
+    }
+
+    if (vecr_widths.isEmpty()) return;
+
+    std::nth_element(vecr_widths.begin(), vecr_widths.begin() + vecr_widths.size() / 2, vecr_widths.end());
+    std::nth_element(vecr_heights.begin(), vecr_heights.begin() + vecr_heights.size() / 2, vecr_heights.end());
+
+    this->mr_sigmaX = this->mr_sigma * vecr_widths.at(vecr_widths.size() / 2);
+    this->mr_sigmaY = this->mr_sigma * vecr_heights.at(vecr_heights.size() / 2);
+
+    // --- Centres of the keys, in standard deviations
+    for (int i_i = 0; i_i < i_count; ++i_i)
+    {
+        if (veco_rects.at(i_i).isEmpty()) continue;
+        if (this->mi_maximumKeyCount >= 0 && this->ms_keyCharacters.size() >= this->mi_maximumKeyCount) break;
+
+        this->ms_keyCharacters += s_characters.at(i_i).toLower();
+        this->mvecr_keyX.append(this->toModelX(veco_rects.at(i_i).center().x()));
+        this->mvecr_keyY.append(this->toModelY(veco_rects.at(i_i).center().y()));
+    }
+}
+
+
+int VirtualKeyboardKeyModel::keyCount() const
+{
+    return this->ms_keyCharacters.size();
+}
+
+
+const QString &VirtualKeyboardKeyModel::keyCharacters() const
+{
+    return this->ms_keyCharacters;
+}
+
+
+const float *VirtualKeyboardKeyModel::keyX() const
+{
+    return this->mvecr_keyX.constData();
+}
+
+
+const float *VirtualKeyboardKeyModel::keyY() const
+{
+    return this->mvecr_keyY.constData();
+}
+
+
+float VirtualKeyboardKeyModel::toModelX(qreal r_x) const
+{
+    return float(r_x / this->mr_sigmaX);
+}
+
+
+float VirtualKeyboardKeyModel::toModelY(qreal r_y) const
+{
+    return float(r_y / this->mr_sigmaY);
+}
+
+
+void VirtualKeyboardKeyModel::scoreDistances(const float *pr_pointX, const float *pr_pointY, int i_length, const float *pr_candidateX, const float *pr_candidateY,
+                                             int i_stride, float r_weight, const float *pr_priors, float *pr_scores)
+{
+#ifdef VIRTUALKEYBOARD_HAS_SSE
+    const __m128 o_weight = _mm_set1_ps(r_weight);
+
+    // Four candidates at a time : the squared distances of their points to the reference points are summed lane by lane
+    for (int i_candidate = 0; i_candidate < i_stride; i_candidate += 4)
+    {
+        __m128 o_distances = _mm_setzero_ps();
+
+        for (int i_i = 0; i_i < i_length; ++i_i)
+        {
+            const __m128 o_dx = _mm_sub_ps(_mm_set1_ps(pr_pointX[i_i]), _mm_loadu_ps(pr_candidateX + i_i * i_stride + i_candidate));
+            const __m128 o_dy = _mm_sub_ps(_mm_set1_ps(pr_pointY[i_i]), _mm_loadu_ps(pr_candidateY + i_i * i_stride + i_candidate));
+            o_distances = _mm_add_ps(o_distances, _mm_add_ps(_mm_mul_ps(o_dx, o_dx), _mm_mul_ps(o_dy, o_dy)));
+        }
+
+        _mm_storeu_ps(pr_scores + i_candidate, _mm_sub_ps(_mm_loadu_ps(pr_priors + i_candidate), _mm_mul_ps(o_weight, o_distances)));
+    }
+#else
+    for (int i_candidate = 0; i_candidate < i_stride; ++i_candidate)
+    {
+        float r_distances = 0;
+
+        for (int i_i = 0; i_i < i_length; ++i_i)
+        {
+            const float r_dx = pr_pointX[i_i] - pr_candidateX[i_i * i_stride + i_candidate];
+            const float r_dy = pr_pointY[i_i] - pr_candidateY[i_i * i_stride + i_candidate];
+            r_distances += r_dx * r_dx + r_dy * r_dy;
+        }
+
+        pr_scores[i_candidate] = pr_priors[i_candidate] - r_weight * r_distances;
+    }
+#endif
+}
@@ -0,0 +1,140 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+#ifndef VIRTUALKEYBOARDKEYMODEL_H
+#define VIRTUALKEYBOARDKEYMODEL_H
+
+#include <QString>
+#include <QVector>
+#include <QRectF>
+
+// SSE : baseline of x86-64, enabled by the compiler flags on 32-bit x86 (the sources using it include <xmmintrin.h>)
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define VIRTUALKEYBOARD_HAS_SSE
+#endif
+
+
+/**
+ * \brief Gaussian model of the positions aimed at the letter keys, shared by the tap correction and the gesture typing
+ *
+ * The standard deviation of the model is a fraction of the median size of the keys, horizontally and vertically : the wide keys
+ * (space, last key of a row) do not widen it. The centres of the keys are kept in standard deviations of the model, in which the
+ * log-likelihood of a position around a key is -(dx² + dy²) / 2.
+ *
+ * This class only depends on QtCore, it can be used without a display.
+ */
+class VirtualKeyboardKeyModel
+{
+    // Private Members
+private:
+
+    /**
+     * Standard deviation of the model, in key widths (horizontally) and key heights (vertically)
+     */
+    qreal mr_sigma;
+
+    /**
+     * Maximum number of keys of the model, negative => no limit
+     */
+    int mi_maximumKeyCount;
+
+    /**
+     * Lowercase character of each key
+     */
+    QString ms_keyCharacters;
+
+    /**
+     * Centres of the keys, in standard deviations of the model
+     */
+    QVector<float> mvecr_keyX;
+    QVector<float> mvecr_keyY;
+
+    /**
+     * Standard deviation of the model, in pixels
+     */
+    qreal mr_sigmaX;
+    qreal mr_sigmaY;
+
+
+    // Public Functions
+public:
+
+    /**
+     * \brief Constructor of a model without keys
+     * \param[in] r_sigma : Standard deviation of the model, in key widths (horizontally) and key heights (vertically)
+     * \param[in] i_maximumKeyCount : Maximum number of keys kept by setKeys(), negative => no limit
+     */
+    explicit VirtualKeyboardKeyModel(qreal r_sigma, int i_maximumKeyCount = -1);
+
+    /**
+     * \brief Set the keys of the model, the standard deviation is taken from their median size
+     *
+     * The keys with an empty rectangle are ignored, the keys after the maximum number of keys too.
+     *
+     * \param[in] s_characters : Character of each key (compared in lowercase)
+     * \param[in] veco_rects : Rectangle of each key
+     */
+    void setKeys(const QString &s_characters, const QVector<QRectF> &veco_rects);
+
+    /**
+     * \brief Get the number of keys of the model
+     */
+    int keyCount() const;
+
+    /**
+     * \brief Get the lowercase character of each key
+     */
+    const QString &keyCharacters() const;
+
+    /**
+     * \brief Get the centres of the keys, in standard deviations of the model (keyCount() each)
+     */
+    const float *keyX() const;
+    const float *keyY() const;
+
+    /**
+     * \brief Convert a coordinate into standard deviations of the model
+     */
+    float toModelX(qreal r_x) const;
+    float toModelY(qreal r_y) const;
+
+    /**
+     * \brief Score candidates by the squared distances of their points to reference points : prior - r_weight * Σ (dx² + dy²)
+     *
+     * The points of the candidates are laid out by position (structure of arrays), the point i of the candidate c is at
+     * i * i_stride + c : four candidates are scored at once with SSE on x86, one at a time elsewhere.
+     *
+     * \param[in] pr_pointX, pr_pointY : Reference points, i_length each
+     * \param[in] i_length : Number of points
+     * \param[in] pr_candidateX, pr_candidateY : Points of the candidates, i_length * i_stride each
+     * \param[in] i_stride : Number of candidates, multiple of 4 (the padding candidates are scored too)
+     * \param[in] r_weight : Weight of the sum of the squared distances
+     * \param[in] pr_priors : Prior of each candidate, i_stride
+     * \param[out] pr_scores : Score of each candidate, i_stride
+     */
+    static void scoreDistances(const float *pr_pointX, const float *pr_pointY, int i_length, const float *pr_candidateX, const float *pr_candidateY,
+                               int i_stride, float r_weight, const float *pr_priors, float *pr_scores);
+};
+
+#endif // VIRTUALKEYBOARDKEYMODEL_H
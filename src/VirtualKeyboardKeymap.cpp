@@ -0,0 +1,615 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+
+#include "VirtualKeyboardKeymap.h"
+
+#include <cstring>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRegExp>
+#include <QTextStream>
+#include <QVector>
+#include <QtEndian>
+
+
+// Header of a compiled keymap
+#define VIRTUALKEYBOARDKEYMAP_MAGIC         "VKMC"
+#define VIRTUALKEYBOARDKEYMAP_VERSION       1
+#define VIRTUALKEYBOARDKEYMAP_HEADERSIZE    32
+
+// Environment variable listing additional keymap directories
+#define VIRTUALKEYBOARDKEYMAP_PATHVARIABLE  "VIRTUALKEYBOARD_KEYMAP_PATH"
+
+
+/**
+ * \brief Header of a compiled keymap, all the fields are little-endian
+ */
+struct VirtualKeyboardKeymapHeader
+{
+    char    tc_magic[4];
+    quint16 i_version;
+    quint16 i_rowCount;
+    quint16 ti_rowKeyCounts[VIRTUALKEYBOARD_KEYMAP_MAXROWS];
+    quint16 ti_rowKeyWidths[VIRTUALKEYBOARD_KEYMAP_MAXROWS];
+    quint32 i_keyCount;
+    quint32 i_poolSize;
+};
+Q_STATIC_ASSERT(sizeof(VirtualKeyboardKeymapHeader) == VIRTUALKEYBOARDKEYMAP_HEADERSIZE);
+
+
+/**
+ * \brief Registry of the loaded keymaps, shared by the whole process
+ */
+struct VirtualKeyboardKeymapRegistry
+{
+    QMutex o_mutex;
+    QMutex o_loadMutex;     // Held while a keymap file is loaded, o_mutex is not : the loaded keymaps stay available meanwhile
+    QHash<QString, VirtualKeyboardKeymap*> hash_keymaps;
+    QStringList lists_searchPaths;
+};
+Q_GLOBAL_STATIC(VirtualKeyboardKeymapRegistry, st_registry)
+
+
+/**
+ * \brief Get the search paths of the keymaps, the mutex of the registry must be held
+ */
+static QStringList registrySearchPaths(const VirtualKeyboardKeymapRegistry *po_registry)
+{
+    QStringList lists_paths = po_registry->lists_searchPaths;
+    foreach (const QString &s_path, QString::fromLocal8Bit(qgetenv(VIRTUALKEYBOARDKEYMAP_PATHVARIABLE)).split(QDir::listSeparator(), QString::SkipEmptyParts))
+        lists_paths << s_path;
+    if (QCoreApplication::instance() != NULL)
+        lists_paths << QCoreApplication::applicationDirPath() + QLatin1String("/keymaps");
+    lists_paths << QLatin1String(":/keymaps");
+
+    return lists_paths;
+}
+
+
+/**
+ * \brief Get a keymap of the registry
+ * \param[out] pb_isRegistered : True if the language is in the registry (loaded, or known to be invalid), may be NULL
+ * \return Keymap, NULL if the language is not in the registry or its keymap is invalid
+ */
+static const VirtualKeyboardKeymap *findRegistered(VirtualKeyboardKeymapRegistry *po_registry, const QString &s_language, bool *pb_isRegistered)
+{
+    QMutexLocker o_locker(&po_registry->o_mutex);
+
+    QHash<QString, VirtualKeyboardKeymap*>::const_iterator it = po_registry->hash_keymaps.constFind(s_language);
+    if (pb_isRegistered != NULL) *pb_isRegistered = it != po_registry->hash_keymaps.constEnd();
+
+    return it != po_registry->hash_keymaps.constEnd() ? it.value() : NULL;
+}
+
+
+/**
+ * \brief Built-in keymaps : compiled images of keymaps/*.vkm ("vkmcompiler --cpp"), read in place
+ */
+Q_DECL_ALIGN(4) static const uchar st_builtinKeymapEN[] =
+{
+#include "../keymaps/EN.inc"
+};
+Q_DECL_ALIGN(4) static const uchar st_builtinKeymapFR[] =
+{
+#include "../keymaps/FR.inc"
+};
+
+
+/**
+ * \brief Names of the layer sections of a source keymap, in VIRTUALKEYBOARD_LAYER_* order
+ */
+static const char *const st_layerSections[VIRTUALKEYBOARD_LAYER_COUNT] = { "lower", "upper", "numbers", "punctuation" };
+
+
+/**
+ * \brief Unescape a key of a source keymap
+ * \return False if the key contains an invalid escape sequence
+ */
+static bool unescapeKey(const QString &s_token, QString &s_key)
+{
+    s_key.clear();
+
+    if (s_token == QLatin1String("\\_")) return true;
+
+    for (int i = 0; i < s_token.size(); ++i)
+    {
+        if (s_token.at(i) != QLatin1Char('\\'))
+        {
+            s_key.append(s_token.at(i));
+            continue;
+        }
+        if (++i >= s_token.size()) return false;
+
+        switch (s_token.at(i).unicode())
+        {
+        case '\\': s_key.append(QLatin1Char('\\')); break;
+        case '#':  s_key.append(QLatin1Char('#'));  break;
+        case 's':  s_key.append(QLatin1Char(' '));  break;
+        case 'u':
+        {
+            bool b_ok = false;
+            const ushort i_codeUnit = (i + 4 < s_token.size()) ? s_token.mid(i + 1, 4).toUShort(&b_ok, 16) : 0;
+            if (!b_ok) return false;
+            s_key.append(QChar(i_codeUnit));
+            i += 4;
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+
+
+VirtualKeyboardKeymap::VirtualKeyboardKeymap() :
+    mpo_file(NULL),
+    mpc_data(NULL),
+    mi_rowCount(0),
+    mi_keyCount(0),
+    mpi_offsets(NULL),
+    mpo_pool(NULL)
+{
+}
+
+
+VirtualKeyboardKeymap::VirtualKeyboardKeymap(const uchar *pc_data, qint64 i_size) :
+    mpo_file(NULL),
+    mpc_data(NULL),
+    mi_rowCount(0),
+    mi_keyCount(0),
+    mpi_offsets(NULL),
+    mpo_pool(NULL)
+{
+    this->attach(pc_data, i_size);
+}
+
+
+VirtualKeyboardKeymap::~VirtualKeyboardKeymap()
+{
+    delete this->mpo_file;
+}
+
+
+const VirtualKeyboardKeymap *VirtualKeyboardKeymap::find(const QString &s_language)
+{
+    // Built-in keymaps : static tables, neither allocation nor lock
+    const VirtualKeyboardKeymap *po_builtinKeymap = VirtualKeyboardKeymap::builtin(s_language);
+    if (po_builtinKeymap != NULL) return po_builtinKeymap;
+
+    VirtualKeyboardKeymapRegistry *po_registry = st_registry();
+
+    bool b_isRegistered = false;
+    const VirtualKeyboardKeymap *po_loadedKeymap = findRegistered(po_registry, s_language, &b_isRegistered);
+    if (b_isRegistered) return po_loadedKeymap;
+
+    // One load at a time : the keymap may have been loaded by another thread while this one was waiting
+    QMutexLocker o_loadLocker(&po_registry->o_loadMutex);
+
+    po_loadedKeymap = findRegistered(po_registry, s_language, &b_isRegistered);
+    if (b_isRegistered) return po_loadedKeymap;
+
+    VirtualKeyboardKeymap *po_keymap = NULL;
+
+    if (!s_language.isEmpty() && !s_language.contains(QLatin1Char('/')) && !s_language.contains(QLatin1Char('\\')))
+    {
+        QStringList lists_paths;
+        {
+            QMutexLocker o_locker(&po_registry->o_mutex);
+            lists_paths = registrySearchPaths(po_registry);
+        }
+
+        for (int i = 0; i < lists_paths.size() && po_keymap == NULL; ++i)
+        {
+            const QString s_baseName = lists_paths.at(i) + QLatin1Char('/') + s_language;
+
+            if (QFileInfo::exists(s_baseName + QLatin1String(VIRTUALKEYBOARD_KEYMAP_COMPILEDSUFFIX)))
+                po_keymap = VirtualKeyboardKeymap::load(s_baseName + QLatin1String(VIRTUALKEYBOARD_KEYMAP_COMPILEDSUFFIX));
+            if (po_keymap == NULL && QFileInfo::exists(s_baseName + QLatin1String(VIRTUALKEYBOARD_KEYMAP_SOURCESUFFIX)))
+                po_keymap = VirtualKeyboardKeymap::load(s_baseName + QLatin1String(VIRTUALKEYBOARD_KEYMAP_SOURCESUFFIX));
+        }
+    }
+
+    // Unknown languages are remembered too, they are not looked up again
+    QMutexLocker o_locker(&po_registry->o_mutex);
+    po_registry->hash_keymaps.insert(s_language, po_keymap);
+    return po_keymap;
+}
+
+
+const VirtualKeyboardKeymap *VirtualKeyboardKeymap::findLoaded(const QString &s_language)
+{
+    const VirtualKeyboardKeymap *po_builtinKeymap = VirtualKeyboardKeymap::builtin(s_language);
+    if (po_builtinKeymap != NULL) return po_builtinKeymap;
+
+    return findRegistered(st_registry(), s_language, NULL);
+}
+
+
+QStringList VirtualKeyboardKeymap::searchPaths()
+{
+    VirtualKeyboardKeymapRegistry *po_registry = st_registry();
+    QMutexLocker o_locker(&po_registry->o_mutex);
+
+    return registrySearchPaths(po_registry);
+}
+
+
+void VirtualKeyboardKeymap::addSearchPath(const QString &s_path)
+{
+    VirtualKeyboardKeymapRegistry *po_registry = st_registry();
+    QMutexLocker o_locker(&po_registry->o_mutex);
+
+    po_registry->lists_searchPaths.prepend(s_path);
+
+    // Forget the unknown languages, they may be in the new directory
+    QHash<QString, VirtualKeyboardKeymap*>::iterator it = po_registry->hash_keymaps.begin();
+    while (it != po_registry->hash_keymaps.end())
+    {
+        if (it.value() == NULL) it = po_registry->hash_keymaps.erase(it);
+        else ++it;
+    }
+}
+
+
+bool VirtualKeyboardKeymap::compile(const QString &s_source, QByteArray *pba_compiled, QString *ps_error)
+{
+    if (pba_compiled == NULL) return false;
+
+    QString s_error;
+    QList<QStringList> tlistlists_layerRows[VIRTUALKEYBOARD_LAYER_COUNT];
+    QList<int> listi_rowKeyCounts;
+    QList<int> listi_rowKeyWidths;
+    int i_section = -1; // -2 : geometry, else VIRTUALKEYBOARD_LAYER_*
+    int i_line = 0;
+
+    foreach (const QString &s_rawLine, s_source.split(QLatin1Char('\n')))
+    {
+        ++i_line;
+        const QString s_line = s_rawLine.trimmed();
+
+        if (s_line.isEmpty() || s_line.startsWith(QLatin1Char('#'))) continue;
+
+        if (s_line.startsWith(QLatin1Char('[')) && s_line.endsWith(QLatin1Char(']')))
+        {
+            const QString s_name = s_line.mid(1, s_line.size() - 2).trimmed();
+            i_section = -1;
+            if (s_name == QLatin1String("geometry")) i_section = -2;
+            for (int i = 0; i < VIRTUALKEYBOARD_LAYER_COUNT; ++i)
+                if (s_name == QLatin1String(st_layerSections[i])) i_section = i;
+
+            if (i_section == -1)
+            {
+                s_error = QString("line %1 : unknown section \"%2\"").arg(i_line).arg(s_name);
+                break;
+            }
+            continue;
+        }
+
+        QStringList lists_tokens = s_line.split(QRegExp("\\s+"), QString::SkipEmptyParts);
+
+        if (i_section == -2)
+        {
+            const QString s_keyword = lists_tokens.takeFirst();
+            QList<int> listi_values;
+            foreach (const QString &s_token, lists_tokens)
+            {
+                bool b_ok;
+                const int i_value = s_token.toInt(&b_ok);
+                if (!b_ok || i_value < 0 || i_value > 0xFFFF)
+                {
+                    s_error = QString("line %1 : invalid value \"%2\"").arg(i_line).arg(s_token);
+                    break;
+                }
+                listi_values << i_value;
+            }
+            if (!s_error.isEmpty()) break;
+
+            if (s_keyword == QLatin1String("rows")) listi_rowKeyCounts = listi_values;
+            else if (s_keyword == QLatin1String("widths")) listi_rowKeyWidths = listi_values;
+            else
+            {
+                s_error = QString("line %1 : unknown geometry \"%2\"").arg(i_line).arg(s_keyword);
+                break;
+            }
+            continue;
+        }
+
+        if (i_section < 0)
+        {
+            s_error = QString("line %1 : keys outside of a layer section").arg(i_line);
+            break;
+        }
+
+        QStringList lists_keys;
+        foreach (const QString &s_token, lists_tokens)
+        {
+            QString s_key;
+            if (!unescapeKey(s_token, s_key))
+            {
+                s_error = QString("line %1 : invalid escape sequence in \"%2\"").arg(i_line).arg(s_token);
+                break;
+            }
+            lists_keys << s_key;
+        }
+        if (!s_error.isEmpty()) break;
+
+        tlistlists_layerRows[i_section] << lists_keys;
+    }
+
+    // Geometry : the longest row of the layers if not given
+    if (s_error.isEmpty() && listi_rowKeyCounts.isEmpty())
+    {
+        for (int i_layer = 0; i_layer < VIRTUALKEYBOARD_LAYER_COUNT; ++i_layer)
+        {
+            for (int i_row = 0; i_row < tlistlists_layerRows[i_layer].size(); ++i_row)
+            {
+                if (i_row >= listi_rowKeyCounts.size()) listi_rowKeyCounts << 0;
+                listi_rowKeyCounts[i_row] = qMax(listi_rowKeyCounts.at(i_row), tlistlists_layerRows[i_layer].at(i_row).size());
+            }
+        }
+    }
+    if (s_error.isEmpty() && (listi_rowKeyCounts.isEmpty() || listi_rowKeyCounts.size() > VIRTUALKEYBOARD_KEYMAP_MAXROWS))
+        s_error = QString("the keymap must have between 1 and %1 rows").arg(VIRTUALKEYBOARD_KEYMAP_MAXROWS);
+    int i_keyCount = 0;
+    foreach (int i_rowKeyCount, listi_rowKeyCounts) i_keyCount += i_rowKeyCount;
+    if (s_error.isEmpty() && i_keyCount > VIRTUALKEYBOARD_KEYMAP_MAXKEYS)
+        s_error = QString("the keymap must have at most %1 keys").arg(VIRTUALKEYBOARD_KEYMAP_MAXKEYS);
+    if (s_error.isEmpty() && listi_rowKeyWidths.size() > listi_rowKeyCounts.size())
+        s_error = QString("more widths than rows");
+    if (s_error.isEmpty() && listi_rowKeyWidths.contains(0))
+        s_error = QString("the widths must be positive");
+
+    for (int i_layer = 0; i_layer < VIRTUALKEYBOARD_LAYER_COUNT && s_error.isEmpty(); ++i_layer)
+    {
+        if (tlistlists_layerRows[i_layer].size() > listi_rowKeyCounts.size())
+            s_error = QString("layer \"%1\" : too many rows").arg(st_layerSections[i_layer]);
+        for (int i_row = 0; i_row < tlistlists_layerRows[i_layer].size() && s_error.isEmpty(); ++i_row)
+            if (tlistlists_layerRows[i_layer].at(i_row).size() > listi_rowKeyCounts.at(i_row))
+                s_error = QString("layer \"%1\" : too many keys on row %2").arg(st_layerSections[i_layer]).arg(i_row + 1);
+    }
+
+    if (!s_error.isEmpty())
+    {
+        if (ps_error != NULL) *ps_error = s_error;
+        return false;
+    }
+
+    // Header
+    VirtualKeyboardKeymapHeader o_header;
+    memset(&o_header, 0, sizeof(o_header));
+    memcpy(o_header.tc_magic, VIRTUALKEYBOARDKEYMAP_MAGIC, sizeof(o_header.tc_magic));
+    o_header.i_version = qToLittleEndian<quint16>(VIRTUALKEYBOARDKEYMAP_VERSION);
+    o_header.i_rowCount = qToLittleEndian<quint16>(listi_rowKeyCounts.size());
+
+    for (int i_row = 0; i_row < listi_rowKeyCounts.size(); ++i_row)
+    {
+        o_header.ti_rowKeyCounts[i_row] = qToLittleEndian<quint16>(listi_rowKeyCounts.at(i_row));
+        o_header.ti_rowKeyWidths[i_row] = qToLittleEndian<quint16>(i_row < listi_rowKeyWidths.size() ? listi_rowKeyWidths.at(i_row)
+                                                                                                     : VIRTUALKEYBOARD_KEYMAP_KEYWIDTH);
+    }
+    o_header.i_keyCount = qToLittleEndian<quint32>(i_keyCount);
+
+    // Offsets and pool
+    QVector<quint32> veci_offsets;
+    QVector<quint16> veci_pool;
+    veci_offsets.reserve(VIRTUALKEYBOARD_LAYER_COUNT * (i_keyCount + 1));
+
+    for (int i_layer = 0; i_layer < VIRTUALKEYBOARD_LAYER_COUNT; ++i_layer)
+    {
+        for (int i_row = 0; i_row < listi_rowKeyCounts.size(); ++i_row)
+        {
+            const QStringList lists_keys = i_row < tlistlists_layerRows[i_layer].size() ? tlistlists_layerRows[i_layer].at(i_row) : QStringList();
+
+            for (int i_column = 0; i_column < listi_rowKeyCounts.at(i_row); ++i_column)
+            {
+                veci_offsets << qToLittleEndian<quint32>(veci_pool.size());
+                if (i_column < lists_keys.size())
+                    foreach (const QChar &o_char, lists_keys.at(i_column)) veci_pool << qToLittleEndian<quint16>(o_char.unicode());
+            }
+        }
+        veci_offsets << qToLittleEndian<quint32>(veci_pool.size());
+    }
+    o_header.i_poolSize = qToLittleEndian<quint32>(veci_pool.size());
+
+    pba_compiled->clear();
+    pba_compiled->reserve(int(sizeof(o_header)) + veci_offsets.size() * int(sizeof(quint32)) + veci_pool.size() * int(sizeof(quint16)));
+    pba_compiled->append(reinterpret_cast<const char*>(&o_header), sizeof(o_header));
+    pba_compiled->append(reinterpret_cast<const char*>(veci_offsets.constData()), veci_offsets.size() * int(sizeof(quint32)));
+    pba_compiled->append(reinterpret_cast<const char*>(veci_pool.constData()), veci_pool.size() * int(sizeof(quint16)));
+
+    return true;
+}
+
+
+int VirtualKeyboardKeymap::rowCount() const
+{
+    return this->mi_rowCount;
+}
+
+
+int VirtualKeyboardKeymap::rowKeyCount(int i_row) const
+{
+    return (i_row >= 0 && i_row < this->mi_rowCount) ? this->mti_rowKeyCounts[i_row] : 0;
+}
+
+
+int VirtualKeyboardKeymap::rowKeyWidth(int i_row) const
+{
+    return (i_row >= 0 && i_row < this->mi_rowCount) ? this->mti_rowKeyWidths[i_row] : 0;
+}
+
+
+int VirtualKeyboardKeymap::keyCount() const
+{
+    return this->mi_keyCount;
+}
+
+
+bool VirtualKeyboardKeymap::isKeyEmpty(int i_layer, int i_indexKey) const
+{
+    if (i_layer < 0 || i_layer >= VIRTUALKEYBOARD_LAYER_COUNT || i_indexKey < 0 || i_indexKey >= this->mi_keyCount) return true;
+
+    const quint32 *pi_offset = this->mpi_offsets + i_layer * (this->mi_keyCount + 1) + i_indexKey;
+    return qFromLittleEndian(pi_offset[0]) == qFromLittleEndian(pi_offset[1]);
+}
+
+
+QString VirtualKeyboardKeymap::keyText(int i_layer, int i_indexKey) const
+{
+    if (this->isKeyEmpty(i_layer, i_indexKey)) return QString();
+
+    const quint32 *pi_offset = this->mpi_offsets + i_layer * (this->mi_keyCount + 1) + i_indexKey;
+    const quint32 i_begin = qFromLittleEndian(pi_offset[0]);
+
+    return QString::fromRawData(this->mpo_pool + i_begin, int(qFromLittleEndian(pi_offset[1]) - i_begin));
+}
+
+
+const VirtualKeyboardKeymap *VirtualKeyboardKeymap::builtin(const QString &s_language)
+{
+    const VirtualKeyboardKeymap *po_keymap = NULL;
+
+    // Constructed on first use (thread-safe), over the static tables
+    if (s_language == QLatin1String("EN"))
+    {
+        static const VirtualKeyboardKeymap so_keymapEN(st_builtinKeymapEN, sizeof(st_builtinKeymapEN));
+        po_keymap = &so_keymapEN;
+    }
+    else if (s_language == QLatin1String("FR"))
+    {
+        static const VirtualKeyboardKeymap so_keymapFR(st_builtinKeymapFR, sizeof(st_builtinKeymapFR));
+        po_keymap = &so_keymapFR;
+    }
+
+    // The tables can not be read in place on big-endian hosts
+    return (po_keymap != NULL && po_keymap->mpc_data != NULL) ? po_keymap : NULL;
+}
+
+
+VirtualKeyboardKeymap *VirtualKeyboardKeymap::load(const QString &s_fileName)
+{
+    VirtualKeyboardKeymap *po_keymap = new VirtualKeyboardKeymap();
+    bool b_isAttached = false;
+
+    if (s_fileName.endsWith(QLatin1String(VIRTUALKEYBOARD_KEYMAP_COMPILEDSUFFIX)))
+    {
+        // Memory-mapped (files and uncompressed resources), else read
+        po_keymap->mpo_file = new QFile(s_fileName);
+        if (po_keymap->mpo_file->open(QIODevice::ReadOnly))
+        {
+            const uchar *pc_data = po_keymap->mpo_file->map(0, po_keymap->mpo_file->size());
+            if (pc_data != NULL)
+            {
+                b_isAttached = po_keymap->attach(pc_data, po_keymap->mpo_file->size());
+            }
+            else
+            {
+                po_keymap->mba_data = po_keymap->mpo_file->readAll();
+                b_isAttached = po_keymap->attach(reinterpret_cast<const uchar*>(po_keymap->mba_data.constData()), po_keymap->mba_data.size());
+                delete po_keymap->mpo_file;
+                po_keymap->mpo_file = NULL;
+            }
+        }
+    }
+    else
+    {
+        QFile o_file(s_fileName);
+        QString s_error;
+
+        if (o_file.open(QIODevice::ReadOnly | QIODevice::Text))
+        {
+            QTextStream o_stream(&o_file);
+            o_stream.setCodec("UTF-8");
+
+            if (VirtualKeyboardKeymap::compile(o_stream.readAll(), &po_keymap->mba_data, &s_error))
+                b_isAttached = po_keymap->attach(reinterpret_cast<const uchar*>(po_keymap->mba_data.constData()), po_keymap->mba_data.size());
+            else
+                qWarning("VirtualKeyboardKeymap: %s: %s", qPrintable(s_fileName), qPrintable(s_error));
+        }
+    }
+
+    if (!b_isAttached)
+    {
+        delete po_keymap;
+        return NULL;
+    }
+    return po_keymap;
+}
+
+
+bool VirtualKeyboardKeymap::attach(const uchar *pc_data, qint64 i_size)
+{
+    // The labels are read in place as UTF-16 : the compiled keymaps are little-endian
+    if (QSysInfo::ByteOrder != QSysInfo::LittleEndian) return false;
+    if (pc_data == NULL || i_size < VIRTUALKEYBOARDKEYMAP_HEADERSIZE || (quintptr(pc_data) & 3) != 0) return false;
+
+    const VirtualKeyboardKeymapHeader *po_header = reinterpret_cast<const VirtualKeyboardKeymapHeader*>(pc_data);
+
+    if (memcmp(po_header->tc_magic, VIRTUALKEYBOARDKEYMAP_MAGIC, sizeof(po_header->tc_magic)) != 0
+            || qFromLittleEndian(po_header->i_version) != VIRTUALKEYBOARDKEYMAP_VERSION)
+        return false;
+
+    const int i_rowCount = qFromLittleEndian(po_header->i_rowCount);
+    if (i_rowCount < 1 || i_rowCount > VIRTUALKEYBOARD_KEYMAP_MAXROWS) return false;
+
+    qint64 i_keyCount = 0;
+    for (int i_row = 0; i_row < i_rowCount; ++i_row)
+    {
+        this->mti_rowKeyCounts[i_row] = qFromLittleEndian(po_header->ti_rowKeyCounts[i_row]);
+        this->mti_rowKeyWidths[i_row] = qFromLittleEndian(po_header->ti_rowKeyWidths[i_row]);
+        if (this->mti_rowKeyWidths[i_row] == 0) return false;
+        i_keyCount += this->mti_rowKeyCounts[i_row];
+    }
+
+    const qint64 i_poolSize = qFromLittleEndian(po_header->i_poolSize);
+    const qint64 i_offsetCount = VIRTUALKEYBOARD_LAYER_COUNT * (i_keyCount + 1);
+    if (i_keyCount > VIRTUALKEYBOARD_KEYMAP_MAXKEYS || i_keyCount != qFromLittleEndian(po_header->i_keyCount)
+            || i_size < VIRTUALKEYBOARDKEYMAP_HEADERSIZE + i_offsetCount * qint64(sizeof(quint32)) + i_poolSize * qint64(sizeof(quint16)))
+        return false;
+
+    const quint32 *pi_offsets = reinterpret_cast<const quint32*>(pc_data + VIRTUALKEYBOARDKEYMAP_HEADERSIZE);
+
+    // Offsets in the pool and increasing : the accessors do not check them again
+    for (qint64 i = 0; i < i_offsetCount; ++i)
+    {
+        if (qFromLittleEndian(pi_offsets[i]) > i_poolSize) return false;
+        if ((i % (i_keyCount + 1)) != 0 && qFromLittleEndian(pi_offsets[i]) < qFromLittleEndian(pi_offsets[i - 1])) return false;
+    }
+
+    this->mpc_data = pc_data;
+    this->mi_rowCount = i_rowCount;
+    this->mi_keyCount = int(i_keyCount);
+    this->mpi_offsets = pi_offsets;
+    this->mpo_pool = reinterpret_cast<const QChar*>(pi_offsets + i_offsetCount);
+
+    return true;
+}
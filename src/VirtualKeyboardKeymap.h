@@ -0,0 +1,279 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+#ifndef VIRTUALKEYBOARDKEYMAP_H
+#define VIRTUALKEYBOARDKEYMAP_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QFile>
+
+
+// Layers of a keymap
+#define VIRTUALKEYBOARD_LAYER_LOWER         0
+#define VIRTUALKEYBOARD_LAYER_UPPER         1
+#define VIRTUALKEYBOARD_LAYER_NUMBERS       2
+#define VIRTUALKEYBOARD_LAYER_PUNCTUATION   3
+#define VIRTUALKEYBOARD_LAYER_COUNT         4
+
+// Maximum number of rows of principal keys
+#define VIRTUALKEYBOARD_KEYMAP_MAXROWS      4
+
+// Maximum number of principal keys per layer (the identifiers of the special keys start at 100)
+#define VIRTUALKEYBOARD_KEYMAP_MAXKEYS      100
+
+// Default minimum width of a principal key (same as VirtualKeyboard.ui)
+#define VIRTUALKEYBOARD_KEYMAP_KEYWIDTH     40
+
+// File extensions of the keymaps
+#define VIRTUALKEYBOARD_KEYMAP_SOURCESUFFIX     ".vkm"
+#define VIRTUALKEYBOARD_KEYMAP_COMPILEDSUFFIX   ".vkmc"
+
+
+/**
+ * \brief Keymap of the virtual keyboard : the principal keys of the four layers, and their geometry
+ *
+ * A keymap is a read-only view over a compiled keymap (.vkmc), either memory-mapped from a file or a Qt resource,
+ * or compiled in memory from a source keymap (.vkm). The key labels are read in place : loading a keymap does not
+ * allocate anything per key.
+ *
+ * The built-in keymaps ("EN", "FR") are static tables compiled in the library : using them allocates nothing.
+ * The other keymaps are loaded lazily by find() and shared by every keyboard of the process, they are never unloaded.
+ * A language is added by dropping a "<LANGUAGE>.vkm" or "<LANGUAGE>.vkmc" file in one of the search paths, without code change.
+ *
+ * Source format (UTF-8) :
+ * \code
+ * # Comment : line starting with '#'
+ * # Geometry (optional) : number of principal keys on each row (else the longest row of the layers),
+ * # and minimum width of the keys of each row (else 40)
+ * [geometry]
+ * rows 10 10 7
+ * widths 40 40 40
+ * # Layers : one line per row, keys separated by spaces, \_ when there is no key at a position
+ * [lower]
+ * q w e r t y u i o p
+ * a s d f g h j k l \_
+ * z x c v b n m
+ * [upper]
+ * ...
+ * [numbers]
+ * ...
+ * [punctuation]
+ * ...
+ * \endcode
+ * Escape sequences in the keys : \_ (no key), \\ (backslash), \# (sharp at the start of a line), \s (space), \uXXXX (UTF-16 code unit).
+ *
+ * Compiled format (little-endian) : a 32 bytes header (magic "VKMC", version, rows geometry, number of keys, size of the pool),
+ * then for each layer the offsets of its keys in the pool (keyCount + 1 quint32), then the pool of UTF-16 labels.
+ */
+class VirtualKeyboardKeymap
+{
+    // Private Members
+private:
+
+    /**
+     * Compiled keymap, when compiled in memory or read from a device which can not be mapped
+     */
+    QByteArray mba_data;
+
+    /**
+     * File mapped, when the keymap is memory-mapped
+     */
+    QFile *mpo_file;
+
+    /**
+     * Start of the compiled keymap
+     */
+    const uchar *mpc_data;
+
+    /**
+     * Number of rows of principal keys
+     */
+    int mi_rowCount;
+
+    /**
+     * Number of principal keys on each row
+     */
+    int mti_rowKeyCounts[VIRTUALKEYBOARD_KEYMAP_MAXROWS];
+
+    /**
+     * Minimum width of the keys of each row
+     */
+    int mti_rowKeyWidths[VIRTUALKEYBOARD_KEYMAP_MAXROWS];
+
+    /**
+     * Number of principal keys in each layer
+     */
+    int mi_keyCount;
+
+    /**
+     * Offsets of the keys in the pool, (mi_keyCount + 1) per layer
+     */
+    const quint32 *mpi_offsets;
+
+    /**
+     * Pool of the UTF-16 labels
+     */
+    const QChar *mpo_pool;
+
+
+    // Public Functions
+public:
+
+    /**
+     * \brief Destructor
+     */
+    ~VirtualKeyboardKeymap();
+
+    /**
+     * \brief Get the keymap of a language, loading it on first use
+     *
+     * The built-in keymaps are returned without allocation. The other keymaps are looked up in the search paths (searchPaths()),
+     * as "<s_language>.vkmc" (memory-mapped) then "<s_language>.vkm" (compiled in memory).
+     * This function is thread-safe.
+     *
+     * \param[in] s_language : Language of the keymap (for example "EN", "FR")
+     * \return Keymap shared by the whole process, NULL if the language is unknown or its keymap invalid
+     */
+    static const VirtualKeyboardKeymap *find(const QString &s_language);
+
+    /**
+     * \brief Get the keymap of a language if it is already loaded, without loading it
+     *
+     * Never waits for a keymap being loaded by another thread. This function is thread-safe.
+     *
+     * \param[in] s_language : Language of the keymap
+     * \return Keymap shared by the whole process, NULL if it is not loaded (yet), or if the language is unknown
+     */
+    static const VirtualKeyboardKeymap *findLoaded(const QString &s_language);
+
+    /**
+     * \brief Get the directories in which the keymaps are looked up, in order :
+     *      \li the directories added with addSearchPath
+     *      \li the directories listed in the VIRTUALKEYBOARD_KEYMAP_PATH environment variable
+     *      \li the "keymaps" directory next to the application
+     *      \li the ":/keymaps" resources (keymaps embedded by the application)
+     * \return List of directories
+     */
+    static QStringList searchPaths();
+
+    /**
+     * \brief Add a directory in which the keymaps are looked up, before the default ones
+     * \param[in] s_path : Directory
+     */
+    static void addSearchPath(const QString &s_path);
+
+    /**
+     * \brief Compile a source keymap
+     * \param[in] s_source : Source keymap
+     * \param[out] pba_compiled : Compiled keymap
+     * \param[out] ps_error : Error message if the compilation fails (optional)
+     * \return True if the source has been compiled
+     */
+    static bool compile(const QString &s_source, QByteArray *pba_compiled, QString *ps_error = NULL);
+
+    /**
+     * \brief Get the number of rows of principal keys
+     * \return Number of rows, in [1, VIRTUALKEYBOARD_KEYMAP_MAXROWS]
+     */
+    int rowCount() const;
+
+    /**
+     * \brief Get the number of principal keys of a row
+     * \param[in] i_row : Row, in [0, rowCount()[
+     * \return Number of keys
+     */
+    int rowKeyCount(int i_row) const;
+
+    /**
+     * \brief Get the minimum width of the principal keys of a row
+     * \param[in] i_row : Row, in [0, rowCount()[
+     * \return Minimum width of the keys
+     */
+    int rowKeyWidth(int i_row) const;
+
+    /**
+     * \brief Get the number of principal keys of each layer
+     * \return Number of keys
+     */
+    int keyCount() const;
+
+    /**
+     * \brief Check if there is no key at a position of a layer
+     * \param[in] i_layer : VIRTUALKEYBOARD_LAYER_*
+     * \param[in] i_indexKey : Index of the key
+     * \return True if there is no key (or if the index is out of range)
+     */
+    bool isKeyEmpty(int i_layer, int i_indexKey) const;
+
+    /**
+     * \brief Get the label of a key, without copy (the string points in the keymap)
+     * \param[in] i_layer : VIRTUALKEYBOARD_LAYER_*
+     * \param[in] i_indexKey : Index of the key
+     * \return Label of the key, empty if there is no key
+     */
+    QString keyText(int i_layer, int i_indexKey) const;
+
+
+    // Private Functions
+private:
+
+    /**
+     * \brief Constructor, use find() to get a keymap
+     */
+    VirtualKeyboardKeymap();
+
+    /**
+     * \brief Constructor of a view over a compiled keymap which stays valid (built-in keymaps)
+     * \param[in] pc_data : Compiled keymap
+     * \param[in] i_size : Size of the compiled keymap
+     */
+    VirtualKeyboardKeymap(const uchar *pc_data, qint64 i_size);
+
+    /**
+     * \brief Get a built-in keymap
+     * \param[in] s_language : Language of the keymap
+     * \return Keymap, NULL if the language has no built-in keymap
+     */
+    static const VirtualKeyboardKeymap *builtin(const QString &s_language);
+
+    /**
+     * \brief Load a keymap file : memory-mapped if possible, else read, compiled first if it is a source keymap
+     * \param[in] s_fileName : File to load
+     * \return Keymap, NULL if the file can not be read or is invalid
+     */
+    static VirtualKeyboardKeymap *load(const QString &s_fileName);
+
+    /**
+     * \brief Check a compiled keymap and set the pointers of the view
+     * \param[in] pc_data : Compiled keymap
+     * \param[in] i_size : Size of the compiled keymap
+     * \return True if the compiled keymap is valid
+     */
+    bool attach(const uchar *pc_data, qint64 i_size);
+};
+
+#endif // VIRTUALKEYBOARDKEYMAP_H
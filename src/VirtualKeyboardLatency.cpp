@@ -0,0 +1,116 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+#include "VirtualKeyboardLatency.h"
+
+#include <QtAlgorithms>
+#include <cstring>
+
+
+
+VirtualKeyboardLatencyHistogram::VirtualKeyboardLatencyHistogram()
+{
+    this->reset();
+}
+
+
+void VirtualKeyboardLatencyHistogram::addSample(qint64 i_microseconds)
+{
+    if (i_microseconds < 0) i_microseconds = 0;
+
+    ++this->mti_buckets[bucketIndex(quint64(i_microseconds))];
+    ++this->mi_count;
+    if (i_microseconds > this->mi_max) this->mi_max = i_microseconds;
+}
+
+
+void VirtualKeyboardLatencyHistogram::reset()
+{
+    std::memset(this->mti_buckets, 0, sizeof(this->mti_buckets));
+    this->mi_count = 0;
+    this->mi_max = 0;
+}
+
+
+qint64 VirtualKeyboardLatencyHistogram::percentile(qreal r_percentile) const
+{
+    if (this->mi_count == 0) return 0;
+
+    // Rank of the sample wanted (1 based)
+    quint64 i_rank = quint64(r_percentile / 100.0 * this->mi_count + 0.5);
+    if (i_rank < 1) i_rank = 1;
+    if (i_rank > this->mi_count) i_rank = this->mi_count;
+
+    quint64 i_cumulated = 0;
+
+    for (int i_i = 0; i_i < VIRTUALKEYBOARDLATENCY_BUCKETCOUNT; ++i_i)
+    {
+        i_cumulated += this->mti_buckets[i_i];
+
+        // The bucket bound can not be higher than the real maximum
+        if (i_cumulated >= i_rank) return qMin(bucketUpperBound(i_i), this->mi_max);
+    }
+    return this->mi_max;
+}
+
+
+VirtualKeyboardLatencyStatistics VirtualKeyboardLatencyHistogram::statistics() const
+{
+    VirtualKeyboardLatencyStatistics o_statistics;
+
+    o_statistics.i_count = this->mi_count;
+    o_statistics.i_p50 = this->percentile(50);
+    o_statistics.i_p95 = this->percentile(95);
+    o_statistics.i_p99 = this->percentile(99);
+    o_statistics.i_max = this->mi_max;
+
+    return o_statistics;
+}
+
+
+int VirtualKeyboardLatencyHistogram::bucketIndex(quint64 i_value)
+{
+    // Values below 8 have their own bucket
+    if (i_value < 8) return int(i_value);
+
+    // Values above the last bucket are counted in the last bucket
+    if (i_value >= (Q_UINT64_C(1) << 32)) return VIRTUALKEYBOARDLATENCY_BUCKETCOUNT - 1;
+
+    // 8 sub-buckets for each power of two : the 3 bits following the most significant bit
+    const int i_shift = (63 - int(qCountLeadingZeroBits(i_value))) - 3;
+
+    return (i_shift + 1) * 8 + int((i_value >> i_shift) & 7);
+}
+
+
+qint64 VirtualKeyboardLatencyHistogram::bucketUpperBound(int i_index)
+{
+    if (i_index < 8) return i_index;
+
+    const int i_shift = i_index / 8 - 1;
+    const qint64 i_mantissa = 8 + i_index % 8;
+
+    return ((i_mantissa + 1) << i_shift) - 1;
+}
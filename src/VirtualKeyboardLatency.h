@@ -0,0 +1,168 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+#ifndef VIRTUALKEYBOARDLATENCY_H
+#define VIRTUALKEYBOARDLATENCY_H
+
+#include <QtGlobal>
+
+
+// Number of buckets of a latency histogram (8 linear sub-buckets per power of two, up to 2^32 us)
+#define VIRTUALKEYBOARDLATENCY_BUCKETCOUNT  240
+
+
+/**
+ * \brief Summary of a latency histogram, values in microseconds
+ */
+struct VirtualKeyboardLatencyStatistics
+{
+    /**
+     * Number of samples
+     */
+    quint64 i_count;
+
+    /**
+     * Median
+     */
+    qint64 i_p50;
+
+    /**
+     * 95th percentile
+     */
+    qint64 i_p95;
+
+    /**
+     * 99th percentile
+     */
+    qint64 i_p99;
+
+    /**
+     * Maximum
+     */
+    qint64 i_max;
+};
+
+
+/**
+ * \brief Key dispatched whose commit has not been measured yet
+ */
+struct VirtualKeyboardLatencyPendingKey
+{
+    /**
+     * Input type of the key (VIRTUALKEYBOARD_LATENCY_* input type)
+     */
+    int i_type;
+
+    /**
+     * Press time, in nanoseconds on the clock of the keyboard
+     */
+    qint64 i_pressTime;
+
+    /**
+     * Press => dispatch latency, in microseconds
+     */
+    qint64 i_pressToDispatch;
+};
+
+
+/**
+ * \brief Low-overhead latency histogram
+ *
+ * Samples are counted in logarithmic buckets (8 linear sub-buckets per power of two, so at most 12.5% of error on the percentiles) :
+ * adding a sample is a few integer operations, the memory used is fixed and does not depend on the number of samples.
+ */
+class VirtualKeyboardLatencyHistogram
+{
+    // Private Members
+private:
+
+    /**
+     * Number of samples in each bucket
+     */
+    quint32 mti_buckets[VIRTUALKEYBOARDLATENCY_BUCKETCOUNT];
+
+    /**
+     * Total number of samples
+     */
+    quint64 mi_count;
+
+    /**
+     * Highest sample, exact value
+     */
+    qint64 mi_max;
+
+
+    // Public Functions
+public:
+
+    /**
+     * \brief Constructor
+     */
+    VirtualKeyboardLatencyHistogram();
+
+    /**
+     * \brief Add a sample
+     * \param[in] i_microseconds : Latency, in microseconds
+     */
+    void addSample(qint64 i_microseconds);
+
+    /**
+     * \brief Remove every sample
+     */
+    void reset();
+
+    /**
+     * \brief Get a percentile
+     * \param[in] r_percentile : Percentile wanted, in [0, 100]
+     * \return Upper bound of the bucket containing the percentile, in microseconds (0 if there is no sample)
+     */
+    qint64 percentile(qreal r_percentile) const;
+
+    /**
+     * \brief Get the summary of the histogram
+     * \return Number of samples, p50, p95, p99 and maximum
+     */
+    VirtualKeyboardLatencyStatistics statistics() const;
+
+
+    // Private Functions
+private:
+
+    /**
+     * \brief Get the bucket of a value
+     * \param[in] i_value : Value, in microseconds
+     * \return Index of the bucket
+     */
+    static int bucketIndex(quint64 i_value);
+
+    /**
+     * \brief Get the highest value of a bucket
+     * \param[in] i_index : Index of the bucket
+     * \return Highest value counted in the bucket, in microseconds
+     */
+    static qint64 bucketUpperBound(int i_index);
+};
+
+#endif // VIRTUALKEYBOARDLATENCY_H
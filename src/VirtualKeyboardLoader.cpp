@@ -0,0 +1,95 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+#include "VirtualKeyboardLoader.h"
+
+#include <QGlobalStatic>
+#include <QMetaObject>
+#include <QThread>
+
+#include "VirtualKeyboardDictionary.h"
+#include "VirtualKeyboardKeymap.h"
+
+
+/**
+ * \brief Thread of the loader, stopped when the process exits
+ */
+struct VirtualKeyboardLoaderThread
+{
+    QThread o_thread;
+    VirtualKeyboardLoader *po_loader;
+
+    VirtualKeyboardLoaderThread() :
+        po_loader(new VirtualKeyboardLoader)
+    {
+        this->po_loader->moveToThread(&this->o_thread);
+        this->o_thread.start(QThread::LowPriority);
+    }
+
+    ~VirtualKeyboardLoaderThread()
+    {
+        this->o_thread.quit();
+        this->o_thread.wait();
+        delete this->po_loader;
+    }
+};
+Q_GLOBAL_STATIC(VirtualKeyboardLoaderThread, st_loaderThread)
+
+
+
+VirtualKeyboardLoader::VirtualKeyboardLoader(QObject *o_parent) :
+    QObject(o_parent)
+{
+}
+
+
+VirtualKeyboardLoader *VirtualKeyboardLoader::instance()
+{
+    return st_loaderThread()->po_loader;
+}
+
+
+void VirtualKeyboardLoader::loadKeymap(const QString &s_language)
+{
+    QMetaObject::invokeMethod(this, "findKeymap", Qt::QueuedConnection, Q_ARG(QString, s_language));
+}
+
+
+void VirtualKeyboardLoader::loadDictionary(const QString &s_fileName)
+{
+    QMetaObject::invokeMethod(this, "findDictionary", Qt::QueuedConnection, Q_ARG(QString, s_fileName));
+}
+
+
+void VirtualKeyboardLoader::findKeymap(const QString &s_language)
+{
+    emit this->keymapLoaded(s_language, VirtualKeyboardKeymap::find(s_language) != NULL);
+}
+
+
+void VirtualKeyboardLoader::findDictionary(const QString &s_fileName)
+{
+    emit this->dictionaryLoaded(s_fileName, VirtualKeyboardDictionary::find(s_fileName) != NULL);
+}
@@ -0,0 +1,113 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+#ifndef VIRTUALKEYBOARDLOADER_H
+#define VIRTUALKEYBOARDLOADER_H
+
+#include <QObject>
+#include <QString>
+
+
+/**
+ * \brief Loader of the keymaps and dictionaries in a background thread, shared by every keyboard of the process
+ *
+ * A load request returns at once : the file is read (and compiled if it is a source) by find() in the loader thread, then
+ * keymapLoaded or dictionaryLoaded is emitted. The keymap or dictionary is in its registry by then : find() or findLoaded()
+ * returns it without waiting. The requests are processed in order, one at a time, the thread runs with a low priority.
+ */
+class VirtualKeyboardLoader : public QObject
+{
+    Q_OBJECT
+
+    friend struct VirtualKeyboardLoaderThread;
+
+
+    // Public Functions
+public:
+
+    /**
+     * \brief Get the loader of the process, its thread is started on first use and stopped when the process exits
+     * \return Loader
+     */
+    static VirtualKeyboardLoader *instance();
+
+    /**
+     * \brief Request the load of a keymap, from any thread
+     * \param[in] s_language : Language of the keymap (see VirtualKeyboardKeymap::find())
+     */
+    void loadKeymap(const QString &s_language);
+
+    /**
+     * \brief Request the load of a dictionary, from any thread
+     * \param[in] s_fileName : Dictionary file (see VirtualKeyboardDictionary::find())
+     */
+    void loadDictionary(const QString &s_fileName);
+
+
+    // Private Functions
+private:
+
+    /**
+     * \brief Constructor, use instance() to get the loader
+     * \param o_parent : parent Object (default 0, the loader is moved to its thread)
+     */
+    explicit VirtualKeyboardLoader(QObject *o_parent = 0);
+
+
+    // Signals
+signals:
+
+    /**
+     * \brief Signal emitted (in the loader thread) when a keymap has been loaded
+     * \param[in] s_language : Language requested
+     * \param[in] b_isFound : False if the language is unknown or its keymap invalid
+     */
+    void keymapLoaded(const QString &s_language, bool b_isFound);
+
+    /**
+     * \brief Signal emitted (in the loader thread) when a dictionary has been loaded
+     * \param[in] s_fileName : File requested
+     * \param[in] b_isFound : False if the file can not be read or is invalid
+     */
+    void dictionaryLoaded(const QString &s_fileName, bool b_isFound);
+
+
+    // Private Slots
+private slots:
+
+    /**
+     * \brief Load a keymap, in the loader thread
+     * \param[in] s_language : Language of the keymap
+     */
+    void findKeymap(const QString &s_language);
+
+    /**
+     * \brief Load a dictionary, in the loader thread
+     * \param[in] s_fileName : Dictionary file
+     */
+    void findDictionary(const QString &s_fileName);
+};
+
+#endif // VIRTUALKEYBOARDLOADER_H
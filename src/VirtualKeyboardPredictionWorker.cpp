@@ -0,0 +1,169 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+#include "VirtualKeyboardPredictionWorker.h"
+
+#include <QMetaObject>
+
+
+
+VirtualKeyboardPredictionWorker::VirtualKeyboardPredictionWorker(int i_suggestionCount, QObject *o_parent) :
+    QObject(o_parent),
+    mi_isDrainPending(0),
+    mpo_dictionary(NULL),
+    mi_suggestionCount(i_suggestionCount)
+{
+}
+
+
+void VirtualKeyboardPredictionWorker::setDictionary(const VirtualKeyboardDictionary *po_dictionary)
+{
+    this->mpo_dictionary.storeRelease(po_dictionary);
+}
+
+
+bool VirtualKeyboardPredictionWorker::post(const VirtualKeyboardPredictionEvent &o_event)
+{
+    if (!this->mo_queue.push(o_event)) return false;
+
+    // A single drain() posted at a time : the events pushed before it starts are applied by it
+    if (this->mi_isDrainPending.testAndSetOrdered(0, 1))
+        QMetaObject::invokeMethod(this, "drain", Qt::QueuedConnection);
+
+    return true;
+}
+
+
+void VirtualKeyboardPredictionWorker::applyEvent(QString &s_word, const VirtualKeyboardPredictionEvent &o_event)
+{
+    switch (o_event.i_type)
+    {
+    case VIRTUALKEYBOARD_PREDICTIONEVENT_TEXT:
+    {
+        int i_start = o_event.s_text.size();
+        while (i_start > 0 && VirtualKeyboardPredictionWorker::isWordCharacter(o_event.s_text.at(i_start - 1))) --i_start;
+
+        // A separator in the text starts a new word
+        if (i_start > 0) s_word = o_event.s_text.mid(i_start);
+        else s_word += o_event.s_text;
+        break;
+    }
+    case VIRTUALKEYBOARD_PREDICTIONEVENT_BACKSPACE:
+        s_word.chop(1);
+        break;
+    case VIRTUALKEYBOARD_PREDICTIONEVENT_RESET:
+        s_word = o_event.s_text;
+        break;
+    default:
+        break;
+    }
+
+    // Same bound as the word read before the cursor : longer words have no completion
+    if (s_word.size() > VIRTUALKEYBOARD_PREDICTION_MAXIMUMWORDLENGTH + 1)
+        s_word = s_word.right(VIRTUALKEYBOARD_PREDICTION_MAXIMUMWORDLENGTH + 1);
+}
+
+
+bool VirtualKeyboardPredictionWorker::isWordCharacter(const QChar &o_char)
+{
+    return o_char.isLetterOrNumber() || o_char == QLatin1Char('\'');
+}
+
+
+QStringList VirtualKeyboardPredictionWorker::completions(const VirtualKeyboardDictionary *po_dictionary, const QString &s_word, int i_count)
+{
+    if (po_dictionary == NULL || s_word.isEmpty() || s_word.size() > VIRTUALKEYBOARD_PREDICTION_MAXIMUMWORDLENGTH) return QStringList();
+
+    QStringList lists_completions = po_dictionary->completions(s_word, i_count);
+
+    // Capitalised word (start of a sentence) : the completions of the lowercase word, capitalised
+    if (lists_completions.size() < i_count && s_word.at(0).isUpper())
+    {
+        QString s_lowercaseWord = s_word;
+        s_lowercaseWord[0] = s_word.at(0).toLower();
+
+        foreach (QString s_completion, po_dictionary->completions(s_lowercaseWord, i_count))
+        {
+            s_completion[0] = s_word.at(0);
+            if (lists_completions.size() < i_count && !lists_completions.contains(s_completion))
+                lists_completions.append(s_completion);
+        }
+    }
+
+    return lists_completions;
+}
+
+
+void VirtualKeyboardPredictionWorker::drain()
+{
+    // Cleared first : an event pushed from now on posts another drain()
+    this->mi_isDrainPending.storeRelease(0);
+
+    VirtualKeyboardPredictionEvent o_event;
+    VirtualKeyboardPredictionEvent o_correction;
+    VirtualKeyboardPredictionEvent o_gesture;
+    int i_sequence = 0;
+    bool b_hasEvent = false;
+    bool b_hasCorrection = false;
+    bool b_hasGesture = false;
+
+    while (this->mo_queue.pop(o_event))
+    {
+        switch (o_event.i_type)
+        {
+        case VIRTUALKEYBOARD_PREDICTIONEVENT_KEYS:
+            this->mo_tapModel.setKeys(o_event.s_text, o_event.veco_rects);
+            this->mo_gestureDecoder.setKeys(o_event.s_text, o_event.veco_rects);
+            break;
+        case VIRTUALKEYBOARD_PREDICTIONEVENT_CORRECTION:
+            // Only the last word (the last path) : the keyboard drops the answers to the previous ones
+            o_correction = o_event;
+            b_hasCorrection = true;
+            break;
+        case VIRTUALKEYBOARD_PREDICTIONEVENT_GESTURE:
+            o_gesture = o_event;
+            b_hasGesture = true;
+            break;
+        default:
+            VirtualKeyboardPredictionWorker::applyEvent(this->ms_word, o_event);
+            i_sequence = o_event.i_sequence;
+            b_hasEvent = true;
+            break;
+        }
+    }
+
+    const VirtualKeyboardDictionary *po_dictionary = this->mpo_dictionary.loadAcquire();
+
+    if (b_hasCorrection)
+        emit this->correctionReady(o_correction.i_sequence, o_correction.s_text,
+                                   this->mo_tapModel.correct(o_correction.veco_points, o_correction.s_text, po_dictionary));
+
+    if (b_hasGesture)
+        emit this->gestureReady(o_gesture.i_sequence, this->mo_gestureDecoder.decode(o_gesture.veco_points, po_dictionary, this->mi_suggestionCount));
+
+    // One lookup for all the events applied
+    if (b_hasEvent)
+        emit this->suggestionsReady(i_sequence, VirtualKeyboardPredictionWorker::completions(po_dictionary, this->ms_word, this->mi_suggestionCount));
+}
@@ -0,0 +1,238 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+#ifndef VIRTUALKEYBOARDPREDICTIONWORKER_H
+#define VIRTUALKEYBOARDPREDICTIONWORKER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QPointF>
+#include <QRectF>
+#include <QAtomicInt>
+#include <QAtomicPointer>
+
+#include "VirtualKeyboardDictionary.h"
+#include "VirtualKeyboardRingBuffer.h"
+#include "VirtualKeyboardTapModel.h"
+#include "VirtualKeyboardGestureDecoder.h"
+
+
+// Types of prediction events
+#define VIRTUALKEYBOARD_PREDICTIONEVENT_TEXT        0
+#define VIRTUALKEYBOARD_PREDICTIONEVENT_BACKSPACE   1
+#define VIRTUALKEYBOARD_PREDICTIONEVENT_RESET       2
+#define VIRTUALKEYBOARD_PREDICTIONEVENT_KEYS        3
+#define VIRTUALKEYBOARD_PREDICTIONEVENT_CORRECTION  4
+#define VIRTUALKEYBOARD_PREDICTIONEVENT_GESTURE     5
+
+// Length from which a word is not completed anymore
+#define VIRTUALKEYBOARD_PREDICTION_MAXIMUMWORDLENGTH 48
+
+// Capacity of the queue of events of a worker (one slot is kept empty)
+#define VIRTUALKEYBOARDPREDICTIONWORKER_QUEUESIZE   256
+
+
+/**
+ * \brief Change of the word before the cursor, sent by the keyboard to its prediction worker
+ */
+struct VirtualKeyboardPredictionEvent
+{
+    /**
+     * VIRTUALKEYBOARD_PREDICTIONEVENT_*
+     */
+    int i_type;
+
+    /**
+     * Sequence number given by the keyboard, sent back with the suggestions computed after the event (or with the correction, the words decoded)
+     */
+    int i_sequence;
+
+    /**
+     * Text committed (VIRTUALKEYBOARD_PREDICTIONEVENT_TEXT), new word (VIRTUALKEYBOARD_PREDICTIONEVENT_RESET), characters of the keys
+     * (VIRTUALKEYBOARD_PREDICTIONEVENT_KEYS) or word typed (VIRTUALKEYBOARD_PREDICTIONEVENT_CORRECTION)
+     */
+    QString s_text;
+
+    /**
+     * Position of the tap of each character of the word typed (VIRTUALKEYBOARD_PREDICTIONEVENT_CORRECTION),
+     * or points of the path traced (VIRTUALKEYBOARD_PREDICTIONEVENT_GESTURE)
+     */
+    QVector<QPointF> veco_points;
+
+    /**
+     * Rectangle of each key (VIRTUALKEYBOARD_PREDICTIONEVENT_KEYS)
+     */
+    QVector<QRectF> veco_rects;
+};
+
+
+/**
+ * \brief Word prediction of a keyboard, run in a thread of its own
+ *
+ * The keyboard (GUI thread) posts an event for each key committed, in a lock-free single-producer / single-consumer queue :
+ * posting costs a copy in the queue, the GUI thread never waits for a lookup. The worker keeps its own copy of the word
+ * before the cursor, updated by the events. Each time it wakes up it applies every event queued, then looks up the completions
+ * of the resulting word once : when the keys come faster than the lookups, the intermediate words are skipped.
+ * The suggestions are sent back by suggestionsReady with the sequence number of the last event applied, the keyboard drops
+ * the ones which are not the answer to its last event.
+ *
+ * The tap correction of the words finished and the decoding of the gesture typing run in the same thread : the keyboard posts the
+ * keys displayed when they change (VIRTUALKEYBOARD_PREDICTIONEVENT_KEYS), the taps of each word finished
+ * (VIRTUALKEYBOARD_PREDICTIONEVENT_CORRECTION) and each path traced (VIRTUALKEYBOARD_PREDICTIONEVENT_GESTURE). Only the last word
+ * and the last path queued are processed, correctionReady and gestureReady send them back with their own sequence numbers.
+ */
+class VirtualKeyboardPredictionWorker : public QObject
+{
+    Q_OBJECT
+
+
+    // Private Members
+private:
+
+    /**
+     * Events posted by the keyboard, not applied yet
+     */
+    VirtualKeyboardRingBuffer<VirtualKeyboardPredictionEvent, VIRTUALKEYBOARDPREDICTIONWORKER_QUEUESIZE> mo_queue;
+
+    /**
+     * 1 while a call of drain() is posted to the worker thread and has not started yet
+     */
+    QAtomicInt mi_isDrainPending;
+
+    /**
+     * Dictionary of the lookups (NULL => no suggestions)
+     */
+    QAtomicPointer<const VirtualKeyboardDictionary> mpo_dictionary;
+
+    /**
+     * Maximum number of suggestions
+     */
+    int mi_suggestionCount;
+
+    /**
+     * Word before the cursor, as known from the events applied (worker thread only)
+     */
+    QString ms_word;
+
+    /**
+     * Spatial model of the taps, over the keys of the last VIRTUALKEYBOARD_PREDICTIONEVENT_KEYS event (worker thread only)
+     */
+    VirtualKeyboardTapModel mo_tapModel;
+
+    /**
+     * Decoder of the paths traced, over the keys of the last VIRTUALKEYBOARD_PREDICTIONEVENT_KEYS event (worker thread only)
+     */
+    VirtualKeyboardGestureDecoder mo_gestureDecoder;
+
+
+    // Public Functions
+public:
+
+    /**
+     * \brief Constructor
+     * \param[in] i_suggestionCount : Maximum number of suggestions
+     * \param o_parent : parent Object (default 0, the worker is moved to its thread)
+     */
+    explicit VirtualKeyboardPredictionWorker(int i_suggestionCount, QObject *o_parent = 0);
+
+    /**
+     * \brief Set the dictionary of the next lookups, from any thread
+     * \param[in] po_dictionary : Dictionary, NULL => no suggestions
+     */
+    void setDictionary(const VirtualKeyboardDictionary *po_dictionary);
+
+    /**
+     * \brief Post an event to the worker, from the thread of the keyboard (the single producer)
+     * \param[in] o_event : Event
+     * \return False if the queue is full (the event is dropped), else True
+     */
+    bool post(const VirtualKeyboardPredictionEvent &o_event);
+
+    /**
+     * \brief Apply an event to a word : the text is appended and only its last word kept, a backspace removes the last character
+     *
+     * Used by the worker on its copy of the word, and by the keyboard to know the word the worker will have
+     *
+     * \param[in,out] s_word : Word
+     * \param[in] o_event : Event
+     */
+    static void applyEvent(QString &s_word, const VirtualKeyboardPredictionEvent &o_event);
+
+    /**
+     * \brief Check if a character is part of the words completed
+     * \param[in] o_char : Character
+     * \return True for the letters, the digits and the apostrophe
+     */
+    static bool isWordCharacter(const QChar &o_char);
+
+    /**
+     * \brief Look up the completions of a word, the capitalised words are completed by the lowercase words too
+     * \param[in] po_dictionary : Dictionary
+     * \param[in] s_word : Word
+     * \param[in] i_count : Maximum number of completions
+     * \return Completions, most frequent first
+     */
+    static QStringList completions(const VirtualKeyboardDictionary *po_dictionary, const QString &s_word, int i_count);
+
+
+    // Signals
+signals:
+
+    /**
+     * \brief Signal emitted (in the worker thread) with the suggestions of the word after the events applied
+     * \param[in] i_sequence : Sequence number of the last event applied
+     * \param[in] lists_suggestions : Words, most frequent first
+     */
+    void suggestionsReady(int i_sequence, const QStringList &lists_suggestions);
+
+    /**
+     * \brief Signal emitted (in the worker thread) with the tap correction of the last word posted
+     * \param[in] i_sequence : Sequence number of the VIRTUALKEYBOARD_PREDICTIONEVENT_CORRECTION event
+     * \param[in] s_word : Word typed
+     * \param[in] s_correction : Correction, empty if the word typed is the best candidate
+     */
+    void correctionReady(int i_sequence, const QString &s_word, const QString &s_correction);
+
+    /**
+     * \brief Signal emitted (in the worker thread) with the words decoded from the last path posted
+     * \param[in] i_sequence : Sequence number of the VIRTUALKEYBOARD_PREDICTIONEVENT_GESTURE event
+     * \param[in] lists_words : Words the path may trace, best first, empty if no word matches the path
+     */
+    void gestureReady(int i_sequence, const QStringList &lists_words);
+
+
+    // Private Slots
+private slots:
+
+    /**
+     * \brief Apply the events queued then look up the completions of the word, correct the last word posted and decode the last path
+     *      posted, in the worker thread
+     */
+    void drain();
+};
+
+#endif // VIRTUALKEYBOARDPREDICTIONWORKER_H
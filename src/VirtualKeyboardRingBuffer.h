@@ -0,0 +1,118 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+#ifndef VIRTUALKEYBOARDRINGBUFFER_H
+#define VIRTUALKEYBOARDRINGBUFFER_H
+
+#include <QAtomicInt>
+
+
+// Size of a cache line : the indexes written by the two threads are kept on different lines
+#define VIRTUALKEYBOARDRINGBUFFER_CACHELINESIZE 64
+
+
+/**
+ * \brief Lock-free single-producer / single-consumer queue of fixed capacity
+ *
+ * One thread pushes, one other thread pops : each index is written by a single thread, and published to the other one with
+ * release / acquire ordering. Neither push() nor pop() locks or allocates (apart from copying T).
+ * The queue holds i_capacity - 1 elements, i_capacity must be a power of two.
+ */
+template <class T, int i_capacity>
+class VirtualKeyboardRingBuffer
+{
+    Q_STATIC_ASSERT(i_capacity >= 2 && (i_capacity & (i_capacity - 1)) == 0);
+
+
+    // Private Members
+private:
+
+    /**
+     * Index of the next element popped, written by the consumer
+     */
+    Q_DECL_ALIGN(VIRTUALKEYBOARDRINGBUFFER_CACHELINESIZE) QAtomicInt mi_head;
+
+    /**
+     * Index of the next element pushed, written by the producer
+     */
+    Q_DECL_ALIGN(VIRTUALKEYBOARDRINGBUFFER_CACHELINESIZE) QAtomicInt mi_tail;
+
+    /**
+     * Elements
+     */
+    Q_DECL_ALIGN(VIRTUALKEYBOARDRINGBUFFER_CACHELINESIZE) T mto_slots[i_capacity];
+
+
+    // Public Functions
+public:
+
+    /**
+     * \brief Constructor of an empty queue
+     */
+    VirtualKeyboardRingBuffer() : mi_head(0), mi_tail(0) {}
+
+    /**
+     * \brief Append an element, from the producer thread
+     * \param[in] o_element : Element
+     * \return False if the queue is full (the element is not appended), else True
+     */
+    bool push(const T &o_element)
+    {
+        const int i_tail = this->mi_tail.load();
+        const int i_next = (i_tail + 1) & (i_capacity - 1);
+
+        if (i_next == this->mi_head.loadAcquire()) return false;
+
+        this->mto_slots[i_tail] = o_element;
+        this->mi_tail.storeRelease(i_next);
+        return true;
+    }
+
+    /**
+     * \brief Take the oldest element, from the consumer thread
+     * \param[out] o_element : Element
+     * \return False if the queue is empty, else True
+     */
+    bool pop(T &o_element)
+    {
+        const int i_head = this->mi_head.load();
+
+        if (i_head == this->mi_tail.loadAcquire()) return false;
+
+        // The slot is emptied by the consumer : what it holds is released here, not by the next push
+        o_element = this->mto_slots[i_head];
+        this->mto_slots[i_head] = T();
+        this->mi_head.storeRelease((i_head + 1) & (i_capacity - 1));
+        return true;
+    }
+
+
+    // Private Functions
+private:
+
+    Q_DISABLE_COPY(VirtualKeyboardRingBuffer)
+};
+
+#endif // VIRTUALKEYBOARDRINGBUFFER_H
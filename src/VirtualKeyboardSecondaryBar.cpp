@@ -0,0 +1,271 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+
+#include "VirtualKeyboardSecondaryBar.h"
+
+#include <QPainter>
+#include <QPaintEvent>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <QScroller>
+#include <QScrollPrepareEvent>
+#include <QScrollEvent>
+#include <qmath.h>
+
+
+// Distance between the tops of two consecutive keys
+#define VIRTUALKEYBOARDSECONDARYBAR_PITCH (VIRTUALKEYBOARDSECONDARYBAR_KEYHEIGHT + VIRTUALKEYBOARDSECONDARYBAR_SPACING)
+
+
+
+VirtualKeyboardSecondaryBar::VirtualKeyboardSecondaryBar(QWidget *w_parent) :
+    QWidget(w_parent),
+    mr_scrollOffset(0),
+    mi_pressedPosition(-1)
+{
+    this->setFocusPolicy(Qt::NoFocus);
+    this->setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Expanding);
+
+    // Kinetic scrolling with the mouse and the touch screens : the press is delivered at once, a key is not clicked once it scrolls
+    QScroller::grabGesture(this, QScroller::LeftMouseButtonGesture);
+
+    QScrollerProperties o_properties = QScroller::scroller(this)->scrollerProperties();
+    o_properties.setScrollMetric(QScrollerProperties::MousePressEventDelay, 0);
+    QScroller::scroller(this)->setScrollerProperties(o_properties);
+}
+
+
+bool VirtualKeyboardSecondaryBar::addKey(const QString &s_keyText, int i_indexMapping)
+{
+    if (this->mmaps_keys.contains(i_indexMapping)) return false;
+
+    this->mmaps_keys.insert(i_indexMapping, s_keyText);
+    this->mveci_order.append(i_indexMapping);
+
+    // Only the new key may be visible
+    this->update(this->keyRect(this->mveci_order.size() - 1).toAlignedRect());
+    return true;
+}
+
+
+bool VirtualKeyboardSecondaryBar::removeKey(int i_indexMapping)
+{
+    if (this->mmaps_keys.remove(i_indexMapping) == 0) return false;
+
+    const int i_position = this->mveci_order.indexOf(i_indexMapping);
+    this->mveci_order.remove(i_position);
+
+    if (this->mi_pressedPosition == i_position)     this->mi_pressedPosition = -1;
+    else if (this->mi_pressedPosition > i_position) --this->mi_pressedPosition;
+
+    this->setScrollOffset(this->mr_scrollOffset);
+    this->update();
+    return true;
+}
+
+
+void VirtualKeyboardSecondaryBar::setKeys(const QMap<int, QString> &maps_keys)
+{
+    this->mmaps_keys = maps_keys;
+    this->mveci_order = maps_keys.keys().toVector();
+    this->mi_pressedPosition = -1;
+
+    this->setScrollOffset(this->mr_scrollOffset);
+    this->update();
+}
+
+
+bool VirtualKeyboardSecondaryBar::containsKey(int i_indexMapping) const
+{
+    return this->mmaps_keys.contains(i_indexMapping);
+}
+
+
+int VirtualKeyboardSecondaryBar::keyCount() const
+{
+    return this->mveci_order.size();
+}
+
+
+QSize VirtualKeyboardSecondaryBar::minimumSizeHint() const
+{
+    return QSize(70, VIRTUALKEYBOARDSECONDARYBAR_KEYHEIGHT);
+}
+
+
+QSize VirtualKeyboardSecondaryBar::sizeHint() const
+{
+    // The bar does not grow with its keys : it scrolls
+    return QSize(70, 3 * VIRTUALKEYBOARDSECONDARYBAR_PITCH);
+}
+
+
+void VirtualKeyboardSecondaryBar::scrollByPages(int i_pageCount)
+{
+    const qreal r_target = qBound(qreal(0), this->mr_scrollOffset + i_pageCount * this->height(), this->maximumScrollOffset());
+
+    QScroller::scroller(this)->scrollTo(QPointF(0, r_target), VIRTUALKEYBOARDSECONDARYBAR_PAGEDURATION);
+}
+
+
+bool VirtualKeyboardSecondaryBar::event(QEvent *po_event)
+{
+    switch (po_event->type())
+    {
+    case QEvent::ScrollPrepare:
+    {
+        QScrollPrepareEvent *po_prepareEvent = static_cast<QScrollPrepareEvent *>(po_event);
+        po_prepareEvent->setViewportSize(this->size());
+        po_prepareEvent->setContentPosRange(QRectF(0, 0, 0, this->maximumScrollOffset()));
+        po_prepareEvent->setContentPos(QPointF(0, this->mr_scrollOffset));
+        po_prepareEvent->accept();
+        return true;
+    }
+    case QEvent::Scroll:
+    {
+        QScrollEvent *po_scrollEvent = static_cast<QScrollEvent *>(po_event);
+
+        // The press becomes a scroll : no click
+        if (this->mi_pressedPosition >= 0 && po_scrollEvent->contentPos().y() != this->mr_scrollOffset)
+        {
+            this->update(this->keyRect(this->mi_pressedPosition).toAlignedRect());
+            this->mi_pressedPosition = -1;
+        }
+        this->setScrollOffset(po_scrollEvent->contentPos().y());
+        return true;
+    }
+    default:
+        return QWidget::event(po_event);
+    }
+}
+
+
+void VirtualKeyboardSecondaryBar::paintEvent(QPaintEvent *po_event)
+{
+    if (this->mveci_order.isEmpty()) return;
+
+    QPainter o_painter(this);
+    o_painter.setRenderHint(QPainter::Antialiasing);
+
+    const QPalette &o_palette = this->palette();
+    const QRect o_exposedRect = po_event->rect();
+
+    // --- Visible window only
+    const int i_first = qMax(0, qFloor((this->mr_scrollOffset + o_exposedRect.top()) / VIRTUALKEYBOARDSECONDARYBAR_PITCH));
+    const int i_last = qMin(this->mveci_order.size() - 1, qFloor((this->mr_scrollOffset + o_exposedRect.bottom()) / VIRTUALKEYBOARDSECONDARYBAR_PITCH));
+
+    for (int i_position = i_first; i_position <= i_last; ++i_position)
+    {
+        const QRectF o_rect = this->keyRect(i_position);
+
+        // Same drawing as the keys of VirtualKeyboardSurface
+        o_painter.setPen(o_palette.color(QPalette::Dark));
+        o_painter.setBrush(o_palette.color(i_position == this->mi_pressedPosition ? QPalette::Mid : QPalette::Button));
+        o_painter.drawRoundedRect(o_rect.adjusted(0.5, 0.5, -0.5, -0.5), 3, 3);
+
+        o_painter.setPen(o_palette.color(QPalette::ButtonText));
+        o_painter.drawText(o_rect, Qt::AlignCenter | Qt::TextWordWrap, this->mmaps_keys.value(this->mveci_order.at(i_position)));
+    }
+}
+
+
+void VirtualKeyboardSecondaryBar::resizeEvent(QResizeEvent *po_event)
+{
+    Q_UNUSED(po_event)
+
+    this->setScrollOffset(this->mr_scrollOffset);
+}
+
+
+void VirtualKeyboardSecondaryBar::mousePressEvent(QMouseEvent *po_event)
+{
+    if (po_event->button() != Qt::LeftButton) return;
+
+    this->mi_pressedPosition = this->keyPositionAt(po_event->localPos());
+    if (this->mi_pressedPosition >= 0) this->update(this->keyRect(this->mi_pressedPosition).toAlignedRect());
+}
+
+
+void VirtualKeyboardSecondaryBar::mouseReleaseEvent(QMouseEvent *po_event)
+{
+    if (po_event->button() != Qt::LeftButton || this->mi_pressedPosition < 0) return;
+
+    const int i_pressedPosition = this->mi_pressedPosition;
+    this->mi_pressedPosition = -1;
+    this->update(this->keyRect(i_pressedPosition).toAlignedRect());
+
+    if (this->keyPositionAt(po_event->localPos()) == i_pressedPosition)
+        emit this->keyClicked(this->mveci_order.at(i_pressedPosition));
+}
+
+
+void VirtualKeyboardSecondaryBar::wheelEvent(QWheelEvent *po_event)
+{
+    // 120 = one wheel step
+    this->setScrollOffset(this->mr_scrollOffset - po_event->angleDelta().y() * VIRTUALKEYBOARDSECONDARYBAR_PITCH / 120.0);
+    po_event->accept();
+}
+
+
+qreal VirtualKeyboardSecondaryBar::maximumScrollOffset() const
+{
+    const qreal r_contentHeight = this->mveci_order.size() * VIRTUALKEYBOARDSECONDARYBAR_PITCH - VIRTUALKEYBOARDSECONDARYBAR_SPACING;
+
+    return qMax(qreal(0), r_contentHeight - this->height());
+}
+
+
+void VirtualKeyboardSecondaryBar::setScrollOffset(qreal r_scrollOffset)
+{
+    r_scrollOffset = qBound(qreal(0), r_scrollOffset, this->maximumScrollOffset());
+
+    if (r_scrollOffset == this->mr_scrollOffset) return;
+
+    this->mr_scrollOffset = r_scrollOffset;
+    this->update();
+}
+
+
+int VirtualKeyboardSecondaryBar::keyPositionAt(const QPointF &o_point) const
+{
+    if (o_point.x() < 0 || o_point.x() >= this->width()) return -1;
+
+    const qreal r_y = this->mr_scrollOffset + o_point.y();
+    const int i_position = qFloor(r_y / VIRTUALKEYBOARDSECONDARYBAR_PITCH);
+
+    // In the spacing between two keys, or after the last key
+    if (i_position < 0 || i_position >= this->mveci_order.size()
+            || r_y - i_position * VIRTUALKEYBOARDSECONDARYBAR_PITCH >= VIRTUALKEYBOARDSECONDARYBAR_KEYHEIGHT)
+        return -1;
+
+    return i_position;
+}
+
+
+QRectF VirtualKeyboardSecondaryBar::keyRect(int i_position) const
+{
+    return QRectF(0, i_position * VIRTUALKEYBOARDSECONDARYBAR_PITCH - this->mr_scrollOffset, this->width(), VIRTUALKEYBOARDSECONDARYBAR_KEYHEIGHT);
+}
@@ -0,0 +1,211 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+
+#ifndef VIRTUALKEYBOARDSECONDARYBAR_H
+#define VIRTUALKEYBOARDSECONDARYBAR_H
+
+#include <QWidget>
+#include <QMap>
+#include <QVector>
+
+
+// Height of a key and space between two keys of the bar, in pixels (same as the secondary buttons of VirtualKeyboard.ui)
+#define VIRTUALKEYBOARDSECONDARYBAR_KEYHEIGHT   50
+#define VIRTUALKEYBOARDSECONDARYBAR_SPACING     6
+
+// Duration of the scroll animation of a page, in ms
+#define VIRTUALKEYBOARDSECONDARYBAR_PAGEDURATION 250
+
+
+/**
+ * \brief Custom-painted, scrollable column of the secondary keys added programmatically
+ *
+ * Used by VirtualKeyboard in the VIRTUALKEYBOARD_RENDER_PAINTED mode in place of one QPushButton per key : the keys are only data
+ * (a label per mapping index) and all the keys have the same height, so the position of a key is computed, not laid out.
+ * A paintEvent draws the keys of the visible window only : memory, layout and paint costs do not depend on the number of keys.
+ *
+ * The bar scrolls kinetically (QScroller, mouse and touch), with the wheel, and by pages (scrollByPages()).
+ */
+class VirtualKeyboardSecondaryBar : public QWidget
+{
+    Q_OBJECT
+
+
+    // Private Members
+private:
+
+    /**
+     * Label of each key, indexed by mapping index
+     */
+    QMap<int, QString> mmaps_keys;
+
+    /**
+     * Mapping indexes of the keys, in display order
+     */
+    QVector<int> mveci_order;
+
+    /**
+     * Scroll position : distance between the top of the first key and the top of the bar, in pixels
+     */
+    qreal mr_scrollOffset;
+
+    /**
+     * Position in mveci_order of the key on which the press started, -1 if there is no press in progress
+     */
+    int mi_pressedPosition;
+
+
+    // Public Functions
+public:
+
+    /**
+     * \brief Constructor
+     * \param w_parent : parent Widget (default 0)
+     */
+    explicit VirtualKeyboardSecondaryBar(QWidget *w_parent = 0);
+
+    /**
+     * \brief Add a key at the end of the bar
+     * \param[in] s_keyText : Key label
+     * \param[in] i_indexMapping : Mapping index of the key
+     * \return False if the index is already used, else True
+     */
+    bool addKey(const QString &s_keyText, int i_indexMapping);
+
+    /**
+     * \brief Remove a key
+     * \param[in] i_indexMapping : Mapping index of the key
+     * \return False if the index is not used, else True
+     */
+    bool removeKey(int i_indexMapping);
+
+    /**
+     * \brief Replace every key, displayed in the order of their indexes
+     * \param[in] maps_keys : Label of each key, indexed by mapping index
+     */
+    void setKeys(const QMap<int, QString> &maps_keys);
+
+    /**
+     * \brief Check if a key is in the bar
+     * \param[in] i_indexMapping : Mapping index of the key
+     */
+    bool containsKey(int i_indexMapping) const;
+
+    /**
+     * \brief Get the number of keys of the bar
+     */
+    int keyCount() const;
+
+    /**
+     * \brief Get the size needed to display one key
+     */
+    QSize minimumSizeHint() const;
+
+    /**
+     * \brief Get the size of the bar
+     */
+    QSize sizeHint() const;
+
+
+    // Public Slots
+public slots:
+
+    /**
+     * \brief Scroll the bar by pages (height of the bar), animated
+     * \param[in] i_pageCount : Number of pages, negative to scroll up
+     */
+    void scrollByPages(int i_pageCount);
+
+
+    // Protected Functions
+protected:
+
+    /**
+     * \brief Handle the events of the kinetic scrolling (QScrollPrepareEvent, QScrollEvent)
+     */
+    bool event(QEvent *po_event);
+
+    /**
+     * \brief Draw the keys of the visible window
+     */
+    void paintEvent(QPaintEvent *po_event);
+
+    /**
+     * \brief Keep the scroll position in the scroll range
+     */
+    void resizeEvent(QResizeEvent *po_event);
+
+    /**
+     * \brief Pointer handling : a key is clicked when the press and the release are on it, without scrolling in between
+     */
+    void mousePressEvent(QMouseEvent *po_event);
+    void mouseReleaseEvent(QMouseEvent *po_event);
+
+    /**
+     * \brief Scroll by one key per wheel step
+     */
+    void wheelEvent(QWheelEvent *po_event);
+
+
+    // Private Functions
+private:
+
+    /**
+     * \brief Get the maximum scroll position
+     */
+    qreal maximumScrollOffset() const;
+
+    /**
+     * \brief Set the scroll position, bounded to the scroll range
+     * \param[in] r_scrollOffset : Scroll position, in pixels
+     */
+    void setScrollOffset(qreal r_scrollOffset);
+
+    /**
+     * \brief Get the position in mveci_order of the key at a point of the bar
+     * \param[in] o_point : Point, in widget coordinates
+     * \return Position of the key, -1 if there is no key at this point
+     */
+    int keyPositionAt(const QPointF &o_point) const;
+
+    /**
+     * \brief Get the rectangle of a key in the bar
+     * \param[in] i_position : Position of the key in mveci_order
+     */
+    QRectF keyRect(int i_position) const;
+
+
+    // Signals
+signals:
+
+    /**
+     * \brief Signal emitted when a key is clicked
+     * \param[in] i_indexMapping : Mapping index of the key
+     */
+    void keyClicked(int i_indexMapping);
+};
+
+#endif // VIRTUALKEYBOARDSECONDARYBAR_H
@@ -0,0 +1,125 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+#include "VirtualKeyboardSnippet.h"
+
+#include <QHash>
+#include <QSharedData>
+
+
+/**
+ * \brief Text of the pool, shared by the snippets with the same text and removed from the pool with the last of them
+ */
+class VirtualKeyboardSnippetText : public QSharedData
+{
+public:
+    explicit VirtualKeyboardSnippetText(const QString &s_text) : s_text(s_text) {}
+    ~VirtualKeyboardSnippetText();
+
+    const QString s_text;
+};
+
+
+/**
+ * \brief Pool of the texts of the snippets, shared by the whole process
+ */
+struct VirtualKeyboardSnippetPool
+{
+    QHash<QString, VirtualKeyboardSnippetText*> hash_texts;
+};
+Q_GLOBAL_STATIC(VirtualKeyboardSnippetPool, st_pool)
+
+
+
+VirtualKeyboardSnippetText::~VirtualKeyboardSnippetText()
+{
+    // The pool may be destroyed before the last snippets (static snippets of the application)
+    if (!st_pool.isDestroyed()) st_pool->hash_texts.remove(this->s_text);
+}
+
+
+VirtualKeyboardSnippet::VirtualKeyboardSnippet() :
+    mi_cursorPosition(-1)
+{
+}
+
+
+VirtualKeyboardSnippet::VirtualKeyboardSnippet(const QString &s_text, bool b_isTemplate) :
+    mi_cursorPosition(-1)
+{
+    QString s_insertedText = s_text;
+
+    if (b_isTemplate)
+    {
+        this->mi_cursorPosition = s_insertedText.indexOf(VIRTUALKEYBOARDSNIPPET_CURSOR);
+        if (this->mi_cursorPosition >= 0) s_insertedText.remove(this->mi_cursorPosition, int(sizeof(VIRTUALKEYBOARDSNIPPET_CURSOR)) - 1);
+    }
+
+    if (s_insertedText.isEmpty()) return;
+
+    // The only lookup in the pool : the copies of the snippet share the text through its reference count
+    VirtualKeyboardSnippetText *&po_text = st_pool->hash_texts[s_insertedText];
+
+    if (po_text == NULL) po_text = new VirtualKeyboardSnippetText(s_insertedText);
+    this->mpo_text = po_text;
+}
+
+
+VirtualKeyboardSnippet::VirtualKeyboardSnippet(const VirtualKeyboardSnippet &o_snippet) :
+    mpo_text(o_snippet.mpo_text),
+    mi_cursorPosition(o_snippet.mi_cursorPosition)
+{
+}
+
+
+VirtualKeyboardSnippet::~VirtualKeyboardSnippet()
+{
+}
+
+
+VirtualKeyboardSnippet &VirtualKeyboardSnippet::operator=(const VirtualKeyboardSnippet &o_snippet)
+{
+    this->mpo_text = o_snippet.mpo_text;
+    this->mi_cursorPosition = o_snippet.mi_cursorPosition;
+    return *this;
+}
+
+
+QString VirtualKeyboardSnippet::text() const
+{
+    return (this->mpo_text.data() != NULL) ? this->mpo_text->s_text : QString();
+}
+
+
+int VirtualKeyboardSnippet::cursorPosition() const
+{
+    return this->mi_cursorPosition;
+}
+
+
+int VirtualKeyboardSnippet::poolSize()
+{
+    return st_pool->hash_texts.size();
+}
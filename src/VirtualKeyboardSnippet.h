@@ -0,0 +1,112 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+#ifndef VIRTUALKEYBOARDSNIPPET_H
+#define VIRTUALKEYBOARDSNIPPET_H
+
+#include <QString>
+#include <QExplicitlySharedDataPointer>
+
+
+// Placeholder of the cursor in a snippet template
+#define VIRTUALKEYBOARDSNIPPET_CURSOR "{cursor}"
+
+
+class VirtualKeyboardSnippetText;
+
+
+/**
+ * \brief Text inserted by a secondary key (see VirtualKeyboard::addSnippetKey), with the position the cursor takes after it
+ *
+ * The texts are interned in a pool shared by every keyboard of the application : the snippets with the same text share a single
+ * refcounted text, released with the last of them. Thousands of snippets configured on several keyboards cost their distinct texts once.
+ * Only the construction from a string hashes it, the copies of a snippet share its text without a lookup in the pool.
+ * The pool is not locked, the snippets are used from the GUI thread.
+ */
+class VirtualKeyboardSnippet
+{
+    // Private Members
+private:
+
+    /**
+     * Text inserted, without the cursor placeholder (text of the pool), NULL => empty text
+     */
+    QExplicitlySharedDataPointer<VirtualKeyboardSnippetText> mpo_text;
+
+    /**
+     * Position of the cursor in ms_text after the insertion, -1 => after the text
+     */
+    int mi_cursorPosition;
+
+
+    // Public Functions
+public:
+
+    /**
+     * \brief Constructor of an empty snippet
+     */
+    VirtualKeyboardSnippet();
+
+    /**
+     * \brief Constructor
+     * \param[in] s_text : Text inserted
+     * \param[in] b_isTemplate : If true, the first VIRTUALKEYBOARDSNIPPET_CURSOR of the text is removed and marks the position of the cursor
+     *      after the insertion, else the text is literal and the cursor is placed after it
+     */
+    VirtualKeyboardSnippet(const QString &s_text, bool b_isTemplate);
+
+    /**
+     * \brief Copy constructor, the text stays shared (no lookup in the pool)
+     */
+    VirtualKeyboardSnippet(const VirtualKeyboardSnippet &o_snippet);
+
+    /**
+     * \brief Destructor, release the text from the pool
+     */
+    ~VirtualKeyboardSnippet();
+
+    /**
+     * \brief Assignment, the text stays shared (no lookup in the pool)
+     */
+    VirtualKeyboardSnippet &operator=(const VirtualKeyboardSnippet &o_snippet);
+
+    /**
+     * \brief Get the text inserted
+     */
+    QString text() const;
+
+    /**
+     * \brief Get the position of the cursor in the text after the insertion
+     * \return Position, -1 => after the text
+     */
+    int cursorPosition() const;
+
+    /**
+     * \brief Get the number of distinct texts of the pool
+     */
+    static int poolSize();
+};
+
+#endif // VIRTUALKEYBOARDSNIPPET_H
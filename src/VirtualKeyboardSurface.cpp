@@ -0,0 +1,556 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+#include "VirtualKeyboardSurface.h"
+
+#include <QPainter>
+#include <QPaintEvent>
+#include <QMouseEvent>
+#include <QTouchEvent>
+
+
+// Size of the icons displayed on the keys (same as the iconSize used in VirtualKeyboard.ui)
+#define VIRTUALKEYBOARDSURFACE_ICONSIZE 35
+
+// Width of the line drawn along the paths traced over the keys
+#define VIRTUALKEYBOARDSURFACE_PATHWIDTH 4
+
+// Maximum number of pre-rendered layers kept (4 layers of a keymap with their Caps and Numbers states, and some of the previous keymap)
+#define VIRTUALKEYBOARDSURFACE_MAXLAYERPIXMAPS 16
+
+
+
+VirtualKeyboardSurface::VirtualKeyboardSurface(QWidget *w_parent) :
+    QWidget(w_parent),
+    mr_cacheDevicePixelRatio(0),
+    mpo_keymap(NULL),
+    mi_layer(VIRTUALKEYBOARD_LAYER_LOWER),
+    mi_pressedKeyId(VIRTUALKEYBOARD_KEY_NONE),
+    mb_isPressedKeyDown(false),
+    mb_isPathTracingOn(false)
+{
+    // Same font as the buttons of VirtualKeyboard.ui
+    QFont o_font = this->font();
+    o_font.setPointSize(12);
+    this->setFont(o_font);
+
+    this->setFocusPolicy(Qt::NoFocus);
+    this->setAttribute(Qt::WA_AcceptTouchEvents);
+    this->setAttribute(Qt::WA_OpaquePaintEvent, false);
+    this->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+
+    this->updateLayerKey();
+}
+
+
+void VirtualKeyboardSurface::setKeymap(const VirtualKeyboardKeymap *po_keymap, int i_layer)
+{
+    this->mi_layer = i_layer;
+
+    if (po_keymap != this->mpo_keymap)
+    {
+        // Other rows of keys : the minimum size may change (the layers of the other keymaps stay cached)
+        this->mpo_keymap = po_keymap;
+        this->updateGeometry();
+    }
+    this->updateLayerKey();
+    this->relayout();
+}
+
+
+void VirtualKeyboardSurface::setKeyText(int i_keyId, const QString &s_text)
+{
+    if (this->mhashs_keyTexts.value(i_keyId) == s_text) return;
+
+    this->mhashs_keyTexts.insert(i_keyId, s_text);
+    this->updateLayerKey();
+    this->updateKey(i_keyId);
+}
+
+
+void VirtualKeyboardSurface::setKeyIcon(int i_keyId, const QIcon &o_icon)
+{
+    // The icons are not part of the layer key : they are only set once
+    this->mhasho_keyIcons.insert(i_keyId, o_icon);
+    this->clearLayerPixmaps();
+    this->updateKey(i_keyId);
+}
+
+
+void VirtualKeyboardSurface::setKeyChecked(int i_keyId, bool b_checked)
+{
+    if (this->mseti_checkedKeys.contains(i_keyId) == b_checked) return;
+
+    if (b_checked)  this->mseti_checkedKeys.insert(i_keyId);
+    else            this->mseti_checkedKeys.remove(i_keyId);
+    this->updateLayerKey();
+    this->updateKey(i_keyId);
+}
+
+
+void VirtualKeyboardSurface::setKeyEnabled(int i_keyId, bool b_enabled)
+{
+    if (this->mseti_disabledKeys.contains(i_keyId) != b_enabled) return;
+
+    if (b_enabled)  this->mseti_disabledKeys.remove(i_keyId);
+    else            this->mseti_disabledKeys.insert(i_keyId);
+    this->updateLayerKey();
+    this->updateKey(i_keyId);
+}
+
+
+void VirtualKeyboardSurface::setPathTracing(bool b_enabled)
+{
+    this->mb_isPathTracingOn = b_enabled;
+
+    // Path in progress dropped : its press goes on as a press of its key
+    if (!b_enabled && !this->mveco_path.isEmpty())
+    {
+        this->mveco_path.clear();
+        this->update();
+    }
+}
+
+
+void VirtualKeyboardSurface::invalidateCache()
+{
+    this->mhasho_layerGeometries.clear();
+    this->clearLayerPixmaps();
+    this->relayout();
+}
+
+
+const VirtualKeyboardGeometry &VirtualKeyboardSurface::geometry() const
+{
+    return this->mo_geometry;
+}
+
+
+QPointF VirtualKeyboardSurface::pressPosition() const
+{
+    return this->mo_pressPosition;
+}
+
+
+QSize VirtualKeyboardSurface::minimumSizeHint() const
+{
+    return VirtualKeyboardGeometry::minimumSize(this->mpo_keymap).toSize();
+}
+
+
+QSize VirtualKeyboardSurface::sizeHint() const
+{
+    return this->minimumSizeHint();
+}
+
+
+bool VirtualKeyboardSurface::event(QEvent *po_event)
+{
+    switch (po_event->type())
+    {
+    // Only the first touch point is followed, like a mouse
+    case QEvent::TouchBegin:
+    case QEvent::TouchUpdate:
+    case QEvent::TouchEnd:
+    {
+        QTouchEvent *po_touchEvent = static_cast<QTouchEvent *>(po_event);
+
+        if (!po_touchEvent->touchPoints().isEmpty())
+        {
+            const QTouchEvent::TouchPoint &o_touchPoint = po_touchEvent->touchPoints().first();
+
+            if (po_event->type() == QEvent::TouchBegin)     this->pointerPressed(o_touchPoint.pos());
+            else if (po_event->type() == QEvent::TouchEnd)  this->pointerReleased(o_touchPoint.pos());
+            else                                            this->pointerMoved(o_touchPoint.pos());
+        }
+        // Accept the event to receive the rest of the touch sequence, and to avoid the synthesized mouse events
+        po_event->accept();
+        return true;
+    }
+    case QEvent::TouchCancel:
+    {
+        const int i_keyId = this->mi_pressedKeyId;
+        const bool b_wasDown = this->mb_isPressedKeyDown;
+
+        this->updateKey(i_keyId);
+        this->mi_pressedKeyId = VIRTUALKEYBOARD_KEY_NONE;
+        this->mb_isPressedKeyDown = false;
+        if (b_wasDown) emit this->keyUp(i_keyId);
+
+        if (!this->mveco_path.isEmpty())
+        {
+            this->mveco_path.clear();
+            this->update();
+        }
+
+        po_event->accept();
+        return true;
+    }
+    default:
+        return QWidget::event(po_event);
+    }
+}
+
+
+void VirtualKeyboardSurface::paintEvent(QPaintEvent *po_event)
+{
+    if (this->mpo_keymap == NULL) return;
+
+    // --- The pre-rendered layers are dropped if the device pixel ratio changed (the widget has been moved to another screen)
+    const qreal r_devicePixelRatio = this->devicePixelRatioF();
+
+    if (r_devicePixelRatio != this->mr_cacheDevicePixelRatio)
+    {
+        this->clearLayerPixmaps();
+        this->mr_cacheDevicePixelRatio = r_devicePixelRatio;
+    }
+
+    // --- Look the layer up only after a change of its key, render it if it has not been displayed yet
+    if (this->mo_layerPixmap.isNull())
+    {
+        QHash<LayerKey, QPixmap>::const_iterator it_layer = this->mhasho_layerPixmaps.constFind(this->mo_layerKey);
+
+        if (it_layer != this->mhasho_layerPixmaps.constEnd())
+        {
+            this->mo_layerPixmap = it_layer.value();
+        }
+        else
+        {
+            // Cache full : the layers of the other keymaps are dropped first
+            if (this->mhasho_layerPixmaps.size() >= VIRTUALKEYBOARDSURFACE_MAXLAYERPIXMAPS)
+            {
+                QHash<LayerKey, QPixmap>::iterator it_pixmap = this->mhasho_layerPixmaps.begin();
+
+                while (it_pixmap != this->mhasho_layerPixmaps.end())
+                {
+                    if (it_pixmap.key().po_keymap != this->mpo_keymap)  it_pixmap = this->mhasho_layerPixmaps.erase(it_pixmap);
+                    else                                                ++it_pixmap;
+                }
+                if (this->mhasho_layerPixmaps.size() >= VIRTUALKEYBOARDSURFACE_MAXLAYERPIXMAPS) this->mhasho_layerPixmaps.clear();
+            }
+            this->mo_layerPixmap = this->renderLayer(r_devicePixelRatio);
+            this->mhasho_layerPixmaps.insert(this->mo_layerKey, this->mo_layerPixmap);
+        }
+    }
+
+    // --- Blit the exposed part of the layer, then draw the pressed key over it
+    QPainter o_painter(this);
+    const QRectF o_exposedRect = po_event->rect();
+
+    o_painter.drawPixmap(o_exposedRect, this->mo_layerPixmap,
+                         QRectF(o_exposedRect.topLeft() * r_devicePixelRatio, o_exposedRect.size() * r_devicePixelRatio));
+
+    // --- Dim the principal keys disabled (not part of the layer key)
+    if (!this->mseti_disabledKeys.isEmpty())
+    {
+        const QVector<VirtualKeyboardGeometry::Key> &vec_keys = this->mo_geometry.keys();
+        QColor o_dim = this->palette().color(QPalette::Window);
+        o_dim.setAlpha(160);
+
+        for (int i_i = 0; i_i < vec_keys.size(); ++i_i)
+        {
+            const VirtualKeyboardGeometry::Key &o_key = vec_keys.at(i_i);
+
+            if (o_key.i_keyId >= 0 && this->mseti_disabledKeys.contains(o_key.i_keyId) && o_key.o_rect.intersects(o_exposedRect))
+                o_painter.fillRect(o_key.o_rect, o_dim);
+        }
+    }
+
+    if (this->mb_isPressedKeyDown)
+    {
+        const QVector<VirtualKeyboardGeometry::Key> &vec_keys = this->mo_geometry.keys();
+
+        for (int i_i = 0; i_i < vec_keys.size(); ++i_i)
+        {
+            if (vec_keys.at(i_i).i_keyId != this->mi_pressedKeyId) continue;
+
+            o_painter.setRenderHint(QPainter::Antialiasing);
+            this->paintKey(o_painter, vec_keys.at(i_i), true);
+            break;
+        }
+    }
+
+    // --- Path traced over the keys
+    if (this->mveco_path.size() >= 2)
+    {
+        o_painter.setRenderHint(QPainter::Antialiasing);
+        o_painter.setPen(QPen(this->palette().color(QPalette::Highlight), VIRTUALKEYBOARDSURFACE_PATHWIDTH, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+        o_painter.drawPolyline(this->mveco_path.constData(), this->mveco_path.size());
+    }
+}
+
+
+void VirtualKeyboardSurface::resizeEvent(QResizeEvent *po_event)
+{
+    Q_UNUSED(po_event)
+
+    this->invalidateCache();
+}
+
+
+void VirtualKeyboardSurface::changeEvent(QEvent *po_event)
+{
+    if (po_event->type() == QEvent::StyleChange || po_event->type() == QEvent::PaletteChange || po_event->type() == QEvent::FontChange)
+    {
+        this->clearLayerPixmaps();
+        this->update();
+    }
+    QWidget::changeEvent(po_event);
+}
+
+
+void VirtualKeyboardSurface::mousePressEvent(QMouseEvent *po_event)
+{
+    if (po_event->button() == Qt::LeftButton)
+        this->pointerPressed(po_event->localPos());
+}
+
+
+void VirtualKeyboardSurface::mouseMoveEvent(QMouseEvent *po_event)
+{
+    this->pointerMoved(po_event->localPos());
+}
+
+
+void VirtualKeyboardSurface::mouseReleaseEvent(QMouseEvent *po_event)
+{
+    if (po_event->button() == Qt::LeftButton)
+        this->pointerReleased(po_event->localPos());
+}
+
+
+void VirtualKeyboardSurface::relayout()
+{
+    if (this->mpo_keymap == NULL) return;
+
+    const QPair<const VirtualKeyboardKeymap *, int> pair_layer(this->mpo_keymap, this->mi_layer);
+    QHash<QPair<const VirtualKeyboardKeymap *, int>, VirtualKeyboardGeometry>::const_iterator it_geometry = this->mhasho_layerGeometries.constFind(pair_layer);
+
+    if (it_geometry != this->mhasho_layerGeometries.constEnd())
+    {
+        this->mo_geometry = it_geometry.value();
+    }
+    else
+    {
+        this->mo_geometry.layout(this->size(), this->mpo_keymap, this->mi_layer);
+        this->mhasho_layerGeometries.insert(pair_layer, this->mo_geometry);
+    }
+    this->update();
+}
+
+
+void VirtualKeyboardSurface::updateLayerKey()
+{
+    // --- Labels : index of the set of labels, a new set is added if it has not been displayed yet
+    int i_keyTextSet = this->mlisthashs_keyTextSets.indexOf(this->mhashs_keyTexts);
+
+    if (i_keyTextSet < 0)
+    {
+        // Labels changed too often : the sets and the layers using them are dropped
+        if (this->mlisthashs_keyTextSets.size() >= VIRTUALKEYBOARDSURFACE_MAXLAYERPIXMAPS)
+        {
+            this->mlisthashs_keyTextSets.clear();
+            this->clearLayerPixmaps();
+        }
+        i_keyTextSet = this->mlisthashs_keyTextSets.size();
+        this->mlisthashs_keyTextSets.append(this->mhashs_keyTexts);
+    }
+
+    // --- States : two bits for each key which is not a principal key (the principal keys disabled are dimmed by paintEvent)
+    quint32 i_keyStates = 0;
+
+    for (QSet<int>::const_iterator it_key = this->mseti_checkedKeys.constBegin(); it_key != this->mseti_checkedKeys.constEnd(); ++it_key)
+    {
+        if (*it_key < VIRTUALKEYBOARD_KEY_NONE) i_keyStates |= 1u << (2 * (VIRTUALKEYBOARD_KEY_NONE - 1 - *it_key));
+    }
+    for (QSet<int>::const_iterator it_key = this->mseti_disabledKeys.constBegin(); it_key != this->mseti_disabledKeys.constEnd(); ++it_key)
+    {
+        if (*it_key < VIRTUALKEYBOARD_KEY_NONE) i_keyStates |= 2u << (2 * (VIRTUALKEYBOARD_KEY_NONE - 1 - *it_key));
+    }
+
+    const LayerKey o_layerKey = {this->mpo_keymap, this->mi_layer, i_keyTextSet, i_keyStates};
+
+    if (!this->mo_layerPixmap.isNull() && o_layerKey == this->mo_layerKey) return;
+
+    this->mo_layerKey = o_layerKey;
+    this->mo_layerPixmap = QPixmap();
+}
+
+
+void VirtualKeyboardSurface::clearLayerPixmaps()
+{
+    this->mhasho_layerPixmaps.clear();
+    this->mo_layerPixmap = QPixmap();
+}
+
+
+QPixmap VirtualKeyboardSurface::renderLayer(qreal r_devicePixelRatio) const
+{
+    QPixmap o_pixmap(this->size() * r_devicePixelRatio);
+    o_pixmap.setDevicePixelRatio(r_devicePixelRatio);
+    o_pixmap.fill(Qt::transparent);
+
+    QPainter o_painter(&o_pixmap);
+    o_painter.setRenderHint(QPainter::Antialiasing);
+    o_painter.setFont(this->font());
+
+    const QVector<VirtualKeyboardGeometry::Key> &vec_keys = this->mo_geometry.keys();
+
+    for (int i_i = 0; i_i < vec_keys.size(); ++i_i)
+        this->paintKey(o_painter, vec_keys.at(i_i), false);
+
+    return o_pixmap;
+}
+
+
+void VirtualKeyboardSurface::paintKey(QPainter &o_painter, const VirtualKeyboardGeometry::Key &o_key, bool b_isDown) const
+{
+    const QPalette &o_palette = this->palette();
+    // The principal keys are rendered enabled in the layers, the disabled ones are dimmed by paintEvent
+    const bool b_isEnabled = o_key.i_keyId >= 0 || !this->mseti_disabledKeys.contains(o_key.i_keyId);
+
+    // --- Key background (same colour as the stylesheet used on the Caps lock button when it is checked)
+    QColor o_background = o_palette.color(QPalette::Button);
+    if (b_isDown)                                               o_background = o_palette.color(QPalette::Mid);
+    else if (this->mseti_checkedKeys.contains(o_key.i_keyId))   o_background = Qt::cyan;
+
+    o_painter.setPen(o_palette.color(QPalette::Dark));
+    o_painter.setBrush(o_background);
+    o_painter.drawRoundedRect(o_key.o_rect.adjusted(0.5, 0.5, -0.5, -0.5), 3, 3);
+
+    // --- Key content : icon or label
+    if (this->mhasho_keyIcons.contains(o_key.i_keyId))
+    {
+        QPixmap o_pixmap = this->mhasho_keyIcons.value(o_key.i_keyId).pixmap(VIRTUALKEYBOARDSURFACE_ICONSIZE, VIRTUALKEYBOARDSURFACE_ICONSIZE,
+                                                                             b_isEnabled ? QIcon::Normal : QIcon::Disabled);
+        QRectF o_pixmapRect(QPointF(0, 0), QSizeF(o_pixmap.size()) / o_pixmap.devicePixelRatio());
+        o_pixmapRect.moveCenter(o_key.o_rect.center());
+        o_painter.drawPixmap(o_pixmapRect.topLeft(), o_pixmap);
+    }
+    else
+    {
+        o_painter.setPen(o_palette.color(b_isEnabled ? QPalette::Active : QPalette::Disabled, QPalette::ButtonText));
+        o_painter.drawText(o_key.o_rect, Qt::AlignCenter,
+                           o_key.i_keyId >= 0 ? this->mpo_keymap->keyText(this->mi_layer, o_key.i_keyId) : this->mhashs_keyTexts.value(o_key.i_keyId));
+    }
+}
+
+
+void VirtualKeyboardSurface::pointerPressed(const QPointF &o_position)
+{
+    const int i_keyId = this->mo_geometry.keyAt(o_position);
+
+    if (i_keyId == VIRTUALKEYBOARD_KEY_NONE || this->mseti_disabledKeys.contains(i_keyId)) return;
+
+    this->mi_pressedKeyId = i_keyId;
+    this->mb_isPressedKeyDown = true;
+    this->mo_pressPosition = o_position;
+    this->updateKey(i_keyId);
+
+    emit this->keyDown(i_keyId);
+}
+
+
+void VirtualKeyboardSurface::pointerMoved(const QPointF &o_position)
+{
+    if (this->mi_pressedKeyId == VIRTUALKEYBOARD_KEY_NONE) return;
+
+    // --- Path in progress : extended, only its new segment is repainted
+    if (!this->mveco_path.isEmpty())
+    {
+        if (o_position == this->mveco_path.last()) return;
+
+        const qreal r_margin = VIRTUALKEYBOARDSURFACE_PATHWIDTH;
+        this->update(QRectF(this->mveco_path.last(), o_position).normalized().adjusted(-r_margin, -r_margin, r_margin, r_margin).toAlignedRect());
+        this->mveco_path.append(o_position);
+        return;
+    }
+
+    const bool b_isDown = this->mo_geometry.keyRect(this->mi_pressedKeyId).contains(o_position);
+
+    // --- Press sliding off its principal key : start of a path, the key goes up
+    if (!b_isDown && this->mb_isPathTracingOn && this->mi_pressedKeyId >= 0)
+    {
+        this->mveco_path.append(this->mo_pressPosition);
+        this->mveco_path.append(o_position);
+        this->update();
+
+        if (this->mb_isPressedKeyDown)
+        {
+            this->mb_isPressedKeyDown = false;
+            this->updateKey(this->mi_pressedKeyId);
+            emit this->keyUp(this->mi_pressedKeyId);
+        }
+        return;
+    }
+
+    if (b_isDown != this->mb_isPressedKeyDown)
+    {
+        this->mb_isPressedKeyDown = b_isDown;
+        this->updateKey(this->mi_pressedKeyId);
+
+        if (b_isDown)   emit this->keyDown(this->mi_pressedKeyId);
+        else            emit this->keyUp(this->mi_pressedKeyId);
+    }
+}
+
+
+void VirtualKeyboardSurface::pointerReleased(const QPointF &o_position)
+{
+    if (this->mi_pressedKeyId == VIRTUALKEYBOARD_KEY_NONE) return;
+
+    const int i_keyId = this->mi_pressedKeyId;
+    const bool b_wasDown = this->mb_isPressedKeyDown;
+
+    this->mi_pressedKeyId = VIRTUALKEYBOARD_KEY_NONE;
+    this->mb_isPressedKeyDown = false;
+    this->updateKey(i_keyId);
+
+    // --- End of a path : emitted in place of the click (cleared first, the slots may start another press)
+    if (!this->mveco_path.isEmpty())
+    {
+        QVector<QPointF> veco_path;
+        veco_path.swap(this->mveco_path);
+        if (o_position != veco_path.last()) veco_path.append(o_position);
+        this->update();
+
+        emit this->pathTraced(veco_path);
+        return;
+    }
+
+    if (b_wasDown) emit this->keyUp(i_keyId);
+
+    // Like QAbstractButton, the key is clicked only if the release happens on the key
+    if (this->mo_geometry.keyRect(i_keyId).contains(o_position))
+        emit this->keyClicked(i_keyId);
+}
+
+
+void VirtualKeyboardSurface::updateKey(int i_keyId)
+{
+    const QRectF o_rect = this->mo_geometry.keyRect(i_keyId);
+
+    if (!o_rect.isNull()) this->update(o_rect.toAlignedRect());
+}
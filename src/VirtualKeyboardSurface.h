@@ -0,0 +1,410 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+#ifndef VIRTUALKEYBOARDSURFACE_H
+#define VIRTUALKEYBOARDSURFACE_H
+
+#include <QWidget>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QSet>
+#include <QIcon>
+#include <QPixmap>
+#include <QVector>
+
+#include "VirtualKeyboardGeometry.h"
+
+
+/**
+ * \brief Custom-painted surface displaying the principal keys of the virtual keyboard
+ *
+ * Used by VirtualKeyboard in the VIRTUALKEYBOARD_RENDER_PAINTED mode in place of the QPushButtons of VirtualKeyboard.ui :
+ * every key is drawn in a single paintEvent from the key-geometry table (VirtualKeyboardGeometry) and the mouse / touch input is handled here.
+ *
+ * Each keymap layer (lower, upper, numbers, punctuation) of each keymap is rendered once into a cached pixmap :
+ * switching layer or language only blits the cached image.
+ * The layer displayed is looked up only when its keymap, layer or special keys change, and at most VIRTUALKEYBOARDSURFACE_MAXLAYERPIXMAPS layers are kept.
+ * The caches are invalidated on resize, device pixel ratio change, style change or through invalidateCache() when the keymaps change.
+ *
+ * With the path tracing on (setPathTracing()), a press sliding off its principal key traces a path over the keys instead :
+ * the path is drawn over the keys and pathTraced() is emitted on release, no key is clicked.
+ */
+class VirtualKeyboardSurface : public QWidget
+{
+    Q_OBJECT
+
+
+    // Private Types
+private:
+
+    /**
+     * \brief Key of a pre-rendered layer : what the keys of the layer look like in the up state
+     */
+    struct LayerKey
+    {
+        /**
+         * Keymap of the layer
+         */
+        const VirtualKeyboardKeymap *po_keymap;
+
+        /**
+         * Layer of the keymap (VIRTUALKEYBOARD_LAYER_*)
+         */
+        int i_layer;
+
+        /**
+         * Labels of the keys which are not principal keys : index in mlisthashs_keyTextSets
+         */
+        int i_keyTextSet;
+
+        /**
+         * Keys which are not principal keys checked and disabled, two bits per key
+         */
+        quint32 i_keyStates;
+
+        bool operator==(const LayerKey &o_other) const
+        {
+            return this->po_keymap == o_other.po_keymap && this->i_layer == o_other.i_layer
+                    && this->i_keyTextSet == o_other.i_keyTextSet && this->i_keyStates == o_other.i_keyStates;
+        }
+    };
+
+    friend uint qHash(const LayerKey &o_key, uint i_seed)
+    {
+        return ::qHash(reinterpret_cast<quintptr>(o_key.po_keymap), i_seed) ^ uint(o_key.i_layer) ^ (uint(o_key.i_keyTextSet) << 4) ^ (o_key.i_keyStates << 12);
+    }
+
+
+    // Private Members
+private:
+
+    /**
+     * Key-geometry table of the keymap displayed
+     */
+    VirtualKeyboardGeometry mo_geometry;
+
+    /**
+     * Key-geometry tables of the layers already displayed with the current size, indexed by keymap and layer
+     */
+    QHash<QPair<const VirtualKeyboardKeymap *, int>, VirtualKeyboardGeometry> mhasho_layerGeometries;
+
+    /**
+     * Pre-rendered layers (at most VIRTUALKEYBOARDSURFACE_MAXLAYERPIXMAPS)
+     */
+    QHash<LayerKey, QPixmap> mhasho_layerPixmaps;
+
+    /**
+     * Key of the layer displayed, updated by updateLayerKey()
+     */
+    LayerKey mo_layerKey;
+
+    /**
+     * Pre-rendered layer displayed, null until paintEvent finds or renders it
+     */
+    QPixmap mo_layerPixmap;
+
+    /**
+     * Sets of labels of the keys which are not principal keys already displayed (the Numbers key toggles between two sets)
+     */
+    QList<QHash<int, QString> > mlisthashs_keyTextSets;
+
+    /**
+     * Device pixel ratio of the pixmaps in mhasho_layerPixmaps
+     */
+    qreal mr_cacheDevicePixelRatio;
+
+    /**
+     * Keymap currently displayed
+     */
+    const VirtualKeyboardKeymap *mpo_keymap;
+
+    /**
+     * Layer of the keymap currently displayed (VIRTUALKEYBOARD_LAYER_*)
+     */
+    int mi_layer;
+
+    /**
+     * Labels of the keys which are not principal keys
+     */
+    QHash<int, QString> mhashs_keyTexts;
+
+    /**
+     * Icons of the keys which are not principal keys
+     */
+    QHash<int, QIcon> mhasho_keyIcons;
+
+    /**
+     * Keys displayed as checked (Caps lock on)
+     */
+    QSet<int> mseti_checkedKeys;
+
+    /**
+     * Keys disabled
+     */
+    QSet<int> mseti_disabledKeys;
+
+    /**
+     * Key on which the press started, VIRTUALKEYBOARD_KEY_NONE if there is no press in progress
+     */
+    int mi_pressedKeyId;
+
+    /**
+     * True if the pointer is still on the pressed key (the key is drawn down)
+     */
+    bool mb_isPressedKeyDown;
+
+    /**
+     * Position of the last press
+     */
+    QPointF mo_pressPosition;
+
+    /**
+     * A press sliding off its principal key traces a path
+     */
+    bool mb_isPathTracingOn;
+
+    /**
+     * Points of the path traced by the press in progress, empty if the press does not trace a path
+     */
+    QVector<QPointF> mveco_path;
+
+
+    // Public Functions
+public:
+
+    /**
+     * \brief Constructor
+     * \param w_parent : parent Widget (default 0)
+     */
+    explicit VirtualKeyboardSurface(QWidget *w_parent = 0);
+
+    /**
+     * \brief Set the keymap displayed on the principal keys
+     * \param[in] po_keymap : Keymap, must stay valid while it is displayed
+     * \param[in] i_layer : Layer of the keymap displayed (VIRTUALKEYBOARD_LAYER_*)
+     */
+    void setKeymap(const VirtualKeyboardKeymap *po_keymap, int i_layer);
+
+    /**
+     * \brief Set the label of a key which is not a principal key
+     * \param[in] i_keyId : Identifier of the key (VIRTUALKEYBOARD_KEY_*)
+     * \param[in] s_text : Label
+     */
+    void setKeyText(int i_keyId, const QString &s_text);
+
+    /**
+     * \brief Set the icon of a key which is not a principal key
+     * \param[in] i_keyId : Identifier of the key (VIRTUALKEYBOARD_KEY_*)
+     * \param[in] o_icon : Icon
+     */
+    void setKeyIcon(int i_keyId, const QIcon &o_icon);
+
+    /**
+     * \brief Display a key as checked or not
+     * \param[in] i_keyId : Identifier of the key
+     * \param[in] b_checked : True to display the key as checked
+     */
+    void setKeyChecked(int i_keyId, bool b_checked);
+
+    /**
+     * \brief Enable or disable a key
+     *
+     * The principal keys disabled are dimmed over the pre-rendered layer : their state does not multiply the cached layers
+     *
+     * \param[in] i_keyId : Identifier of the key
+     * \param[in] b_enabled : True to enable the key
+     */
+    void setKeyEnabled(int i_keyId, bool b_enabled);
+
+    /**
+     * \brief Enable or disable the path tracing : a press sliding off its principal key traces a path over the keys (default : off)
+     * \param[in] b_enabled : True to trace the paths
+     */
+    void setPathTracing(bool b_enabled);
+
+    /**
+     * \brief Drop the key-geometry tables and the pre-rendered layers
+     *
+     * Called when the size changes, or when the labels of the keys are modified
+     */
+    void invalidateCache();
+
+    /**
+     * \brief Get the key-geometry table
+     * \return Key-geometry table, laid out for the current size and keymap
+     */
+    const VirtualKeyboardGeometry &geometry() const;
+
+    /**
+     * \brief Get the position of the last press on a key (raw touch point, not the centre of the key)
+     * \return Position, in the coordinates of the surface
+     */
+    QPointF pressPosition() const;
+
+    /**
+     * \brief Reimplemented from QWidget
+     */
+    QSize minimumSizeHint() const;
+
+    /**
+     * \brief Reimplemented from QWidget
+     */
+    QSize sizeHint() const;
+
+
+    // Protected Functions
+protected:
+
+    /**
+     * \brief Reimplemented from QWidget, handle the touch events
+     */
+    bool event(QEvent *po_event);
+
+    /**
+     * \brief Reimplemented from QWidget, draw every key
+     */
+    void paintEvent(QPaintEvent *po_event);
+
+    /**
+     * \brief Reimplemented from QWidget, lay out the keys for the new size
+     */
+    void resizeEvent(QResizeEvent *po_event);
+
+    /**
+     * \brief Reimplemented from QWidget, invalidate the pre-rendered layers when the style, palette or font change
+     */
+    void changeEvent(QEvent *po_event);
+
+    /**
+     * \brief Reimplemented from QWidget
+     */
+    void mousePressEvent(QMouseEvent *po_event);
+
+    /**
+     * \brief Reimplemented from QWidget
+     */
+    void mouseMoveEvent(QMouseEvent *po_event);
+
+    /**
+     * \brief Reimplemented from QWidget
+     */
+    void mouseReleaseEvent(QMouseEvent *po_event);
+
+
+    // Private Functions
+private:
+
+    /**
+     * \brief Lay out the keys for the current size and keymap (or reuse the cached layout) and repaint the surface
+     */
+    void relayout();
+
+    /**
+     * \brief Compute the key of the layer displayed : keymap, layer, labels and state of the keys which are not principal keys
+     *
+     * Called when one of them changes, not on each paint : the pre-rendered layer displayed is looked up again on the next paint
+     */
+    void updateLayerKey();
+
+    /**
+     * \brief Drop the pre-rendered layers
+     */
+    void clearLayerPixmaps();
+
+    /**
+     * \brief Render every key of the layer displayed, in the up state
+     * \param[in] r_devicePixelRatio : Device pixel ratio of the pixmap
+     * \return Pre-rendered layer
+     */
+    QPixmap renderLayer(qreal r_devicePixelRatio) const;
+
+    /**
+     * \brief Draw a key
+     * \param[in] o_painter : Painter to use
+     * \param[in] o_key : Key to draw
+     * \param[in] b_isDown : True to draw the key in the down state
+     */
+    void paintKey(QPainter &o_painter, const VirtualKeyboardGeometry::Key &o_key, bool b_isDown) const;
+
+    /**
+     * \brief Start a press
+     * \param[in] o_position : Position of the press
+     */
+    void pointerPressed(const QPointF &o_position);
+
+    /**
+     * \brief Follow a press : the pressed key is down only while the pointer is on it, or the pointer extends the path traced
+     * \param[in] o_position : Position of the pointer
+     */
+    void pointerMoved(const QPointF &o_position);
+
+    /**
+     * \brief End a press : the key is clicked if the pointer is still on it, or the path traced is emitted
+     * \param[in] o_position : Position of the release
+     */
+    void pointerReleased(const QPointF &o_position);
+
+    /**
+     * \brief Repaint a single key
+     * \param[in] i_keyId : Identifier of the key
+     */
+    void updateKey(int i_keyId);
+
+
+    // Signals
+signals:
+
+    // The three signals follow the semantic of QAbstractButton::pressed, released and clicked
+
+    /**
+     * \brief Signal emitted when a key goes down (pressed, or pointer back on the pressed key)
+     * \param[in] i_keyId : Index of the key in the keymap for a principal key, else one of the VIRTUALKEYBOARD_KEY_* values
+     */
+    void keyDown(int i_keyId);
+
+    /**
+     * \brief Signal emitted when a key goes up (released, or pointer slid off the pressed key)
+     * \param[in] i_keyId : Index of the key in the keymap for a principal key, else one of the VIRTUALKEYBOARD_KEY_* values
+     */
+    void keyUp(int i_keyId);
+
+    /**
+     * \brief Signal emitted when a key is clicked (pressed and released on the key)
+     * \param[in] i_keyId : Index of the key in the keymap for a principal key, else one of the VIRTUALKEYBOARD_KEY_* values
+     */
+    void keyClicked(int i_keyId);
+
+    /**
+     * \brief Signal emitted when a path traced over the keys is released (see setPathTracing())
+     *
+     * The principal key on which the path started went up (keyUp()) when the path left it, and is not clicked.
+     *
+     * \param[in] veco_path : Points of the path, from the press to the release, in the coordinates of the surface
+     */
+    void pathTraced(const QVector<QPointF> &veco_path);
+};
+
+#endif // VIRTUALKEYBOARDSURFACE_H
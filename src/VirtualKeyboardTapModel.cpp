@@ -0,0 +1,145 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+#include "VirtualKeyboardTapModel.h"
+
+#include <QStringList>
+
+
+
+VirtualKeyboardTapModel::VirtualKeyboardTapModel() :
+    mo_keyModel(VIRTUALKEYBOARD_TAPMODEL_SIGMA)
+{
+}
+
+
+void VirtualKeyboardTapModel::setKeys(const QString &s_characters, const QVector<QRectF> &veco_rects)
+{
+    this->mo_keyModel.setKeys(s_characters, veco_rects);
+}
+
+
+int VirtualKeyboardTapModel::keyCount() const
+{
+    return this->mo_keyModel.keyCount();
+}
+
+
+QString VirtualKeyboardTapModel::correct(const QVector<QPointF> &veco_taps, const QString &s_word, const VirtualKeyboardDictionary *po_dictionary) const
+{
+    const int i_length = s_word.size();
+
+    const QString &s_keyCharacters = this->mo_keyModel.keyCharacters();
+    const float *pr_keyX = this->mo_keyModel.keyX();
+    const float *pr_keyY = this->mo_keyModel.keyY();
+
+    if (po_dictionary == NULL || s_keyCharacters.isEmpty() || i_length < 2 || i_length != veco_taps.size()) return QString();
+
+    const QString s_lowercaseWord = s_word.toLower();
+    const float r_radius2 = float(VIRTUALKEYBOARD_TAPMODEL_CANDIDATERADIUS * VIRTUALKEYBOARD_TAPMODEL_CANDIDATERADIUS);
+
+    // --- Characters of the keys near each tap, the character typed first
+    QVector<float> vecr_tapX(i_length);
+    QVector<float> vecr_tapY(i_length);
+    QStringList lists_characters;
+
+    for (int i_i = 0; i_i < i_length; ++i_i)
+    {
+        const QChar o_typed = s_lowercaseWord.at(i_i);
+        if (!o_typed.isLetter() || !s_keyCharacters.contains(o_typed)) return QString();
+
+        vecr_tapX[i_i] = this->mo_keyModel.toModelX(veco_taps.at(i_i).x());
+        vecr_tapY[i_i] = this->mo_keyModel.toModelY(veco_taps.at(i_i).y());
+
+        QString s_characters(o_typed);
+        for (int i_key = 0; i_key < s_keyCharacters.size(); ++i_key)
+        {
+            const float r_dx = vecr_tapX.at(i_i) - pr_keyX[i_key];
+            const float r_dy = vecr_tapY.at(i_i) - pr_keyY[i_key];
+
+            if (r_dx * r_dx + r_dy * r_dy <= r_radius2 && !s_characters.contains(s_keyCharacters.at(i_key)))
+                s_characters += s_keyCharacters.at(i_key);
+        }
+
+        lists_characters.append(s_characters);
+    }
+
+    QVector<int> veci_frequencies;
+    QStringList lists_candidates = po_dictionary->matches(lists_characters, VIRTUALKEYBOARD_TAPMODEL_MAXIMUMCANDIDATES, &veci_frequencies);
+
+    // The word typed competes with its corrections, without prior if it is not in the dictionary
+    int i_typed = lists_candidates.indexOf(s_lowercaseWord);
+    if (i_typed < 0)
+    {
+        i_typed = lists_candidates.size();
+        lists_candidates.append(s_lowercaseWord);
+        veci_frequencies.append(0);
+    }
+
+    if (lists_candidates.size() == 1) return QString();
+
+    // --- Keys of the candidates by position, padded to a multiple of 4 with the word typed
+    const int i_count = lists_candidates.size();
+    const int i_stride = (i_count + 3) & ~3;
+
+    QVector<float> vecr_keyX(i_length * i_stride);
+    QVector<float> vecr_keyY(i_length * i_stride);
+    QVector<float> vecr_priors(i_stride);
+    QVector<float> vecr_scores(i_stride);
+
+    for (int i_candidate = 0; i_candidate < i_stride; ++i_candidate)
+    {
+        const int i_source = i_candidate < i_count ? i_candidate : i_typed;
+        const QString &s_candidate = lists_candidates.at(i_source);
+
+        vecr_priors[i_candidate] = float(VIRTUALKEYBOARD_TAPMODEL_PRIORWEIGHT * veci_frequencies.at(i_source));
+
+        // Every character of a candidate is the character of a key : it has been matched on lists_characters
+        for (int i_i = 0; i_i < i_length; ++i_i)
+        {
+            const int i_key = s_keyCharacters.indexOf(s_candidate.at(i_i));
+            vecr_keyX[i_i * i_stride + i_candidate] = pr_keyX[i_key];
+            vecr_keyY[i_i * i_stride + i_candidate] = pr_keyY[i_key];
+        }
+    }
+
+    // Log-likelihood of the taps : -(dx² + dy²) / 2 each
+    VirtualKeyboardKeyModel::scoreDistances(vecr_tapX.constData(), vecr_tapY.constData(), i_length, vecr_keyX.constData(), vecr_keyY.constData(),
+                                            i_stride, 0.5f, vecr_priors.constData(), vecr_scores.data());
+
+    int i_best = i_typed;
+    for (int i_candidate = 0; i_candidate < i_count; ++i_candidate)
+        if (vecr_scores.at(i_candidate) > vecr_scores.at(i_best)) i_best = i_candidate;
+
+    if (i_best == i_typed || vecr_scores.at(i_best) - vecr_scores.at(i_typed) < VIRTUALKEYBOARD_TAPMODEL_MINIMUMGAIN) return QString();
+
+    // --- Case of the word typed
+    QString s_correction = lists_candidates.at(i_best);
+    for (int i_i = 0; i_i < i_length; ++i_i)
+        if (s_word.at(i_i).isUpper()) s_correction[i_i] = s_correction.at(i_i).toUpper();
+
+    return s_correction;
+}
+
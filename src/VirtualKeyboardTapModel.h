@@ -0,0 +1,111 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+#ifndef VIRTUALKEYBOARDTAPMODEL_H
+#define VIRTUALKEYBOARDTAPMODEL_H
+
+#include <QString>
+#include <QVector>
+#include <QPointF>
+#include <QRectF>
+
+#include "VirtualKeyboardDictionary.h"
+#include "VirtualKeyboardKeyModel.h"
+
+
+// Standard deviation of the taps around the centre of the key aimed at, in key widths (horizontally) and key heights (vertically)
+#define VIRTUALKEYBOARD_TAPMODEL_SIGMA              0.5
+
+// Distance from a tap within which a key may have been aimed at, in standard deviations
+#define VIRTUALKEYBOARD_TAPMODEL_CANDIDATERADIUS    2.0
+
+// Weight of the frequency of the words in their score, in natural log units per step of the quantized frequency
+#define VIRTUALKEYBOARD_TAPMODEL_PRIORWEIGHT        0.1
+
+// Minimum score difference between a correction and the word typed, in natural log units
+#define VIRTUALKEYBOARD_TAPMODEL_MINIMUMGAIN        2.0
+
+// Maximum number of words scored for a word typed : the most frequent of the words spelt by the keys near the taps
+#define VIRTUALKEYBOARD_TAPMODEL_MAXIMUMCANDIDATES  1024
+
+
+/**
+ * \brief Spatial model of the taps, correcting the words typed with near-miss taps on a neighbour key
+ *
+ * Each tap is modeled by a Gaussian centred on the key aimed at (VIRTUALKEYBOARD_TAPMODEL_SIGMA key sizes). The candidates of a
+ * word typed are the words of the dictionary of its length spelt by the keys near each tap (VirtualKeyboardDictionary::matches()),
+ * their score is the log-likelihood of the taps plus their frequency in the dictionary. The best candidate replaces the word typed
+ * if it scores VIRTUALKEYBOARD_TAPMODEL_MINIMUMGAIN more than it.
+ *
+ * The keys are modeled by VirtualKeyboardKeyModel, the candidates are scored together by VirtualKeyboardKeyModel::scoreDistances(),
+ * laid out by position (structure of arrays) : four words at once with SSE on x86, one at a time elsewhere.
+ *
+ * This class only depends on QtCore, it can be used without a display.
+ */
+class VirtualKeyboardTapModel
+{
+    // Private Members
+private:
+
+    /**
+     * Keys of the model, VIRTUALKEYBOARD_TAPMODEL_SIGMA key sizes of standard deviation
+     */
+    VirtualKeyboardKeyModel mo_keyModel;
+
+
+    // Public Functions
+public:
+
+    /**
+     * \brief Constructor of a model without keys
+     */
+    VirtualKeyboardTapModel();
+
+    /**
+     * \brief Set the keys of the model, the standard deviation is taken from their median size
+     * \param[in] s_characters : Character of each key (compared in lowercase)
+     * \param[in] veco_rects : Rectangle of each key, in the coordinates of the taps
+     */
+    void setKeys(const QString &s_characters, const QVector<QRectF> &veco_rects);
+
+    /**
+     * \brief Get the number of keys of the model
+     */
+    int keyCount() const;
+
+    /**
+     * \brief Correct a word typed
+     *
+     * Only the words made of letters typed on the keys of the model are corrected, the case of the word typed is kept.
+     *
+     * \param[in] veco_taps : Position of the tap of each character of the word
+     * \param[in] s_word : Word typed
+     * \param[in] po_dictionary : Dictionary of the candidates
+     * \return Correction, empty if the word typed is the best candidate (or can not be corrected)
+     */
+    QString correct(const QVector<QPointF> &veco_taps, const QString &s_word, const VirtualKeyboardDictionary *po_dictionary) const;
+};
+
+#endif // VIRTUALKEYBOARDTAPMODEL_H
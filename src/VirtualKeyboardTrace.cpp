@@ -0,0 +1,356 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+#include "VirtualKeyboardTrace.h"
+#include "VirtualKeyboard.h"
+
+
+// Header of a trace
+#define VIRTUALKEYBOARDTRACE_MAGIC      "VKTR"
+#define VIRTUALKEYBOARDTRACE_VERSION    1
+
+
+/**
+ * \brief Append an unsigned integer to a buffer, 7 bits per byte (varint)
+ */
+static void writeVarint(QByteArray &ba_buffer, quint64 i_value)
+{
+    while (i_value >= 0x80)
+    {
+        ba_buffer.append(char((i_value & 0x7F) | 0x80));
+        i_value >>= 7;
+    }
+    ba_buffer.append(char(i_value));
+}
+
+
+/**
+ * \brief Read an unsigned integer written by writeVarint
+ * \return False if the buffer ends before the integer
+ */
+static bool readVarint(const QByteArray &ba_buffer, int &i_position, quint64 &i_value)
+{
+    i_value = 0;
+
+    for (int i_shift = 0; i_shift < 64; i_shift += 7)
+    {
+        if (i_position >= ba_buffer.size()) return false;
+
+        const quint8 i_byte = quint8(ba_buffer.at(i_position++));
+        i_value |= quint64(i_byte & 0x7F) << i_shift;
+
+        if (!(i_byte & 0x80)) return true;
+    }
+    return false;
+}
+
+
+/**
+ * \brief Check if the events of a type carry a text
+ */
+static bool hasText(int i_type)
+{
+    return i_type == VIRTUALKEYBOARDTRACE_EVENT_SUGGESTION || i_type == VIRTUALKEYBOARDTRACE_EVENT_CORRECTION
+            || i_type == VIRTUALKEYBOARDTRACE_EVENT_GESTUREWORD;
+}
+
+
+
+VirtualKeyboardTraceRecorder::VirtualKeyboardTraceRecorder(VirtualKeyboard *w_keyboard, QObject *o_parent) :
+    QObject(o_parent),
+    mpw_keyboard(w_keyboard),
+    mi_lastTimestamp(0),
+    mi_eventCount(0)
+{
+}
+
+
+bool VirtualKeyboardTraceRecorder::start(QIODevice *po_device)
+{
+    if (po_device == NULL || !po_device->isWritable() || this->mpw_keyboard.isNull()) return false;
+
+    this->stop();
+
+    QByteArray ba_header(VIRTUALKEYBOARDTRACE_MAGIC);
+    ba_header.append(char(VIRTUALKEYBOARDTRACE_VERSION));
+    if (po_device->write(ba_header) != ba_header.size()) return false;
+
+    this->mpo_device = po_device;
+    this->mi_lastTimestamp = 0;
+    this->mi_eventCount = 0;
+    this->mo_clock.start();
+
+    connect(this->mpw_keyboard, SIGNAL(keyDispatched(int)),
+            this,               SLOT(keyDispatched(int)));
+    connect(this->mpw_keyboard, SIGNAL(secondaryKeyPressed(int)),
+            this,               SLOT(secondaryKeyPressed(int)));
+    connect(this->mpw_keyboard, SIGNAL(snippetDispatched(int)),
+            this,               SLOT(snippetDispatched(int)));
+    connect(this->mpw_keyboard, SIGNAL(suggestionDispatched(QString)),
+            this,               SLOT(suggestionDispatched(QString)));
+    connect(this->mpw_keyboard, SIGNAL(correctionDispatched(QString,QString)),
+            this,               SLOT(correctionDispatched(QString,QString)));
+    connect(this->mpw_keyboard, SIGNAL(gestureWordDispatched(QString)),
+            this,               SLOT(gestureWordDispatched(QString)));
+
+    return true;
+}
+
+
+void VirtualKeyboardTraceRecorder::stop()
+{
+    if (!this->mpw_keyboard.isNull()) disconnect(this->mpw_keyboard, 0, this, 0);
+
+    this->mpo_device.clear();
+}
+
+
+int VirtualKeyboardTraceRecorder::eventCount() const
+{
+    return this->mi_eventCount;
+}
+
+
+void VirtualKeyboardTraceRecorder::writeEvent(int i_type, int i_key, const QString &s_text)
+{
+    if (this->mpo_device.isNull()) return;
+
+    const qint64 i_timestamp = this->mo_clock.nsecsElapsed() / 1000;
+
+    QByteArray ba_event;
+    writeVarint(ba_event, quint64(i_timestamp - this->mi_lastTimestamp));
+    ba_event.append(char(i_type));
+    // Zigzag encoding : the mapping index of a secondary key can be negative
+    writeVarint(ba_event, (quint64(qint64(i_key)) << 1) ^ quint64(qint64(i_key) >> 63));
+    if (hasText(i_type))
+    {
+        const QByteArray ba_text = s_text.toUtf8();
+        writeVarint(ba_event, quint64(ba_text.size()));
+        ba_event.append(ba_text);
+    }
+
+    this->mpo_device->write(ba_event);
+    this->mi_lastTimestamp = i_timestamp;
+    ++this->mi_eventCount;
+}
+
+
+void VirtualKeyboardTraceRecorder::keyDispatched(int i_keyId)
+{
+    this->writeEvent(VIRTUALKEYBOARDTRACE_EVENT_KEY, i_keyId);
+}
+
+
+void VirtualKeyboardTraceRecorder::secondaryKeyPressed(int i_indexKey)
+{
+    this->writeEvent(VIRTUALKEYBOARDTRACE_EVENT_SECONDARYKEY, i_indexKey);
+}
+
+
+void VirtualKeyboardTraceRecorder::snippetDispatched(int i_indexMapping)
+{
+    this->writeEvent(VIRTUALKEYBOARDTRACE_EVENT_SNIPPET, i_indexMapping);
+}
+
+
+void VirtualKeyboardTraceRecorder::suggestionDispatched(const QString &s_suggestion)
+{
+    this->writeEvent(VIRTUALKEYBOARDTRACE_EVENT_SUGGESTION, 0, s_suggestion);
+}
+
+
+void VirtualKeyboardTraceRecorder::correctionDispatched(const QString &s_word, const QString &s_correction)
+{
+    this->writeEvent(VIRTUALKEYBOARDTRACE_EVENT_CORRECTION, s_word.size(), s_word + s_correction);
+}
+
+
+void VirtualKeyboardTraceRecorder::gestureWordDispatched(const QString &s_word)
+{
+    this->writeEvent(VIRTUALKEYBOARDTRACE_EVENT_GESTUREWORD, 0, s_word);
+}
+
+
+
+VirtualKeyboardTraceReplayer::VirtualKeyboardTraceReplayer(VirtualKeyboard *w_keyboard, QObject *o_parent) :
+    QObject(o_parent),
+    mpw_keyboard(w_keyboard),
+    mi_nextEvent(0)
+{
+    this->mo_timer.setSingleShot(true);
+    this->mo_timer.setTimerType(Qt::PreciseTimer);
+
+    connect(&this->mo_timer,    SIGNAL(timeout()),
+            this,               SLOT(replayDueEvents()));
+}
+
+
+bool VirtualKeyboardTraceReplayer::load(QIODevice *po_device)
+{
+    this->mvec_events.clear();
+
+    if (po_device == NULL || !po_device->isReadable()) return false;
+
+    const QByteArray ba_trace = po_device->readAll();
+    const QByteArray ba_magic(VIRTUALKEYBOARDTRACE_MAGIC);
+
+    if (!ba_trace.startsWith(ba_magic) || ba_trace.size() <= ba_magic.size()
+            || quint8(ba_trace.at(ba_magic.size())) != VIRTUALKEYBOARDTRACE_VERSION)
+        return false;
+
+    int i_position = ba_magic.size() + 1;
+    qint64 i_timestamp = 0;
+
+    while (i_position < ba_trace.size())
+    {
+        quint64 i_delta, i_key;
+        VirtualKeyboardTraceEvent o_event;
+
+        if (!readVarint(ba_trace, i_position, i_delta) || i_position >= ba_trace.size())
+        {
+            this->mvec_events.clear();
+            return false;
+        }
+        o_event.i_type = quint8(ba_trace.at(i_position++));
+
+        if (!readVarint(ba_trace, i_position, i_key))
+        {
+            this->mvec_events.clear();
+            return false;
+        }
+
+        i_timestamp += qint64(i_delta);
+        o_event.i_timestamp = i_timestamp;
+        o_event.i_key = int(qint64(i_key >> 1) ^ -qint64(i_key & 1));
+
+        if (hasText(o_event.i_type))
+        {
+            quint64 i_size;
+
+            if (!readVarint(ba_trace, i_position, i_size) || i_size > quint64(ba_trace.size() - i_position))
+            {
+                this->mvec_events.clear();
+                return false;
+            }
+            o_event.s_text = QString::fromUtf8(ba_trace.constData() + i_position, int(i_size));
+            i_position += int(i_size);
+        }
+
+        this->mvec_events.append(o_event);
+    }
+    return true;
+}
+
+
+const QVector<VirtualKeyboardTraceEvent> &VirtualKeyboardTraceReplayer::events() const
+{
+    return this->mvec_events;
+}
+
+
+void VirtualKeyboardTraceReplayer::replay(int i_mode)
+{
+    this->mo_timer.stop();
+    this->mo_eventLatency.reset();
+    this->mi_nextEvent = 0;
+    this->mo_clock.start();
+
+    if (i_mode == VIRTUALKEYBOARDTRACE_REPLAY_FAST)
+    {
+        for (; this->mi_nextEvent < this->mvec_events.size(); ++this->mi_nextEvent)
+            this->replayEvent(this->mvec_events.at(this->mi_nextEvent));
+
+        this->finish();
+    }
+    else
+    {
+        this->replayDueEvents();
+    }
+}
+
+
+void VirtualKeyboardTraceReplayer::replayEvent(const VirtualKeyboardTraceEvent &o_event)
+{
+    if (this->mpw_keyboard.isNull()) return;
+
+    const qint64 i_start = this->mo_clock.nsecsElapsed();
+
+    switch (o_event.i_type)
+    {
+    case VIRTUALKEYBOARDTRACE_EVENT_SECONDARYKEY:
+    case VIRTUALKEYBOARDTRACE_EVENT_SNIPPET:
+        this->mpw_keyboard->pressSecondaryKey(o_event.i_key);
+        break;
+    case VIRTUALKEYBOARDTRACE_EVENT_SUGGESTION:
+        this->mpw_keyboard->pressSuggestion(o_event.s_text);
+        break;
+    case VIRTUALKEYBOARDTRACE_EVENT_CORRECTION:
+        this->mpw_keyboard->pressCorrection(o_event.s_text.left(o_event.i_key), o_event.s_text.mid(o_event.i_key));
+        break;
+    case VIRTUALKEYBOARDTRACE_EVENT_GESTUREWORD:
+        this->mpw_keyboard->pressGestureWord(o_event.s_text);
+        break;
+    default:
+        this->mpw_keyboard->pressKey(o_event.i_key);
+        break;
+    }
+
+    this->mo_eventLatency.addSample((this->mo_clock.nsecsElapsed() - i_start) / 1000);
+}
+
+
+void VirtualKeyboardTraceReplayer::finish()
+{
+    VirtualKeyboardTraceReport o_report;
+
+    o_report.i_eventCount = this->mvec_events.size();
+    o_report.i_duration = this->mo_clock.nsecsElapsed() / 1000;
+    o_report.r_throughput = o_report.i_duration > 0 ? o_report.i_eventCount * 1000000.0 / o_report.i_duration : 0;
+    o_report.o_eventLatency = this->mo_eventLatency.statistics();
+
+    emit this->finished(o_report);
+}
+
+
+void VirtualKeyboardTraceReplayer::replayDueEvents()
+{
+    const qint64 i_now = this->mo_clock.nsecsElapsed() / 1000;
+
+    while (this->mi_nextEvent < this->mvec_events.size() && this->mvec_events.at(this->mi_nextEvent).i_timestamp <= i_now)
+    {
+        this->replayEvent(this->mvec_events.at(this->mi_nextEvent));
+        ++this->mi_nextEvent;
+    }
+
+    if (this->mi_nextEvent >= this->mvec_events.size())
+    {
+        this->finish();
+        return;
+    }
+
+    // Wait for the next event (the timer has a millisecond resolution)
+    const qint64 i_delay = (this->mvec_events.at(this->mi_nextEvent).i_timestamp - (this->mo_clock.nsecsElapsed() / 1000) + 999) / 1000;
+    this->mo_timer.start(int(qMax(qint64(0), i_delay)));
+}
@@ -0,0 +1,349 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+#ifndef VIRTUALKEYBOARDTRACE_H
+#define VIRTUALKEYBOARDTRACE_H
+
+#include <QObject>
+#include <QString>
+#include <QPointer>
+#include <QVector>
+#include <QIODevice>
+#include <QElapsedTimer>
+#include <QTimer>
+
+#include "VirtualKeyboardLatency.h"
+
+class VirtualKeyboard;
+
+
+// Types of the events of a trace
+#define VIRTUALKEYBOARDTRACE_EVENT_KEY          0
+#define VIRTUALKEYBOARDTRACE_EVENT_SECONDARYKEY 1
+#define VIRTUALKEYBOARDTRACE_EVENT_SNIPPET      2
+#define VIRTUALKEYBOARDTRACE_EVENT_SUGGESTION   3
+#define VIRTUALKEYBOARDTRACE_EVENT_CORRECTION   4
+#define VIRTUALKEYBOARDTRACE_EVENT_GESTUREWORD  5
+
+// Replay modes
+#define VIRTUALKEYBOARDTRACE_REPLAY_REALTIME    0
+#define VIRTUALKEYBOARDTRACE_REPLAY_FAST        1
+
+
+/**
+ * \brief Event of a keystroke trace
+ */
+struct VirtualKeyboardTraceEvent
+{
+    /**
+     * Time of the event since the start of the recording, in microseconds
+     */
+    qint64 i_timestamp;
+
+    /**
+     * VIRTUALKEYBOARDTRACE_EVENT_*
+     */
+    int i_type;
+
+    /**
+     * Key identifier (as passed to VirtualKeyboard::pressKey), mapping index of the secondary or snippet key,
+     * length of the word corrected for a correction, 0 for the other events
+     */
+    int i_key;
+
+    /**
+     * Word of a suggestion or of a gesture, word corrected followed by its correction for a correction, empty for the other events
+     */
+    QString s_text;
+};
+
+
+/**
+ * \brief Result of the replay of a trace
+ */
+struct VirtualKeyboardTraceReport
+{
+    /**
+     * Number of events replayed
+     */
+    int i_eventCount;
+
+    /**
+     * Duration of the replay, in microseconds
+     */
+    qint64 i_duration;
+
+    /**
+     * Events replayed per second
+     */
+    qreal r_throughput;
+
+    /**
+     * Time spent to dispatch each event, in microseconds
+     */
+    VirtualKeyboardLatencyStatistics o_eventLatency;
+};
+
+
+/**
+ * \brief Record the keystrokes of a VirtualKeyboard into a compact binary trace
+ *
+ * Every key dispatched by the keyboard (principal keys, space, backspace, enter, layer toggles, cut / copy / paste), every secondary
+ * and snippet key, and every text typed without a key (suggestion, tap correction, word of a gesture) is written with its timestamp.
+ *
+ * Trace format : the magic "VKTR", a version byte, then for each event :
+ *  \li the time elapsed since the previous event in microseconds (varint)
+ *  \li the event type (1 byte)
+ *  \li the key (zigzag varint)
+ *  \li for the suggestions, corrections and gesture words : the size of the text in bytes (varint) then the text (UTF-8)
+ */
+class VirtualKeyboardTraceRecorder : public QObject
+{
+    Q_OBJECT
+
+
+    // Private Members
+private:
+
+    /**
+     * Keyboard recorded
+     */
+    QPointer<VirtualKeyboard> mpw_keyboard;
+
+    /**
+     * Device in which the trace is written, NULL if not recording
+     */
+    QPointer<QIODevice> mpo_device;
+
+    /**
+     * Clock started with the recording
+     */
+    QElapsedTimer mo_clock;
+
+    /**
+     * Timestamp of the last event written, in microseconds
+     */
+    qint64 mi_lastTimestamp;
+
+    /**
+     * Number of events written
+     */
+    int mi_eventCount;
+
+
+    // Public Functions
+public:
+
+    /**
+     * \brief Constructor
+     * \param w_keyboard : Keyboard to record
+     * \param o_parent : parent object (default 0)
+     */
+    explicit VirtualKeyboardTraceRecorder(VirtualKeyboard *w_keyboard, QObject *o_parent = 0);
+
+    /**
+     * \brief Start recording
+     * \param[in] po_device : Device opened in write mode, in which the trace is written
+     * \return False if the device is not writable, else True
+     */
+    bool start(QIODevice *po_device);
+
+    /**
+     * \brief Stop recording (the device is not closed)
+     */
+    void stop();
+
+    /**
+     * \brief Get the number of events recorded
+     * \return Number of events written since start
+     */
+    int eventCount() const;
+
+
+    // Private Functions
+private:
+
+    /**
+     * \brief Write an event in the trace
+     * \param[in] i_type : VIRTUALKEYBOARDTRACE_EVENT_*
+     * \param[in] i_key : Key identifier, mapping index, or length of the word corrected
+     * \param[in] s_text : Text of the suggestions, corrections and gesture words
+     */
+    void writeEvent(int i_type, int i_key, const QString &s_text = QString());
+
+
+    // Private Slots
+private slots:
+
+    /**
+     * \brief Slot connected to VirtualKeyboard::keyDispatched
+     */
+    void keyDispatched(int i_keyId);
+
+    /**
+     * \brief Slot connected to VirtualKeyboard::secondaryKeyPressed
+     */
+    void secondaryKeyPressed(int i_indexKey);
+
+    /**
+     * \brief Slot connected to VirtualKeyboard::snippetDispatched
+     */
+    void snippetDispatched(int i_indexMapping);
+
+    /**
+     * \brief Slot connected to VirtualKeyboard::suggestionDispatched
+     */
+    void suggestionDispatched(const QString &s_suggestion);
+
+    /**
+     * \brief Slot connected to VirtualKeyboard::correctionDispatched
+     */
+    void correctionDispatched(const QString &s_word, const QString &s_correction);
+
+    /**
+     * \brief Slot connected to VirtualKeyboard::gestureWordDispatched
+     */
+    void gestureWordDispatched(const QString &s_word);
+};
+
+
+/**
+ * \brief Replay a trace recorded by VirtualKeyboardTraceRecorder on a VirtualKeyboard (and its input widget)
+ *
+ * The events are replayed either at their original speed (asynchronously, finished is emitted at the end)
+ * or as fast as possible (synchronously). No display is needed, the replay works under the offscreen platform.
+ *
+ * The texts typed without a key are replayed by their text : the suggestions through VirtualKeyboard::pressSuggestion(QString),
+ * the words of the gestures through VirtualKeyboard::pressGestureWord() (the path is not decoded again), the corrections through
+ * VirtualKeyboard::pressCorrection() once the space finishing the word has been replayed.
+ */
+class VirtualKeyboardTraceReplayer : public QObject
+{
+    Q_OBJECT
+
+
+    // Private Members
+private:
+
+    /**
+     * Keyboard driven
+     */
+    QPointer<VirtualKeyboard> mpw_keyboard;
+
+    /**
+     * Events of the trace loaded
+     */
+    QVector<VirtualKeyboardTraceEvent> mvec_events;
+
+    /**
+     * Index of the next event to replay
+     */
+    int mi_nextEvent;
+
+    /**
+     * Clock started with the replay
+     */
+    QElapsedTimer mo_clock;
+
+    /**
+     * Timer used to replay at the original speed
+     */
+    QTimer mo_timer;
+
+    /**
+     * Time spent to dispatch each event
+     */
+    VirtualKeyboardLatencyHistogram mo_eventLatency;
+
+
+    // Public Functions
+public:
+
+    /**
+     * \brief Constructor
+     * \param w_keyboard : Keyboard to drive
+     * \param o_parent : parent object (default 0)
+     */
+    explicit VirtualKeyboardTraceReplayer(VirtualKeyboard *w_keyboard, QObject *o_parent = 0);
+
+    /**
+     * \brief Load a trace
+     * \param[in] po_device : Device opened in read mode, containing the trace
+     * \return False if the trace is invalid, else True
+     */
+    bool load(QIODevice *po_device);
+
+    /**
+     * \brief Get the events of the trace loaded
+     * \return Events, in chronological order
+     */
+    const QVector<VirtualKeyboardTraceEvent> &events() const;
+
+    /**
+     * \brief Replay the trace loaded
+     *
+     * With VIRTUALKEYBOARDTRACE_REPLAY_FAST the function returns once every event is replayed, finished has been emitted.
+     * With VIRTUALKEYBOARDTRACE_REPLAY_REALTIME the function returns immediately, finished is emitted at the end of the replay.
+     *
+     * \param[in] i_mode : VIRTUALKEYBOARDTRACE_REPLAY_REALTIME or VIRTUALKEYBOARDTRACE_REPLAY_FAST
+     */
+    void replay(int i_mode);
+
+
+    // Private Functions
+private:
+
+    /**
+     * \brief Replay one event, and count the time spent
+     * \param[in] o_event : Event to replay
+     */
+    void replayEvent(const VirtualKeyboardTraceEvent &o_event);
+
+    /**
+     * \brief Build the report and emit finished
+     */
+    void finish();
+
+
+    // Signals
+signals:
+
+    /**
+     * \brief Signal emitted at the end of a replay
+     * \param[in] o_report : Throughput and per-event latency of the replay
+     */
+    void finished(const VirtualKeyboardTraceReport &o_report);
+
+
+    // Private Slots
+private slots:
+
+    /**
+     * \brief Slot called by mo_timer, replay the events due (VIRTUALKEYBOARDTRACE_REPLAY_REALTIME)
+     */
+    void replayDueEvents();
+};
+
+#endif // VIRTUALKEYBOARDTRACE_H
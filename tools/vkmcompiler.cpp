@@ -0,0 +1,105 @@
+/*---------------------------------------------------------------------------------------------------------------------------------
+
+Copyright (c) 2014 Arnaud Vazard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-----------------------------------------------------------------------------------------------------------------------------------*/
+
+
+
+/*
+ * Compile a source keymap (.vkm) into a compiled keymap (.vkmc), or a source dictionary (.vkd) into a compiled dictionary (.vkdc),
+ * memory-mapped by the keyboard at runtime
+ *
+ * Usage : vkmcompiler [--cpp] <source.vkm|source.vkd> [<output>]
+ *
+ * With --cpp, the compiled keymap is written as a list of C++ byte literals (.inc), to be compiled in the keyboard (built-in keymaps)
+ */
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QTextStream>
+
+#include "VirtualKeyboardKeymap.h"
+#include "VirtualKeyboardDictionary.h"
+
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication o_application(argc, argv);
+    QStringList lists_arguments = o_application.arguments();
+    const bool b_isCppOutput = lists_arguments.removeAll(QLatin1String("--cpp")) > 0;
+
+    if (lists_arguments.size() < 2 || lists_arguments.size() > 3)
+    {
+        qWarning("Usage: vkmcompiler [--cpp] <source%s|source%s> [<output>]", VIRTUALKEYBOARD_KEYMAP_SOURCESUFFIX, VIRTUALKEYBOARD_DICTIONARY_SOURCESUFFIX);
+        return 2;
+    }
+
+    const QString s_sourceName = lists_arguments.at(1);
+    const bool b_isDictionary = s_sourceName.endsWith(QLatin1String(VIRTUALKEYBOARD_DICTIONARY_SOURCESUFFIX));
+    const char *pc_compiledSuffix = b_isDictionary ? VIRTUALKEYBOARD_DICTIONARY_COMPILEDSUFFIX : VIRTUALKEYBOARD_KEYMAP_COMPILEDSUFFIX;
+    const QString s_compiledName = lists_arguments.size() == 3 ? lists_arguments.at(2)
+                                                               : QFileInfo(s_sourceName).completeBaseName()
+                                                                 + QLatin1String(b_isCppOutput ? ".inc" : pc_compiledSuffix);
+
+    QFile o_source(s_sourceName);
+    if (!o_source.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        qWarning("vkmcompiler: can not read %s", qPrintable(s_sourceName));
+        return 1;
+    }
+    QTextStream o_stream(&o_source);
+    o_stream.setCodec("UTF-8");
+
+    QByteArray ba_compiled;
+    QString s_error;
+    const bool b_isCompiled = b_isDictionary ? VirtualKeyboardDictionary::compile(o_stream.readAll(), &ba_compiled, &s_error)
+                                             : VirtualKeyboardKeymap::compile(o_stream.readAll(), &ba_compiled, &s_error);
+    if (!b_isCompiled)
+    {
+        qWarning("%s: %s", qPrintable(s_sourceName), qPrintable(s_error));
+        return 1;
+    }
+
+    // C++ byte literals, 16 per line
+    if (b_isCppOutput)
+    {
+        QByteArray ba_cpp = "// Generated by vkmcompiler from " + QFileInfo(s_sourceName).fileName().toUtf8() + ", do not edit\n";
+
+        for (int i = 0; i < ba_compiled.size(); ++i)
+        {
+            ba_cpp += QByteArray("0x") + QByteArray::number(quint8(ba_compiled.at(i)), 16).rightJustified(2, '0') + ',';
+            ba_cpp += (i % 16 == 15 || i == ba_compiled.size() - 1) ? '\n' : ' ';
+        }
+        ba_compiled = ba_cpp;
+    }
+
+    QFile o_compiled(s_compiledName);
+    if (!o_compiled.open(QIODevice::WriteOnly) || o_compiled.write(ba_compiled) != ba_compiled.size())
+    {
+        qWarning("vkmcompiler: can not write %s", qPrintable(s_compiledName));
+        return 1;
+    }
+
+    return 0;
+}